@@ -0,0 +1,6 @@
+#version 430 core
+
+// depth only, the rasterized depth is stored in the atlas tile
+void main()
+{
+}
@@ -0,0 +1,10 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 lightMatrix; // projection * view of the atlas tile being rendered
+
+void main()
+{
+    gl_Position = lightMatrix * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 430 core
+
+// depth only, the lit fill pass that follows tests against it with GL_EQUAL
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 430 core
+#if defined(LAYER_ARB)
+#extension GL_ARB_shader_viewport_layer_array : require
+#elif defined(LAYER_AMD)
+#extension GL_AMD_vertex_shader_layer : require
+#endif
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in int aFace; // per instance: target cube face of this copy
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform int face; // target face when the faces are rendered one pass each
+
+out vec4 FragPos;
+
+void main()
+{
+    FragPos = model * vec4(aPos, 1.0);
+#if defined(LAYER_ARB) || defined(LAYER_AMD)
+    gl_Layer = aFace;
+    gl_Position = shadowMatrices[aFace] * FragPos;
+#else
+    gl_Position = shadowMatrices[face] * FragPos;
+#endif
+}
\ No newline at end of file
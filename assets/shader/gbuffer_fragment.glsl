@@ -0,0 +1,46 @@
+#version 430 core
+
+// 延迟渲染的几何阶段，与 model_vertex.glsl 一起使用
+// 颜色为材质系数与纹理（或模型颜色）的乘积，光照阶段（model_fragment.glsl 定义 DEFERRED）不再乘材质
+layout (location = 0) out vec4 gNormal;  // xyz: 世界空间法线，w: 高光指数
+layout (location = 1) out vec4 gDiffuse;
+layout (location = 2) out vec4 gSpecular;
+layout (location = 3) out vec4 gAmbient;
+
+struct Textures {
+    sampler2D diffuse1;
+    sampler2D specular1;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+layout (std140, binding = 2) uniform Material {
+    vec3 ambient;
+    float shininess;
+    vec3 diffuse;
+    float dissolve;
+    vec3 specular;
+    float refractiveIndex;
+    vec3 emission;
+    int illum;
+} material;
+
+uniform Textures textures;
+uniform vec3 modelColor;
+uniform bool hasTexture;
+
+void main() {
+    vec3 diffuseOriColor = modelColor;
+    vec3 specularOriColor = vec3(0.5f, 0.5f, 0.5f);
+    if (hasTexture) {
+        diffuseOriColor = texture(textures.diffuse1, TexCoords).rgb;
+        specularOriColor = texture(textures.specular1, TexCoords).rgb;
+    }
+
+    gNormal = vec4(normalize(Normal), material.shininess);
+    gDiffuse = vec4(material.diffuse * diffuseOriColor, 1.0f);
+    gSpecular = vec4(material.specular * specularOriColor, 1.0f);
+    gAmbient = vec4(material.ambient * diffuseOriColor, 1.0f);
+}
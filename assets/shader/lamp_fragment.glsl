@@ -1,7 +1,7 @@
 #version 430 core
 out vec4 FragColor;
 
-uniform vec3 lightColor;
+flat in vec3 lightColor;
 
 void main()
 {
@@ -1,11 +1,19 @@
 #version 430 core
 layout (location = 0) in vec3 aPos;
+layout (location = 6) in mat4 aModel; // per instance, written by LightFactory
+layout (location = 10) in vec4 aColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float far_plane;
+};
+
+flat out vec3 lightColor;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    lightColor = aColor.rgb;
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
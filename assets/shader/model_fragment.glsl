@@ -1,57 +1,173 @@
 #version 430 core
 
-out vec4 FragColor;
+// 定义 PERMUTATION 时为特化的变体，以下宏由程序在编译时给出：
+//   DIR_LIGHT_COUNT / POINT_LIGHT_COUNT / SPOT_LIGHT_COUNT  各类型灯光的数量，灯光数组按此顺序排列
+//   HAS_TEXTURE  0 或 1
+//   SHADOW_LIGHT  投射阴影的灯光在数组中的位置，-1 表示没有阴影
+//   ATLAS_SHADOWS  0 或 1，为 1 时每个灯光从阴影图集取阴影，不使用 SHADOW_LIGHT
+//   CLUSTERED  0 或 1，为 1 时点光与聚光只遍历片段所在分块的列表，不使用 POINT_LIGHT_COUNT / SPOT_LIGHT_COUNT
+// 未定义时为通用版本，灯光类型、纹理与阴影在运行时判断
+// 定义 DEFERRED 时为延迟渲染的光照阶段，与 screen_vertex.glsl 一起全屏绘制，
+// 位置由深度重建，法线与材质颜色从 G-buffer 读取（见 gbuffer_fragment.glsl），HAS_TEXTURE 不使用
+// 定义 OIT_WEIGHTED 或 OIT_LINKED 时绘制透明网格，颜色不直接写入，由 oit_composite_fragment.glsl
+// 或 oit_resolve_fragment.glsl 合成到画面上
 
-struct Material {
+layout (location = 0) out vec4 FragColor;
+#if defined(OIT_WEIGHTED)
+// 加权混合：FragColor 累加 (预乘颜色, 不透明度) * 权重，Revealage 以 (1 - 不透明度) 连乘
+layout (location = 1) out float Revealage;
+#elif defined(OIT_LINKED)
+// 片元挂到所在像素的链表上，被不透明几何遮挡的片元不能写入
+layout (early_fragment_tests) in;
+layout (std430, binding = 7) coherent buffer OitHeads {
+    uint oitFragments;  // 申请的节点数，超过 oitCapacity 的片元被丢弃
+    uint oitHeads[];  // 每个像素链表的第一个节点序号加 1，0 表示空，按行排列，宽度为 oitWidth
+};
+layout (std430, binding = 8) writeonly buffer OitNodes {
+    uvec4 oitNodes[];  // 半精度的颜色与不透明度、深度、下一个节点序号加 1
+};
+uniform int oitWidth;
+uniform int oitCapacity;
+#endif
+
+struct Textures {
     sampler2D diffuse1;
     sampler2D specular1;
-    float shininess;
 };
 
+// vec3 之后紧跟一个标量，与 C++ 端的 LightData 布局一致
 struct Light {
-    int type;  // 1: directional, 2: point, 3: spot, 0: none
     vec3 position;
+    int type;  // 1: directional, 2: point, 3: spot, 0: none
     vec3 direction;
+    float cutOff;  // 聚光裁剪
     vec3 color;
+    float outerCutOff;
 
-    // 系数
+    // 系数与衰减
     vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    // 衰减
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
-
-    // 聚光裁剪
-    float cutOff;
-    float outerCutOff;
 };
-#define MAX_LIGHTS 10
 #define DIR_LIGHT 1
 #define POINT_LIGHT 2
 #define SPOT_LIGHT 3
 #define TORCH_LIGHT 4
+// 可编辑的灯光数量（MAX_LIGHT_NUM），之后为采样的点光与聚光，不按类型排列
+const int EDITABLE_LIGHTS = 10;
+
+// 阴影图集中的一个图块，rect 为纹理坐标的偏移与缩放，rect.z 为 0 表示尚无内容
+struct ShadowTile {
+    mat4 matrix;
+    vec4 rect;
+};
 
 
+#ifdef DEFERRED
+// 固定的纹理单元，与 MainRender 中的 GBUFFER_UNIT 一致
+layout (binding = 25) uniform sampler2D gNormal;
+layout (binding = 26) uniform sampler2D gDiffuse;
+layout (binding = 27) uniform sampler2D gSpecular;
+layout (binding = 28) uniform sampler2D gAmbient;
+layout (binding = 29) uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+// 由 G-buffer 填充，之后的计算与前向渲染相同
+vec3 FragPos;
+vec3 Normal;
+vec2 TexCoords;
+#else
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+#endif
 
-uniform vec3 viewPos;
-uniform Material material;
-uniform Light lights[MAX_LIGHTS];
-uniform bool hasTexture;
+layout (std140, binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float far_plane;
+};
+
+layout (std430, binding = 1) readonly buffer Lights {
+    Light lights[];
+};
+
+// 按灯光在 lights 中的位置索引，x 为第一个图块，y 为图块数（0 表示没有阴影）
+// 平行光的图块为由近到远的级联，点光源为立方体的六个面（+X, -X, +Y, -Y, +Z, -Z）
+layout (std430, binding = 3) readonly buffer Shadows {
+    ivec4 shadowLights[16];
+    ShadowTile shadowTiles[];
+};
+
+// 分块光照：clusterGrid.xyz 为三个方向的分块数，clusterScale.xy 将 gl_FragCoord 换算为分块坐标，
+// 深度层号为 log(depth) * clusterScale.z - clusterScale.w
+// clusterRanges 为每个分块在 clusterLights 中的起点与数量，按 x + X * (y + Y * z) 排列
+layout (std430, binding = 4) readonly buffer Clusters {
+    uvec4 clusterGrid;
+    vec4 clusterScale;
+    uvec2 clusterRanges[];
+};
+
+layout (std430, binding = 5) readonly buffer ClusterLights {
+    uint clusterLights[];
+};
+
+#ifdef DEFERRED
+// G-buffer 中的颜色已经乘过材质系数
+struct GBufferMaterial {
+    vec3 ambient;
+    float shininess;
+    vec3 diffuse;
+    vec3 specular;
+};
+GBufferMaterial material;
+#else
+// 当前网格的材质常量
+layout (std140, binding = 2) uniform Material {
+    vec3 ambient;
+    float shininess;
+    vec3 diffuse;
+    float dissolve;
+    vec3 specular;
+    float refractiveIndex;
+    vec3 emission;
+    int illum;
+} material;
+#endif
+
+uniform Textures textures;
 uniform vec3 modelColor;
 uniform samplerCube shadowMap;
-uniform float far_plane;
+layout (binding = 30) uniform sampler2DShadow shadowAtlas;  // 固定的纹理单元，不与网格纹理冲突
+uniform float shadowDepthStep;  // 深度贴图的量化步长（世界单位），16 位深度时不能忽略
+#if defined(OIT_WEIGHTED) || defined(OIT_LINKED)
+uniform float opacity;  // 网格的不透明度，不随材质常量是否启用变化
+#endif
+#ifdef WIREFRAME
+noperspective in vec3 EdgeDistance;  // 到三角形三条边的屏幕距离（像素）
+uniform vec3 wireColor;
+uniform float wireWidth;
+#endif
+#ifndef PERMUTATION
+uniform bool hasTexture;
 uniform bool shadowEnable;
+uniform int shadowLight;  // 投射阴影的灯光在数组中的位置，-1 表示没有
+uniform bool atlasShadows;
+uniform bool clustered;
+uniform int dirLightCount;  // 分块光照时逐个计算的平行光数量，平行光在数组最前
+#endif
 
-vec3 CalcDirLight(Light light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
-vec3 CalcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
-vec3 CalcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
-float ShadowCalculation(Light light, vec3 fragPos);
+vec3 CalcDirLight(int index, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow);
+vec3 CalcSpotLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow);
+vec3 CalcLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow);
+float ShadowCalculation(int index, vec3 fragPos);
+float AtlasShadow(int index, vec3 fragPos, vec3 normal);
+uint ClusterIndex(vec3 fragPos);
 
 // array of offset direction for sampling
 vec3 gridSamplingDisk[20] = vec3[]
@@ -63,39 +179,140 @@ vec3 gridSamplingDisk[20] = vec3[]
     vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
 );
 
+/// 单遍线框：到最近的边不超过线宽一半的像素混合为线框颜色，边缘一个像素内平滑过渡
+vec3 Wireframe(vec3 color) {
+#ifdef WIREFRAME
+    float edge = min(EdgeDistance.x, min(EdgeDistance.y, EdgeDistance.z));
+    float coverage = 1.0f - smoothstep(wireWidth * 0.5f - 0.5f, wireWidth * 0.5f + 0.5f, edge);
+    return mix(color, wireColor, coverage);
+#else
+    return color;
+#endif
+}
+
+/// 不透明网格直接输出，透明网格按 OIT 的方式输出
+void WriteColor(vec3 color) {
+#if defined(OIT_WEIGHTED)
+    // 权重随观察空间的深度减小，近处的片元在平均颜色中占比更大（McGuire & Bavoil 2013, 式 7）
+    float depth = -(view * vec4(FragPos, 1.0f)).z;
+    float weight = clamp(10.0f / (1e-5f + pow(depth / 5.0f, 2.0f) + pow(depth / 200.0f, 6.0f)), 1e-2f, 3e3f);
+    FragColor = vec4(color * opacity, opacity) * (opacity * weight);
+    Revealage = opacity;
+#elif defined(OIT_LINKED)
+    uint node = atomicAdd(oitFragments, 1u);
+    if (node >= uint(oitCapacity))
+        return;
+    uint pixel = uint(gl_FragCoord.y) * uint(oitWidth) + uint(gl_FragCoord.x);
+    uint next = atomicExchange(oitHeads[pixel], node + 1u);
+    oitNodes[node] = uvec4(packHalf2x16(color.rg), packHalf2x16(vec2(color.b, opacity)),
+                           floatBitsToUint(gl_FragCoord.z), next);
+#else
+    FragColor = vec4(color, 1.0f);
+#endif
+}
+
 void main() {
     vec3 diffuseOriColor = vec3(1.0f);
     vec3 specularOriColor = vec3(1.0f);
+#if defined(DEFERRED)
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth == 1.0f)  // 没有几何，保留背景
+        discard;
+    vec4 clip = vec4(vec3(gl_FragCoord.xy / vec2(textureSize(gDepth, 0)), depth) * 2.0f - 1.0f, 1.0f);
+    vec4 world = inverseViewProjection * clip;
+    FragPos = world.xyz / world.w;
+    vec4 normalShininess = texelFetch(gNormal, pixel, 0);
+    Normal = normalShininess.xyz;
+    material.shininess = normalShininess.w;
+    material.diffuse = texelFetch(gDiffuse, pixel, 0).rgb;
+    material.specular = texelFetch(gSpecular, pixel, 0).rgb;
+    material.ambient = texelFetch(gAmbient, pixel, 0).rgb;
+    // 之后绘制的线框、顶点与选择叠加层按模型的深度测试
+    gl_FragDepth = depth;
+#elif defined(PERMUTATION)
+#if HAS_TEXTURE
+    diffuseOriColor = texture(textures.diffuse1, TexCoords).rgb;
+    specularOriColor = texture(textures.specular1, TexCoords).rgb;
+#else
+    diffuseOriColor = modelColor;
+    specularOriColor = vec3(0.5f, 0.5f, 0.5f);
+#endif
+#else
     if (hasTexture) {
-        diffuseOriColor = texture(material.diffuse1, TexCoords).rgb;
-        specularOriColor = texture(material.specular1, TexCoords).rgb;
+        diffuseOriColor = texture(textures.diffuse1, TexCoords).rgb;
+        specularOriColor = texture(textures.specular1, TexCoords).rgb;
     }
     else {
         diffuseOriColor = modelColor;
         specularOriColor = vec3(0.5f, 0.5f, 0.5f);
     }
+#endif
 
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
 
+    // 阴影只属于一个灯光，在进入灯光循环前计算一次
+#ifdef PERMUTATION
+    const int shadowIndex = SHADOW_LIGHT;
+    const bool atlas = ATLAS_SHADOWS != 0;
+    const bool clusteredPath = CLUSTERED != 0;
+    const int dirCount = DIR_LIGHT_COUNT;
+#else
+    int shadowIndex = shadowEnable ? shadowLight : -1;
+    bool atlas = atlasShadows;
+    bool clusteredPath = clustered;
+    int dirCount = dirLightCount;
+#endif
+    float shadowValue = shadowIndex >= 0 ? ShadowCalculation(shadowIndex, FragPos) : 0.0f;
+
     vec3 result = vec3(0.0f);
 
-    for (int i = 0; i < MAX_LIGHTS; i++) {
-        if (lights[i].type == DIR_LIGHT) {
-            result += CalcDirLight(lights[i], norm, viewDir, diffuseOriColor, specularOriColor);
+    if (clusteredPath) {
+        // 平行光影响所有片段，其余灯光只遍历所在分块的列表
+        for (int i = 0; i < dirCount; i++) {
+            result += CalcDirLight(i, norm, viewDir, diffuseOriColor, specularOriColor,
+                                   atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
         }
-        else if (lights[i].type == POINT_LIGHT) {
-            result += CalcPointLight(lights[i], norm, FragPos, viewDir, diffuseOriColor, specularOriColor);
-        }
-        else if (lights[i].type == SPOT_LIGHT || lights[i].type == TORCH_LIGHT) {
-            result += CalcSpotLight(lights[i], norm, FragPos, viewDir, diffuseOriColor, specularOriColor);
+        uvec2 range = clusterRanges[ClusterIndex(FragPos)];
+        for (uint j = range.x; j < range.x + range.y; j++) {
+            int i = int(clusterLights[j]);
+            result += CalcLight(i, norm, FragPos, viewDir, diffuseOriColor, specularOriColor,
+                                atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
         }
+        WriteColor(Wireframe(result));
+        return;
+    }
+
+#ifdef PERMUTATION
+    for (int i = 0; i < DIR_LIGHT_COUNT; i++) {
+        result += CalcDirLight(i, norm, viewDir, diffuseOriColor, specularOriColor,
+                               atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
+    }
+    for (int i = DIR_LIGHT_COUNT; i < DIR_LIGHT_COUNT + POINT_LIGHT_COUNT; i++) {
+        result += CalcPointLight(i, norm, FragPos, viewDir, diffuseOriColor, specularOriColor,
+                                 atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
     }
+    for (int i = DIR_LIGHT_COUNT + POINT_LIGHT_COUNT; i < DIR_LIGHT_COUNT + POINT_LIGHT_COUNT + SPOT_LIGHT_COUNT; i++) {
+        result += CalcSpotLight(i, norm, FragPos, viewDir, diffuseOriColor, specularOriColor,
+                                atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
+    }
+    // 采样的灯光没有阴影
+    for (int i = EDITABLE_LIGHTS; i < lights.length(); i++) {
+        result += CalcLight(i, norm, FragPos, viewDir, diffuseOriColor, specularOriColor, 0.0f);
+    }
+#else
+    for (int i = 0; i < lights.length(); i++) {
+        result += CalcLight(i, norm, FragPos, viewDir, diffuseOriColor, specularOriColor,
+                            atlas ? AtlasShadow(i, FragPos, norm) : i == shadowIndex ? shadowValue : 0.0f);
+    }
+#endif
 
-    FragColor = vec4(result, 1.0f);
+    WriteColor(Wireframe(result));
 }
 
-vec3 CalcDirLight(Light light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor) {
+vec3 CalcDirLight(int index, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow) {
+    Light light = lights[index];
     vec3 lightDir = normalize(-light.direction);
     // 漫反射着色
     float diff = max(dot(normal, lightDir), 0.0);
@@ -103,15 +320,14 @@ vec3 CalcDirLight(Light light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec
     vec3 halfwayDir = normalize(lightDir + viewDir);
     float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
     // 合并结果
-    vec3 ambient  = light.ambient  * diffuseColor;
-    vec3 diffuse  = light.diffuse  * light.color * diff * diffuseColor;
-    vec3 specular = light.specular * spec * specularColor;
-    // 阴影
-    float shadow = shadowEnable ? ShadowCalculation(light, FragPos) : 0.0f;
+    vec3 ambient  = light.ambient  * material.ambient * diffuseColor;
+    vec3 diffuse  = light.diffuse  * material.diffuse * light.color * diff * diffuseColor;
+    vec3 specular = light.specular * material.specular * spec * specularColor;
     return ambient + (1.0f - min(shadow, 0.75f)) * (diffuse + specular);
 }
 
-vec3 CalcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor) {
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow) {
+    Light light = lights[index];
     vec3 lightDir = normalize(light.position - fragPos);
     // 漫反射着色
     float diff = max(dot(normal, lightDir), 0.0f);
@@ -123,18 +339,17 @@ vec3 CalcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 d
     float attenuation = 1.0f / (light.constant + light.linear * distance +
     light.quadratic * (distance * distance));
     // 合并结果
-    vec3 ambient  = light.ambient  * diffuseColor;
-    vec3 diffuse  = light.diffuse  * light.color * diff * diffuseColor;
-    vec3 specular = light.specular * light.color * spec * specularColor;
+    vec3 ambient  = light.ambient  * material.ambient * diffuseColor;
+    vec3 diffuse  = light.diffuse  * material.diffuse * light.color * diff * diffuseColor;
+    vec3 specular = light.specular * material.specular * light.color * spec * specularColor;
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
-    // 阴影
-    float shadow = shadowEnable ? ShadowCalculation(light, FragPos) : 0.0f;
     return ambient + (1.0f - min(shadow, 0.75f)) * (diffuse + specular);
 }
 
-vec3 CalcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor) {
+vec3 CalcSpotLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow) {
+    Light light = lights[index];
     vec3 lightDir = normalize(light.position - fragPos);
     // 漫反射着色
     float diff = max(dot(normal, lightDir), 0.0f);
@@ -150,26 +365,42 @@ vec3 CalcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 di
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
     // 合并结果
-    vec3 ambient  = light.ambient  * diffuseColor;
-    vec3 diffuse  = light.diffuse  * light.color * diff * diffuseColor;
-    vec3 specular = light.specular * light.color * spec * specularColor;
+    vec3 ambient  = light.ambient  * material.ambient * diffuseColor;
+    vec3 diffuse  = light.diffuse  * material.diffuse * light.color * diff * diffuseColor;
+    vec3 specular = light.specular * material.specular * light.color * spec * specularColor;
     ambient  *= attenuation * intensity;
     diffuse  *= attenuation * intensity;
     specular *= attenuation * intensity;
-    // 阴影
-    float shadow = shadowEnable ? ShadowCalculation(light, FragPos) : 0.0f;
     return ambient + (1.0f - min(shadow, 0.75f)) * (diffuse + specular);
 }
 
-float ShadowCalculation(Light light, vec3 fragPos)
+vec3 CalcLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shadow) {
+    int type = lights[index].type;
+    if (type == DIR_LIGHT)
+        return CalcDirLight(index, normal, viewDir, diffuseColor, specularColor, shadow);
+    if (type == POINT_LIGHT)
+        return CalcPointLight(index, normal, fragPos, viewDir, diffuseColor, specularColor, shadow);
+    if (type == SPOT_LIGHT || type == TORCH_LIGHT)
+        return CalcSpotLight(index, normal, fragPos, viewDir, diffuseColor, specularColor, shadow);
+    return vec3(0.0f);
+}
+
+uint ClusterIndex(vec3 fragPos) {
+    float depth = -(view * vec4(fragPos, 1.0f)).z;
+    uvec3 cluster = uvec3(gl_FragCoord.xy * clusterScale.xy, max(log(depth) * clusterScale.z - clusterScale.w, 0.0f));
+    cluster = min(cluster, clusterGrid.xyz - 1u);
+    return cluster.x + clusterGrid.x * (cluster.y + clusterGrid.y * cluster.z);
+}
+
+float ShadowCalculation(int index, vec3 fragPos)
 {
-    if (light != lights[0]) return 0.f;
+    Light light = lights[index];
     vec3 fragToLight = fragPos - light.position;
     float currentDepth = length(fragToLight);
 
     vec3 normal = normalize(Normal);
     vec3 lightDir = normalize(light.position - fragPos);
-    float bias = max(0.020f * (1.0f - dot(normal, lightDir)), 0.001f);
+    float bias = max(0.020f * (1.0f - dot(normal, lightDir)), 0.001f) + shadowDepthStep;
 
     float shadowValue = 0.0f;
     int samples = 20;
@@ -187,3 +418,53 @@ float ShadowCalculation(Light light, vec3 fragPos)
 
     return shadowValue;
 }
+
+float AtlasShadow(int index, vec3 fragPos, vec3 normal)
+{
+    if (index >= 16 || shadowLights[index].y == 0)
+        return 0.0f;
+    int first = shadowLights[index].x;
+    int count = shadowLights[index].y;
+    Light light = lights[index];
+
+    // 点光源按主轴选择立方体的面，平行光选择第一个包含该点的级联
+    int tile = first;
+    if (light.type == POINT_LIGHT) {
+        vec3 d = fragPos - light.position;
+        vec3 a = abs(d);
+        int face = a.x >= a.y && a.x >= a.z ? (d.x > 0.0f ? 0 : 1) :
+                   a.y >= a.z ? (d.y > 0.0f ? 2 : 3) : (d.z > 0.0f ? 4 : 5);
+        tile = first + min(face, count - 1);
+    }
+
+    vec3 lightDir = light.type == DIR_LIGHT ? normalize(-light.direction) : normalize(light.position - fragPos);
+    // 沿法线偏移，掠射角越大偏移越多
+    vec3 offsetPos = fragPos + normal * 0.01f * (1.0f - max(dot(normal, lightDir), 0.0f));
+    vec3 coord = vec3(-1.0f);
+    for (int i = 0; i < count; i++) {
+        int candidate = light.type == DIR_LIGHT ? first + i : tile;
+        vec4 clip = shadowTiles[candidate].matrix * vec4(offsetPos, 1.0f);
+        vec3 p = clip.xyz / clip.w * 0.5f + 0.5f;
+        if (clip.w > 0.0f && all(greaterThanEqual(p, vec3(0.0f))) && all(lessThanEqual(p, vec3(1.0f)))) {
+            tile = candidate;
+            coord = p;
+            break;
+        }
+        if (light.type != DIR_LIGHT)
+            break;
+    }
+    vec4 rect = shadowTiles[tile].rect;
+    if (coord.x < 0.0f || rect.z == 0.0f)  // 不在任何图块内，或图块尚未渲染
+        return 0.0f;
+
+    // 3x3 次硬件比较采样，限制在图块内半个纹素，不会采到相邻的图块
+    vec2 texel = 1.0f / vec2(textureSize(shadowAtlas, 0));
+    vec2 low = rect.xy + texel * 0.5f;
+    vec2 high = rect.xy + rect.z - texel * 0.5f;
+    vec2 uv = rect.xy + coord.xy * rect.z;
+    float lit = 0.0f;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            lit += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texel, low, high), coord.z));
+    return 1.0f - lit / 9.0f;
+}
@@ -3,14 +3,28 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+#ifdef WIREFRAME
+// 单遍线框经过 wireframe_geometry.glsl 转发给片段着色器，顶点着色器的输出改名以免与几何着色器的输出重名
+#define FragPos vFragPos
+#define TexCoords vTexCoords
+#define Normal vNormal
+#endif
+
 out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
 out vec4 FragPosLightSpace;
+// 深度预渲染与之后的光照阶段是不同的程序，按 GL_EQUAL 比较深度时位置必须逐位一致
+invariant gl_Position;
+
+layout (std140, binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float far_plane;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat4 lightSpaceMatrix;
 
 void main()
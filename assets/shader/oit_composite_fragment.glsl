@@ -0,0 +1,22 @@
+#version 430 core
+
+// 加权混合 OIT 的合成，与 screen_vertex.glsl 一起全屏绘制
+// 混合方式为 (GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA)：画面按 revealage 保留，其余为透明片元的加权平均颜色
+out vec4 FragColor;
+
+// 固定的纹理单元，与 MainRender 中的 OIT_UNIT 一致
+layout (binding = 23) uniform sampler2D oitAccum;
+layout (binding = 24) uniform sampler2D oitRevealage;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(oitRevealage, pixel, 0).r;
+    if (revealage == 1.0f)  // 没有透明片元
+        discard;
+    vec4 accum = texelFetch(oitAccum, pixel, 0);
+    // 半精度累加可能溢出，溢出时按最大值计
+    if (isinf(max(max(abs(accum.r), abs(accum.g)), max(abs(accum.b), abs(accum.a)))))
+        accum.rgb = vec3(accum.a);
+    FragColor = vec4(accum.rgb / max(accum.a, 1e-5f), revealage);
+}
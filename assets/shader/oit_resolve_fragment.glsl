@@ -0,0 +1,60 @@
+#version 430 core
+
+// 链表 OIT 的合成，与 screen_vertex.glsl 一起全屏绘制
+// 每个像素最多取最近的 MAX_LAYERS 个片元，按深度由远到近混合
+// 输出预乘的颜色与剩余的透射率，混合方式为 (GL_ONE, GL_SRC_ALPHA)
+out vec4 FragColor;
+
+layout (std430, binding = 7) readonly buffer OitHeads {
+    uint oitFragments;
+    uint oitHeads[];
+};
+layout (std430, binding = 8) readonly buffer OitNodes {
+    uvec4 oitNodes[];
+};
+uniform int oitWidth;
+
+const int MAX_LAYERS = 16;
+
+void main()
+{
+    uint node = oitHeads[uint(gl_FragCoord.y) * uint(oitWidth) + uint(gl_FragCoord.x)];
+    if (node == 0u)
+        discard;
+
+    uvec4 layers[MAX_LAYERS];
+    int count = 0;
+    for (; node != 0u; node = oitNodes[node - 1u].w) {
+        uvec4 fragment = oitNodes[node - 1u];
+        if (count < MAX_LAYERS) {
+            layers[count++] = fragment;
+            continue;
+        }
+        // 已满时替换最远的片元，超出的层数从最远处丢弃
+        int farthest = 0;
+        for (int i = 1; i < MAX_LAYERS; i++)
+            if (uintBitsToFloat(layers[i].z) > uintBitsToFloat(layers[farthest].z))
+                farthest = i;
+        if (uintBitsToFloat(fragment.z) < uintBitsToFloat(layers[farthest].z))
+            layers[farthest] = fragment;
+    }
+
+    // 插入排序，由远到近
+    for (int i = 1; i < count; i++) {
+        uvec4 fragment = layers[i];
+        int j = i - 1;
+        for (; j >= 0 && uintBitsToFloat(layers[j].z) < uintBitsToFloat(fragment.z); j--)
+            layers[j + 1] = layers[j];
+        layers[j + 1] = fragment;
+    }
+
+    vec3 color = vec3(0.0f);
+    float transmittance = 1.0f;
+    for (int i = 0; i < count; i++) {
+        vec2 rg = unpackHalf2x16(layers[i].x);
+        vec2 ba = unpackHalf2x16(layers[i].y);
+        color = mix(color, vec3(rg, ba.x), ba.y);
+        transmittance *= 1.0f - ba.y;
+    }
+    FragColor = vec4(color, transmittance);
+}
@@ -0,0 +1,21 @@
+#version 430 core
+
+// 统计填充阶段每个像素执行片元着色的次数，与 model_vertex.glsl 一起使用
+// 提前深度测试之后才计数，被深度测试剔除的片元不计入，与光照着色器实际执行的次数一致
+layout (early_fragment_tests) in;
+
+layout (std430, binding = 6) buffer Overdraw {
+    uint shadedFragments;
+    uint coveredPixels;
+    uint pixelCounts[];  // 按行排列，宽度为 overdrawWidth
+};
+
+uniform int overdrawWidth;
+
+void main()
+{
+    uint index = uint(gl_FragCoord.y) * uint(overdrawWidth) + uint(gl_FragCoord.x);
+    if (atomicAdd(pixelCounts[index], 1u) == 0u)
+        atomicAdd(coveredPixels, 1u);
+    atomicAdd(shadedFragments, 1u);
+}
\ No newline at end of file
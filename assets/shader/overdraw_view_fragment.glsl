@@ -0,0 +1,29 @@
+#version 430 core
+
+// 片元着色次数的热力图，与 screen_vertex.glsl 一起全屏绘制，没有片元的像素保留原有内容
+out vec4 FragColor;
+
+layout (std430, binding = 6) readonly buffer Overdraw {
+    uint shadedFragments;
+    uint coveredPixels;
+    uint pixelCounts[];
+};
+
+uniform int overdrawWidth;
+
+// 1 次为蓝色，依次经过青、绿、黄，8 次及以上为红色
+const vec3 palette[5] = vec3[](
+    vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f),
+    vec3(1.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f)
+);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uint count = pixelCounts[pixel.y * overdrawWidth + pixel.x];
+    if (count == 0u)
+        discard;
+    float t = clamp(float(count - 1u) / 7.0f, 0.0f, 1.0f) * 4.0f;
+    int i = min(int(t), 3);
+    FragColor = vec4(mix(palette[i], palette[i + 1], t - float(i)), 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#version 430 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+in vec3 vFragPos[];
+in vec3 vNormal[];
+in vec2 vTexCoords[];
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+noperspective out vec3 EdgeDistance; // 到三条边的屏幕距离（像素），在屏幕空间线性插值
+
+uniform vec2 viewportSize;
+
+void main()
+{
+    // 有顶点在相机之后时投影后的位置无意义，不画线框
+    bool behind = gl_in[0].gl_Position.w <= 0.0 || gl_in[1].gl_Position.w <= 0.0 || gl_in[2].gl_Position.w <= 0.0;
+    vec2 p[3];
+    for (int i = 0; i < 3; i++)
+        p[i] = gl_in[i].gl_Position.xy / gl_in[i].gl_Position.w * 0.5 * viewportSize;
+
+    // 每个顶点到对边的高 = 两倍面积 / 对边长度，对边上的点距离为 0
+    float area = abs((p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x));
+    vec3 heights = area / max(vec3(length(p[2] - p[1]), length(p[2] - p[0]), length(p[1] - p[0])), vec3(1e-6));
+
+    for (int i = 0; i < 3; i++)
+    {
+        FragPos = vFragPos[i];
+        Normal = vNormal[i];
+        TexCoords = vTexCoords[i];
+        EdgeDistance = vec3(0.0);
+        EdgeDistance[i] = heights[i];
+        if (behind)
+            EdgeDistance = vec3(1e6);
+        gl_Position = gl_in[i].gl_Position;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace bench {
+    Stats summarize(vector<double> &samples) {
+        Stats stats;
+        if (samples.empty())
+            return stats;
+
+        std::sort(samples.begin(), samples.end());
+        for (auto sample : samples)
+            stats.total += sample;
+        stats.mean = stats.total / (double)samples.size();
+        stats.p50 = samples[samples.size() / 2];
+        stats.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        return stats;
+    }
+
+    const vector<string> &assetModels() {
+        static const vector<string> models = {
+                "model/bun_zipper.ply",
+                "model/bunny_iH.ply2",
+                "model/bunny/bunny.obj",
+                "model/bunny_texture/bunny.obj",
+                "model/nanosuit/nanosuit.obj",
+                "model/cube.ply",
+                "model/cube.obj",
+                "model/sphere.ply",
+                "model/plane.ply",
+        };
+        return models;
+    }
+
+    Model *loadModel(const string &assetRoot, const string &path, bool headless) {
+        return new Model(assetRoot + "/" + path, headless);
+    }
+
+    void forEachAsset(const string &assetRoot, const std::function<void(const string &, Model &)> &callback,
+                      bool headless) {
+        for (auto &path : assetModels()) {
+            std::unique_ptr<Model> model;
+            try {
+                model.reset(loadModel(assetRoot, path, headless));
+            }
+            catch (std::runtime_error &ex) {
+                std::cerr << path << ": " << ex.what() << std::endl;
+                continue;
+            }
+            callback(path, *model);
+        }
+    }
+
+    Model *makeScan(unsigned int size, bool headless) {
+        vector<VertexData> vertices(size * size);
+        vector<unsigned int> indices;
+        vector<Face> faces;
+        MeshInfo meshInfo;
+
+        // 起伏的高度场，覆盖 [-0.9, 0.9] 范围，与模型标准化后的尺寸一致
+        for (unsigned int y = 0; y < size; y++) {
+            for (unsigned int x = 0; x < size; x++) {
+                auto u = (float)x / (float)(size - 1);
+                auto v = (float)y / (float)(size - 1);
+                auto &vertex = vertices[y * size + x];
+                vertex.position = glm::vec3(u * 1.8f - 0.9f, v * 1.8f - 0.9f,
+                                            0.1f * std::sin(u * 25.f) * std::cos(v * 17.f));
+                vertex.normal = glm::vec3(0.f, 0.f, 1.f);
+                vertex.texCoord = glm::vec2(u, v);
+            }
+        }
+
+        indices.reserve((size_t)(size - 1) * (size - 1) * 6);
+        faces.reserve((size_t)(size - 1) * (size - 1) * 2);
+        for (unsigned int y = 0; y + 1 < size; y++) {
+            for (unsigned int x = 0; x + 1 < size; x++) {
+                auto i0 = y * size + x;
+                Face f0{{i0, i0 + 1, i0 + size + 1}};
+                Face f1{{i0, i0 + size + 1, i0 + size}};
+                for (auto &f : {f0, f1}) {
+                    faces.push_back(f);
+                    indices.insert(indices.end(), f.vertex, f.vertex + 3);
+                }
+            }
+        }
+
+        meshInfo.minVertex = glm::vec3(-0.9f, -0.9f, -0.1f);
+        meshInfo.maxVertex = glm::vec3(0.9f, 0.9f, 0.1f);
+
+        auto model = new Model();
+        model->meshes.emplace_back(vertices, indices, faces, vector<Texture>(), meshInfo, headless);
+        return model;
+    }
+
+    vector<double> gpuTimes(int frames, const vector<std::function<void()>> &passes) {
+        vector<GLuint> queries(passes.size());
+        glGenQueries((GLsizei)queries.size(), queries.data());
+        vector<double> times(passes.size(), 0.0);
+        for (int frame = -1; frame < frames; frame++) {
+            for (size_t i = 0; i < passes.size(); i++) {
+                glFinish();  // 之前的命令执行完，不计入这一阶段
+                glBeginQuery(GL_TIME_ELAPSED, queries[i]);
+                passes[i]();
+                glEndQuery(GL_TIME_ELAPSED);
+            }
+            for (size_t i = 0; i < passes.size() && frame >= 0; i++) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+                times[i] += (double)elapsed / 1e6;
+            }
+        }
+        glDeleteQueries((GLsizei)queries.size(), queries.data());
+        for (auto &time : times)
+            time /= frames;
+        return times;
+    }
+
+    vector<double> finishTimes(int frames, const vector<std::function<void()>> &passes) {
+        vector<double> times(passes.size(), 0.0);
+        for (int frame = -1; frame < frames; frame++) {
+            for (size_t i = 0; i < passes.size(); i++) {
+                glFinish();
+                Timer timer;
+                passes[i]();
+                glFinish();
+                if (frame >= 0)
+                    times[i] += timer.elapsed();
+            }
+        }
+        for (auto &time : times)
+            time /= frames;
+        return times;
+    }
+
+    vector<unsigned char> readPixels(int width, int height) {
+        vector<unsigned char> pixels((size_t)width * height * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return pixels;
+    }
+
+    ImageDiff compareImages(const vector<unsigned char> &a, const vector<unsigned char> &b) {
+        ImageDiff diff;
+        for (size_t i = 0; i + 3 < a.size() && i + 3 < b.size(); i += 4) {
+            int pixel = 0;
+            for (int c = 0; c < 3; c++)
+                pixel = std::max(pixel, std::abs((int)a[i + c] - (int)b[i + c]));
+            diff.maxDiff = std::max(diff.maxDiff, pixel);
+            diff.pixels += pixel > 0;
+        }
+        return diff;
+    }
+
+    bool softwareRenderer() {
+        auto renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+        if (!renderer)
+            return false;
+        string name = renderer;
+        for (auto software : {"llvmpipe", "softpipe", "SwiftShader", "Software", "GDI Generic"})
+            if (name.find(software) != string::npos)
+                return true;
+        return false;
+    }
+
+    glm::mat4 viewMatrix() {
+        return glm::lookAt(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, 2.f), glm::vec3(0.f, 1.f, 0.f));
+    }
+
+    glm::mat4 projectionMatrix() {
+        return glm::perspective(glm::radians(45.f), (float)WIDTH / (float)HEIGHT, 0.1f, 1000.f);
+    }
+}
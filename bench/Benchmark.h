@@ -0,0 +1,107 @@
+#ifndef MODEL_VIEWER_BENCHMARK_H
+#define MODEL_VIEWER_BENCHMARK_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "util/opengl/Model.h"
+
+using std::string;
+using std::vector;
+
+/// 无窗口基准测试公共工具
+namespace bench {
+    /// 与主窗口一致的默认视口与相机参数
+    constexpr int WIDTH = 1400;
+    constexpr int HEIGHT = 800;
+
+    struct Stats {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p99 = 0.0;
+        double total = 0.0;
+    };
+
+    class Timer {
+    public:
+        Timer() : m_start(std::chrono::steady_clock::now()) { }
+
+        /// \return 自创建以来经过的毫秒数
+        [[nodiscard]] double elapsed() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /// 统计一组耗时样本（毫秒），会对样本排序
+    Stats summarize(vector<double> &samples);
+
+    /// 内置模型列表（相对于资源目录）
+    const vector<string> &assetModels();
+
+    /// 加载模型，headless 为 false 时创建顶点缓冲与纹理，需要 OpenGL 上下文
+    Model *loadModel(const string &assetRoot, const string &path, bool headless = true);
+
+    /// 依次加载每个内置模型并回调，加载失败的模型输出错误后跳过
+    void forEachAsset(const string &assetRoot, const std::function<void(const string &, Model &)> &callback,
+                      bool headless = true);
+
+    /// 生成模拟扫描数据的高度场网格
+    /// \param size 每边顶点数，顶点总数为 size * size
+    Model *makeScan(unsigned int size, bool headless = true);
+
+    /// 主窗口默认相机下的观察与投影矩阵
+    glm::mat4 viewMatrix();
+    glm::mat4 projectionMatrix();
+
+    /// 不显示窗口的 OpenGL 上下文，供需要 GPU 的基准测试使用
+    /// 构建时没有找到 GLFW 或无法创建上下文时返回 false
+    bool createContext();
+    void destroyContext();
+
+    /// 每帧依次执行 passes，分别以 GL_TIME_ELAPSED 查询计时，第一帧预热不计入
+    /// \return 每个阶段 frames 帧的平均 GPU 耗时（毫秒）
+    vector<double> gpuTimes(int frames, const vector<std::function<void()>> &passes);
+    /// 与 gpuTimes 相同，但每个阶段前后都以 glFinish 等待并按墙钟计时
+    /// 软件光栅化在 glFinish 时才执行绘制，计时查询只统计到提交
+    vector<double> finishTimes(int frames, const vector<std::function<void()>> &passes);
+
+    /// 读回当前读帧缓冲左下角 width x height 的颜色（RGBA8）
+    vector<unsigned char> readPixels(int width = WIDTH, int height = HEIGHT);
+
+    struct ImageDiff {
+        int maxDiff = 0;  // 单个通道的最大差（0-255）
+        size_t pixels = 0;  // 有差异的像素数
+    };
+
+    /// 逐像素比较两张 readPixels 的结果，只比较 RGB
+    ImageDiff compareImages(const vector<unsigned char> &a, const vector<unsigned char> &b);
+
+    /// 当前上下文是否为软件光栅化（llvmpipe 等），此时的耗时不代表 GPU 硬件
+    bool softwareRenderer();
+
+    int runSnap(const string &assetRoot);
+    int runRegion(const string &assetRoot);
+    int runRay(const string &assetRoot);
+    int runWeld(const string &assetRoot);
+    int runFace(const string &assetRoot);
+    int runTopology(const string &assetRoot);
+    int runSelection(const string &assetRoot);
+    int runShading(const string &assetRoot);
+    int runShadow(const string &assetRoot);
+    int runAtlas(const string &assetRoot);
+    int runClusters(const string &assetRoot);
+    int runDeferred(const string &assetRoot);
+    int runPrepass(const string &assetRoot);
+    int runLamp(const string &assetRoot);
+    int runWireframe(const string &assetRoot);
+    int runTransparency(const string &assetRoot);
+    int runProfiler(const string &assetRoot);
+}
+
+#endif //MODEL_VIEWER_BENCHMARK_H
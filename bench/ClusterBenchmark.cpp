@@ -0,0 +1,291 @@
+#include "Benchmark.h"
+#include "util/LightClusters.h"
+#include "util/LightFactory.h"
+#include "util/Parallel.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Clusters 缓冲头部以及 Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct ClusterHeader {
+            glm::uvec4 grid;
+            glm::vec4 scale;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        // 逐灯光的着色在软件光栅化上很慢，GPU 对比使用四分之一的像素
+        constexpr int SHADING_WIDTH = WIDTH / 2;
+        constexpr int SHADING_HEIGHT = HEIGHT / 2;
+        constexpr int SHADING_FRAMES = 2;
+        // 分块省略光照低于 CUTOFF（1/256）的灯光，灯光密集处多个省略的灯光叠加，再加上求和顺序的差异
+        constexpr int SHADING_TOLERANCE = 4;
+    }
+
+    /// 在相机前方随机放置点光与聚光（四分之一），影响范围 0.3 到 1.5
+    static vector<LightData> makeLights(size_t count) {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> x(-4.f, 4.f), y(-3.f, 3.f), z(-6.f, 2.5f), unit(0.f, 1.f);
+        vector<LightData> lights(count);
+        for (size_t i = 0; i < count; i++) {
+            auto &light = lights[i];
+            light = LightData{};
+            light.position = glm::vec3(x(random), y(random), z(random));
+            light.type = i % 4 == 3 ? SPOT_LIGHT : POINT_LIGHT;
+            light.direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f);
+            light.cutOff = std::cos(glm::radians(20.f));
+            light.outerCutOff = std::cos(glm::radians(30.f));
+            light.color = glm::vec3(unit(random), unit(random), unit(random));
+            light.diffuse = glm::vec3(1.f);
+            light.specular = glm::vec3(0.5f);
+            light.constant = 1.f;
+            auto range = 0.3f + 1.2f * unit(random);
+            light.quadratic = (1.f / LightClusters::CUTOFF - 1.f) / (range * range);
+        }
+        return lights;
+    }
+
+    /// 光照不低于 CUTOFF 的采样点，必须出现在所在分块的列表中
+    static size_t missingLights(const LightClusters &clusters, const vector<LightData> &lights,
+                                const glm::mat4 &view, const glm::mat4 &projection) {
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> ndc(-1.f, 1.f), depth(std::log(0.1f), std::log(20.f));
+        auto inverseView = glm::inverse(view);
+        size_t missing = 0;
+        for (int sample = 0; sample < 20000; sample++) {
+            glm::vec2 p(ndc(random), ndc(random));
+            auto d = std::exp(depth(random));
+            glm::vec3 viewPos(p.x * d / projection[0][0], p.y * d / projection[1][1], -d);
+            auto world = glm::vec3(inverseView * glm::vec4(viewPos, 1.f));
+
+            auto range = clusters.ranges()[clusters.clusterIndex(p, d)];
+            auto begin = clusters.indices().begin() + range.x, end = begin + range.y;
+            for (uint32_t i = 0; i < lights.size(); i++) {
+                auto &light = lights[i];
+                auto offset = world - light.position;
+                auto distance = glm::length(offset);
+                if (distance > LightClusters::lightRange(light) * 0.999f)
+                    continue;
+                if (light.type == SPOT_LIGHT && glm::dot(offset / distance, light.direction) < light.outerCutOff)
+                    continue;
+                if (std::find(begin, end, i) == end)
+                    missing++;
+            }
+        }
+        return missing;
+    }
+
+    /// 扫描网格表面上方的点光与聚光（四分之一，照向表面），影响范围 0.12（与 MainRender 的采样灯光一样为模型尺寸的 5%），世界坐标
+    static vector<LightData> surfaceLights(size_t count) {
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> coordinate(-0.9f, 0.9f), unit(0.f, 1.f);
+        vector<LightData> lights(count);
+        for (size_t i = 0; i < count; i++) {
+            auto &light = lights[i];
+            light = LightData{};
+            light.position = glm::vec3(coordinate(random), coordinate(random), 0.12f);
+            light.type = i % 4 == 3 ? SPOT_LIGHT : POINT_LIGHT;
+            light.direction = glm::vec3(0.f, 0.f, -1.f);
+            light.cutOff = std::cos(glm::radians(30.f));
+            light.outerCutOff = std::cos(glm::radians(45.f));
+            light.color = glm::vec3(unit(random), unit(random), unit(random));
+            light.diffuse = glm::vec3(1.f);
+            light.specular = glm::vec3(0.5f);
+            light.constant = 1.f;
+            light.quadratic = (1.f / LightClusters::CUTOFF - 1.f) / (0.12f * 0.12f);
+        }
+        return lights;
+    }
+
+    /// 同一场景分别以遍历全部灯光与遍历分块列表着色，读回画面比较
+    static int compareShading(const string &assetRoot) {
+        std::cout << "GPU shading: brute force vs clustered (" << SHADING_WIDTH << "x" << SHADING_HEIGHT
+                  << ", scan 256x256, lights on the surface, mean of " << SHADING_FRAMES << " frames)" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        ShaderVariants variants(assetRoot + "/shader/model_vertex.glsl", assetRoot + "/shader/model_fragment.glsl");
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SHADING_WIDTH, SHADING_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SHADING_WIDTH, SHADING_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, SHADING_WIDTH, SHADING_HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        GpuBuffer frameBuffer, materialBuffer;
+        GpuBuffer clusterBuffer{GL_SHADER_STORAGE_BUFFER}, clusterLightBuffer{GL_SHADER_STORAGE_BUFFER};
+        FrameData frame{view, projection, glm::vec3(0.f, 0.f, 3.f), 1000.f};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.update(0, &material, sizeof(material));
+        materialBuffer.bindBase(MATERIAL_BINDING);
+
+        std::unique_ptr<Model> scan(makeScan(256, false));
+        auto &factory = LightFactory::get();
+        LightClusters clusters;
+        int result = 0;
+        std::cout << std::left << std::setw(10) << "Lights" << std::right << std::setw(14) << "Brute(ms)"
+                  << std::setw(14) << "Clustered(ms)" << std::setw(10) << "Speedup" << std::setw(10) << "Max diff"
+                  << std::setw(10) << "Pixels" << std::endl;
+        for (size_t count : {100, 500}) {
+            factory.reset();
+            factory.setSampledLights(surfaceLights(count));
+            factory.updateBuffer();
+            clusters.build(factory.lightData(), factory.lightCount(), view, projection, 0.1f, 1000.f);
+            auto &grid = clusters.grid;
+            ClusterHeader header{glm::uvec4(grid.x, grid.y, grid.z, 0),
+                                 glm::vec4((float)grid.x / SHADING_WIDTH, (float)grid.y / SHADING_HEIGHT,
+                                           clusters.depthScale(), clusters.depthBias())};
+            auto &ranges = clusters.ranges();
+            auto &indices = clusters.indices();
+            clusterBuffer.allocate(sizeof(header) + ranges.size() * sizeof(glm::uvec2));
+            clusterBuffer.update(0, &header, sizeof(header));
+            clusterBuffer.update(sizeof(header), ranges.data(), ranges.size() * sizeof(glm::uvec2));
+            clusterLightBuffer.allocate(std::max<size_t>(indices.size(), 1) * sizeof(uint32_t));
+            clusterLightBuffer.update(0, indices.data(), indices.size() * sizeof(uint32_t));
+            clusterBuffer.bindBase(CLUSTER_BINDING);
+            clusterLightBuffer.bindBase(CLUSTER_LIGHT_BINDING);
+
+            // 两种方式都使用特化的程序，只有灯光循环不同
+            ShaderPermutation permutation;
+            permutation.dirLights = factory.dirLightCount();
+            permutation.pointLights = factory.pointLightCount();
+            permutation.spotLights = factory.spotLightCount();
+            auto brute = variants.get(permutation);
+            permutation.pointLights = permutation.spotLights = 0;
+            permutation.clustered = true;
+            auto clustered = variants.get(permutation);
+            if (!brute || !clustered) {
+                std::cerr << "variant failed to compile" << std::endl;
+                result = 1;
+                break;
+            }
+            auto draw = [&](ShaderProgram *program) {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                program->use(glm::mat4(1.f), view, projection);
+                program->setValue("shadowLight", -1);
+                program->setValue("atlasShadows", false);
+                program->setValue("clustered", program == clustered);
+                program->setValue("dirLightCount", factory.dirLightCount());
+                scan->render(program, false, false);
+            };
+
+            auto bruteTime = finishTimes(SHADING_FRAMES, {[&]() { draw(brute); }})[0];
+            auto bruteImage = readPixels(SHADING_WIDTH, SHADING_HEIGHT);
+            auto clusteredTime = finishTimes(SHADING_FRAMES, {[&]() { draw(clustered); }})[0];
+            auto diff = compareImages(bruteImage, readPixels(SHADING_WIDTH, SHADING_HEIGHT));
+            std::cout << std::left << std::setw(10) << factory.lightCount() << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(14) << bruteTime << std::setw(14) << clusteredTime
+                      << std::setprecision(2) << std::setw(9) << bruteTime / clusteredTime << "x"
+                      << std::setw(10) << diff.maxDiff << std::setw(10) << diff.pixels << std::defaultfloat
+                      << std::endl;
+            if (diff.maxDiff > SHADING_TOLERANCE) {
+                std::cerr << "  clustered shading differs from brute force by more than " << SHADING_TOLERANCE
+                          << "/255" << std::endl;
+                result = 1;
+            }
+        }
+
+        factory.reset();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        return result;
+    }
+
+    int runClusters(const string &assetRoot) {
+        auto view = viewMatrix(), projection = projectionMatrix();
+        std::cout << "Light clusters (16x9x24, " << parallel::workerCount() << " workers)" << std::endl;
+        std::cout << std::left << std::setw(10) << "Lights" << std::right
+                  << std::setw(12) << "Visible"
+                  << std::setw(12) << "Indices"
+                  << std::setw(10) << "Max"
+                  << std::setw(14) << "Scalar(ms)"
+                  << std::setw(12) << "SIMD(ms)"
+                  << std::setw(14) << "Threads(ms)"
+                  << std::setw(10) << "Missing" << std::endl;
+
+        int result = 0;
+        for (size_t count : {1000, 10000}) {
+            auto lights = makeLights(count);
+            LightClusters clusters;
+            auto measure = [&](bool simd, bool threads) {
+                clusters.simd = simd;
+                clusters.threads = threads;
+                vector<double> samples;
+                for (int i = 0; i < 50; i++) {
+                    clusters.build(lights.data(), lights.size(), view, projection, 0.1f, 1000.f);
+                    samples.push_back(clusters.buildTime);
+                }
+                return summarize(samples).p50;
+            };
+
+            auto scalar = measure(false, false);
+            auto reference = clusters.indices();
+            auto referenceRanges = clusters.ranges();
+            auto simd = measure(true, false);
+            auto threaded = measure(true, true);
+            // 三种方式的结果必须完全一致
+            bool same = clusters.indices() == reference && clusters.ranges() == referenceRanges;
+            auto missing = missingLights(clusters, lights, view, projection);
+
+            std::cout << std::left << std::setw(10) << count << std::right
+                      << std::setw(12) << clusters.visibleLights
+                      << std::setw(12) << clusters.indices().size()
+                      << std::setw(10) << clusters.maxClusterLights
+                      << std::setw(14) << std::fixed << std::setprecision(3) << scalar
+                      << std::setw(12) << simd
+                      << std::setw(14) << threaded
+                      << std::setw(10) << missing << std::endl;
+            if (!same) {
+                std::cerr << "  SIMD or threaded assignment differs from scalar" << std::endl;
+                result = 1;
+            }
+            if (missing > 0)
+                result = 1;
+        }
+        std::cout << std::endl;
+        if (compareShading(assetRoot))
+            result = 1;
+        return result;
+    }
+}
@@ -0,0 +1,257 @@
+#include "Benchmark.h"
+#include "util/LightClusters.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GBuffer.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <random>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Clusters 缓冲头部以及 Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct ClusterHeader {
+            glm::uvec4 grid;
+            glm::vec4 scale;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        constexpr int FRAMES = 10;
+        constexpr float NEAR_PLANE = 0.1f;
+        constexpr float FAR_PLANE = 1000.f;
+        constexpr int GBUFFER_UNIT = 25;  // 与 model_fragment.glsl 一致
+        constexpr int TOLERANCE = 1;  // 延迟与前向画面允许的通道差（0-255），光照计算相同，只有 G-buffer 的精度不同
+
+        /// 与 MainRender::sampleLights 相同：随机顶点处沿法线偏移的点光与聚光（四分之一，照向表面），
+        /// 影响范围为模型尺寸的 5%，直接给出世界坐标
+        vector<LightData> sampleLights(const Model &model, const glm::mat4 &matrix, size_t count) {
+            vector<std::pair<glm::vec3, glm::vec3>> points;
+            glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+            auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+            for (auto &mesh : model.meshes) {
+                for (auto &vertex : mesh.getVertices()) {
+                    auto position = glm::vec3(matrix * glm::vec4(vertex.position, 1.f));
+                    points.emplace_back(position, glm::normalize(normalMatrix * vertex.normal));
+                    low = glm::min(low, position);
+                    high = glm::max(high, position);
+                }
+            }
+            vector<LightData> lights;
+            if (points.empty() || count == 0)
+                return lights;
+            auto range = glm::length(high - low) * 0.05f;
+
+            std::mt19937 random((unsigned int)count);
+            std::uniform_int_distribution<size_t> pick(0, points.size() - 1);
+            std::uniform_real_distribution<float> unit(0.f, 1.f);
+            lights.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                auto &[position, normal] = points[pick(random)];
+                auto &light = lights[i];
+                light = LightData{};
+                light.type = i % 4 == 3 ? SPOT_LIGHT : POINT_LIGHT;
+                light.position = position + normal * range * 0.2f;
+                light.direction = -normal;
+                light.cutOff = std::cos(glm::radians(30.f));
+                light.outerCutOff = std::cos(glm::radians(45.f));
+                glm::vec3 color(unit(random), unit(random), unit(random));
+                light.color = color / std::max(std::max(color.r, color.g), std::max(color.b, 0.01f));
+                light.diffuse = glm::vec3(1.f);
+                light.specular = glm::vec3(0.5f);
+                light.constant = 1.f;
+                light.quadratic = (1.f / LightClusters::CUTOFF - 1.f) / (range * range);
+            }
+            return lights;
+        }
+    }
+
+    int runDeferred(const string &assetRoot) {
+        std::cout << "== deferred: forward vs deferred shading (" << WIDTH << "x" << HEIGHT
+                  << ", clustered lights sampled on the surface, GPU mean of " << FRAMES << " frames) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        auto fragmentPath = assetRoot + "/shader/model_fragment.glsl";
+        ShaderVariants forwardVariants(assetRoot + "/shader/model_vertex.glsl", fragmentPath);
+        ShaderVariants deferredVariants(assetRoot + "/shader/screen_vertex.glsl", fragmentPath);
+        ShaderProgram gbufferShader;
+        gbufferShader.load(assetRoot + "/shader/model_vertex.glsl", assetRoot + "/shader/gbuffer_fragment.glsl");
+        if (!gbufferShader.linked()) {
+            std::cerr << gbufferShader.lastError() << std::endl;
+            return 1;
+        }
+
+        // 前向渲染与光照阶段的目标
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+
+        GBuffer gbuffer;
+        gbuffer.allocate(WIDTH, HEIGHT);
+        GLuint screenVao;
+        glGenVertexArrays(1, &screenVao);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        GpuBuffer frameBuffer, materialBuffer;
+        GpuBuffer clusterBuffer{GL_SHADER_STORAGE_BUFFER}, clusterLightBuffer{GL_SHADER_STORAGE_BUFFER};
+        FrameData frame{view, projection, glm::vec3(0.f, 0.f, 3.f), FAR_PLANE};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.update(0, &material, sizeof(material));
+
+        auto &factory = LightFactory::get();
+        LightClusters clusters;
+        int result = 0;
+        std::cout << std::left << std::setw(30) << "model" << std::right << std::setw(10) << "faces"
+                  << std::setw(9) << "sampled" << std::setw(13) << "forward ms" << std::setw(13) << "G-buffer ms"
+                  << std::setw(13) << "lighting ms" << std::setw(13) << "deferred ms" << std::setw(10) << "speedup"
+                  << std::setw(10) << "max diff" << std::endl;
+
+        auto measure = [&](const string &name, Model &model, const glm::mat4 &matrix) {
+            size_t faces = 0;
+            for (auto &mesh : model.meshes)
+                faces += mesh.getFaces().size();
+
+            for (size_t count : {0, 1000}) {
+                factory.reset();
+                factory.setSampledLights(sampleLights(model, matrix, count));
+                factory.updateBuffer();
+                clusters.build(factory.lightData(), factory.lightCount(), view, projection, NEAR_PLANE, FAR_PLANE);
+                auto &grid = clusters.grid;
+                ClusterHeader header{glm::uvec4(grid.x, grid.y, grid.z, 0),
+                                     glm::vec4((float)grid.x / WIDTH, (float)grid.y / HEIGHT,
+                                               clusters.depthScale(), clusters.depthBias())};
+                auto &ranges = clusters.ranges();
+                auto &indices = clusters.indices();
+                clusterBuffer.allocate(sizeof(header) + ranges.size() * sizeof(glm::uvec2));
+                clusterBuffer.update(0, &header, sizeof(header));
+                clusterBuffer.update(sizeof(header), ranges.data(), ranges.size() * sizeof(glm::uvec2));
+                clusterLightBuffer.allocate(std::max<size_t>(indices.size(), 1) * sizeof(uint32_t));
+                clusterLightBuffer.update(0, indices.data(), indices.size() * sizeof(uint32_t));
+                clusterBuffer.bindBase(CLUSTER_BINDING);
+                clusterLightBuffer.bindBase(CLUSTER_LIGHT_BINDING);
+                materialBuffer.bindBase(MATERIAL_BINDING);
+
+                ShaderPermutation permutation;
+                permutation.dirLights = factory.dirLightCount();
+                permutation.clustered = true;
+                ShaderProgram *forwardPrograms[2];
+                for (bool texture : {false, true}) {
+                    permutation.texture = texture;
+                    forwardPrograms[texture] = forwardVariants.get(permutation);
+                }
+                permutation.texture = false;
+                permutation.deferred = true;
+                auto lighting = deferredVariants.get(permutation);
+                if (!forwardPrograms[0] || !forwardPrograms[1] || !lighting) {
+                    std::cerr << "variant failed to compile" << std::endl;
+                    result = 1;
+                    return;
+                }
+                auto setCommon = [&](ShaderProgram &program) {
+                    program.setValue("shadowLight", -1);
+                    program.setValue("atlasShadows", false);
+                    program.setValue("clustered", true);
+                    program.setValue("dirLightCount", factory.dirLightCount());
+                };
+
+                auto forward = gpuTimes(FRAMES, {[&]() {
+                    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    for (size_t i = 0; i < model.meshes.size(); i++) {
+                        auto program = forwardPrograms[!model.meshes[i].getTextures().empty()];
+                        program->use(matrix, view, projection);
+                        setCommon(*program);
+                        model.renderMesh(i, program, false, false);
+                    }
+                }});
+                auto forwardImage = readPixels();
+
+                auto deferred = gpuTimes(FRAMES, {[&]() {
+                    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.framebuffer());
+                    gbuffer.clear();
+                    gbufferShader.use(matrix, view, projection);
+                    model.render(&gbufferShader, false, false);
+                }, [&]() {
+                    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    lighting->use();
+                    lighting->setValue("inverseViewProjection", glm::inverse(projection * view));
+                    setCommon(*lighting);
+                    gbuffer.bindTextures(GBUFFER_UNIT);
+                    glDepthFunc(GL_ALWAYS);
+                    glBindVertexArray(screenVao);
+                    glDrawArrays(GL_TRIANGLES, 0, 3);
+                    glBindVertexArray(0);
+                    glDepthFunc(GL_LESS);
+                }});
+
+                auto diff = compareImages(forwardImage, readPixels());
+                auto deferredTotal = deferred[0] + deferred[1];
+                std::cout << std::left << std::setw(30) << name << std::right << std::setw(10) << faces
+                          << std::setw(9) << factory.sampledLightCount() << std::fixed << std::setprecision(3)
+                          << std::setw(13) << forward[0] << std::setw(13) << deferred[0] << std::setw(13) << deferred[1]
+                          << std::setw(13) << deferredTotal << std::setprecision(2) << std::setw(9)
+                          << forward[0] / deferredTotal << "x" << std::setw(10) << diff.maxDiff << std::defaultfloat
+                          << std::endl;
+                if (diff.maxDiff > TOLERANCE) {
+                    std::cerr << "  deferred shading differs from forward by more than " << TOLERANCE << "/255 ("
+                              << diff.pixels << " pixels)" << std::endl;
+                    result = 1;
+                }
+            }
+        };
+
+        std::unique_ptr<Model> scan(makeScan(512, false));
+        measure("scan 512x512", *scan, glm::mat4(1.f));
+        forEachAsset(assetRoot, [&](const string &path, Model &model) {
+            measure(path, model, model.basisTransform);
+        }, false);
+
+        factory.reset();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteVertexArrays(1, &screenVao);
+        return result;
+    }
+}
@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+#include "util/FaceLookup.h"
+#include "util/opengl/PolygonTriangle.h"
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    /// 随机面上的高亮切换，按三个顶点序号查找，与右键高亮的路径一致
+    static void faceModel(const string &name, Model &model, size_t toggles) {
+        size_t faceCount = 0;
+        for (auto &mesh : model.meshes)
+            faceCount += mesh.getFaces().size();
+
+        Timer buildTimer;
+        FaceLookup lookup(model.meshes);
+        auto buildTime = buildTimer.elapsed();
+
+        PolygonTriangle triangles(model.meshes, lookup, true);
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> meshDist(0, model.meshes.size() - 1);
+
+        // 预先生成切换序列，计时只包含切换本身
+        struct Toggle {
+            int meshIndex;
+            unsigned int vertex[3];
+        };
+        vector<Toggle> sequence(toggles);
+        for (auto &item : sequence) {
+            item.meshIndex = (int)meshDist(random);
+            const auto &faces = model.meshes[item.meshIndex].getFaces();
+            auto face = std::uniform_int_distribution<size_t>(0, faces.size() - 1)(random);
+            std::copy(faces[face].vertex, faces[face].vertex + 3, item.vertex);
+        }
+
+        Timer toggleTimer;
+        for (auto &item : sequence)
+            triangles.modifyIndices(item.meshIndex, item.vertex[0], item.vertex[1], item.vertex[2]);
+        auto toggleTime = toggleTimer.elapsed();
+
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::setw(10) << faceCount
+                  << std::setw(12) << std::fixed << std::setprecision(2) << buildTime
+                  << std::setw(12) << std::setprecision(0) << toggles / (toggleTime / 1000.0)
+                  << std::setw(10) << std::setprecision(1) << toggleTime * 1e6 / toggles
+                  << std::setw(12) << triangles.triangleCount() << std::endl;
+    }
+
+    int runFace(const string &assetRoot) {
+        constexpr size_t TOGGLES = 1000000;
+        std::cout << "== face lookup + triangle highlight (" << TOGGLES << " toggles)" << std::endl;
+        std::cout << std::left << std::setw(32) << "model" << std::right
+                  << std::setw(10) << "faces" << std::setw(12) << "build ms"
+                  << std::setw(12) << "toggles/s" << std::setw(10) << "ns" << std::setw(12) << "highlighted"
+                  << std::endl;
+
+        forEachAsset(assetRoot, [](const string &path, Model &model) {
+            faceModel(path, model, TOGGLES);
+        });
+        for (auto size : {1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            faceModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model, TOGGLES);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,46 @@
+#include "Benchmark.h"
+#include "glad/glad.h"
+
+#ifdef BENCH_GL
+#include <GLFW/glfw3.h>
+
+namespace bench {
+    static GLFWwindow *contextWindow = nullptr;
+
+    bool createContext() {
+        if (contextWindow)
+            return true;
+        if (!glfwInit())
+            return false;
+        // 与主窗口相同的 4.3 核心模式，窗口不显示，渲染到帧缓冲对象
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        contextWindow = glfwCreateWindow(64, 64, "model-viewer-bench", nullptr, nullptr);
+        if (!contextWindow) {
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(contextWindow);
+        return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    }
+
+    void destroyContext() {
+        if (!contextWindow)
+            return;
+        glfwDestroyWindow(contextWindow);
+        glfwTerminate();
+        contextWindow = nullptr;
+    }
+}
+#else
+namespace bench {
+    bool createContext() {
+        return false;
+    }
+
+    void destroyContext() {
+    }
+}
+#endif
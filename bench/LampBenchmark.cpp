@@ -0,0 +1,192 @@
+#include "Benchmark.h"
+#include "util/LightClusters.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GpuBuffer.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        constexpr int FRAMES = 20;
+        constexpr float FAR_PLANE = 1000.f;
+
+        /// 改为实例化绘制之前的灯光着色器，每个灯光单独设置模型矩阵与颜色
+        const char *LEGACY_VERTEX = R"(#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (std140, binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float far_plane;
+};
+uniform mat4 model;
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+})";
+
+        const char *LEGACY_FRAGMENT = R"(#version 430 core
+out vec4 FragColor;
+uniform vec3 lightColor;
+void main()
+{
+    FragColor = vec4(lightColor, 1.f);
+})";
+
+        /// 分布在相机前方的点光，颜色的最大分量为 1，影响范围 0.5（灯光模型的缩放为 0.025）
+        vector<LightData> scatterLights(size_t count) {
+            std::mt19937 random((unsigned int)count);
+            std::uniform_real_distribution<float> unit(0.f, 1.f);
+            vector<LightData> lights(count);
+            for (auto &light : lights) {
+                light = LightData{};
+                light.type = POINT_LIGHT;
+                light.position = glm::vec3(unit(random) * 4.f - 2.f, unit(random) * 2.4f - 1.2f, -unit(random) * 2.f);
+                glm::vec3 color(unit(random), unit(random), unit(random));
+                light.color = color / std::max(std::max(color.r, color.g), std::max(color.b, 0.01f));
+                light.diffuse = glm::vec3(1.f);
+                light.constant = 1.f;
+                light.quadratic = (1.f / LightClusters::CUTOFF - 1.f) / 0.25f;
+            }
+            return lights;
+        }
+
+        struct FrameTime {
+            double submit = 0.0;  // 提交绘制命令的 CPU 耗时
+            double total = 0.0;  // 包括等待 GPU 完成
+        };
+
+        /// 每帧的平均耗时（毫秒），第一帧预热不计入
+        FrameTime frameTime(const std::function<void()> &draw) {
+            FrameTime time;
+            for (int frame = 0; frame <= FRAMES; frame++) {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glFinish();
+                Timer timer;
+                draw();
+                auto submit = timer.elapsed();
+                glFinish();
+                if (frame > 0) {
+                    time.submit += submit / FRAMES;
+                    time.total += timer.elapsed() / FRAMES;
+                }
+            }
+            return time;
+        }
+    }
+
+    int runLamp(const string &assetRoot) {
+        std::cout << "== lamps: per-light draws vs one instanced draw (" << WIDTH << "x" << HEIGHT
+                  << ", sphere gizmos, mean of " << FRAMES << " frames) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        std::unique_ptr<Model> sphere(loadModel(assetRoot, "model/sphere.ply", false));
+        ShaderProgram legacyShader, lampShader;
+        legacyShader.addShader(ShaderProgram::Vertex, LEGACY_VERTEX);
+        legacyShader.addShader(ShaderProgram::Fragment, LEGACY_FRAGMENT);
+        legacyShader.link();
+        lampShader.load(assetRoot + "/shader/lamp_vertex.glsl", assetRoot + "/shader/lamp_fragment.glsl");
+        for (auto *program : {&legacyShader, &lampShader}) {
+            if (!program->linked()) {
+                std::cerr << program->lastError() << std::endl;
+                return 1;
+            }
+        }
+
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        GpuBuffer frameBuffer;
+        FrameData frame{view, projection, glm::vec3(0.f, 0.f, 3.f), FAR_PLANE};
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+
+        auto &factory = LightFactory::get();
+        factory.reset();
+        factory.deleteLight(0);
+        factory.setBaseModel(sphere.get());
+        factory.showSampledLamps = true;
+
+        std::cout << std::left << std::setw(10) << "lamps" << std::right << std::setw(12) << "submit ms"
+                  << std::setw(12) << "frame ms" << std::setw(22) << "instanced submit ms" << std::setw(12)
+                  << "frame ms" << std::setw(16) << "submit speedup" << std::setw(16) << "uploads/frame"
+                  << std::setw(10) << "max diff" << std::endl;
+        int result = 0;
+        for (size_t count : {10, 100, 1000, 10000}) {
+            auto lights = scatterLights(count);
+            factory.setSampledLights(lights);
+            factory.modelRender(lampShader);  // 重建实例数据
+
+            // 与 LightFactory 中采样灯光的模型矩阵相同，两种方式画出同样的画面
+            auto legacy = frameTime([&]() {
+                for (auto &light : lights) {
+                    auto scale = LightClusters::lightRange(light) * LightFactory::SAMPLED_LAMP_SCALE;
+                    auto model = glm::scale(glm::translate(glm::mat4(1.f), light.position), glm::vec3(scale));
+                    legacyShader.use(model, view, projection);
+                    legacyShader.setValue("lightColor", light.color);
+                    sphere->render(&legacyShader);
+                }
+            });
+            auto legacyImage = readPixels();
+            GpuBuffer::resetStats();
+            auto instanced = frameTime([&]() { factory.modelRender(lampShader); });
+            GpuBuffer::resetStats();
+            auto diff = compareImages(legacyImage, readPixels());
+            if (factory.lampCount() != count) {
+                std::cerr << "expected " << count << " lamps, drew " << factory.lampCount() << std::endl;
+                result = 1;
+            }
+
+            std::cout << std::left << std::setw(10) << count << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(12) << legacy.submit << std::setw(12) << legacy.total << std::setw(22)
+                      << instanced.submit << std::setw(12) << instanced.total << std::setprecision(2)
+                      << std::setw(15) << legacy.submit / instanced.submit << "x" << std::setw(16)
+                      << (double)GpuBuffer::lastUpdates / (FRAMES + 1) << std::setw(10) << diff.maxDiff
+                      << std::defaultfloat << std::endl;
+            if (diff.maxDiff > 0) {
+                std::cerr << "  instanced lamps differ from per-light draws in " << diff.pixels << " pixels"
+                          << std::endl;
+                result = 1;
+            }
+        }
+
+        factory.clearSampledLights();
+        factory.showSampledLamps = false;
+        factory.setBaseModel(nullptr);
+        factory.reset();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        return result;
+    }
+}
@@ -0,0 +1,215 @@
+#include "Benchmark.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        constexpr int FRAMES = 10;
+        constexpr int LAYERS = 8;
+        constexpr unsigned int LAYER_SIZE = 128;
+        constexpr float FAR_PLANE = 1000.f;
+
+        /// 沿视线方向叠放的 LAYERS 层起伏网格，每层一个网格，按由远到近存放（未排序时的最坏情况）
+        void makeLayers(Model &model) {
+            for (int layer = LAYERS - 1; layer >= 0; layer--) {
+                std::unique_ptr<Model> scan(makeScan(LAYER_SIZE, false));
+                auto &source = scan->meshes[0];
+                auto vertices = source.getVertices();
+                auto offset = -0.15f * (float)layer;
+                for (auto &vertex : vertices)
+                    vertex.position.z += offset;
+                auto info = source.getMeshInfo();
+                info.minVertex.z += offset;
+                info.maxVertex.z += offset;
+                model.meshes.emplace_back(vertices, source.getIndices(), source.getFaces(), vector<Texture>(), info);
+            }
+        }
+
+        void drawGeometry(const Model &model, const vector<size_t> &order) {
+            for (auto i : order) {
+                glBindVertexArray(model.meshes[i].getVao());
+                glDrawElements(GL_TRIANGLES, (GLsizei)model.meshes[i].getIndices().size(), GL_UNSIGNED_INT, nullptr);
+            }
+            glBindVertexArray(0);
+        }
+    }
+
+    int runPrepass(const string &assetRoot) {
+        std::cout << "== prepass: depth pre-pass and front-to-back order (" << WIDTH << "x" << HEIGHT << ", "
+                  << LAYERS << " stacked layers, 2 dir 4 point 4 spot, GPU mean of " << FRAMES << " frames) =="
+                  << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        auto vertexPath = assetRoot + "/shader/model_vertex.glsl";
+        ShaderVariants variants(vertexPath, assetRoot + "/shader/model_fragment.glsl");
+        ShaderProgram depthShader, overdrawShader;
+        depthShader.load(vertexPath, assetRoot + "/shader/depth_prepass_fragment.glsl");
+        overdrawShader.load(vertexPath, assetRoot + "/shader/overdraw_fragment.glsl");
+        for (auto *program : {&depthShader, &overdrawShader}) {
+            if (!program->linked()) {
+                std::cerr << program->lastError() << std::endl;
+                return 1;
+            }
+        }
+
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        auto eye = glm::vec3(0.f, 0.f, 3.f);
+        GpuBuffer frameBuffer, materialBuffer, overdrawBuffer{GL_SHADER_STORAGE_BUFFER};
+        FrameData frame{view, projection, eye, FAR_PLANE};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.update(0, &material, sizeof(material));
+        materialBuffer.bindBase(MATERIAL_BINDING);
+        overdrawBuffer.allocate((2 + (size_t)WIDTH * HEIGHT) * sizeof(uint32_t));
+        overdrawBuffer.bindBase(OVERDRAW_BINDING);
+
+        auto &factory = LightFactory::get();
+        factory.reset();
+        // reset 后第 0 个灯光是点光源
+        const std::pair<LightType, int> lights[] = {{POINT_LIGHT, 3}, {DIRECTIONAL_LIGHT, 2}, {SPOT_LIGHT, 4}};
+        for (auto [type, count] : lights)
+            for (int i = 0; i < count; i++)
+                factory.addLight(type);
+        factory.updateBuffer();
+        ShaderPermutation permutation;
+        permutation.dirLights = factory.dirLightCount();
+        permutation.pointLights = factory.pointLightCount();
+        permutation.spotLights = factory.spotLightCount();
+        auto lit = variants.get(permutation);
+        if (!lit) {
+            std::cerr << "variant failed to compile" << std::endl;
+            return 1;
+        }
+
+        Model model;
+        makeLayers(model);
+        auto matrix = glm::mat4(1.f);
+        vector<size_t> stored(model.meshes.size()), sorted;
+        std::iota(stored.begin(), stored.end(), 0);
+        model.sortFrontToBack(matrix, eye, sorted);
+
+        std::cout << std::left << std::setw(14) << "order" << std::setw(10) << "pre-pass" << std::right
+                  << std::setw(13) << "pre-pass ms" << std::setw(10) << "lit ms" << std::setw(10) << "total ms"
+                  << std::setw(12) << "overdraw" << std::setw(10) << "max diff" << std::endl;
+        // 顺序与预渲染只影响被遮挡片元的着色，画面必须与第一种组合逐像素相同
+        vector<unsigned char> reference;
+        int result = 0;
+        for (bool sort : {false, true}) {
+            for (bool prepass : {false, true}) {
+                auto &order = sort ? sorted : stored;
+                // 与 MainRender::renderForward 相同的深度状态
+                auto depthPass = [&]() {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    if (!prepass)
+                        return;
+                    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                    depthShader.use(matrix, view, projection);
+                    drawGeometry(model, order);
+                    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                };
+                auto shade = [&](ShaderProgram &program, const std::function<void()> &draw) {
+                    if (prepass) {
+                        glDepthFunc(GL_EQUAL);
+                        glDepthMask(GL_FALSE);
+                    }
+                    program.use(matrix, view, projection);
+                    draw();
+                    glDepthFunc(GL_LESS);
+                    glDepthMask(GL_TRUE);
+                };
+
+                auto times = gpuTimes(FRAMES, {depthPass, [&]() {
+                    shade(*lit, [&]() {
+                        lit->setValue("shadowLight", -1);
+                        for (auto i : order)
+                            model.renderMesh(i, lit, false, false);
+                    });
+                }});
+                auto image = readPixels();
+                if (reference.empty())
+                    reference = image;
+                auto diff = compareImages(reference, image);
+
+                // 以同样的顺序与深度状态统计着色次数
+                depthPass();
+                overdrawBuffer.clear();
+                shade(overdrawShader, [&]() {
+                    overdrawShader.setValue("overdrawWidth", WIDTH);
+                    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                    drawGeometry(model, order);
+                    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                });
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                uint32_t counters[2] = {};
+                overdrawBuffer.read(0, counters, sizeof(counters));
+
+                std::cout << std::left << std::setw(14) << (sort ? "front-to-back" : "back-to-front")
+                          << std::setw(10) << (prepass ? "yes" : "no") << std::right << std::fixed
+                          << std::setprecision(3) << std::setw(13) << times[0] << std::setw(10) << times[1]
+                          << std::setw(10) << times[0] + times[1] << std::setprecision(2) << std::setw(11)
+                          << (counters[1] > 0 ? (double)counters[0] / counters[1] : 0.0) << "x"
+                          << std::setw(10) << diff.maxDiff << std::defaultfloat << std::endl;
+                if (diff.maxDiff > 0) {
+                    std::cerr << "  image differs from back-to-front without pre-pass in " << diff.pixels << " pixels"
+                              << std::endl;
+                    result = 1;
+                }
+            }
+        }
+
+        factory.reset();
+        glEnable(GL_CULL_FACE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        return result;
+    }
+}
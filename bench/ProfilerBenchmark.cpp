@@ -0,0 +1,180 @@
+#include "Benchmark.h"
+#include "util/Profiler.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+namespace bench {
+    namespace {
+        constexpr int ITERATIONS = 1000000;
+        constexpr int FRAME_ITERATIONS = 1000;  // 每帧的迭代数，环形缓冲不会写满
+        constexpr int THREADS = 4;
+        constexpr int THREAD_SCOPES = 200000;
+        constexpr int GPU_FRAMES = 20;
+        constexpr int CLEARS = 10;
+
+        volatile int sink = 0;
+
+        /// 每次迭代两层嵌套区间，返回每个区间的纳秒数（扣除无区间的循环）
+        double scopeCost(bool scoped) {
+            auto &profiler = Profiler::get();
+            Timer timer;
+            for (int i = 0; i < ITERATIONS; i++) {
+                if (scoped) {
+                    ProfileScope outer("outer");
+                    ProfileScope inner("inner");
+                    sink = sink + 1;
+                }
+                else {
+                    sink = sink + 1;
+                }
+                if (i % FRAME_ITERATIONS == 0)
+                    profiler.newFrame();
+            }
+            profiler.newFrame();
+            return timer.elapsed() * 1e6 / ITERATIONS / 2.0;
+        }
+
+        size_t countEvents(const char *name) {
+            size_t count = 0;
+            for (auto &frame : Profiler::get().history())
+                for (auto &event : frame.events)
+                    if (event.name == name)
+                        count++;
+            return count;
+        }
+    }
+
+    int runProfiler(const string &) {
+        std::cout << "== profiler: CPU scope cost, per-thread rings and GPU timestamp scopes (" << ITERATIONS
+                  << " iterations, 2 nested scopes each) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+        auto &profiler = Profiler::get();
+        int result = 0;
+
+        auto baseline = scopeCost(false);
+        Profiler::enabled = false;
+        auto disabled = scopeCost(true) - baseline;
+        Profiler::enabled = true;
+        profiler.clear();
+        auto enabled = scopeCost(true) - baseline;
+        std::cout << std::fixed << std::setprecision(2) << "scope cost: " << disabled << " ns disabled, "
+                  << enabled << " ns enabled (loop " << baseline * 2.0 << " ns/iteration), "
+                  << profiler.droppedEvents() << " dropped" << std::defaultfloat << std::endl;
+
+        // 工作线程各自写入，主线程同时按帧收集
+        profiler.clear();
+        std::atomic<int> running{THREADS};
+        vector<std::thread> threads;
+        Timer threadTimer;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < THREAD_SCOPES; i++) {
+                    ProfileScope scope("worker");
+                    sink = sink + 1;
+                }
+                running--;
+            });
+        }
+        size_t collected = 0, dropped = 0;
+        auto collect = [&]() {
+            profiler.newFrame();
+            collected += countEvents("worker");
+            dropped += profiler.droppedEvents();
+            profiler.clear();
+        };
+        while (running > 0) {
+            collect();
+            std::this_thread::yield();
+        }
+        for (auto &thread : threads)
+            thread.join();
+        auto threadTime = threadTimer.elapsed();
+        collect();
+        std::cout << "threads: " << THREADS << " x " << THREAD_SCOPES << " scopes in " << std::fixed
+                  << std::setprecision(1) << threadTime << " ms, " << collected << " collected, " << dropped
+                  << " dropped (ring full before the main thread drained it)" << std::defaultfloat << std::endl;
+        if (collected + dropped != (size_t)THREADS * THREAD_SCOPES) {
+            std::cerr << "expected " << THREADS * THREAD_SCOPES << " worker scopes, got "
+                      << collected + dropped << std::endl;
+            result = 1;
+        }
+
+        // GPU 区间：嵌套的清除，结果晚两帧读回
+        GLuint target, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        profiler.clear();
+        for (int frame = 0; frame < GPU_FRAMES; frame++) {
+            profiler.newFrame();
+            {
+                ProfileScope cpu("Frame Work");
+                GpuProfileScope outer("Clears");
+                for (int i = 0; i < CLEARS; i++) {
+                    GpuProfileScope inner("Clear");
+                    glClearColor((float)i / CLEARS, 0.f, 0.f, 1.f);
+                    glClear(GL_COLOR_BUFFER_BIT);
+                }
+            }
+            glFinish();  // 相当于交换缓冲，保证两帧之后查询已完成
+        }
+        profiler.newFrame();
+        profiler.newFrame();
+        auto *last = profiler.lastFrame();
+        size_t gpuScopes = 0, nested = 0;
+        double gpuTime = 0.0;
+        if (last) {
+            for (auto &event : last->events) {
+                if (event.track != Profiler::GPU_TRACK)
+                    continue;
+                gpuScopes++;
+                if (event.end < event.start)
+                    result = 1;
+                if (event.depth == 0)
+                    gpuTime += (double)(event.end - event.start) / 1e6;
+                else
+                    nested++;
+            }
+        }
+        std::cout << "gpu: frame " << (last ? last->index : 0) << ", " << gpuScopes << " scopes (" << nested
+                  << " nested), " << std::fixed << std::setprecision(3) << gpuTime << " ms, "
+                  << profiler.droppedGpuFrames() << " frames dropped" << std::defaultfloat << std::endl;
+        if (gpuScopes != CLEARS + 1) {
+            std::cerr << "expected " << CLEARS + 1 << " GPU scopes in the last resolved frame" << std::endl;
+            result = 1;
+        }
+
+        auto path = "profiler_trace.json";
+        Timer exportTimer;
+        if (!profiler.exportChromeTrace(path)) {
+            std::cerr << "failed to write " << path << std::endl;
+            result = 1;
+        }
+        else {
+            std::ifstream in(path, std::ios::ate);
+            std::cout << "trace: " << profiler.history().size() << " frames, " << in.tellg() << " bytes in "
+                      << std::fixed << std::setprecision(3) << exportTimer.elapsed() << " ms -> " << path
+                      << std::defaultfloat << std::endl;
+        }
+
+        Profiler::enabled = false;
+        profiler.newFrame();
+        profiler.clear();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        return result;
+    }
+}
@@ -0,0 +1,188 @@
+#include "Benchmark.h"
+#include "util/RayPicker.h"
+#include "util/Parallel.h"
+
+#include <atomic>
+#include <cfloat>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    constexpr size_t CHECK_RAYS = 3000;
+    constexpr size_t CHECK_TESTS = 600000000;  // 每组射线与原拾取方式比较时最多的三角形求交次数
+
+    /// 视口内均匀随机分布的屏幕坐标
+    static vector<glm::vec2> randomPoints(size_t count) {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> xDist(0.f, (float)WIDTH);
+        std::uniform_real_distribution<float> yDist(0.f, (float)HEIGHT);
+        vector<glm::vec2> points(count);
+        for (auto &point : points)
+            point = glm::vec2(xDist(random), yDist(random));
+        return points;
+    }
+
+    /// 按固定像素间隔覆盖整个视口的屏幕坐标
+    static vector<glm::vec2> gridPoints(int step) {
+        vector<glm::vec2> points;
+        for (int y = step / 2; y < HEIGHT; y += step)
+            for (int x = step / 2; x < WIDTH; x += step)
+                points.emplace_back((float)x, (float)y);
+        return points;
+    }
+
+    /// 逐个三角形求交的参照结果，顶点变换到世界坐标后测试每个面
+    struct BruteForceHit {
+        RayPicker::RayHit exact;  // 重心坐标归一化后判断，边界包含在内
+        RayPicker::RayHit legacy;  // 原拾取方式：未归一化的 u、v 与固定阈值比较
+    };
+
+    static BruteForceHit bruteForce(const vector<Mesh> &meshes, const glm::mat4 &model, const RayPicker::Ray &ray) {
+        constexpr float EPSILON = 0.0000001f;
+        BruteForceHit result;
+        result.exact.t = FLT_MAX;
+        result.legacy.t = 1000.f;
+        for (int j = 0; j < (int)meshes.size(); j++) {
+            auto &vertices = meshes[j].getVertices();
+            auto &faces = meshes[j].getFaces();
+            for (unsigned int f = 0; f < faces.size(); f++) {
+                glm::vec3 v[3];
+                for (int i = 0; i < 3; i++)
+                    v[i] = glm::vec3(model * glm::vec4(vertices[faces[f].vertex[i]].position, 1.0f));
+                auto e1 = v[1] - v[0];
+                auto e2 = v[2] - v[0];
+                auto p = glm::cross(ray.dir, e2);
+                auto det = glm::dot(e1, p);
+                if (det == 0.f)
+                    continue;
+                auto s = ray.orig - v[0];
+                auto q = glm::cross(s, e1);
+                auto u = glm::dot(s, p);
+                auto w = glm::dot(ray.dir, q);
+                auto t = glm::dot(e2, q) / det;
+
+                if (u / det >= 0.f && w / det >= 0.f && (u + w) / det <= 1.f && t > 1e-6f && t < result.exact.t)
+                    result.exact = {j, f, t, u / det, w / det};
+
+                if ((det > -EPSILON && det < EPSILON) || u < EPSILON || u - det > -EPSILON ||
+                    w < EPSILON || u + w - det > -EPSILON)
+                    continue;
+                if (t > 0 && t < result.legacy.t)
+                    result.legacy = {j, f, t, u / det, w / det};
+            }
+        }
+        return result;
+    }
+
+    static bool sameHit(const RayPicker::RayHit &a, const RayPicker::RayHit &b) {
+        if (a.meshIndex == -1 || b.meshIndex == -1)
+            return a.meshIndex == b.meshIndex;
+        return std::abs(a.t - b.t) <= 1e-4f * std::max(1.f, a.t);
+    }
+
+    struct CheckResult {
+        size_t mismatches = 0;  // 与逐面求交不一致
+        size_t legacyMisses = 0;  // 原拾取方式未命中而层次包围盒命中
+        size_t legacyOther = 0;  // 与原拾取方式的其他差异
+    };
+
+    /// 比较前 count 条射线：命中与否一致，交点距离的相对误差不超过 1e-4
+    /// 共享边上的射线可能命中相邻的面，因此比较距离而不比较面序号
+    /// 原拾取方式用固定阈值比较未归一化的重心坐标，小三角形靠近边的射线会从两个面之间漏过，单独统计
+    static CheckResult checkRays(const Model &model, const vector<RayPicker::Ray> &rays,
+                                 const vector<RayPicker::RayHit> &hits, size_t count) {
+        std::atomic<size_t> mismatches{0}, legacyMisses{0}, legacyOther{0};
+        parallel::forEach(count, [&](size_t i) {
+            auto expected = bruteForce(model.meshes, model.basisTransform, rays[i]);
+            if (!sameHit(expected.exact, hits[i]))
+                mismatches++;
+            if (!sameHit(expected.legacy, hits[i])) {
+                if (expected.legacy.meshIndex == -1)
+                    legacyMisses++;
+                else
+                    legacyOther++;
+            }
+        }, 16);
+        return {mismatches, legacyMisses, legacyOther};
+    }
+
+    static int rayModel(const string &name, Model &model) {
+        size_t faceCount = 0;
+        for (auto &mesh : model.meshes)
+            faceCount += mesh.getFaces().size();
+
+        RayPicker picker;
+        Timer buildTimer;
+        picker.buildIndex(model.meshes);
+        auto buildTime = buildTimer.elapsed();
+        std::cout << name << ": " << faceCount << " faces, index build " << std::fixed << std::setprecision(2)
+                  << buildTime << " ms" << std::endl;
+
+        auto cameraPos = glm::vec3(0.f, 0.f, 3.f);
+        auto inverseModel = glm::inverse(model.basisTransform);
+        int result = 0;
+        const std::pair<string, vector<glm::vec2>> sets[] = {
+                {"random 200k", randomPoints(200000)},
+                {"grid 2px",    gridPoints(2)},
+        };
+        for (auto &set : sets) {
+            auto rays = RayPicker::screenRays(cameraPos, viewMatrix(), projectionMatrix(), set.second, WIDTH, HEIGHT);
+
+            // 批量接口的吞吐量
+            vector<RayPicker::RayHit> hits;
+            Timer batchTimer;
+            picker.intersectRays(model.meshes, model.basisTransform, rays, hits);
+            auto batchTime = batchTimer.elapsed();
+
+            size_t hitCount = 0;
+            for (auto &hit : hits)
+                hitCount += hit.meshIndex != -1;
+
+            // 单条射线的延迟，取前 10000 条
+            vector<double> samples;
+            for (size_t i = 0; i < rays.size() && i < 10000; i++) {
+                Timer timer;
+                auto hit = picker.intersectRay(model.meshes, inverseModel, rays[i]);
+                samples.push_back(timer.elapsed() * 1000.0);
+                (void)hit;
+            }
+            auto stats = summarize(samples);
+            auto checked = std::min({rays.size(), CHECK_RAYS, CHECK_TESTS / std::max<size_t>(faceCount, 1)});
+            auto check = checkRays(model, rays, hits, checked);
+
+            std::cout << "  " << std::left << std::setw(14) << set.first << std::right
+                      << std::setw(10) << rays.size()
+                      << std::setw(14) << std::setprecision(0) << rays.size() / (batchTime / 1000.0)
+                      << std::setw(10) << std::setprecision(2) << stats.p50
+                      << std::setw(10) << stats.p99
+                      << std::setw(9) << std::setprecision(1) << 100.0 * hitCount / rays.size() << "%"
+                      << std::setw(14) << std::to_string(check.mismatches) + "/" + std::to_string(checked)
+                      << std::setw(8) << check.legacyMisses << std::setw(8) << check.legacyOther << std::endl;
+            if (check.mismatches > 0 || check.legacyOther > 0)
+                result = 1;
+        }
+        return result;
+    }
+
+    int runRay(const string &assetRoot) {
+        std::cout << "== batch ray query (" << parallel::workerCount() << " threads)" << std::endl;
+        std::cout << "  " << std::left << std::setw(14) << "set" << std::right
+                  << std::setw(10) << "rays" << std::setw(14) << "rays/s"
+                  << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "hit"
+                  << std::setw(14) << "mismatch" << std::setw(8) << "old +" << std::setw(8) << "old !=" << std::endl;
+        std::cout << "  (mismatch: leading rays of each set against a per-triangle test; old +: hits the old picker"
+                     " missed near edges of small faces; old !=: any other difference from the old picker)" << std::endl;
+
+        int result = 0;
+        forEachAsset(assetRoot, [&](const string &path, Model &model) {
+            result |= rayModel(path, model);
+        });
+        for (auto size : {300u, 1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            result |= rayModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model);
+        }
+        return result;
+    }
+}
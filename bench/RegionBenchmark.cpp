@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+#include "util/RayPicker.h"
+#include "util/RegionPicker.h"
+#include "util/Parallel.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+namespace bench {
+    struct RegionCase {
+        string name;
+        RegionPicker::Shape shape;
+        float extent;  // 区域占视口的比例
+        RegionPicker::Options options;
+    };
+
+    /// 以视口中心为中心的矩形（对角两点）或圆形套索
+    static vector<glm::vec2> makeRegion(RegionPicker::Shape shape, float extent) {
+        glm::vec2 center(WIDTH * 0.5f, HEIGHT * 0.5f);
+        glm::vec2 half(WIDTH * extent * 0.5f, HEIGHT * extent * 0.5f);
+        if (shape == RegionPicker::RECTANGLE)
+            return {center - half, center + half};
+
+        vector<glm::vec2> region;
+        for (int i = 0; i < 64; i++) {
+            auto angle = glm::two_pi<float>() * (float)i / 64.f;
+            region.push_back(center + half * glm::vec2(std::cos(angle), std::sin(angle)));
+        }
+        return region;
+    }
+
+    static void regionModel(const string &name, Model &model, const vector<RegionCase> &cases, int repeat) {
+        size_t faceCount = 0;
+        for (auto &mesh : model.meshes)
+            faceCount += mesh.getFaces().size();
+
+        RayPicker picker;
+        Timer buildTimer;
+        picker.buildIndex(model.meshes);
+        auto buildTime = buildTimer.elapsed();
+        std::cout << name << ": " << faceCount << " faces, index build " << std::fixed << std::setprecision(2)
+                  << buildTime << " ms" << std::endl;
+
+        auto view = viewMatrix();
+        auto projection = projectionMatrix();
+        RegionPicker regionPicker;
+        for (auto &regionCase : cases) {
+            auto region = makeRegion(regionCase.shape, regionCase.extent);
+            vector<double> samples;
+            for (int i = 0; i < repeat; i++) {
+                regionPicker.regionPick(model.meshes, picker.getBvhs(), region, regionCase.shape, regionCase.options,
+                                        glm::vec3(0.f, 0.f, 3.f), model.basisTransform, view, projection,
+                                        WIDTH, HEIGHT);
+                samples.push_back(regionPicker.pickTime);
+            }
+
+            auto stats = summarize(samples);
+            std::cout << "  " << std::left << std::setw(30) << regionCase.name << std::right
+                      << std::setw(10) << regionPicker.faceCount
+                      << std::setw(10) << regionPicker.pointCount
+                      << std::setw(12) << std::setprecision(3) << stats.mean
+                      << std::setw(12) << stats.p50
+                      << std::setw(12) << stats.p99 << std::endl;
+        }
+    }
+
+    int runRegion(const string &assetRoot) {
+        std::cout << "== region select (" << parallel::workerCount() << " threads)" << std::endl;
+        std::cout << "  " << std::left << std::setw(30) << "case" << std::right
+                  << std::setw(10) << "faces" << std::setw(10) << "points"
+                  << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::endl;
+
+        RegionPicker::Options all{true, false, false, false};
+        RegionPicker::Options visible{true, false, false, true};
+        RegionPicker::Options partial{true, false, true, true};
+        RegionPicker::Options points{false, true, false, true};
+        const vector<RegionCase> cases = {
+                {"rect 20% all",          RegionPicker::RECTANGLE, 0.2f, all},
+                {"rect 50% all",          RegionPicker::RECTANGLE, 0.5f, all},
+                {"rect 50% visible",      RegionPicker::RECTANGLE, 0.5f, visible},
+                {"rect 50% partial",      RegionPicker::RECTANGLE, 0.5f, partial},
+                {"rect 50% points",       RegionPicker::RECTANGLE, 0.5f, points},
+                {"lasso 50% all",         RegionPicker::LASSO,     0.5f, all},
+                {"lasso 50% visible",     RegionPicker::LASSO,     0.5f, visible},
+        };
+
+        forEachAsset(assetRoot, [&cases](const string &path, Model &model) {
+            regionModel(path, model, cases, 10);
+        });
+        for (auto size : {500u, 1000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            regionModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model, cases, 5);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,113 @@
+#include "Benchmark.h"
+#include "util/SelectionSet.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    /// 随机分布（几乎不可压缩）或连续区域（游程很少）的选择
+    static SelectionSet makeSelection(const string &name, const vector<Mesh> &meshes, double ratio, bool contiguous) {
+        SelectionSet set(name, meshes);
+        std::mt19937 random(42);
+        std::bernoulli_distribution pick(ratio);
+        for (size_t j = 0; j < meshes.size(); j++) {
+            for (auto *bits : {&set.points[j], &set.faces[j]}) {
+                if (contiguous) {
+                    bits->setRange(0, (size_t)((double)bits->size() * ratio));
+                    continue;
+                }
+                for (size_t i = 0; i < bits->size(); i++)
+                    if (pick(random))
+                        bits->set(i);
+            }
+        }
+        return set;
+    }
+
+    static void selectionModel(const string &name, Model &model) {
+        const std::tuple<string, double, bool> cases[] = {
+                {"random 50%",     0.5,  false},
+                {"random 1%",      0.01, false},
+                {"contiguous 50%", 0.5,  true},
+        };
+
+        auto path = (std::filesystem::temp_directory_path() / "model-viewer-bench.sel").string();
+        for (auto &[caseName, ratio, contiguous] : cases) {
+            auto set = makeSelection(caseName, model.meshes, ratio, contiguous);
+            auto other = makeSelection("other", model.meshes, 0.5, false);
+
+            // 四种集合运算各一次，外加计数
+            Timer algebraTimer;
+            auto result = set;
+            result.combine(other, SelectionSet::UNION);
+            result.combine(other, SelectionSet::INTERSECT);
+            result.combine(other, SelectionSet::SUBTRACT);
+            result.invert();
+            auto count = result.pointCount() + result.faceCount();
+            auto algebraTime = algebraTimer.elapsed();
+
+            SelectionStore store(model.meshes);
+            store.put(set);
+            if (!store.save(path) || !store.load(path)) {
+                std::cerr << store.lastError << std::endl;
+                continue;
+            }
+            auto elements = store.sets()[0].pointCount() + store.sets()[0].faceCount();
+
+            std::cout << std::left << std::setw(24) << name << std::setw(16) << caseName << std::right
+                      << std::setw(12) << elements
+                      << std::setw(12) << std::fixed << std::setprecision(3) << algebraTime
+                      << std::setw(12) << store.saveTime
+                      << std::setw(12) << store.loadTime
+                      << std::setw(12) << store.fileSize << std::endl;
+            (void)count;
+        }
+        std::filesystem::remove(path);
+    }
+
+    /// 集合数量被改成接近 2^32 的文件必须以错误返回，不能尝试分配
+    static bool rejectsCorruptCount(const Model &model) {
+        auto path = (std::filesystem::temp_directory_path() / "model-viewer-corrupt.sel").string();
+        SelectionStore store(model.meshes);
+        store.put(makeSelection("set", model.meshes, 0.5, true));
+        if (!store.save(path))
+            return false;
+        {
+            // 标识、版本、哈希、网格数与每个网格的顶点数和面数之后是集合数量
+            std::fstream file(path, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+            file.seekp((std::streamoff)(20 + 8 * model.meshes.size()));
+            uint32_t count = 0xfffffff0u;
+            file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        }
+        auto rejected = !store.load(path) && store.sets().size() == 1;
+        std::filesystem::remove(path);
+        return rejected;
+    }
+
+    int runSelection(const string &assetRoot) {
+        std::cout << "== selection sets" << std::endl;
+        std::cout << std::left << std::setw(24) << "model" << std::setw(16) << "case" << std::right
+                  << std::setw(12) << "elements" << std::setw(12) << "algebra ms" << std::setw(12) << "save ms"
+                  << std::setw(12) << "load ms" << std::setw(12) << "bytes" << std::endl;
+
+        forEachAsset(assetRoot, [](const string &path, Model &model) {
+            selectionModel(path, model);
+        });
+        for (auto size : {1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            selectionModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model);
+        }
+
+        std::unique_ptr<Model> scan(makeScan(100));
+        if (!rejectsCorruptCount(*scan)) {
+            std::cerr << "a selection file with a corrupt set count was not rejected" << std::endl;
+            return 1;
+        }
+        std::cout << "corrupt set count: rejected" << std::endl;
+        return 0;
+    }
+}
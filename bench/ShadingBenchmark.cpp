@@ -0,0 +1,228 @@
+#include "Benchmark.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        constexpr int FRAMES = 10;
+        constexpr int OVERDRAW = 4;  // 每帧重复绘制全屏四边形的次数，放大片元着色的开销
+        constexpr unsigned int SHADOW_SIZE = 512;
+        constexpr float FAR_PLANE = 1000.f;
+        constexpr int TOLERANCE = 1;  // 变体与通用着色器输出允许的通道差（0-255），只有浮点运算顺序不同
+
+        /// 覆盖整个视口的四边形，位于 z = 0 平面，观察与投影矩阵为单位矩阵
+        std::unique_ptr<Mesh> makeQuad(const vector<Texture> &textures) {
+            vector<VertexData> vertices(4);
+            const glm::vec2 corners[4] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+            for (int i = 0; i < 4; i++) {
+                vertices[i].position = glm::vec3(corners[i], 0.f);
+                vertices[i].normal = glm::vec3(0.f, 0.f, 1.f);
+                vertices[i].texCoord = corners[i] * 0.5f + 0.5f;
+            }
+            vector<Face> faces = {{{0, 1, 2}}, {{0, 2, 3}}};
+            vector<unsigned int> indices = {0, 1, 2, 0, 2, 3};
+            return std::make_unique<Mesh>(vertices, indices, faces, textures, MeshInfo());
+        }
+
+        GLuint makeCheckerTexture() {
+            constexpr int SIZE = 256;
+            vector<unsigned char> pixels(SIZE * SIZE * 3);
+            for (int y = 0; y < SIZE; y++)
+                for (int x = 0; x < SIZE; x++)
+                    for (int c = 0; c < 3; c++)
+                        pixels[(y * SIZE + x) * 3 + c] = ((x / 16 + y / 16) % 2) ? 220 : 40;
+            GLuint texture;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, SIZE, SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            return texture;
+        }
+
+        /// 深度全部为 1 的立方体阴影贴图，采样开销与真实阴影相同
+        GLuint makeShadowCube(GLuint &fbo) {
+            GLuint cube;
+            glGenTextures(1, &cube);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, cube);
+            for (unsigned int i = 0; i < 6; ++i)
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_SIZE, SHADOW_SIZE, 0,
+                             GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cube, 0);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            return cube;
+        }
+
+        /// 按数量设置灯光，reset 后第 0 个灯光是点光源（投射阴影），pointLights 至少为 1
+        void setupLights(LightFactory &factory, int dirLights, int pointLights, int spotLights) {
+            factory.reset();
+            auto add = [&](LightType type, int count) {
+                for (int i = 0; i < count; i++)
+                    factory.addLight(type);
+            };
+            add(POINT_LIGHT, pointLights - 1);
+            add(DIRECTIONAL_LIGHT, dirLights);
+            add(SPOT_LIGHT, spotLights);
+            factory.updateBuffer();
+        }
+
+        /// 与 MainRender 相同，阴影贴图始终绑定，是否计算阴影由 shadowLight 决定
+        /// \return 每帧平均耗时（毫秒），包括等待 GPU 完成
+        double drawFrames(ShaderProgram &program, Mesh &quad, GLuint shadowCube, int shadowLight) {
+            auto frame = [&]() {
+                glClear(GL_COLOR_BUFFER_BIT);
+                program.use(glm::mat4(1.f), glm::mat4(1.f), glm::mat4(1.f));
+                program.setValue("shadowLight", shadowLight);
+                for (int i = 0; i < OVERDRAW; i++)
+                    quad.render(&program, false, false, shadowCube);
+                glFinish();
+            };
+            frame();  // 预热，排除首次绘制时驱动的延迟编译
+            Timer timer;
+            for (int i = 0; i < FRAMES; i++)
+                frame();
+            return timer.elapsed() / FRAMES;
+        }
+    }
+
+    int runShading(const string &assetRoot) {
+        std::cout << "== shading: uber shader vs permutations (" << WIDTH << "x" << HEIGHT << ", "
+                  << OVERDRAW << " full-screen layers, mean of " << FRAMES << " frames) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+        if (softwareRenderer())
+            std::cout << "note: software rasterizer, timings do not represent GPU hardware; run the same bench on a "
+                         "GPU driver for hardware numbers" << std::endl;
+
+        auto vertexPath = assetRoot + "/shader/model_vertex.glsl";
+        auto fragmentPath = assetRoot + "/shader/model_fragment.glsl";
+        ShaderProgram uber;
+        uber.load(vertexPath, fragmentPath);
+        if (!uber.linked()) {
+            std::cerr << uber.lastError() << std::endl;
+            return 1;
+        }
+        ShaderVariants variants(vertexPath, fragmentPath);
+
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glDisable(GL_DEPTH_TEST);  // 每一层都执行完整的片元着色
+
+        GLuint shadowFbo;
+        auto shadowCube = makeShadowCube(shadowFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        auto checker = makeCheckerTexture();
+        auto plainQuad = makeQuad({});
+        auto texturedQuad = makeQuad({{checker, "diffuse", ""}, {checker, "specular", ""}});
+
+        GpuBuffer frameBuffer, materialBuffer;
+        FrameData frame{glm::mat4(1.f), glm::mat4(1.f), glm::vec3(0.f, 0.f, 3.f), FAR_PLANE};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.update(0, &material, sizeof(material));
+        materialBuffer.bindBase(MATERIAL_BINDING);
+
+        const std::tuple<string, int, int, int> lightSets[] = {
+                {"1 point",            0, 1, 0},
+                {"1 dir 1 point 1 spot", 1, 1, 1},
+                {"2 dir 4 point 4 spot", 2, 4, 4},
+        };
+
+        auto &factory = LightFactory::get();
+        std::cout << std::left << std::setw(24) << "lights" << std::setw(10) << "texture" << std::setw(8) << "shadow"
+                  << std::right << std::setw(12) << "uber ms" << std::setw(12) << "variant ms" << std::setw(10) << "speedup"
+                  << std::setw(10) << "max diff" << std::endl;
+        int result = 0;
+        for (auto &[name, dirLights, pointLights, spotLights] : lightSets) {
+            setupLights(factory, dirLights, pointLights, spotLights);
+            for (bool texture : {false, true}) {
+                for (bool shadow : {false, true}) {
+                    auto &quad = texture ? *texturedQuad : *plainQuad;
+
+                    ShaderPermutation permutation;
+                    permutation.dirLights = factory.dirLightCount();
+                    permutation.pointLights = factory.pointLightCount();
+                    permutation.spotLights = factory.spotLightCount();
+                    permutation.texture = texture;
+                    permutation.shadowLight = shadow ? factory.shadowLightIndex() : -1;
+                    auto variant = variants.get(permutation);
+                    if (!variant) {
+                        std::cerr << "variant failed to compile" << std::endl;
+                        continue;
+                    }
+
+                    auto uberTime = drawFrames(uber, quad, shadowCube, permutation.shadowLight);
+                    auto uberImage = readPixels();
+                    auto variantTime = drawFrames(*variant, quad, shadowCube, permutation.shadowLight);
+                    auto diff = compareImages(uberImage, readPixels());
+                    if (diff.maxDiff > TOLERANCE)
+                        result = 1;
+                    std::cout << std::left << std::setw(24) << name << std::setw(10) << (texture ? "yes" : "no")
+                              << std::setw(8) << (shadow ? "yes" : "no") << std::right << std::fixed
+                              << std::setprecision(3) << std::setw(12) << uberTime << std::setw(12) << variantTime
+                              << std::setprecision(2) << std::setw(9) << uberTime / variantTime << "x"
+                              << std::setw(10) << diff.maxDiff << std::defaultfloat << std::endl;
+                }
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteFramebuffers(1, &shadowFbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteTextures(1, &shadowCube);
+        glDeleteTextures(1, &checker);
+        if (result)
+            std::cerr << "a variant differs from the uber shader by more than " << TOLERANCE << "/255" << std::endl;
+        return result;
+    }
+}
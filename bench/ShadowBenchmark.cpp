@@ -0,0 +1,293 @@
+#include "Benchmark.h"
+#include "util/opengl/ShadowClusters.h"
+#include "util/opengl/ShadowMap.h"
+#include "util/opengl/ShaderProgram.h"
+#include "util/opengl/ShadowAtlas.h"
+#include "util/LightFactory.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+
+namespace bench {
+    namespace {
+        constexpr int FRAMES = 10;
+        constexpr int GRID = 48;  // 每个网格 GRID * GRID 个立方体
+        constexpr int MESHES = 4;  // 四个象限各一个网格
+        constexpr unsigned int SHADOW_SIZE = 1024;
+        constexpr float NEAR_PLANE = 0.1f;
+        constexpr float FAR_PLANE = 1000.f;
+        constexpr unsigned int ALL_FACES = 0x3f;
+
+        /// 在 xz 平面上排成网格的立方体，三角形按行存放，相邻的三角形在空间上也相邻
+        Mesh makeBlocks(const glm::vec3 &origin, float spacing) {
+            vector<VertexData> vertices;
+            vector<unsigned int> indices;
+            vector<Face> faces;
+            const glm::vec3 corners[8] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+                                          {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+            const unsigned int quads[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 4, 7, 3},
+                                              {1, 2, 6, 5}, {3, 7, 6, 2}, {0, 1, 5, 4}};
+            for (int z = 0; z < GRID; z++) {
+                for (int x = 0; x < GRID; x++) {
+                    auto base = (unsigned int)vertices.size();
+                    auto height = 0.5f + 0.5f * (float)((x * 7 + z * 13) % 5);
+                    auto offset = origin + glm::vec3((float)x, 0.f, (float)z) * spacing;
+                    for (auto &corner : corners) {
+                        VertexData vertex{};
+                        vertex.position = offset + corner * glm::vec3(0.5f, height, 0.5f) * spacing;
+                        vertices.push_back(vertex);
+                    }
+                    for (auto &quad : quads) {
+                        Face f0{{base + quad[0], base + quad[1], base + quad[2]}};
+                        Face f1{{base + quad[0], base + quad[2], base + quad[3]}};
+                        for (auto &f : {f0, f1}) {
+                            faces.push_back(f);
+                            indices.insert(indices.end(), f.vertex, f.vertex + 3);
+                        }
+                    }
+                }
+            }
+            return {vertices, indices, faces, vector<Texture>(), MeshInfo()};
+        }
+
+        vector<glm::mat4> faceMatrices(const glm::vec3 &lightPos) {
+            auto projection = glm::perspective(glm::radians(90.f), 1.f, NEAR_PLANE, FAR_PLANE);
+            const glm::vec3 directions[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+            const glm::vec3 ups[6] = {{0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+            vector<glm::mat4> matrices;
+            for (int i = 0; i < 6; i++)
+                matrices.push_back(projection * glm::lookAt(lightPos, lightPos + directions[i], ups[i]));
+            return matrices;
+        }
+
+        /// count 个灯光均匀分布在场地上方的圆周上，依次为点光、聚光、平行光，都指向场地中心
+        void placeLights(LightFactory &factory, int count, float angle) {
+            factory.reset();
+            const LightType types[] = {POINT_LIGHT, SPOT_LIGHT, DIRECTIONAL_LIGHT};
+            for (int i = 1; i < count; i++)
+                factory.addLight(types[i % 3], i);
+            for (int i = 0; i < count; i++) {
+                auto light = factory.getLight(i);
+                light->reset();
+                auto theta = angle + 6.2831853f * (float)i / (float)count;
+                light->position = glm::vec3(4.f * std::cos(theta), 3.f, 4.f * std::sin(theta));
+                light->direction = -light->position;
+                light->outerCutOffDegree = 35.f;
+            }
+            factory.updateBuffer();
+        }
+
+        /// \return 每帧平均耗时（毫秒），包括剔除与等待 GPU 完成
+        double timeFrames(const std::function<void()> &frame) {
+            frame();  // 预热
+            glFinish();
+            Timer timer;
+            for (int i = 0; i < FRAMES; i++) {
+                frame();
+                glFinish();
+            }
+            return timer.elapsed() / FRAMES;
+        }
+    }
+
+    int runShadow(const string &assetRoot) {
+        std::cout << "== shadow: geometry shader vs culled clusters (" << SHADOW_SIZE << "^2 cube, "
+                  << MESHES * GRID * GRID * 12 << " triangles, mean of " << FRAMES << " frames) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        auto fragmentPath = assetRoot + "/shader/depth_shadow_fragment.glsl";
+        auto instancedPath = assetRoot + "/shader/depth_shadow_instanced_vertex.glsl";
+        ShaderProgram geometry, perFace, layered;
+        geometry.load(assetRoot + "/shader/depth_shadow_vertex.glsl", fragmentPath,
+                      assetRoot + "/shader/depth_shadow_geometry.glsl");
+        perFace.load(instancedPath, fragmentPath);
+        bool layeredSupported = ShadowClusters::layeredSupported();
+        if (layeredSupported)
+            layered.load(instancedPath, fragmentPath, "", ShadowClusters::layerDefines());
+        for (auto *program : {&geometry, &perFace}) {
+            if (!program->linked()) {
+                std::cerr << program->lastError() << std::endl;
+                return 1;
+            }
+        }
+
+        // 10 x 10 的场地，灯光位于中心时六个面都有内容，位于角落时大部分块落在三个面之外
+        constexpr float SPACING = 10.f / (GRID * 2);
+        vector<Mesh> meshes;
+        for (int i = 0; i < MESHES; i++)
+            meshes.push_back(makeBlocks(glm::vec3((float)(i % 2) * 5.f - 5.f, 0.f, (float)(i / 2) * 5.f - 5.f), SPACING));
+        ShadowClusters clusters(meshes);
+        std::cout << "clusters: " << clusters.clusterCount() << " of " << ShadowClusters::CLUSTER_TRIANGLES
+                  << " triangles, vertex gl_Layer: " << (layeredSupported ? "yes" : "no") << std::endl;
+
+        ShadowMap shadowMap;
+        shadowMap.allocate({SHADOW_SIZE, GL_DEPTH_COMPONENT24});
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.framebuffer());
+        auto model = glm::mat4(1.f);
+
+        const std::pair<const char *, glm::vec3> lights[] = {
+                {"center", glm::vec3(0.f, 3.f, 0.f)},
+                {"corner", glm::vec3(-5.5f, 3.f, -5.5f)},
+        };
+        std::cout << std::left << std::setw(10) << "light" << std::setw(14) << "path" << std::right
+                  << std::setw(12) << "ms/frame" << std::setw(12) << "draws" << std::setw(12) << "cull ms" << std::endl;
+        auto report = [](const char *light, const char *path, double time, const string &draws, float cullTime) {
+            std::cout << std::left << std::setw(10) << light << std::setw(14) << path << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(12) << time << std::setw(12) << draws
+                      << std::setw(12) << cullTime << std::endl;
+        };
+
+        for (auto &[name, lightPos] : lights) {
+            auto matrices = faceMatrices(lightPos);
+            auto setCommon = [&](ShaderProgram &program) {
+                program.use();
+                program.setValue("model", model);
+                program.setValue("far_plane", FAR_PLANE);
+                program.setValue("lightPos", lightPos);
+                program.uniform<glm::mat4>("shadowMatrices").set(matrices.data(), 6);
+            };
+
+            auto geometryTime = timeFrames([&]() {
+                setCommon(geometry);
+                geometry.setValue("faceMask", (int)ALL_FACES);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                for (auto &mesh : meshes) {
+                    glBindVertexArray(mesh.getVao());
+                    glDrawElements(GL_TRIANGLES, (GLsizei)mesh.getIndices().size(), GL_UNSIGNED_INT, nullptr);
+                }
+                glBindVertexArray(0);
+            });
+            auto total = std::to_string(clusters.clusterCount() * 6);
+            report(name, "geometry", geometryTime, total + "/" + total, 0.f);
+
+            if (layeredSupported) {
+                auto layeredTime = timeFrames([&]() {
+                    clusters.cull(model, matrices.data(), ALL_FACES);
+                    setCommon(layered);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                    clusters.drawLayered();
+                });
+                report(name, "layered", layeredTime,
+                       std::to_string(clusters.visibleDraws) + "/" + std::to_string(clusters.totalDraws), clusters.cullTime);
+            }
+
+            auto sixPassTime = timeFrames([&]() {
+                clusters.cull(model, matrices.data(), ALL_FACES);
+                setCommon(perFace);
+                for (int i = 0; i < 6; i++) {
+                    shadowMap.attachFace(i);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                    perFace.setValue("face", i);
+                    clusters.drawFace(i);
+                }
+                shadowMap.attachLayered();
+            });
+            report(name, "six passes", sixPassTime,
+                   std::to_string(clusters.visibleDraws) + "/" + std::to_string(clusters.totalDraws), clusters.cullTime);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glCullFace(GL_BACK);
+        return 0;
+    }
+
+    int runAtlas(const string &assetRoot) {
+        constexpr size_t TILE_BUDGET = 8;
+        std::cout << "== atlas: shadow cost vs shadowed light count (64 MB atlas, "
+                  << MESHES * GRID * GRID * 12 << " triangles, " << TILE_BUDGET << " tiles per frame) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        ShaderProgram depth;
+        depth.load(assetRoot + "/shader/depth_atlas_vertex.glsl", assetRoot + "/shader/depth_atlas_fragment.glsl");
+        if (!depth.linked()) {
+            std::cerr << depth.lastError() << std::endl;
+            return 1;
+        }
+
+        constexpr float SPACING = 10.f / (GRID * 2);
+        vector<Mesh> meshes;
+        for (int i = 0; i < MESHES; i++)
+            meshes.push_back(makeBlocks(glm::vec3((float)(i % 2) * 5.f - 5.f, 0.f, (float)(i / 2) * 5.f - 5.f), SPACING));
+        ShadowClusters clusters(meshes);
+
+        ShadowAtlas atlas;
+        atlas.allocate(ShadowAtlas::fit(64u << 20));
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        auto model = glm::mat4(1.f);
+        ShadowAtlas::View view{glm::lookAt(glm::vec3(0.f, 6.f, 9.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)),
+                               glm::perspective(glm::radians(45.f), (float)WIDTH / HEIGHT, 0.1f, FAR_PLANE),
+                               0.1f, FAR_PLANE};
+
+        auto &factory = LightFactory::get();
+        vector<ShadowAtlas::Caster> casters;
+        auto update = [&]() {
+            casters.clear();
+            for (int i = 0; i < MAX_LIGHT_NUM; i++)
+                if (factory.getLight(i)->type != NONE)
+                    casters.push_back({i, factory.bufferIndex(i), factory.getLight(i)});
+            atlas.layout(casters, view, model);
+            depth.use();
+            depth.setValue("model", model);
+            atlas.render([&](const vector<glm::mat4> &matrices) {
+                clusters.cullViews(model, matrices);
+            }, [&](size_t tile, const glm::mat4 &matrix) {
+                depth.setValue("lightMatrix", matrix);
+                clusters.drawView(tile);
+            });
+        };
+
+        std::cout << std::setw(7) << "lights" << std::setw(8) << "tiles" << std::setw(9) << "dropped"
+                  << std::setw(12) << "full ms" << std::setw(12) << "static ms" << std::setw(12) << "moving ms"
+                  << std::setw(10) << "deferred" << std::setw(10) << "cull ms" << std::endl;
+        for (int count : {1, 2, 4, 6, 8, 10}) {
+            placeLights(factory, count, 0.f);
+            // 所有图块都渲染一次
+            atlas.tileBudget = ShadowAtlas::MAX_TILES;
+            atlas.invalidate();
+            glFinish();
+            Timer timer;
+            update();
+            glFinish();
+            auto fullTime = timer.elapsed();
+            auto stats = atlas.stats;
+
+            // 灯光与相机不动时全部复用
+            atlas.tileBudget = TILE_BUDGET;
+            auto staticTime = timeFrames(update);
+
+            // 每帧移动所有灯光，只在预算内更新
+            float angle = 0.f;
+            size_t deferred = 0;
+            float cullTime = 0.f;  // 一帧内所有图块的剔除与一次上传
+            auto movingTime = timeFrames([&]() {
+                angle += 0.01f;
+                placeLights(factory, count, angle);
+                update();
+                deferred = atlas.stats.deferred;
+                cullTime = clusters.cullTime;
+            });
+
+            std::cout << std::fixed << std::setprecision(3) << std::setw(7) << count << std::setw(8) << stats.tiles
+                      << std::setw(9) << stats.dropped << std::setw(12) << fullTime << std::setw(12) << staticTime
+                      << std::setw(12) << movingTime << std::setw(10) << deferred << std::setw(10) << cullTime
+                      << std::endl;
+        }
+
+        factory.reset();
+        return 0;
+    }
+}
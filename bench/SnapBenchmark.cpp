@@ -0,0 +1,62 @@
+#include "Benchmark.h"
+#include "util/RayPicker.h"
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    /// 随机光标位置上的顶点吸附查询
+    static void snapModel(const string &name, Model &model, int queries) {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> xDist(WIDTH * 0.25f, WIDTH * 0.75f);
+        std::uniform_real_distribution<float> yDist(HEIGHT * 0.1f, HEIGHT * 0.9f);
+
+        size_t vertexCount = 0;
+        for (auto &mesh : model.meshes)
+            vertexCount += mesh.getVertices().size();
+
+        RayPicker picker;
+        Timer buildTimer;
+        picker.buildIndex(model.meshes);
+        auto buildTime = buildTimer.elapsed();
+
+        auto view = viewMatrix();
+        auto projection = projectionMatrix();
+        vector<double> samples;
+        int snapped = 0;
+        for (int i = 0; i < queries; i++) {
+            picker.rayPick(model.meshes, glm::vec3(0.f, 0.f, 3.f), model.basisTransform, view, projection,
+                           xDist(random), yDist(random), WIDTH, HEIGHT);
+            samples.push_back(picker.snapTime);
+            snapped += picker.selectPointValid;
+        }
+
+        auto stats = summarize(samples);
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::setw(10) << vertexCount
+                  << std::setw(12) << std::fixed << std::setprecision(2) << buildTime
+                  << std::setw(12) << std::setprecision(4) << stats.mean
+                  << std::setw(12) << stats.p50
+                  << std::setw(12) << stats.p99
+                  << std::setw(9) << std::setprecision(1) << 100.0 * snapped / queries << "%" << std::endl;
+    }
+
+    int runSnap(const string &assetRoot) {
+        std::cout << "== vertex snap (" << RayPicker().pointPickPixels << " px)" << std::endl;
+        std::cout << std::left << std::setw(32) << "model" << std::right
+                  << std::setw(10) << "vertices" << std::setw(12) << "build ms"
+                  << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+                  << std::setw(10) << "snapped" << std::endl;
+
+        forEachAsset(assetRoot, [](const string &path, Model &model) {
+            snapModel(path, model, 1000);
+        });
+        for (auto size : {1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            snapModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model, 200);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+#include "util/VertexWeld.h"
+#include "util/MeshTopology.h"
+#include "util/Parallel.h"
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    static void topologyModel(const string &name, Model &model) {
+        size_t faceCount = 0;
+        for (auto &mesh : model.meshes)
+            faceCount += mesh.getFaces().size();
+
+        VertexWeld weld(model.meshes);
+        MeshTopology topology(model.meshes, weld);
+        size_t components = 0, loops = 0;
+        for (int j = 0; j < model.meshes.size(); j++) {
+            components += topology.componentCount(j);
+            loops += topology.boundaryLoopCount(j);
+        }
+
+        // 预先生成查询序列，计时只包含查询本身
+        constexpr size_t QUERIES = 1000000;
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> meshDist(0, model.meshes.size() - 1);
+        vector<std::pair<int, unsigned int>> vertices(QUERIES), faces(QUERIES);
+        for (size_t i = 0; i < QUERIES; i++) {
+            auto meshIndex = (int)meshDist(random);
+            const auto &mesh = model.meshes[meshIndex];
+            vertices[i] = {meshIndex, std::uniform_int_distribution<unsigned int>(
+                    0, (unsigned int)mesh.getVertices().size() - 1)(random)};
+            faces[i] = {meshIndex, std::uniform_int_distribution<unsigned int>(
+                    0, (unsigned int)mesh.getFaces().size() - 1)(random)};
+        }
+
+        vector<unsigned int> ring;
+        size_t ringSize = 0;
+        Timer ringTimer;
+        for (auto &query : vertices) {
+            ring.clear();
+            topology.oneRing(query.first, query.second, ring);
+            ringSize += ring.size();
+        }
+        auto ringTime = ringTimer.elapsed();
+
+        size_t neighbourCount = 0;
+        Timer neighbourTimer;
+        for (auto &query : faces) {
+            unsigned int neighbours[3];
+            topology.faceNeighbours(query.first, query.second, neighbours);
+            for (auto neighbour : neighbours)
+                neighbourCount += neighbour != MeshTopology::INVALID;
+        }
+        auto neighbourTime = neighbourTimer.elapsed();
+
+        // 从单个面出发扩张 5 环，以及整个连通分量
+        vector<double> growSamples, connectedSamples;
+        for (size_t i = 0; i < 100; i++) {
+            auto &seed = faces[i];
+            Bitset selection(model.meshes[seed.first].getFaces().size());
+            selection.set(seed.second);
+            Timer growTimer;
+            topology.growFaces(seed.first, selection, 5);
+            growSamples.push_back(growTimer.elapsed());
+
+            Timer connectedTimer;
+            topology.connectedFaces(seed.first, selection);
+            connectedSamples.push_back(connectedTimer.elapsed());
+        }
+        auto grow = summarize(growSamples);
+        auto connected = summarize(connectedSamples);
+
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::setw(10) << faceCount
+                  << std::setw(10) << components
+                  << std::setw(8) << loops
+                  << std::setw(10) << std::fixed << std::setprecision(2) << topology.buildTime
+                  << std::setw(12) << std::setprecision(1) << ringTime * 1e6 / QUERIES
+                  << std::setw(8) << (double)ringSize / QUERIES
+                  << std::setw(12) << neighbourTime * 1e6 / QUERIES
+                  << std::setw(12) << std::setprecision(3) << grow.p50
+                  << std::setw(14) << connected.p50 << std::endl;
+        (void)neighbourCount;
+    }
+
+    int runTopology(const string &assetRoot) {
+        std::cout << "== mesh topology (" << parallel::workerCount() << " threads)" << std::endl;
+        std::cout << std::left << std::setw(32) << "model" << std::right
+                  << std::setw(10) << "faces" << std::setw(10) << "parts" << std::setw(8) << "loops"
+                  << std::setw(10) << "build ms" << std::setw(12) << "ring ns" << std::setw(8) << "valence"
+                  << std::setw(12) << "adjacent ns" << std::setw(12) << "grow5 ms" << std::setw(14) << "connected ms"
+                  << std::endl;
+
+        forEachAsset(assetRoot, [](const string &path, Model &model) {
+            topologyModel(path, model);
+        });
+        for (auto size : {1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            topologyModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,312 @@
+#include "Benchmark.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/OitBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        constexpr int FRAMES = 5;
+        constexpr unsigned int GRID = 64;
+        constexpr float OPACITY = 0.3f;
+        constexpr float FAR_PLANE = 1000.f;
+        constexpr int OIT_UNIT = 23;  // 与 oit_composite_fragment.glsl 一致
+
+        /// z 处朝向相机的平面网格，覆盖 [-width, width] x [-height, height]
+        void addPlane(Model &model, float z, float width, float height) {
+            vector<VertexData> vertices(GRID * GRID);
+            vector<unsigned int> indices;
+            vector<Face> faces;
+            for (unsigned int y = 0; y < GRID; y++) {
+                for (unsigned int x = 0; x < GRID; x++) {
+                    auto u = (float)x / (float)(GRID - 1), v = (float)y / (float)(GRID - 1);
+                    auto &vertex = vertices[y * GRID + x];
+                    vertex.position = glm::vec3((u * 2.f - 1.f) * width, (v * 2.f - 1.f) * height, z);
+                    vertex.normal = glm::vec3(0.f, 0.f, 1.f);
+                    vertex.texCoord = glm::vec2(u, v);
+                }
+            }
+            for (unsigned int y = 0; y + 1 < GRID; y++) {
+                for (unsigned int x = 0; x + 1 < GRID; x++) {
+                    auto i0 = y * GRID + x;
+                    Face f0{{i0, i0 + 1, i0 + GRID + 1}};
+                    Face f1{{i0, i0 + GRID + 1, i0 + GRID}};
+                    for (auto &f : {f0, f1}) {
+                        faces.push_back(f);
+                        indices.insert(indices.end(), f.vertex, f.vertex + 3);
+                    }
+                }
+            }
+            MeshInfo info;
+            info.minVertex = glm::vec3(-width, -height, z);
+            info.maxVertex = glm::vec3(width, height, z);
+            model.meshes.emplace_back(vertices, indices, faces, vector<Texture>(), info);
+        }
+
+        /// 第 layer 层的颜色，相邻层色相不同，排序错误时颜色明显偏移
+        glm::vec3 layerColor(int layer) {
+            auto hue = (float)layer * 0.618f;
+            hue -= std::floor(hue);
+            return glm::clamp(glm::abs(glm::mod(hue * 6.f + glm::vec3(0.f, 4.f, 2.f), 6.f) - 3.f) - 1.f, 0.f, 1.f);
+        }
+
+        /// 每帧按深度排序 triangles 个三角形的 CPU 耗时（毫秒），按重心深度，OIT 要省掉的就是这一步
+        double sortTime(size_t triangles) {
+            vector<std::pair<float, unsigned int>> keys(triangles);
+            for (size_t i = 0; i < triangles; i++)
+                keys[i] = {std::sin((float)i * 12.9898f) * 43758.5453f, (unsigned int)i};
+            Timer timer;
+            std::sort(keys.begin(), keys.end());
+            return timer.elapsed();
+        }
+    }
+
+    int runTransparency(const string &assetRoot) {
+        std::cout << "== transparency: weighted blended vs per-pixel linked-list OIT (" << WIDTH << "x" << HEIGHT
+                  << ", stacked planes at opacity " << OPACITY << ", mean of " << FRAMES << " frames) =="
+                  << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        auto vertexPath = assetRoot + "/shader/model_vertex.glsl";
+        auto fragmentPath = assetRoot + "/shader/model_fragment.glsl";
+        ShaderVariants variants(vertexPath, fragmentPath);
+        ShaderProgram compositeShader, resolveShader;
+        compositeShader.load(assetRoot + "/shader/screen_vertex.glsl", assetRoot + "/shader/oit_composite_fragment.glsl");
+        resolveShader.load(assetRoot + "/shader/screen_vertex.glsl", assetRoot + "/shader/oit_resolve_fragment.glsl");
+        for (auto *program : {&compositeShader, &resolveShader}) {
+            if (!program->linked()) {
+                std::cerr << program->lastError() << std::endl;
+                return 1;
+            }
+        }
+
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        GLuint screenVao;
+        glGenVertexArrays(1, &screenVao);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        auto matrix = glm::mat4(1.f);
+        GpuBuffer frameBuffer, materialBuffer;
+        FrameData frame{view, projection, glm::vec3(0.f, 0.f, 3.f), FAR_PLANE};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.bindBase(MATERIAL_BINDING);
+
+        auto &factory = LightFactory::get();
+        factory.reset();
+        factory.updateBuffer();
+        ShaderPermutation permutation;
+        permutation.dirLights = factory.dirLightCount();
+        permutation.pointLights = factory.pointLightCount();
+        permutation.spotLights = factory.spotLightCount();
+        ShaderProgram *programs[3];
+        for (int oit = 0; oit < 3; oit++) {
+            permutation.oit = oit;
+            programs[oit] = variants.get(permutation);
+            if (!programs[oit]) {
+                std::cerr << "variant failed to compile" << std::endl;
+                return 1;
+            }
+        }
+
+        OitBuffer oitBuffer;
+        oitBuffer.allocate(WIDTH, HEIGHT, OitBuffer::depthFormat(fbo));
+        int result = 0;
+        std::cout << std::left << std::setw(8) << "layers" << std::right << std::setw(12) << "fragments"
+                  << std::setw(12) << "sort ms" << std::setw(14) << "weighted ms" << std::setw(12) << "linked ms"
+                  << std::setw(16) << "weighted error" << std::setw(14) << "linked error" << std::setw(12) << "dropped"
+                  << std::endl;
+        for (int layers : {1, 2, 4, 8, 16}) {
+            // 一块不透明的平面挡住中间一半宽度，位于透明层的中间，其后的透明片元被深度测试剔除
+            Model scene;
+            for (int layer = 0; layer < layers; layer++)
+                addPlane(scene, -0.1f * (float)layer, 1.2f, 0.7f);
+            addPlane(scene, -0.1f * (float)(layers - 1) * 0.5f - 0.05f, 0.6f, 0.7f);
+            auto opaque = scene.meshes.size() - 1;
+            oitBuffer.allocateLists(WIDTH, HEIGHT, layers + 1);
+
+            auto draw = [&](ShaderProgram &program, size_t mesh) {
+                material.diffuse = mesh == opaque ? glm::vec3(0.5f) : layerColor((int)mesh);
+                materialBuffer.update(0, &material, sizeof(material));
+                program.setValue("opacity", mesh == opaque ? 1.f : OPACITY);
+                scene.renderMesh(mesh, &program, false, false);
+            };
+            auto use = [&](ShaderProgram &program) {
+                program.use(matrix, view, projection);
+                program.setValue("shadowLight", -1);
+                program.setValue("shadowMap", 31);  // 与网格纹理的单元区分，否则采样器类型冲突
+                program.setValue("oitWidth", WIDTH);
+                program.setValue("oitCapacity", (int)oitBuffer.nodeCapacity());
+            };
+            auto opaquePass = [&]() {
+                glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                use(*programs[0]);
+                draw(*programs[0], opaque);
+            };
+            auto composite = [&](ShaderProgram &program) {
+                glDepthFunc(GL_ALWAYS);
+                glDepthMask(GL_FALSE);
+                program.use();
+                program.setValue("oitWidth", WIDTH);
+                glBindVertexArray(screenVao);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                glBindVertexArray(0);
+                glDepthFunc(GL_LESS);
+                glDepthMask(GL_TRUE);
+                glDisable(GL_BLEND);
+            };
+
+            // 与 MainRender::renderTransparent 相同的状态
+            auto weighted = [&]() {
+                oitBuffer.begin(fbo);
+                glEnable(GL_BLEND);
+                glBlendFunci(OitBuffer::ACCUM, GL_ONE, GL_ONE);
+                glBlendFunci(OitBuffer::REVEALAGE, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+                glDepthMask(GL_FALSE);
+                use(*programs[ShaderPermutation::OIT_WEIGHTED_MODE]);
+                for (int layer = 0; layer < layers; layer++)
+                    draw(*programs[ShaderPermutation::OIT_WEIGHTED_MODE], layer);
+                glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+                glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+                oitBuffer.bindTextures(OIT_UNIT);
+                composite(compositeShader);
+            };
+            auto linked = [&]() {
+                oitBuffer.clearLists();
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                glDepthMask(GL_FALSE);
+                use(*programs[ShaderPermutation::OIT_LINKED_MODE]);
+                for (int layer = 0; layer < layers; layer++)
+                    draw(*programs[ShaderPermutation::OIT_LINKED_MODE], layer);
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+                composite(resolveShader);
+            };
+            // 参考结果：平面互不相交，按网格由远到近混合即为精确结果
+            auto sorted = [&]() {
+                glEnable(GL_BLEND);
+                glBlendColor(0.f, 0.f, 0.f, OPACITY);
+                glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+                glDepthMask(GL_FALSE);
+                use(*programs[0]);
+                for (int layer = layers - 1; layer >= 0; layer--)
+                    draw(*programs[0], layer);
+                glDepthMask(GL_TRUE);
+                glDisable(GL_BLEND);
+            };
+
+            auto capture = [&](const std::function<void()> &transparent) {
+                opaquePass();
+                transparent();
+                glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+                vector<unsigned char> pixels((size_t)WIDTH * HEIGHT * 4);
+                glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                return pixels;
+            };
+            auto reference = capture(sorted);
+            auto linkedImage = capture(linked);
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            auto fragments = oitBuffer.readFragmentCount();
+            auto weightedImage = capture(weighted);
+            // 透明层覆盖的像素上每个通道的平均误差（0-255）
+            auto error = [&](const vector<unsigned char> &image) {
+                double sum = 0.0;
+                size_t count = 0;
+                for (size_t i = 0; i < image.size(); i += 4) {
+                    if (image[i] == reference[i] && image[i + 1] == reference[i + 1] && image[i + 2] == reference[i + 2] &&
+                        reference[i] == 0 && reference[i + 1] == 0 && reference[i + 2] == 0)
+                        continue;  // 背景
+                    for (int c = 0; c < 3; c++)
+                        sum += std::abs((int)image[i + c] - (int)reference[i + c]);
+                    count += 3;
+                }
+                return count > 0 ? sum / (double)count : 0.0;
+            };
+
+            auto weightedTimes = finishTimes(FRAMES, {opaquePass, weighted});
+            auto linkedTimes = finishTimes(FRAMES, {opaquePass, linked});
+            // 延迟读回：每帧只复制计数，绘制完成后的帧读到的计数与同步读回一致
+            for (int frame = 0; frame < 4; frame++) {
+                opaquePass();
+                linked();
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                oitBuffer.queryFragmentCount();
+                glFinish();
+            }
+            if (oitBuffer.fragmentCount() != fragments) {
+                std::cerr << layers << " layers: delayed fragment count " << oitBuffer.fragmentCount()
+                          << " differs from " << fragments << std::endl;
+                result = 1;
+            }
+            auto triangles = (size_t)layers * (GRID - 1) * (GRID - 1) * 2;
+            auto dropped = fragments > oitBuffer.nodeCapacity() ? fragments - oitBuffer.nodeCapacity() : 0;
+            auto linkedError = error(linkedImage);
+            if (dropped > 0 || linkedError > 1.0) {
+                std::cerr << layers << " layers: linked-list OIT differs from sorted blending" << std::endl;
+                result = 1;
+            }
+            std::cout << std::left << std::setw(8) << layers << std::right << std::setw(12) << fragments
+                      << std::fixed << std::setprecision(3) << std::setw(12) << sortTime(triangles) << std::setw(14)
+                      << weightedTimes[1] << std::setw(12) << linkedTimes[1] << std::setprecision(2) << std::setw(16)
+                      << error(weightedImage) << std::setw(14) << linkedError << std::setw(12) << dropped
+                      << std::defaultfloat << std::endl;
+        }
+
+        factory.reset();
+        glEnable(GL_CULL_FACE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteVertexArrays(1, &screenVao);
+        return result;
+    }
+}
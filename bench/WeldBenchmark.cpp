@@ -0,0 +1,60 @@
+#include "Benchmark.h"
+#include "util/VertexWeld.h"
+#include "util/opengl/PolygonPoint.h"
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+namespace bench {
+    /// 随机顶点上的高亮切换
+    static void weldModel(const string &name, Model &model, size_t toggles) {
+        Timer buildTimer;
+        VertexWeld weld(model.meshes);
+        auto buildTime = buildTimer.elapsed();
+
+        PolygonPoint points(model.meshes, weld, true);
+        std::mt19937 random(42);
+        std::uniform_int_distribution<size_t> meshDist(0, model.meshes.size() - 1);
+
+        // 预先生成切换序列，计时只包含切换本身
+        vector<std::pair<int, unsigned int>> sequence(toggles);
+        for (auto &item : sequence) {
+            item.first = (int)meshDist(random);
+            auto count = model.meshes[item.first].getVertices().size();
+            item.second = std::uniform_int_distribution<unsigned int>(0, (unsigned int)count - 1)(random);
+        }
+
+        Timer toggleTimer;
+        for (auto &item : sequence)
+            points.modifyIndices(item.first, item.second);
+        auto toggleTime = toggleTimer.elapsed();
+
+        std::cout << std::left << std::setw(32) << name << std::right
+                  << std::setw(10) << weld.vertexCount()
+                  << std::setw(10) << weld.groupCount()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << buildTime
+                  << std::setw(12) << std::setprecision(0) << toggles / (toggleTime / 1000.0)
+                  << std::setw(10) << std::setprecision(1) << toggleTime * 1e6 / toggles
+                  << std::setw(12) << points.pointCount() << std::endl;
+    }
+
+    int runWeld(const string &assetRoot) {
+        constexpr size_t TOGGLES = 1000000;
+        std::cout << "== vertex weld + point highlight (" << TOGGLES << " toggles)" << std::endl;
+        std::cout << std::left << std::setw(32) << "model" << std::right
+                  << std::setw(10) << "vertices" << std::setw(10) << "groups" << std::setw(12) << "build ms"
+                  << std::setw(12) << "toggles/s" << std::setw(10) << "ns" << std::setw(12) << "highlighted"
+                  << std::endl;
+
+        forEachAsset(assetRoot, [](const string &path, Model &model) {
+            weldModel(path, model, TOGGLES);
+        });
+        for (auto size : {1000u, 2000u}) {
+            std::unique_ptr<Model> model(makeScan(size));
+            weldModel("scan " + std::to_string(size) + "x" + std::to_string(size), *model, TOGGLES);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,197 @@
+#include "Benchmark.h"
+#include "util/LightFactory.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderProgram.h"
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+namespace bench {
+    namespace {
+        /// 与 MainRender 的 Frame 块、Model 的 Material 块布局一致
+        struct FrameData {
+            glm::mat4 view;
+            glm::mat4 projection;
+            glm::vec3 viewPos;
+            float farPlane;
+        };
+
+        struct MaterialData {
+            glm::vec3 ambient = glm::vec3(1.f);
+            float shininess = 32.f;
+            glm::vec3 diffuse = glm::vec3(1.f);
+            float dissolve = 1.f;
+            glm::vec3 specular = glm::vec3(1.f);
+            float refractiveIndex = 1.f;
+            glm::vec3 emission = glm::vec3(0.f);
+            int illum = 2;
+        };
+
+        constexpr int FRAMES = 10;
+        constexpr int REPEATS = 5;
+        constexpr float FAR_PLANE = 1000.f;
+        const glm::vec3 LINE_COLOR(0.f, 0.f, 0.f);
+        const glm::vec3 POINT_COLOR(1.f, 0.f, 0.f);
+    }
+
+    int runWireframe(const string &assetRoot) {
+        std::cout << "== wireframe: fill + line + point overlay (" << WIDTH << "x" << HEIGHT
+                  << ", model/bun_zipper.ply, mean of " << FRAMES << " frames) ==" << std::endl;
+        if (!createContext()) {
+            std::cout << "skipped: no OpenGL context available" << std::endl;
+            return 0;
+        }
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+
+        std::unique_ptr<Model> model;
+        try {
+            model.reset(loadModel(assetRoot, "model/bun_zipper.ply", false));
+        }
+        catch (std::runtime_error &ex) {
+            std::cout << "skipped: " << ex.what() << std::endl;
+            return 0;
+        }
+
+        // 加载时建立的边缓冲之外单独计时去重
+        size_t faces = 0, edges = 0;
+        vector<double> samples;
+        for (int i = 0; i < REPEATS; i++) {
+            Timer timer;
+            edges = 0;
+            for (auto &mesh : model->meshes)
+                edges += Mesh::uniqueEdges(mesh.getIndices(), mesh.getVertices().size()).size() / 2;
+            samples.push_back(timer.elapsed());
+        }
+        for (auto &mesh : model->meshes)
+            faces += mesh.getFaces().size();
+        auto build = summarize(samples);
+        std::cout << "unique edges: " << edges << " of " << faces * 3 << " triangle edges, built in "
+                  << std::fixed << std::setprecision(3) << build.p50 << " ms (median of " << REPEATS << ")"
+                  << std::defaultfloat << std::endl;
+
+        auto vertexPath = assetRoot + "/shader/model_vertex.glsl";
+        auto fragmentPath = assetRoot + "/shader/model_fragment.glsl";
+        ShaderProgram fillShader, wireShader, colorShader;
+        fillShader.load(vertexPath, fragmentPath);
+        wireShader.loadAsync(vertexPath, fragmentPath, assetRoot + "/shader/wireframe_geometry.glsl",
+                             "#define WIREFRAME\n");
+        wireShader.finish();
+        colorShader.load(vertexPath, assetRoot + "/shader/model_color_fragment.glsl");
+        for (auto *program : {&fillShader, &wireShader, &colorShader}) {
+            if (!program->linked()) {
+                std::cerr << program->lastError() << std::endl;
+                return 1;
+            }
+        }
+
+        GLuint target, depth, fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenRenderbuffers(1, &target);
+        glBindRenderbuffer(GL_RENDERBUFFER, target);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+
+        auto view = viewMatrix(), projection = projectionMatrix();
+        auto matrix = model->basisTransform;
+        GpuBuffer frameBuffer, materialBuffer;
+        FrameData frame{view, projection, glm::vec3(0.f, 0.f, 3.f), FAR_PLANE};
+        MaterialData material;
+        frameBuffer.allocate(sizeof(frame));
+        frameBuffer.update(0, &frame, sizeof(frame));
+        frameBuffer.bindBase(FRAME_BINDING);
+        materialBuffer.allocate(sizeof(material));
+        materialBuffer.update(0, &material, sizeof(material));
+        materialBuffer.bindBase(MATERIAL_BINDING);
+        auto &factory = LightFactory::get();
+        factory.reset();
+        factory.updateBuffer();
+
+        auto fill = [&](ShaderProgram &program, bool offset) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            if (offset) {
+                glEnable(GL_POLYGON_OFFSET_FILL);
+                glPolygonOffset(1.0f, 1.0f);
+            }
+            program.use(matrix, view, projection);
+            program.setValue("shadowLight", -1);
+            program.setValue("shadowMap", 31);  // 与网格纹理的单元区分，否则采样器类型冲突
+            program.setValue("wireColor", LINE_COLOR);
+            program.setValue("wireWidth", 1.f);
+            program.setValue("viewportSize", glm::vec2(WIDTH, HEIGHT));
+            model->render(&program, false, false);
+            glDisable(GL_POLYGON_OFFSET_FILL);
+        };
+        // 与 MainRender::renderLine / renderPoint 相同
+        auto lines = [&]() {
+            glDepthFunc(GL_LEQUAL);
+            colorShader.use(matrix, view, projection);
+            colorShader.setValue("modelColor", LINE_COLOR);
+            model->renderEdges();
+            glDepthFunc(GL_LESS);
+        };
+        auto points = [&]() {
+            glDepthFunc(GL_LEQUAL);
+            glPointSize(2.5f);
+            colorShader.use(matrix, view, projection);
+            colorShader.setValue("modelColor", POINT_COLOR);
+            model->renderPoints();
+            glDepthFunc(GL_LESS);
+        };
+        // 去重之前的做法：以多边形模式重新绘制全部三角形，每条内部边光栅化两次
+        auto legacyPass = [&](GLenum polygonMode, GLenum offsetMode, float offset, const glm::vec3 &color) {
+            glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
+            glEnable(offsetMode);
+            glPolygonOffset(offset, offset);
+            colorShader.use(matrix, view, projection);
+            colorShader.setValue("modelColor", color);
+            model->render(&colorShader, true, false);
+            glDisable(offsetMode);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        };
+
+        struct Mode {
+            const char *name;
+            vector<std::function<void()>> passes;
+        };
+        const Mode modes[] = {
+                {"polygon-mode redraw", {[&]() { fill(fillShader, false); },
+                                         [&]() { legacyPass(GL_LINE, GL_POLYGON_OFFSET_LINE, -1.f, LINE_COLOR); },
+                                         [&]() { legacyPass(GL_POINT, GL_POLYGON_OFFSET_POINT, -1.5f, POINT_COLOR); }}},
+                {"edge buffer", {[&]() { fill(fillShader, true); }, lines, points}},
+                {"single-pass", {[&]() { fill(wireShader, true); }, [] {}, points}},
+        };
+
+        glLineWidth(1.0f);
+        glPointSize(2.5f);
+        std::cout << std::left << std::setw(22) << "mode" << std::right << std::setw(10) << "fill ms"
+                  << std::setw(10) << "line ms" << std::setw(10) << "point ms" << std::setw(11) << "total ms"
+                  << std::setw(10) << "speedup" << std::endl;
+        double baseline = 0.0;
+        for (auto &mode : modes) {
+            auto times = finishTimes(FRAMES, mode.passes);
+            auto total = times[0] + times[1] + times[2];
+            if (baseline == 0.0)
+                baseline = total;
+            std::cout << std::left << std::setw(22) << mode.name << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(10) << times[0] << std::setw(10) << times[1] << std::setw(10) << times[2]
+                      << std::setw(11) << total << std::setprecision(2) << std::setw(9) << baseline / total << "x"
+                      << std::defaultfloat << std::endl;
+        }
+
+        factory.reset();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &target);
+        glDeleteRenderbuffers(1, &depth);
+        return 0;
+    }
+}
@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include <iostream>
+#include <functional>
+#include <map>
+
+/// 用法: model-viewer-bench [--assets <dir>] [benchmark...]
+/// 不指定基准名称时运行全部
+int main(int argc, char **argv)
+{
+    const std::map<string, std::function<int(const string &)>> benchmarks = {
+            {"snap", bench::runSnap},
+            {"region", bench::runRegion},
+            {"ray", bench::runRay},
+            {"weld", bench::runWeld},
+            {"faces", bench::runFace},
+            {"topology", bench::runTopology},
+            {"selection", bench::runSelection},
+            {"shading", bench::runShading},
+            {"shadow", bench::runShadow},
+            {"atlas", bench::runAtlas},
+            {"clusters", bench::runClusters},
+            {"deferred", bench::runDeferred},
+            {"prepass", bench::runPrepass},
+            {"lamps", bench::runLamp},
+            {"wireframe", bench::runWireframe},
+            {"transparency", bench::runTransparency},
+            {"profiler", bench::runProfiler},
+    };
+
+    string assetRoot = "assets";
+    vector<string> names;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--assets" && i + 1 < argc)
+            assetRoot = argv[++i];
+        else
+            names.push_back(arg);
+    }
+    if (names.empty())
+        for (auto &it : benchmarks)
+            names.push_back(it.first);
+
+    int result = 0;
+    for (auto &name : names) {
+        auto it = benchmarks.find(name);
+        if (it == benchmarks.end()) {
+            std::cerr << "Unknown benchmark: " << name << std::endl;
+            return 1;
+        }
+        try {
+            result |= it->second(assetRoot);
+        }
+        catch (std::runtime_error &ex) {
+            std::cerr << ex.what() << std::endl;
+            result = 1;
+        }
+        std::cout << std::endl;
+    }
+    return result;
+}
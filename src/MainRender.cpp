@@ -5,6 +5,10 @@
 #include "util/opengl/PolygonPoint.h"
 #include "util/opengl/PolygonTriangle.h"
 #include "util/RayPicker.h"
+#include "util/VertexWeld.h"
+#include "util/FaceLookup.h"
+#include "util/MeshTopology.h"
+#include "util/Profiler.h"
 #include "util/event/Event.h"
 #include "util/event/Mouse.h"
 #include "util/event/Keyboard.h"
@@ -12,6 +16,12 @@
 #include "imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <random>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/random.hpp>
@@ -49,9 +59,11 @@ MainRender::MainRender(GLFWwindow *window, Camera *camera, Mouse *mouse, Keyboar
 MainRender::~MainRender()
 {
     unloadModel();
+    glDeleteVertexArrays(1, &m_screenVao);
 
     delete m_lampModel;
     delete rayPicker;
+    delete regionPicker;
 
     delete m_lineColor;
     delete m_pointColor;
@@ -64,6 +76,8 @@ MainRender::~MainRender()
 void MainRender::render(float deltaTime)
 {
     m_deltaTime = deltaTime;
+    ShaderProgram::resetStats();
+    GpuBuffer::resetStats();
     glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -81,28 +95,111 @@ void MainRender::render(float deltaTime)
 //             -5.f * m_height / m_width / 2.0f, 5.f * m_height / m_width / 2.0f,
 //             NEAR_PLANE, FAR_PLANE);
     m_viewMatrix = m_camera->GetViewMatrix();
-
+    updateFrameBuffer();
     if (modelLoaded) {
         updateModelMatrix();
+        updateSampledLights();
+    }
+    lightFactory->updateBuffer();
+
+    if (modelLoaded) {
+        updateDrawOrder();
         if (mode.fill) {
-            renderShadow(0);
+            if (atlasShadows)
+                updateShadowAtlas();
+            else
+                updateShadow(0);
+            if (clusteredLighting)
+                updateLightClusters();
+            // 光照阶段写入深度，之后的叠加层与前向渲染时一样按深度测试
+            if (deferredShading && !overdrawView)
+                renderDeferred();
         }
 
+        auto overlayStart = std::chrono::steady_clock::now();
+        overlayTimer.begin();
         renderHighlight(m_modelColorShader);
         if (mode.select) renderSelect(m_modelColorShader);
-        if (mode.fill) {
-            renderFill(m_modelShader);
-        }
-        if (mode.line) renderLine(m_modelColorShader);
+        overlayTimer.end();
+        overlayCpuTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - overlayStart).count();
+        if (mode.fill && (!deferredShading || overdrawView))
+            renderForward();
+        if (mode.fill && !overdrawView && !m_transparentOrder.empty())
+            renderTransparent();
+        else
+            transparencyStats = TransparencyStats();
+        wireTimer.begin();
+        if (!mode.fill && occludedOverlay && (mode.line || mode.point))
+            renderOverlayDepth();
+        if (mode.line && (!fillDrawsWireframe() || !m_transparentOrder.empty())) renderLine(m_modelColorShader);
         if (mode.point) renderPoint(m_modelColorShader);
+        wireTimer.end();
     }
 
     if (mode.lamp) renderLamp(m_lampShader);
 }
 
-void MainRender::renderShadow(int lightIndex) {
+bool MainRender::needsRedraw() const
+{
+    if (m_modelVariants.pending() > 0)
+        return true;
+    if (!modelLoaded || !mode.fill)
+        return false;
+    if (atlasShadows)
+        return shadowAtlas.stats.deferred > 0;
+    return m_shadowDirtyFaces != 0 && lightFactory->getLight(0)->type != NONE;
+}
+
+void MainRender::updateShadow(int lightIndex) {
+    PROFILE_PASS("Shadow Map");
+    auto light = lightFactory->getLight(lightIndex);
+    if (light->type == NONE)  // 着色器不会采样阴影贴图
+        return;
+    initializeShadow();
+
+    ShadowKey key{light->position, m_shadowMap.format().resolution, m_modelMatrix, (int)transparency, modelOpacity};
+    bool changed = std::memcmp(&key, &m_shadowKey, sizeof(ShadowKey)) != 0;
+    if (changed) {
+        m_shadowKey = key;
+        m_shadowDirtyFaces = ALL_SHADOW_FACES;
+    }
+    if (!shadowCache)
+        m_shadowDirtyFaces = ALL_SHADOW_FACES;
+
+    auto faceTime = shadowTimer.elapsedPerSample();
+    if (m_shadowDirtyFaces == 0) {
+        shadowStats.framesSkipped++;
+        shadowStats.savedTime += 6 * faceTime;
+        return;
+    }
+
+    // 灯光或模型正在移动时只轮流更新一个面，停止后的第一帧补齐其余的面
+    // 其它面暂时保留上一次的内容
+    auto faces = m_shadowDirtyFaces;
+    if (shadowCache && shadowAmortize && changed && !m_shadowStale) {
+        while (!(m_shadowDirtyFaces & (1u << m_shadowNextFace)))
+            m_shadowNextFace = (m_shadowNextFace + 1) % 6;
+        faces = 1u << m_shadowNextFace;
+        m_shadowNextFace = (m_shadowNextFace + 1) % 6;
+    }
+
+    int faceCount = 0;
+    for (int i = 0; i < 6; i++)
+        faceCount += (faces >> i) & 1;
+    shadowTimer.begin(faceCount);
+    renderShadow(lightIndex, faces);
+    shadowTimer.end();
+    m_shadowDirtyFaces &= ~faces;
+    m_shadowStale = false;
+
+    shadowStats.framesRendered++;
+    shadowStats.facesRendered += faceCount;
+    shadowStats.savedTime += (6 - faceCount) * faceTime;
+}
+
+void MainRender::renderShadow(int lightIndex, unsigned int faces) {
     // 渲染深度贴图
-    glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, NEAR_PLANE, FAR_PLANE);
+    glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, FAR_PLANE);
     std::vector<glm::mat4> shadowTransforms;
     auto lightPos = lightFactory->getLight(lightIndex)->position;
     shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
@@ -113,15 +210,37 @@ void MainRender::renderShadow(int lightIndex) {
     shadowTransforms.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
     // render scene from light's point of view
     glCullFace(GL_FRONT);
-    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_depthMapFbo);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    m_shadowShader.use();
-    for (unsigned int i = 0; i < 6; ++i)
-        m_shadowShader.setValue("shadowMatrices[" + std::to_string(i) + "]", shadowTransforms[i]);
-    m_shadowShader.setValue("far_plane", FAR_PLANE);
-    m_shadowShader.setValue("lightPos", lightPos);
-    renderFill(m_shadowShader);
+    auto resolution = (GLsizei)m_shadowMap.format().resolution;
+    glViewport(0, 0, resolution, resolution);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_shadowMap.framebuffer());
+    if (shadowPath != SHADOW_GEOMETRY) {
+        renderShadowClusters(lightPos, shadowTransforms.data(), faces);
+    }
+    else if (faces == ALL_SHADOW_FACES) {
+        m_shadowShader.use();
+        m_shadowMatrices.set(shadowTransforms.data(), 6);
+        m_shadowShader.setValue("far_plane", FAR_PLANE);
+        m_shadowShader.setValue("lightPos", lightPos);
+        m_shadowShader.setValue("faceMask", (int)faces);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        renderShadowFill();
+    }
+    else {
+        m_shadowShader.use();
+        m_shadowMatrices.set(shadowTransforms.data(), 6);
+        m_shadowShader.setValue("far_plane", FAR_PLANE);
+        m_shadowShader.setValue("lightPos", lightPos);
+        // 逐个面挂载为非分层附件，几何着色器只输出该面的图元，清除也只影响该面
+        for (int i = 0; i < 6; i++) {
+            if (!(faces & (1u << i)))
+                continue;
+            m_shadowMap.attachFace(i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            m_shadowShader.setValue("faceMask", 1 << i);
+            renderShadowFill();
+        }
+        m_shadowMap.attachLayered();
+    }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glCullFace(GL_BACK);
     // reset viewport
@@ -129,7 +248,188 @@ void MainRender::renderShadow(int lightIndex) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void MainRender::updateShadowAtlas() {
+    PROFILE_PASS("Shadow Atlas");
+    // 立方体贴图不再使用，释放显存，切换回来时按预算重新分配
+    m_shadowMap.release();
+    if (shadowAtlas.allocate(ShadowAtlas::fit(shadowBudget)))
+        invalidateShadow();
+
+    // 手电筒与相机位置重合，阴影看不到
+    vector<ShadowAtlas::Caster> casters;
+    for (int i = 0; i < MAX_LIGHT_NUM; i++) {
+        auto light = lightFactory->getLight(i);
+        if (light->type != NONE && light->type != TORCH_LIGHT && light->castShadow)
+            casters.push_back({i, lightFactory->bufferIndex(i), light});
+    }
+    shadowAtlas.layout(casters, {m_viewMatrix, m_projectionMatrix, NEAR_PLANE, FAR_PLANE}, m_modelMatrix);
+    if (!shadowCache)
+        shadowAtlas.invalidate();
+
+    m_shadowAtlasShader.use();
+    m_shadowAtlasShader.setValue("model", m_modelMatrix);
+    // 所有图块一次剔除、一次上传绘制命令，每个图块按偏移绘制自己的一段
+    shadowAtlas.render([this](const vector<glm::mat4> &matrices) {
+        m_shadowClusters->cullViews(m_modelMatrix, matrices);
+    }, [this](size_t tile, const glm::mat4 &matrix) {
+        m_shadowAtlasShader.setValue("lightMatrix", matrix);
+        m_shadowClusters->drawView(tile);
+    });
+    glViewport(0, 0, m_width, m_height);
+}
+
+void MainRender::bindShadowAtlas() const {
+    glActiveTexture(GL_TEXTURE0 + SHADOW_ATLAS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, atlasShadows ? shadowAtlas.texture() : 0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void MainRender::sampleLights(size_t count) {
+    m_sampledLights.clear();
+    lightFactory->clearSampledLights();
+    if (count == 0 || !modelLoaded)
+        return;
+
+    size_t vertexTotal = 0;
+    glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+    for (auto &mesh : m_model->meshes) {
+        for (auto &vertex : mesh.getVertices()) {
+            low = glm::min(low, vertex.position);
+            high = glm::max(high, vertex.position);
+        }
+        vertexTotal += mesh.getVertices().size();
+    }
+    if (vertexTotal == 0)
+        return;
+    // 影响范围为模型尺寸的 5%，光照在范围处衰减到 LightClusters::CUTOFF
+    auto range = glm::length(high - low) * 0.05f;
+
+    std::mt19937 random((unsigned int)count);
+    std::uniform_int_distribution<size_t> pick(0, vertexTotal - 1);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    m_sampledLights.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        auto index = pick(random);
+        int j = 0;
+        while (index >= m_model->meshes[j].getVertices().size())
+            index -= m_model->meshes[j++].getVertices().size();
+        auto &vertex = m_model->meshes[j].getVertices()[index];
+
+        auto &light = m_sampledLights[i];
+        light = LightData{};
+        light.type = i % 4 == 3 ? SPOT_LIGHT : POINT_LIGHT;
+        light.position = vertex.position + vertex.normal * range * 0.2f;
+        light.direction = -vertex.normal;
+        light.cutOff = std::cos(glm::radians(30.f));
+        light.outerCutOff = std::cos(glm::radians(45.f));
+        glm::vec3 color(unit(random), unit(random), unit(random));
+        light.color = color / std::max(std::max(color.r, color.g), std::max(color.b, 0.01f));
+        light.diffuse = glm::vec3(1.f);
+        light.specular = glm::vec3(0.5f);
+        light.constant = 1.f;
+        light.quadratic = (1.f / LightClusters::CUTOFF - 1.f) / (range * range);
+    }
+    m_sampledMatrix = glm::mat4(0.f);
+}
+
+void MainRender::updateSampledLights() {
+    if (m_sampledLights.empty() || m_sampledMatrix == m_modelMatrix)
+        return;
+    m_sampledMatrix = m_modelMatrix;
+    // 模型矩阵为均匀缩放，衰减按缩放后的距离计算
+    auto scale = glm::length(glm::vec3(m_modelMatrix[0]));
+    auto rotation = glm::mat3(m_modelMatrix) / scale;
+    auto world = m_sampledLights;
+    for (auto &light : world) {
+        light.position = glm::vec3(m_modelMatrix * glm::vec4(light.position, 1.f));
+        light.direction = rotation * light.direction;
+        light.quadratic /= scale * scale;
+    }
+    lightFactory->setSampledLights(world);
+}
+
+void MainRender::updateLightClusters() {
+    PROFILE_PASS("Light Clusters");
+    lightClusters.build(lightFactory->lightData(), lightFactory->lightCount(), m_viewMatrix, m_projectionMatrix,
+                        NEAR_PLANE, FAR_PLANE);
+
+    auto &grid = lightClusters.grid;
+    ClusterHeader header{glm::uvec4(grid.x, grid.y, grid.z, 0),
+                         glm::vec4((float)grid.x / (float)std::max(m_width, 1), (float)grid.y / (float)std::max(m_height, 1),
+                                   lightClusters.depthScale(), lightClusters.depthBias())};
+    auto &ranges = lightClusters.ranges();
+    auto rangeBytes = ranges.size() * sizeof(glm::uvec2);
+    if (m_clusterBuffer.size() != sizeof(ClusterHeader) + rangeBytes)
+        m_clusterBuffer.allocate(sizeof(ClusterHeader) + rangeBytes);
+    m_clusterBuffer.update(0, &header, sizeof(ClusterHeader));
+    m_clusterBuffer.update(sizeof(ClusterHeader), ranges.data(), rangeBytes);
+
+    // 索引数量随相机变化，按 1.5 倍增长，避免每帧重新分配
+    auto &indices = lightClusters.indices();
+    auto indexBytes = std::max<size_t>(indices.size(), 1) * sizeof(uint32_t);
+    if (m_clusterLightBuffer.size() < indexBytes)
+        m_clusterLightBuffer.allocate(indexBytes * 3 / 2);
+    m_clusterLightBuffer.update(0, indices.data(), indices.size() * sizeof(uint32_t));
+
+    m_clusterBuffer.bindBase(CLUSTER_BINDING);
+    m_clusterLightBuffer.bindBase(CLUSTER_LIGHT_BINDING);
+}
+
+void MainRender::renderShadowClusters(const glm::vec3 &lightPos, const glm::mat4 *shadowTransforms, unsigned int faces) {
+    m_shadowClusters->cull(m_modelMatrix, shadowTransforms, faces);
+    bool layered = shadowPath == SHADOW_LAYERED && ShadowClusters::layeredSupported();
+    auto &shader = layered ? m_shadowLayeredShader : m_shadowFaceShader;
+    shader.use();
+    shader.setValue("model", m_modelMatrix);
+    (layered ? m_layeredShadowMatrices : m_faceShadowMatrices).set(shadowTransforms, 6);
+    shader.setValue("far_plane", FAR_PLANE);
+    shader.setValue("lightPos", lightPos);
+
+    if (layered) {
+        // 只更新部分面时逐个挂载并清除，再恢复分层挂载一次绘制
+        if (faces == ALL_SHADOW_FACES) {
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+        else {
+            for (int i = 0; i < 6; i++) {
+                if (!(faces & (1u << i)))
+                    continue;
+                m_shadowMap.attachFace(i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+            }
+            m_shadowMap.attachLayered();
+        }
+        m_shadowClusters->drawLayered();
+    }
+    else {
+        for (int i = 0; i < 6; i++) {
+            if (!(faces & (1u << i)))
+                continue;
+            m_shadowMap.attachFace(i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            shader.setValue("face", i);
+            m_shadowClusters->drawFace(i);
+        }
+        m_shadowMap.attachLayered();
+    }
+}
+
+void MainRender::updateFrameBuffer() {
+    FrameData data{m_viewMatrix, m_projectionMatrix, m_camera->position, FAR_PLANE};
+    if (!m_frameBuffer.valid()) {
+        m_frameBuffer.allocate(sizeof(FrameData));
+        m_frameBuffer.update(0, &data, sizeof(data));
+        m_frameData = data;
+    }
+    else if (std::memcmp(&data, &m_frameData, sizeof(FrameData)) != 0) {
+        m_frameBuffer.update(0, &data, sizeof(data));
+        m_frameData = data;
+    }
+    m_frameBuffer.bindBase(FRAME_BINDING);
+}
+
 void MainRender::renderHighlight(ShaderProgram &shader) {
+    PROFILE_PASS("Highlight");
     shader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
     shader.setValue("modelColor", *m_highlightPointColor);
     m_highlightPoint->render(-1.15f, 5.0f);
@@ -140,6 +440,7 @@ void MainRender::renderHighlight(ShaderProgram &shader) {
 }
 
 void MainRender::renderSelect(ShaderProgram &shader) {
+    PROFILE_PASS("Selection");
     if (rayPicker->selectPointValid)
     {
         m_selectPoint->resetIndices(rayPicker->selectMeshIndex, rayPicker->selectPointIndex);
@@ -164,45 +465,358 @@ void MainRender::renderSelect(ShaderProgram &shader) {
 void MainRender::renderFill(ShaderProgram &shader) {
     glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);//设置绘制模型为绘制前面与背面模型，以填充的方式绘制
     // don't forget to enable shader before setting uniforms
-    shader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
-    shader.setValue("viewPos", m_camera->position);
-    shader.setValue("material.shininess", defaultShininess);
-    shader.setValue("lightSpaceMatrix", m_lightSpaceMatrix);
-    shader.setValue("far_plane", FAR_PLANE);
-    lightFactory->importShaderValue(shader);
+    useFillProgram(shader);
+    m_model->setDefaultShininess(defaultShininess);
+    bindShadowAtlas();
+
+    for (auto i : m_drawOrder)
+        m_model->renderMesh(i, &shader, false, false, m_shadowMap.texture());
+}
+
+void MainRender::renderShadowFill() {
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_shadowShader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    for (auto order : {&m_drawOrder, &m_transparentOrder})
+        for (auto i : *order)
+            m_model->renderMesh(i, &m_shadowShader, false, false, m_shadowMap.texture());
+}
+
+void MainRender::useFillProgram(ShaderProgram &program) const {
+    program.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    program.setValue("lightSpaceMatrix", m_lightSpaceMatrix);
+    program.setValue("shadowLight", atlasShadows ? -1 : lightFactory->shadowLightIndex());
+    program.setValue("atlasShadows", atlasShadows);
+    program.setValue("clustered", clusteredLighting);
+    program.setValue("dirLightCount", lightFactory->dirLightCount());
+    program.setValue("shadowDepthStep", shadowDepthStep());
+    program.setValue("wireColor", *m_lineColor);
+    program.setValue("wireWidth", 1.f);
+    program.setValue("viewportSize", glm::vec2(m_width, m_height));
+}
+
+ShaderPermutation MainRender::fillPermutation() const {
+    ShaderPermutation permutation;
+    permutation.dirLights = lightFactory->dirLightCount();
+    // 分块光照时点光与聚光的数量不影响变体，增删灯光不需要编译新的变体
+    permutation.pointLights = clusteredLighting ? 0 : lightFactory->pointLightCount();
+    permutation.spotLights = clusteredLighting ? 0 : lightFactory->spotLightCount();
+    permutation.shadowLight = atlasShadows ? -1 : lightFactory->shadowLightIndex();
+    permutation.atlas = atlasShadows;
+    permutation.clustered = clusteredLighting;
+    permutation.wireframe = fillDrawsWireframe();
+    return permutation;
+}
+
+void MainRender::renderFillVariants() {
+    glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+    m_model->setDefaultShininess(defaultShininess);
+
+    auto permutation = fillPermutation();
+    bindShadowAtlas();
+
+    variantDraws = fallbackDraws = 0;
+    ShaderProgram *current = nullptr;
+    for (auto i : m_drawOrder) {
+        permutation.texture = !m_model->meshes[i].getTextures().empty();
+        auto program = m_modelVariants.find(permutation);
+        if (program)
+            variantDraws++;
+        else {
+            program = permutation.wireframe ? &m_wireframeShader : &m_modelShader;
+            fallbackDraws++;
+        }
+        // 相邻网格使用同一程序时不需要重新设置
+        if (program != current) {
+            useFillProgram(*program);
+            current = program;
+        }
+        m_model->renderMesh(i, program, false, false, m_shadowMap.texture());
+    }
+}
+
+void MainRender::renderDeferred() {
+    PROFILE_PASS("Deferred");
+    m_gbuffer.allocate(m_width, m_height);
+
+    gbufferTimer.begin();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_gbuffer.framebuffer());
+    m_gbuffer.clear();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_model->setDefaultShininess(defaultShininess);
+    setSurfaceOffset(true);
+    m_gbufferShader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    for (auto i : m_drawOrder)
+        m_model->renderMesh(i, &m_gbufferShader, false, false);
+    setSurfaceOffset(false);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gbufferTimer.end();
+
+    lightingTimer.begin();
+    auto permutation = fillPermutation();
+    permutation.deferred = true;
+    permutation.wireframe = false;
+    auto program = shaderPermutations ? m_deferredVariants.find(permutation) : nullptr;
+    if (!program)
+        program = &m_deferredShader;
+    program->use();
+    program->setValue("inverseViewProjection", glm::inverse(m_projectionMatrix * m_viewMatrix));
+    program->setValue("shadowMap", SHADOW_MAP_UNIT);
+    program->setValue("shadowEnable", true);
+    program->setValue("shadowLight", permutation.shadowLight);
+    program->setValue("atlasShadows", atlasShadows);
+    program->setValue("clustered", clusteredLighting);
+    program->setValue("dirLightCount", lightFactory->dirLightCount());
+    program->setValue("shadowDepthStep", shadowDepthStep());
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_shadowMap.texture());
+    bindShadowAtlas();
+    m_gbuffer.bindTextures(GBUFFER_UNIT);
+
+    // 没有几何的像素被丢弃，保留背景颜色与深度
+    glDepthFunc(GL_ALWAYS);
+    glBindVertexArray(m_screenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    lightingTimer.end();
+}
+
+void MainRender::updateDrawOrder() {
+    PROFILE_SCOPE("Draw Order");
+    if (sortFrontToBack)
+        m_model->sortFrontToBack(m_modelMatrix, m_camera->position, m_drawOrder);
+    else {
+        m_drawOrder.resize(m_model->meshes.size());
+        for (size_t i = 0; i < m_drawOrder.size(); i++)
+            m_drawOrder[i] = i;
+    }
+
+    // 透明网格不写入深度，预渲染、G-buffer 与线框的深度只包括不透明网格
+    m_transparentOrder.clear();
+    if (transparency == TRANSPARENCY_OPAQUE)
+        return;
+    auto transparent = std::stable_partition(m_drawOrder.begin(), m_drawOrder.end(), [&](size_t i) {
+        return modelOpacity >= 1.f && !m_model->isTransparent(i);
+    });
+    m_transparentOrder.assign(transparent, m_drawOrder.end());
+    m_drawOrder.erase(transparent, m_drawOrder.end());
+}
+
+void MainRender::drawGeometry() const {
+    for (auto i : m_drawOrder) {
+        auto &mesh = m_model->meshes[i];
+        glBindVertexArray(mesh.getVao());
+        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.getIndices().size(), GL_UNSIGNED_INT, nullptr);
+    }
+    glBindVertexArray(0);
+}
+
+void MainRender::renderForward() {
+    PROFILE_PASS("Forward");
+    setSurfaceOffset(true);
+    if (depthPrepass) {
+        prepassTimer.begin();
+        renderDepthPrepass();
+        prepassTimer.end();
+        // 深度已经写好，光照阶段只着色与之相等的片元
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    forwardTimer.begin();
+    if (overdrawView)
+        renderOverdraw();
+    else if (shaderPermutations)
+        renderFillVariants();
+    else
+        renderFill(fillDrawsWireframe() ? m_wireframeShader : m_modelShader);
+    forwardTimer.end();
+    setSurfaceOffset(false);
+
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+}
 
+void MainRender::renderDepthPrepass() {
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    m_depthPrepassShader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    drawGeometry();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void MainRender::renderOverdraw() {
+    auto bytes = (2 + (size_t)m_width * (size_t)m_height) * sizeof(uint32_t);
+    if (m_overdrawBuffer.size() != bytes)
+        m_overdrawBuffer.allocate(bytes);
+    m_overdrawBuffer.clear();
+    m_overdrawBuffer.bindBase(OVERDRAW_BINDING);
+
+    // 与光照阶段相同的深度状态，只计数不写颜色
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    m_overdrawShader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    m_overdrawShader.setValue("overdrawWidth", m_width);
+    drawGeometry();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // 热力图画在模型所在的像素上，不改变深度
+    glDepthFunc(GL_ALWAYS);
+    glDepthMask(GL_FALSE);
+    m_overdrawViewShader.use();
+    m_overdrawViewShader.setValue("overdrawWidth", m_width);
+    glBindVertexArray(m_screenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    uint32_t counters[2] = {};
+    m_overdrawBuffer.read(0, counters, sizeof(counters));
+    overdrawStats.shadedFragments = counters[0];
+    overdrawStats.coveredPixels = counters[1];
+}
+
+void MainRender::renderTransparent() {
+    PROFILE_PASS("Transparency");
+    transparencyTimer.begin();
+    auto linked = transparency == TRANSPARENCY_LINKED_LIST;
+    if (linked) {
+        m_oitBuffer.allocateLists(m_width, m_height, oitListLayers);
+        m_oitBuffer.clearLists();
+        // 片元只写入链表
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    }
+    else {
+        if (m_windowDepthFormat == 0)
+            m_windowDepthFormat = OitBuffer::depthFormat(0);
+        m_oitBuffer.allocate(m_width, m_height, m_windowDepthFormat);
+        m_oitBuffer.begin(0);
+        glEnable(GL_BLEND);
+        glBlendFunci(OitBuffer::ACCUM, GL_ONE, GL_ONE);
+        glBlendFunci(OitBuffer::REVEALAGE, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    }
+    // 按不透明几何的深度测试但不写入，透明网格的背面同样可见
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_model->setDefaultShininess(defaultShininess);
+    bindShadowAtlas();
+
+    auto permutation = fillPermutation();
+    permutation.wireframe = false;  // 透明网格的线框仍按边绘制
+    permutation.oit = transparency;
+    auto &fallback = linked ? m_oitLinkedShader : m_oitWeightedShader;
+    ShaderProgram *current = nullptr;
+    for (auto i : m_transparentOrder) {
+        auto &mesh = m_model->meshes[i];
+        permutation.texture = !mesh.getTextures().empty();
+        auto program = shaderPermutations ? m_modelVariants.find(permutation) : nullptr;
+        if (!program)
+            program = &fallback;
+        if (program != current) {
+            useFillProgram(*program);
+            program->setValue("oitWidth", m_width);
+            program->setValue("oitCapacity", (int)m_oitBuffer.nodeCapacity());
+            current = program;
+        }
+        auto &info = mesh.getMeshInfo();
+        program->setValue("opacity", modelOpacity * (info.valid ? info.dissolve : 1.f));
+        m_model->renderMesh(i, program, false, false, m_shadowMap.texture());
+    }
+    glEnable(GL_CULL_FACE);
 
-    m_model->render(&shader, false, false, m_depthMap);
+    // 合成到画面，不改变深度
+    glEnable(GL_BLEND);
+    if (linked) {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+        m_oitResolveShader.use();
+        m_oitResolveShader.setValue("oitWidth", m_width);
+    }
+    else {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+        m_oitBuffer.bindTextures(OIT_UNIT);
+        m_oitCompositeShader.use();
+    }
+    glDepthFunc(GL_ALWAYS);
+    glBindVertexArray(m_screenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    transparencyTimer.end();
+
+    transparencyStats.meshes = m_transparentOrder.size();
+    transparencyStats.capacity = linked ? m_oitBuffer.nodeCapacity() : 0;
+    if (linked) {
+        // 计数复制到读回缓冲，若干帧后再读，不等待本帧的透明绘制
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        m_oitBuffer.queryFragmentCount();
+        transparencyStats.fragments = m_oitBuffer.fragmentCount();
+    }
+    else
+        transparencyStats.fragments = 0;
+}
+
+bool MainRender::fillDrawsWireframe() const {
+    return mode.line && mode.fill && singlePassWireframe && !deferredShading && !overdrawView;
+}
+
+void MainRender::setSurfaceOffset(bool enable) const {
+    // 与 glPolygonMode(GL_LINE) 时对线框的偏移相反，偏移的是面，线与点的深度与顶点完全一致
+    if (enable && ((mode.line && !fillDrawsWireframe()) || mode.point)) {
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.0f, 1.0f);
+    }
+    else
+        glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
+void MainRender::renderOverlayDepth() {
+    PROFILE_PASS("Overlay Depth");
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    setSurfaceOffset(true);
+    m_depthPrepassShader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
+    drawGeometry();
+    setSurfaceOffset(false);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 }
 
 void MainRender::renderLine(ShaderProgram &shader) {
-    glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);//将绘制模式改为线
-    glEnable(GL_POLYGON_OFFSET_LINE);//开启多边形偏移
+    PROFILE_PASS("Wireframe");
+    glDepthFunc(GL_LEQUAL);
     glLineWidth(1.0f);
-    glPolygonOffset(-1.0f,-1.0f);//设置多边形偏移量
     shader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
     shader.setValue("modelColor", *m_lineColor);
-    m_model->render(&shader);
-    glDisable(GL_POLYGON_OFFSET_LINE);//关闭多边形偏移
+    if (!fillDrawsWireframe())
+        m_model->renderEdges();
+    else  // 单遍线框只在不透明网格的填充中
+        for (auto i : m_transparentOrder)
+            m_model->meshes[i].renderEdges();
+    glDepthFunc(GL_LESS);
 }
 
 void MainRender::renderPoint(ShaderProgram &shader) {
-    glPolygonMode(GL_FRONT_AND_BACK,GL_POINT);//将绘制模式改为点
-    glEnable(GL_POLYGON_OFFSET_POINT);//开启多边形偏移
-    glPolygonOffset(-1.5f,-1.5f);//设置多边形偏移量
+    PROFILE_PASS("Points");
+    glDepthFunc(GL_LEQUAL);
     glPointSize(2.5f);
     shader.use(m_modelMatrix, m_viewMatrix, m_projectionMatrix);
     shader.setValue("modelColor", *m_pointColor);
-    m_model->render(&shader);
-    glDisable(GL_POLYGON_OFFSET_POINT);//关闭多边形偏移
+    m_model->renderPoints();
+    glDepthFunc(GL_LESS);
 }
 
 void MainRender::renderLamp(ShaderProgram &shader) {
+    PROFILE_PASS("Lamps");
     glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 //    m_lampShader.use(lightFactory->getLight(0)->modelMatrix, m_viewMatrix, m_projectionMatrix);
 //    m_lampShader.setValue("lightColor", lightFactory->getLight(0)->color);
 //    m_lampModel->prepareRender(&m_lampShader);
-    lightFactory->modelRender(shader, m_viewMatrix, m_projectionMatrix);
+    lightFactory->modelRender(shader);
 }
 
 void MainRender::resizeGL(int w, int h)
@@ -219,6 +833,8 @@ void MainRender::initializeGL() {
     initializeLight();
     initializeRayPicker();
     initializeShadow();
+    finishShader();
+    glGenVertexArrays(1, &m_screenVao);
 
     glEnable(GL_CULL_FACE);
     glEnable(GL_DEPTH_TEST);
@@ -226,47 +842,60 @@ void MainRender::initializeGL() {
 }
 
 void MainRender::initializeShadow() {
-    // 深度贴图帧缓冲对象
-    glGenFramebuffers(1, &m_depthMapFbo);
-    // 创建2D纹理
-    glGenTextures(1, &m_depthMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_depthMap);
-    for (unsigned int i = 0; i < 6; ++i)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    // 深度纹理作为帧缓冲的深度缓冲
-    glBindFramebuffer(GL_FRAMEBUFFER, m_depthMapFbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // 规格不变时直接复用，分辨率或预算变化时在原纹理上重新分配
+    auto format = ShadowMap::fit(lightFactory->getLight(0)->shadowResolution, shadowBudget);
+    if (m_shadowMap.allocate(format))
+        invalidateShadow();
+}
+
+float MainRender::shadowDepthStep() const {
+    // 深度贴图保存 距离 / 远平面，量化误差为远平面除以深度的级数
+    if (!m_shadowMap.valid())
+        return 0.f;
+    return FAR_PLANE / (float)((1u << m_shadowMap.format().depthBits()) - 1);
 }
 
 void MainRender::initializeShader() {
-#pragma omp parallel
-#pragma omp sections
-    {
-#pragma omp section
-        {
-            m_modelShader.load("assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl");
-        }
-#pragma omp section
-        {
-            m_modelColorShader.load("assets/shader/model_vertex.glsl", "assets/shader/model_color_fragment.glsl");
-        }
-#pragma omp section
-        {
-            m_lampShader.load("assets/shader/lamp_vertex.glsl", "assets/shader/lamp_fragment.glsl");
-        }
-#pragma omp section
-        {
-            m_shadowShader.load("assets/shader/depth_shadow_vertex.glsl", "assets/shader/depth_shadow_fragment.glsl", "assets/shader/depth_shadow_geometry.glsl");
-        }
-    }
+    // OpenGL 调用只能在持有上下文的线程进行，并行编译交给驱动的编译线程
+    // 这里只提交编译，等待放在 initializeGL 的最后，与其余初始化重叠
+    ShaderProgram::enableParallelCompile();
+    m_modelShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl");
+    m_modelColorShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/model_color_fragment.glsl");
+    m_gbufferShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/gbuffer_fragment.glsl");
+    m_deferredShader.loadAsync("assets/shader/screen_vertex.glsl", "assets/shader/model_fragment.glsl", "", "#define DEFERRED\n");
+    m_depthPrepassShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/depth_prepass_fragment.glsl");
+    m_overdrawShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/overdraw_fragment.glsl");
+    m_overdrawViewShader.loadAsync("assets/shader/screen_vertex.glsl", "assets/shader/overdraw_view_fragment.glsl");
+    m_oitWeightedShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl", "",
+                                  "#define OIT_WEIGHTED\n");
+    m_oitLinkedShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl", "",
+                                "#define OIT_LINKED\n");
+    m_oitCompositeShader.loadAsync("assets/shader/screen_vertex.glsl", "assets/shader/oit_composite_fragment.glsl");
+    m_oitResolveShader.loadAsync("assets/shader/screen_vertex.glsl", "assets/shader/oit_resolve_fragment.glsl");
+    m_wireframeShader.loadAsync("assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl",
+                                "assets/shader/wireframe_geometry.glsl", "#define WIREFRAME\n");
+    m_lampShader.loadAsync("assets/shader/lamp_vertex.glsl", "assets/shader/lamp_fragment.glsl");
+    m_shadowShader.loadAsync("assets/shader/depth_shadow_vertex.glsl", "assets/shader/depth_shadow_fragment.glsl", "assets/shader/depth_shadow_geometry.glsl");
+    m_shadowFaceShader.loadAsync("assets/shader/depth_shadow_instanced_vertex.glsl", "assets/shader/depth_shadow_fragment.glsl");
+    m_shadowAtlasShader.loadAsync("assets/shader/depth_atlas_vertex.glsl", "assets/shader/depth_atlas_fragment.glsl");
+    if (ShadowClusters::layeredSupported())
+        m_shadowLayeredShader.loadAsync("assets/shader/depth_shadow_instanced_vertex.glsl", "assets/shader/depth_shadow_fragment.glsl",
+                                        "", ShadowClusters::layerDefines());
+}
+
+void MainRender::finishShader() {
+    auto start = std::chrono::steady_clock::now();
+    for (auto shader : {&m_modelShader, &m_modelColorShader, &m_gbufferShader, &m_deferredShader,
+                        &m_depthPrepassShader, &m_overdrawShader, &m_overdrawViewShader, &m_wireframeShader,
+                        &m_oitWeightedShader, &m_oitLinkedShader, &m_oitCompositeShader, &m_oitResolveShader, &m_lampShader,
+                        &m_shadowShader, &m_shadowFaceShader, &m_shadowAtlasShader})
+        shader->finish();
+    if (ShadowClusters::layeredSupported())
+        m_shadowLayeredShader.finish();
+    shaderWaitTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_shadowMatrices = m_shadowShader.uniform<glm::mat4>("shadowMatrices");
+    m_layeredShadowMatrices = m_shadowLayeredShader.uniform<glm::mat4>("shadowMatrices");
+    m_faceShadowMatrices = m_shadowFaceShader.uniform<glm::mat4>("shadowMatrices");
 }
 
 void MainRender::initializeModel() {
@@ -275,6 +904,7 @@ void MainRender::initializeModel() {
 
 void MainRender::initializeRayPicker() {
     rayPicker = new RayPicker();
+    regionPicker = new RegionPicker();
 }
 
 void MainRender::initializeEvent() {
@@ -284,6 +914,7 @@ void MainRender::initializeEvent() {
     initializeCameraEvent(handler);
     initializeModelEvent(handler);
     initializeModeChangeEvent(handler);
+    initializeRegionEvent(handler);
 }
 
 void MainRender::initializeRayPickerEvent(EventHandler& handler) {
@@ -428,7 +1059,7 @@ void MainRender::initializeModelEvent(EventHandler& handler) {
 
     // 鼠标左键 旋转模型
     handler.addListener([this](const event::Mouse::MoveEvent &event) {
-        if (!mode.camera && m_mouse->state[MouseButton::LEFT] && !mode.gui) {
+        if (!mode.camera && m_mouse->state[MouseButton::LEFT] && !mode.gui && !mode.region) {
             if (modelLoaded) {
                 modelTransform.rotation.x -= event.offset.y * 0.005f / modelTransform.scale;
                 modelTransform.rotation.y += event.offset.x * 0.005f / modelTransform.scale;
@@ -485,6 +1116,62 @@ void MainRender::initializeModeChangeEvent(EventHandler& handler) {
     });
 }
 
+void MainRender::initializeRegionEvent(EventHandler& handler) {
+    // 选择模式 左键拖拽 绘制矩形/套索区域，需在gui模式判断之后注册
+    handler.addListener([this](const event::Mouse::ClickHoldEvent<MouseButton::LEFT> &event){
+        if (modelLoaded && mode.select && !mode.gui && regionShape != RegionPicker::NONE) {
+            mode.region = true;
+            regionPoints = {event.position, event.position};
+        }
+    });
+
+    handler.addListener([this](const event::Mouse::MoveEvent &event){
+        if (!mode.region)
+            return;
+        if (regionShape == RegionPicker::RECTANGLE)
+            regionPoints.back() = event.position;
+        else if (glm::distance(regionPoints.back(), event.position) > 2.f)  // 套索按最小间距采样
+            regionPoints.push_back(event.position);
+    });
+
+    // 松开左键 提交区域
+    handler.addListener([this](const event::Mouse::ClickReleaseEvent<MouseButton::LEFT> &event){
+        if (!mode.region)
+            return;
+        mode.region = false;
+        if (modelLoaded)
+            commitRegion();
+        regionPoints.clear();
+    });
+}
+
+void MainRender::commitRegion() {
+    regionPicker->regionPick(
+            m_model->meshes, rayPicker->getBvhs(), regionPoints, regionShape, regionOptions,
+            m_camera->position, m_modelMatrix, m_viewMatrix, m_projectionMatrix, m_width, m_height);
+
+    // 批量写入高亮集合
+    for (int j = 0; j < m_model->meshes.size(); j++) {
+        const auto &points = regionPicker->selectPoints[j];
+        if (!points.empty()) {
+            if (regionRemove)
+                m_highlightPoint->removeIndices(j, points);
+            else
+                m_highlightPoint->addIndices(j, points);
+        }
+
+        for (auto face : regionPicker->selectFaces[j]) {
+            if (regionRemove)
+                m_highlightTriangle->removeFace(j, face);
+            else
+                m_highlightTriangle->addFace(j, face);
+        }
+    }
+
+    std::cout << (regionRemove ? "un" : "") << "highlight region: " << regionPicker->faceCount << " faces, "
+              << regionPicker->pointCount << " points (" << regionPicker->pickTime << " ms)" << std::endl;
+}
+
 void MainRender::loadModel(const string &path) {
     if (modelLoaded) {  // 释放之前的模型
         delete m_model;
@@ -492,10 +1179,15 @@ void MainRender::loadModel(const string &path) {
         delete m_selectTriangle;
         delete m_highlightPoint;
         delete m_highlightTriangle;
+        delete m_vertexWeld;
+        delete m_faceLookup;
+        delete m_topology;
+        delete m_shadowClusters;
+        delete selectionStore;
 
-        glDeleteFramebuffers(1, &m_depthMapFbo);
-
+        rayPicker->clearIndex();
         modelLoaded = false;
+        sampleLights(0);
     }
 
     // 加载模型
@@ -509,16 +1201,34 @@ void MainRender::loadModel(const string &path) {
 
     if (m_model->meshes.empty()) {
         std::cerr << "Model is empty" << std::endl;
+        delete m_model;
         return;
     }
     modelName = path.substr(path.find_last_of('/') + 1);
+    modelPath = path;
 
     // 加载几何模型
 
-    m_selectPoint = new PolygonPoint(m_model->meshes);
-    m_selectTriangle = new PolygonTriangle(m_model->meshes);
-    m_highlightPoint = new PolygonPoint(m_model->meshes);
-    m_highlightTriangle = new PolygonTriangle(m_model->meshes);
+    m_vertexWeld = new VertexWeld(m_model->meshes);
+    m_selectPoint = new PolygonPoint(m_model->meshes, *m_vertexWeld);
+    m_faceLookup = new FaceLookup(m_model->meshes);
+    m_selectTriangle = new PolygonTriangle(m_model->meshes, *m_faceLookup);
+    m_highlightPoint = new PolygonPoint(m_model->meshes, *m_vertexWeld);
+    m_highlightTriangle = new PolygonTriangle(m_model->meshes, *m_faceLookup);
+    m_topology = new MeshTopology(m_model->meshes, *m_vertexWeld);
+    m_shadowClusters = new ShadowClusters(m_model->meshes);
+
+    // 以模型内容区分的命名选择集合，之前保存过则直接读取
+    selectionStore = new SelectionStore(m_model->meshes);
+    if (std::filesystem::exists(selectionStore->defaultPath())) {
+        if (selectionStore->load(selectionStore->defaultPath()))
+            std::cout << "load " << selectionStore->sets().size() << " selection sets ("
+                      << selectionStore->loadTime << " ms)" << std::endl;
+        else
+            std::cerr << selectionStore->lastError << std::endl;
+    }
+
+    rayPicker->buildIndex(m_model->meshes);
 
     defaultShininess = m_model->meshes[0].getMeshInfo().valid ? m_model->meshes[0].getMeshInfo().shininess : 32.0f;
 
@@ -526,7 +1236,8 @@ void MainRender::loadModel(const string &path) {
     resetModelMatrix();
     m_camera->reset();
 
-    initializeShadow();
+    // 深度贴图沿用，几何变化后全部重新渲染
+    invalidateShadow();
 
     modelLoaded = true;
 }
@@ -554,17 +1265,185 @@ void MainRender::unloadModel() {
         delete m_selectTriangle;
         delete m_highlightPoint;
         delete m_highlightTriangle;
+        delete m_vertexWeld;
+        delete m_faceLookup;
+        delete m_topology;
+        delete m_shadowClusters;
+        delete selectionStore;
 
+        rayPicker->clearIndex();
         modelLoaded = false;
+        sampleLights(0);
+    }
+}
+
+size_t MainRender::getHighlightPointCount() const {
+    return m_highlightPoint->pointCount();
+}
+
+size_t MainRender::getHighlightTriangleCount() const {
+    return m_highlightTriangle->triangleCount();
+}
+
+size_t MainRender::getEdgeCount() const {
+    size_t count = 0;
+    if (modelLoaded)
+        for (auto &mesh : m_model->meshes)
+            count += mesh.edgeCount();
+    return count;
+}
+
+void MainRender::stressHighlight(size_t count) {
+    m_highlightPoint->clearIndices();
+    m_highlightTriangle->clearIndices();
+    if (count == 0)
+        return;
+
+    size_t faceTotal = 0, vertexTotal = 0;
+    for (auto &mesh : m_model->meshes) {
+        faceTotal += mesh.getFaces().size();
+        vertexTotal += mesh.getVertices().size();
+    }
+
+    // 按网格大小分配数量，在网格内等间隔取样
+    for (int j = 0; j < m_model->meshes.size(); j++) {
+        auto faces = m_model->meshes[j].getFaces().size();
+        auto faceCount = std::min(faces, (size_t)((double)count * faces / faceTotal + 0.5));
+        for (size_t i = 0; i < faceCount; i++)
+            m_highlightTriangle->addFace(j, (unsigned int)(i * faces / faceCount));
+
+        auto vertexCount = m_model->meshes[j].getVertices().size();
+        auto pointCount = std::min(vertexCount, (size_t)((double)count * vertexCount / vertexTotal + 0.5));
+        for (size_t i = 0; i < pointCount; i++)
+            m_highlightPoint->addIndices(j, (unsigned int)(i * vertexCount / pointCount));
+    }
+}
+
+void MainRender::stressReload(int count) {
+    if (!modelLoaded)
+        return;
+    auto path = modelPath;
+    auto start = std::chrono::steady_clock::now();
+    glFinish();
+    reloadStress = ReloadStress();
+    reloadStress.memoryBefore = GpuBuffer::availableMemory();
+    auto allocations = ShadowMap::allocations + shadowAtlas.allocations;
+
+    for (int i = 0; i < count; i++) {
+        loadModel(path);
+        if (!modelLoaded)
+            break;
+        reloadStress.loads++;
+        // 每次加载后按当前的阴影路径渲染一次，确认深度贴图被复用而不是重新分配
+        updateModelMatrix();
+        if (atlasShadows)
+            updateShadowAtlas();
+        else
+            updateShadow(0);
+        glFinish();
+        if ((i + 1) % 10 == 0)
+            std::cout << "reload " << i + 1 << ": " << GpuBuffer::availableMemory() << " KB available, "
+                      << ShadowMap::allocatedBytes / 1024 << " KB in shadow maps, "
+                      << shadowAtlas.bytes() / 1024 << " KB in shadow atlas" << std::endl;
     }
+
+    reloadStress.memoryAfter = GpuBuffer::availableMemory();
+    reloadStress.shadowBytes = ShadowMap::allocatedBytes + shadowAtlas.bytes();
+    reloadStress.shadowAllocations = ShadowMap::allocations + shadowAtlas.allocations - allocations;
+    reloadStress.time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    glViewport(0, 0, m_width, m_height);
+}
+
+void MainRender::growHighlight() {
+    applyTopology(GROW);
+}
+
+void MainRender::shrinkHighlight() {
+    applyTopology(SHRINK);
+}
+
+void MainRender::selectConnectedHighlight() {
+    applyTopology(CONNECTED);
+}
+
+void MainRender::applyTopology(TopologyOperation operation) {
+    // 焊接组跨越所有网格，增删一个网格的点会改变其它网格的点
+    // 先读出所有网格运算前的状态并完成运算，最后再统一增删，结果与网格顺序无关
+    auto meshCount = m_model->meshes.size();
+    vector<Bitset> faceBefore, faceAfter, vertexBefore, vertexAfter;
+    for (int j = 0; j < meshCount; j++) {
+        const auto &mesh = m_model->meshes[j];
+        vector<Polygon::Element> faces;
+        m_highlightTriangle->getElements(faces, j);
+        Bitset face(mesh.getFaces().size());
+        for (auto &element : faces)
+            face.set(element.index);
+        faceBefore.push_back(std::move(face));
+
+        // 点以拓扑顶点运算，焊接组中的其它顶点随之增删
+        Bitset vertex(mesh.getVertices().size());
+        for (auto index : m_highlightPoint->getIndices(j))
+            vertex.set(m_topology->canonical(j, index));
+        vertexBefore.push_back(std::move(vertex));
+    }
+
+    faceAfter = faceBefore;
+    vertexAfter = vertexBefore;
+    for (int j = 0; j < meshCount; j++) {
+        if (operation == GROW) {
+            m_topology->growFaces(j, faceAfter[j], highlightRings);
+            m_topology->growVertices(j, vertexAfter[j], highlightRings);
+        }
+        else if (operation == SHRINK) {
+            m_topology->shrinkFaces(j, faceAfter[j], highlightRings);
+            m_topology->shrinkVertices(j, vertexAfter[j], highlightRings);
+        }
+        else {
+            m_topology->connectedFaces(j, faceAfter[j]);
+            m_topology->connectedVertices(j, vertexAfter[j]);
+        }
+    }
+
+    // 先删除后添加：焊接点可能被另一个网格的删除带走，添加时与当前的高亮比较，运算后保留的点都会补回
+    for (int j = 0; j < meshCount; j++) {
+        faceBefore[j].forEach([this, j, &faceAfter](size_t face) {
+            if (!faceAfter[j].test(face))
+                m_highlightTriangle->removeFace(j, (unsigned int)face);
+        });
+        vertexBefore[j].forEach([this, j, &vertexAfter](size_t vertex) {
+            if (!vertexAfter[j].test(vertex))
+                m_highlightPoint->removeIndices(j, (unsigned int)vertex);
+        });
+    }
+    for (int j = 0; j < meshCount; j++) {
+        faceAfter[j].forEach([this, j, &faceBefore](size_t face) {
+            if (!faceBefore[j].test(face))
+                m_highlightTriangle->addFace(j, (unsigned int)face);
+        });
+        Bitset present(m_model->meshes[j].getVertices().size());
+        for (auto index : m_highlightPoint->getIndices(j))
+            present.set(m_topology->canonical(j, index));
+        vertexAfter[j].forEach([this, j, &present](size_t vertex) {
+            if (!present.test(vertex))
+                m_highlightPoint->addIndices(j, (unsigned int)vertex);
+        });
+    }
+}
+
+void MainRender::storeHighlight(const string &name) {
+    selectionStore->put(SelectionSet::capture(name, m_model->meshes, *m_highlightPoint, *m_highlightTriangle));
 }
 
-std::string MainRender::getHighlightPointString() const& {
-    return m_highlightPoint->getIndicesString();
+void MainRender::combineHighlight(size_t index, SelectionSet::Operation operation) {
+    auto highlight = SelectionSet::capture("", m_model->meshes, *m_highlightPoint, *m_highlightTriangle);
+    highlight.combine(selectionStore->sets()[index], operation);
+    highlight.applyTo(*m_highlightPoint, *m_highlightTriangle);
 }
 
-std::string MainRender::getHighlightTriangleString() const &{
-    return m_highlightTriangle->getIndicesString();
+void MainRender::invertHighlight() {
+    auto highlight = SelectionSet::capture("", m_model->meshes, *m_highlightPoint, *m_highlightTriangle);
+    highlight.invert();
+    highlight.applyTo(*m_highlightPoint, *m_highlightTriangle);
 }
 
 void MainRender::initializeLight() {
@@ -5,6 +5,17 @@
 #include "util/event/Event.h"
 #include "util/opengl/Light.h"
 #include "util/LightFactory.h"
+#include "util/LightClusters.h"
+#include "util/RegionPicker.h"
+#include "util/SelectionSet.h"
+#include "util/opengl/GpuTimer.h"
+#include "util/opengl/GpuBuffer.h"
+#include "util/opengl/ShaderVariants.h"
+#include "util/opengl/ShadowMap.h"
+#include "util/opengl/ShadowClusters.h"
+#include "util/opengl/ShadowAtlas.h"
+#include "util/opengl/GBuffer.h"
+#include "util/opengl/OitBuffer.h"
 #include <glm/matrix.hpp>
 
 class Model;
@@ -14,6 +25,9 @@ class Keyboard;
 class PolygonPoint;
 class PolygonTriangle;
 class RayPicker;
+class VertexWeld;
+class FaceLookup;
+class MeshTopology;
 
 class MainRender : public OpenGLRender
 {
@@ -26,6 +40,7 @@ public:
         bool point = false;
         bool select = false;
         bool camera = false;
+        bool region = false;  // 正在绘制选择区域
     };
     struct ModelTransform {
         glm::vec3 position;
@@ -42,19 +57,61 @@ public:
     void loadModel(const string &path);
     void unloadModel();
 
-    [[nodiscard]] std::string getHighlightPointString() const&;
-    [[nodiscard]] std::string getHighlightTriangleString() const&;
+    [[nodiscard]] const PolygonPoint &getHighlightPoint() const { return *m_highlightPoint; }
+    [[nodiscard]] const PolygonTriangle &getHighlightTriangle() const { return *m_highlightTriangle; }
+    [[nodiscard]] size_t getHighlightPointCount() const;
+    [[nodiscard]] size_t getHighlightTriangleCount() const;
+
+    /// 压力测试：将高亮集合替换为均匀分布在模型上的 count 个点和 count 个面
+    void stressHighlight(size_t count);
+
+    /// 重复加载的压力测试结果，显存由驱动报告（NVX/ATI 扩展），不支持时为 -1
+    struct ReloadStress {
+        int loads = 0;
+        long long memoryBefore = -1;  // KB
+        long long memoryAfter = -1;
+        size_t shadowBytes = 0;  // 立方体阴影贴图与阴影图集之和
+        size_t shadowAllocations = 0;  // 测试期间阴影贴图或图集重新分配的次数
+        float time = 0.f;  // 毫秒
+    };
+    /// 压力测试：重复加载当前模型 count 次，检查显存是否稳定
+    void stressReload(int count);
+    ReloadStress reloadStress;
+
+    /// 高亮的点与面沿网格邻接关系扩张或收缩 highlightRings 环
+    void growHighlight();
+    void shrinkHighlight();
+    /// 高亮扩展到所在的整个连通分量
+    void selectConnectedHighlight();
+
+    [[nodiscard]] const MeshTopology &getTopology() const { return *m_topology; }
+
+    /// 当前高亮保存为命名集合，同名集合被替换
+    void storeHighlight(const string &name);
+    /// 高亮集合与第 index 个命名集合运算，结果作为新的高亮
+    void combineHighlight(size_t index, SelectionSet::Operation operation);
+    void invertHighlight();
 
 
     bool modelLoaded;
     string modelName;
+    string modelPath;
 
     glm::vec3 backgroundColor = glm::vec3(0.6f);
 
     RayPicker *rayPicker;
+    RegionPicker *regionPicker;
     Mode mode;
 
+    RegionPicker::Shape regionShape = RegionPicker::NONE;  // 选择模式下左键拖拽使用的区域工具
+    RegionPicker::Options regionOptions;
+    bool regionRemove = false;  // 区域内元素取消高亮，否则加入高亮
+    vector<glm::vec2> regionPoints;  // 正在绘制的区域（屏幕像素坐标）
+
+    int highlightRings = 1;
+
     LightFactory *lightFactory;
+    SelectionStore *selectionStore;
 
     ModelTransform modelTransform;
 
@@ -62,10 +119,136 @@ public:
         *m_selectTriangleColor, *m_highlightPointColor, *m_highlightTriangleColor;
 
     float defaultShininess = 32.0f;
+
+    GpuTimer overlayTimer;  // 高亮与选择叠加层的GPU耗时
+    float overlayCpuTime = 0.f;  // 高亮与选择叠加层的CPU耗时（毫秒），包括索引上传与绘制提交
+
+    bool shaderPermutations = true;  // 按灯光组合与纹理使用特化的着色器变体
+    size_t variantDraws = 0;  // 上一帧使用特化变体与通用程序绘制的网格数
+    size_t fallbackDraws = 0;
+    [[nodiscard]] const ShaderVariants &getModelVariants() const { return m_modelVariants; }
+
+    /// 阴影贴图缓存的统计，跳过的帧按最近测得的单面耗时估算节省的时间
+    struct ShadowStats {
+        size_t framesRendered = 0;
+        size_t framesSkipped = 0;
+        size_t facesRendered = 0;
+        float savedTime = 0.f;  // 毫秒
+    };
+    bool shadowCache = true;  // 灯光、模型矩阵与几何不变时复用上一帧的阴影贴图
+    bool shadowAmortize = true;  // 阴影贴图持续变化时每帧只更新一个面
+    ShadowStats shadowStats;
+    GpuTimer shadowTimer;  // 按面数平均的阴影贴图更新耗时
+    /// 阴影贴图的绘制方式：几何着色器把每个三角形输出到六个面，或按面剔除分块后
+    /// 以实例化分层绘制（顶点着色器写 gl_Layer）或逐面六遍绘制
+    enum ShadowPath {
+        SHADOW_GEOMETRY,
+        SHADOW_LAYERED,
+        SHADOW_SIX_PASS,
+    };
+    ShadowPath shadowPath = SHADOW_LAYERED;  // 不支持分层时按逐面绘制
+    [[nodiscard]] const ShadowClusters &getShadowClusters() const { return *m_shadowClusters; }
+    size_t shadowBudget = 64u << 20;  // 阴影贴图的显存预算（字节），决定深度格式与分辨率
+    [[nodiscard]] const ShadowMap &getShadowMap() const { return m_shadowMap; }
+    /// 下一帧重新渲染整个阴影贴图，不分帧更新
+    void invalidateShadow() {
+        m_shadowDirtyFaces = ALL_SHADOW_FACES;
+        m_shadowStale = true;
+        shadowAtlas.invalidate();
+    }
+    /// 所有灯光共用阴影图集，否则只有第 0 个灯光以立方体贴图投射阴影
+    bool atlasShadows = true;
+    ShadowAtlas shadowAtlas;
+
+    /// 分块光照：点光与聚光按视锥分块筛选，片段只计算所在分块的灯光，否则逐个计算所有灯光
+    bool clusteredLighting = true;
+    LightClusters lightClusters;
+    /// 在模型表面随机采样 count 个短距离的彩色点光与聚光（四分之一为聚光，照向表面），随模型移动
+    /// count 为 0 时清除，加载或卸载模型时同样清除
+    void sampleLights(size_t count);
+
+    /// 延迟渲染：先把法线与材质颜色写入 G-buffer，再全屏计算一次光照（点光与聚光同样按分块筛选），
+    /// 线框、顶点与选择叠加层在光照之后按 G-buffer 的深度绘制；否则为前向渲染
+    bool deferredShading = false;
+    GpuTimer forwardTimer;  // 前向渲染填充的GPU耗时
+    GpuTimer gbufferTimer;  // 延迟渲染几何阶段的GPU耗时
+    GpuTimer lightingTimer;  // 延迟渲染光照阶段的GPU耗时
+    [[nodiscard]] const GBuffer &getGBuffer() const { return m_gbuffer; }
+
+    /// 前向填充之前先只写深度，光照阶段以 GL_EQUAL 测试，每个像素只执行一次光照着色
+    bool depthPrepass = false;
+    GpuTimer prepassTimer;  // 深度预渲染的GPU耗时
+    /// 网格按包围盒由近到远绘制，没有深度预渲染时提前深度测试也能剔除大部分被遮挡的片元
+    bool sortFrontToBack = true;
+    /// 调试视图：填充阶段以片元着色次数的热力图代替光照，延迟渲染时同样按前向的几何统计
+    bool overdrawView = false;
+    struct OverdrawStats {
+        size_t shadedFragments = 0;  // 通过深度测试、执行了片元着色的片元
+        size_t coveredPixels = 0;  // 至少着色一次的像素
+
+        [[nodiscard]] float ratio() const {
+            return coveredPixels > 0 ? (float)shadedFragments / (float)coveredPixels : 0.f;
+        }
+    };
+    OverdrawStats overdrawStats;  // 热力图打开时每帧更新
+
+    /// 线框在前向填充时按到三角形边的屏幕距离画出，不再单独绘制边
+    /// 延迟渲染、热力图或不填充时仍以去重后的边绘制
+    bool singlePassWireframe = false;
+    /// 不填充时线框与顶点按模型表面遮挡，只显示可见的一面；关闭时透视显示全部的边与顶点
+    bool occludedOverlay = false;
+    GpuTimer wireTimer;  // 单独绘制的线框与顶点的GPU耗时
+    /// 当前模型去重后的边数
+    [[nodiscard]] size_t getEdgeCount() const;
+
+    /// 透明网格（材质透明度小于 1，整体不透明度小于 1 时为全部网格）在不透明几何之后绘制，不按深度排序：
+    /// 加权混合把透明片元按深度加权平均，一次全屏合成；逐像素链表保存每个片元，合成时排序后精确混合
+    enum Transparency {
+        TRANSPARENCY_OPAQUE,  // 全部按不透明绘制
+        TRANSPARENCY_WEIGHTED = ShaderPermutation::OIT_WEIGHTED_MODE,
+        TRANSPARENCY_LINKED_LIST = ShaderPermutation::OIT_LINKED_MODE,
+    };
+    Transparency transparency = TRANSPARENCY_WEIGHTED;
+    float modelOpacity = 1.f;  // 与每个网格的材质透明度相乘
+    int oitListLayers = 4;  // 逐像素链表平均每个像素的节点容量
+    GpuTimer transparencyTimer;  // 透明网格绘制与合成的GPU耗时
+    struct TransparencyStats {
+        size_t meshes = 0;  // 上一帧绘制的透明网格
+        size_t fragments = 0;  // 逐像素链表申请的节点，超出容量的部分被丢弃，为若干帧之前的计数
+        size_t capacity = 0;
+    };
+    TransparencyStats transparencyStats;
+    [[nodiscard]] const OitBuffer &getOitBuffer() const { return m_oitBuffer; }
+
+    /// 按需渲染：画面没有变化时窗口阻塞等待输入，不再每帧重复绘制（包括阴影贴图）
+    bool renderOnDemand = true;
+    struct FrameStats {
+        unsigned long long framesRendered = 0;
+        unsigned long long framesSkipped = 0;  // 被唤醒但没有需要绘制的内容
+    };
+    FrameStats frameStats;
+    /// 没有输入时仍需继续绘制：着色器变体在后台编译，或阴影贴图分帧更新尚未完成
+    [[nodiscard]] bool needsRedraw() const;
+
+    float shaderWaitTime = 0.f;  // 初始化结束时等待着色器链接的时间（毫秒）
+    float startupTime = 0.f;  // 进程启动到第一帧绘制完成的时间（毫秒）
 private:
     static constexpr float NEAR_PLANE = 0.1f;
     static constexpr float FAR_PLANE = 1000.f;
-    static constexpr unsigned int SHADOW_WIDTH = 4096, SHADOW_HEIGHT = 4096;
+    static constexpr unsigned int ALL_SHADOW_FACES = 0x3f;
+    static constexpr int SHADOW_ATLAS_UNIT = 30;  // 与 model_fragment.glsl 中 shadowAtlas 的 binding 一致
+    static constexpr int SHADOW_MAP_UNIT = 31;  // 与 Mesh::render 绑定立方体阴影贴图的单元一致
+    static constexpr int GBUFFER_UNIT = 25;  // G-buffer 占用的第一个纹理单元，与 model_fragment.glsl 一致
+    static constexpr int OIT_UNIT = 23;  // 加权混合 OIT 占用的第一个纹理单元，与 oit_composite_fragment.glsl 一致
+
+    /// 与着色器中 std140 布局的 Frame 块一致
+    struct FrameData {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec3 viewPos;
+        float farPlane;
+    };
+    static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 Frame block");
 
     GLFWwindow *m_window;
     int m_width, m_height;
@@ -77,26 +260,74 @@ private:
     PolygonPoint *m_selectPoint;
     PolygonTriangle *m_highlightTriangle;
     PolygonTriangle *m_selectTriangle;
+    VertexWeld *m_vertexWeld;
+    FaceLookup *m_faceLookup;
+    MeshTopology *m_topology;
+    ShadowClusters *m_shadowClusters;
 
     ShaderProgram m_modelShader, m_modelColorShader;
     ShaderProgram m_lampShader, m_shadowShader;
+    ShaderProgram m_shadowLayeredShader, m_shadowFaceShader, m_shadowAtlasShader;
+    UniformHandle<glm::mat4> m_shadowMatrices, m_layeredShadowMatrices, m_faceShadowMatrices;
+    ShaderVariants m_modelVariants{"assets/shader/model_vertex.glsl", "assets/shader/model_fragment.glsl",
+                                   "assets/shader/wireframe_geometry.glsl"};
+    ShaderProgram m_wireframeShader;  // 单遍线框的通用程序，变体尚未编译完成时使用
+    ShaderProgram m_gbufferShader, m_deferredShader;
+    ShaderVariants m_deferredVariants{"assets/shader/screen_vertex.glsl", "assets/shader/model_fragment.glsl"};
+    GBuffer m_gbuffer;
+    GLuint m_screenVao = 0;  // 全屏绘制使用的空顶点数组
+    ShaderProgram m_depthPrepassShader, m_overdrawShader, m_overdrawViewShader;
+    GpuBuffer m_overdrawBuffer{GL_SHADER_STORAGE_BUFFER};  // 两个计数之后为每个像素的着色次数
+    vector<size_t> m_drawOrder;  // 填充阶段绘制不透明网格的顺序
+    vector<size_t> m_transparentOrder;  // 透明网格，在不透明几何之后绘制
+    ShaderProgram m_oitWeightedShader, m_oitLinkedShader;  // 透明网格的通用程序，变体尚未编译完成时使用
+    ShaderProgram m_oitCompositeShader, m_oitResolveShader;
+    OitBuffer m_oitBuffer;
+    GLenum m_windowDepthFormat = 0;  // 首次使用加权混合时查询
 
     glm::mat4 m_modelMatrix;
     glm::mat4 m_viewMatrix;
     glm::mat4 m_projectionMatrix;
     glm::mat4 m_lightSpaceMatrix;
 
+    GpuBuffer m_frameBuffer;
+    FrameData m_frameData{};  // 已上传的内容
+
+    /// 与着色器中 Clusters 缓冲的头部一致，之后紧跟每个分块的区间
+    struct ClusterHeader {
+        glm::uvec4 grid;
+        glm::vec4 scale;  // 像素到分块的比例，深度层号的比例与偏移
+    };
+    GpuBuffer m_clusterBuffer{GL_SHADER_STORAGE_BUFFER};
+    GpuBuffer m_clusterLightBuffer{GL_SHADER_STORAGE_BUFFER};
+    vector<LightData> m_sampledLights;  // 模型空间
+    glm::mat4 m_sampledMatrix{0.f};  // 已转换到世界坐标时的模型矩阵
+
     Camera *m_camera;
 
     Mouse *m_mouse;
     Keyboard *m_keyboard;
 
-    unsigned int m_depthMapFbo;
-    unsigned int m_depthMap;
+    ShadowMap m_shadowMap;
+
+    /// 决定阴影贴图内容的状态，与上次渲染时不同则所有面失效
+    struct ShadowKey {
+        glm::vec3 lightPos;
+        unsigned int resolution;
+        glm::mat4 model;
+        int transparency;  // 透明方式与不透明度决定网格在两个绘制顺序间的划分
+        float opacity;
+    };
+    ShadowKey m_shadowKey{};
+    unsigned int m_shadowDirtyFaces = ALL_SHADOW_FACES;  // 第 i 位表示立方体贴图第 i 个面需要重新渲染
+    int m_shadowNextFace = 0;  // 分帧更新时轮流选择的面
+    bool m_shadowStale = true;  // 内容属于之前的几何或分辨率，不能只更新部分面
 
 
     void initializeGL() override;
     void initializeShader() override;
+    /// 等待 initializeShader 提交的程序链接完成
+    void finishShader();
     void initializeModel();
     void initializeRayPicker();
 
@@ -105,19 +336,74 @@ private:
     void initializeCameraEvent(EventHandler &handler);
     void initializeModelEvent(EventHandler &handler);
     void initializeModeChangeEvent(EventHandler &handler);
+    void initializeRegionEvent(EventHandler &handler);
+    void commitRegion();
+
+    enum TopologyOperation {
+        GROW,
+        SHRINK,
+        CONNECTED,
+    };
+    void applyTopology(TopologyOperation operation);
     void renderHighlight(ShaderProgram &shader);
     void renderSelect(ShaderProgram &shader);
     void renderFill(ShaderProgram &shader);
+    /// 阴影贴图的几何着色器路径，不透明与透明网格都投射阴影，与剔除路径相同
+    void renderShadowFill();
+    /// 当前灯光与阴影设置对应的特化参数，纹理按网格另行设置
+    [[nodiscard]] ShaderPermutation fillPermutation() const;
+    /// 每个网格选择当前灯光组合与纹理对应的变体，变体尚未编译完成时使用通用程序
+    void renderFillVariants();
+    /// G-buffer 按窗口尺寸分配，几何阶段之后全屏绘制光照，写入模型的深度
+    void renderDeferred();
+    /// 按 sortFrontToBack 更新 m_drawOrder，透明网格移到 m_transparentOrder
+    void updateDrawOrder();
+    /// 按 m_drawOrder 只绘制几何，不绑定纹理与材质
+    void drawGeometry() const;
+    /// 可选的深度预渲染，之后为光照或热力图
+    void renderForward();
+    void renderDepthPrepass();
+    /// 统计每个像素的片元着色次数并绘制热力图，读回计数时等待 GPU
+    void renderOverdraw();
+    /// 填充程序共用的设置
+    void useFillProgram(ShaderProgram &program) const;
+    /// 透明网格按 transparency 的方式绘制后合成到画面，不写入深度
+    void renderTransparent();
+    /// 线框是否在填充阶段画出
+    [[nodiscard]] bool fillDrawsWireframe() const;
+    /// 单独绘制线框或顶点时填充的面向后偏移，线与点按真实深度绘制，enable 为 false 时关闭偏移
+    void setSurfaceOffset(bool enable) const;
+    /// 不填充且 occludedOverlay 打开时先只写深度，线框与顶点同样被遮挡
+    void renderOverlayDepth();
+    /// 每条边与每个顶点只绘制一次
     void renderLine(ShaderProgram &shader);
     void renderPoint(ShaderProgram &shader);
     void renderLamp(ShaderProgram &shader);
     void updateModelMatrix();
+    /// 相机矩阵等每帧数据有变化时写入 uniform 缓冲，并绑定到 FRAME_BINDING
+    void updateFrameBuffer();
 
     void initializeLight();
 
+    /// 按第 0 个灯光的分辨率与显存预算分配深度立方体贴图，规格变化时阴影失效
     void initializeShadow();
+    /// 深度贴图的量化步长（世界单位），加到阴影比较的偏移上
+    [[nodiscard]] float shadowDepthStep() const;
 
-    void renderShadow(int lightIndex);
+    /// 检查阴影贴图是否失效，只渲染失效的面，分帧更新时每帧只渲染一个面
+    void updateShadow(int lightIndex);
+    /// \param faces 需要渲染的面的位掩码
+    void renderShadow(int lightIndex, unsigned int faces);
+    /// 分块剔除后的阴影绘制，深度贴图的帧缓冲已绑定
+    void renderShadowClusters(const glm::vec3 &lightPos, const glm::mat4 *shadowTransforms, unsigned int faces);
+    /// 为所有投射阴影的灯光分配图集中的图块，在预算内渲染失效的图块
+    void updateShadowAtlas();
+    /// 阴影图集绑定到 SHADOW_ATLAS_UNIT，不使用时绑定 0
+    void bindShadowAtlas() const;
+    /// 模型矩阵变化后重新转换采样的灯光
+    void updateSampledLights();
+    /// 分配灯光到分块并上传到 CLUSTER_BINDING 与 CLUSTER_LIGHT_BINDING
+    void updateLightClusters();
 };
 
 #endif
\ No newline at end of file
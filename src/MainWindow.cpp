@@ -5,9 +5,18 @@
 #include "util/event/Keyboard.h"
 #include "util/RayPicker.h"
 #include "util/Controller.h"
+#include "util/opengl/ShaderCache.h"
+#include "util/Profiler.h"
 
+#include <chrono>
+#include <iostream>
 #include <sstream>
 
+namespace {
+// 静态初始化在 main 之前完成，作为启动计时的起点
+const auto processStart = std::chrono::steady_clock::now();
+}
+
 MainWindow::MainWindow(int width, int height) : OpenGLWindow(width, height)
 {
     m_camera = new Camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -36,25 +45,53 @@ MainWindow::~MainWindow() {
 }
 
 void MainWindow::render(float deltaTime) {
-    EventHandler::get().getEventBus()->process();
-    m_mouse->update();
-    m_keyboard->update();
+    setRenderOnDemand(m_render->renderOnDemand);
+    m_render->frameStats = {getRenderedFrames(), getSkippedFrames()};
+
+    {
+        PROFILE_SCOPE("Events");
+        EventHandler::get().getEventBus()->process();
+        m_mouse->update();
+        m_keyboard->update();
+    }
 
     if (m_render->mode.camera)
         setCursorMode(CursorMode::Disabled);
     else
         setCursorMode(CursorMode::Normal);
 
-    m_controller->prepareRender();
-
-    m_render->render(deltaTime);
+    {
+        PROFILE_SCOPE("ImGui Build");
+        m_controller->prepareRender();
+    }
+    {
+        PROFILE_SCOPE("Render");
+        m_render->render(deltaTime);
+    }
+    {
+        PROFILE_PASS("ImGui Draw");
+        m_controller->render();
+    }
 
-    m_controller->render();
+    if (m_render->startupTime == 0.f) {  // 第一帧，等待 GPU 完成后记录启动耗时
+        glFinish();
+        m_render->startupTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+        auto &cache = ShaderCache::get();
+        std::cout << "first frame after " << m_render->startupTime << " ms (" << cache.hits << " programs from cache, "
+                  << cache.misses << " compiled, waited " << m_render->shaderWaitTime << " ms for linking)" << std::endl;
+    }
 
     refreshTitle();
 
 }
 
+bool MainWindow::needsRedraw() {
+    // 总线上有未处理的事件，按住的按键与鼠标按钮每帧都会投递
+    if (EventHandler::get().waitForEvents())
+        return true;
+    return m_render->needsRedraw();
+}
+
 void MainWindow::refreshTitle() {
     std::stringstream title;
     if (m_render->modelLoaded) {
@@ -21,6 +21,7 @@ public:
 
 protected:
     void render(float deltaTime) override;
+    bool needsRedraw() override;
     void resizeEvent(int width, int height) override;
     void keyEvent(int key, int scancode, int action, int mods) override;
     void mouseMoveEvent(double xpos, double ypos) override;
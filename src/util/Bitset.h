@@ -0,0 +1,150 @@
+#ifndef MODEL_VIEWER_BITSET_H
+#define MODEL_VIEWER_BITSET_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "Simd.h"
+
+/// 定长稠密位集，长度在运行时确定
+class Bitset {
+public:
+    Bitset() = default;
+    explicit Bitset(size_t size) { resize(size); }
+
+    void resize(size_t size) {
+        m_size = size;
+        m_words.assign((size + 63) / 64, 0);
+    }
+
+    [[nodiscard]] size_t size() const { return m_size; }
+
+    [[nodiscard]] bool test(size_t i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+    void set(size_t i) { m_words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { m_words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    /// 翻转并返回翻转后的值
+    bool flip(size_t i) {
+        m_words[i >> 6] ^= uint64_t(1) << (i & 63);
+        return test(i);
+    }
+
+    void clear() { m_words.assign(m_words.size(), 0); }
+
+    /// 置位 [begin, end)
+    void setRange(size_t begin, size_t end) {
+        if (begin >= end)
+            return;
+        auto first = begin >> 6, last = (end - 1) >> 6;
+        auto firstMask = ~uint64_t(0) << (begin & 63);
+        auto lastMask = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+        if (first == last) {
+            m_words[first] |= firstMask & lastMask;
+            return;
+        }
+        m_words[first] |= firstMask;
+        std::fill(m_words.begin() + (long long)first + 1, m_words.begin() + (long long)last, ~uint64_t(0));
+        m_words[last] |= lastMask;
+    }
+
+    /// 集合运算，两个位集长度必须相同
+    void unite(const Bitset &other) { combine<Op::Unite>(other); }
+    void intersect(const Bitset &other) { combine<Op::Intersect>(other); }
+    void subtract(const Bitset &other) { combine<Op::Subtract>(other); }
+    void invert() {
+        combine<Op::Invert>(*this);
+        // 长度之外的位保持为 0，count 与 forEach 依赖这一点
+        if (m_size & 63)
+            m_words.back() &= ~uint64_t(0) >> (64 - (m_size & 63));
+    }
+
+    [[nodiscard]] const std::vector<uint64_t> &words() const { return m_words; }
+    [[nodiscard]] std::vector<uint64_t> &words() { return m_words; }
+
+    /// 置位的个数，CPU 支持 AVX2 时用 popcnt 指令
+    [[nodiscard]] size_t count() const {
+#ifdef SIMD_HAS_AVX2
+        if (simd::avx2())
+            return countAvx2(m_words.data(), m_words.size());
+#endif
+        size_t result = 0;
+        for (auto word : m_words)
+            result += std::popcount(word);
+        return result;
+    }
+
+    /// 按序号从小到大回调每个置位的序号
+    template<typename Function>
+    void forEach(Function &&function) const {
+        for (size_t i = 0; i < m_words.size(); i++)
+            for (auto word = m_words[i]; word; word &= word - 1)
+                function(i * 64 + std::countr_zero(word));
+    }
+
+private:
+    enum class Op { Unite, Intersect, Subtract, Invert };
+
+    template<Op op>
+    static uint64_t apply(uint64_t a, uint64_t b) {
+        if constexpr (op == Op::Unite)
+            return a | b;
+        else if constexpr (op == Op::Intersect)
+            return a & b;
+        else if constexpr (op == Op::Subtract)
+            return a & ~b;
+        else
+            return ~a;
+    }
+
+#ifdef SIMD_HAS_AVX2
+    /// 每次处理 4 个字，返回已处理的字数
+    template<Op op>
+    SIMD_AVX2 static size_t combineAvx2(uint64_t *a, const uint64_t *b, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            if constexpr (op == Op::Unite)
+                x = _mm256_or_si256(x, y);
+            else if constexpr (op == Op::Intersect)
+                x = _mm256_and_si256(x, y);
+            else if constexpr (op == Op::Subtract)
+                x = _mm256_andnot_si256(y, x);
+            else
+                x = _mm256_xor_si256(x, _mm256_set1_epi64x(-1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + i), x);
+        }
+        return i;
+    }
+
+    /// 支持 AVX2 的 CPU 都支持 popcnt，按基础指令集编译时 std::popcount 只能用查表或位运算实现
+    SIMD_AVX2 static size_t countAvx2(const uint64_t *words, size_t count) {
+        size_t result = 0;
+        for (size_t i = 0; i < count; i++)
+            result += std::popcount(words[i]);
+        return result;
+    }
+#endif
+
+    /// 逐字运算，CPU 支持 AVX2 时每次处理 4 个字
+    template<Op op>
+    void combine(const Bitset &other) {
+        auto *a = m_words.data();
+        const auto *b = other.m_words.data();
+        size_t i = 0;
+#ifdef SIMD_HAS_AVX2
+        if (simd::avx2())
+            i = combineAvx2<op>(a, b, m_words.size());
+#endif
+        for (; i < m_words.size(); i++)
+            a[i] = apply<op>(a[i], b[i]);
+    }
+
+    size_t m_size = 0;
+    std::vector<uint64_t> m_words;
+};
+
+
+#endif //MODEL_VIEWER_BITSET_H
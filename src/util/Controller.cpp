@@ -8,6 +8,10 @@
 #include "event/Mouse.h"
 #include "event/Keyboard.h"
 #include "RayPicker.h"
+#include "HighlightTable.h"
+#include "MeshTopology.h"
+#include "opengl/ShaderCache.h"
+#include "Profiler.h"
 #include "nfd/nfd.h"
 #include "../MainRender.h"
 
@@ -15,6 +19,8 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
+#include <iostream>
+#include <map>
 
 #include <Windows.h>
 
@@ -94,24 +100,216 @@ void Controller::prepareRender() {
         ImGui::End();
     }
 
+    if (m_render->mode.region)
+        showRegionOutline();
+#ifdef MODEL_VIEWER_PROFILER
+    if (Profiler::enabled)
+        showProfiler();
+#endif
+
     // Rendering
     ImGui::Render();
 }
 
-void Controller::showHighlightTab() const {
-    ImGui::Text("Points");
+void Controller::showProfiler() {
+    auto &profiler = Profiler::get();
+    ImGui::SetNextWindowSize(ImVec2(900.f, 0.f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler")) {
+        ImGui::End();
+        return;
+    }
+    ImGui::InputText("##tracePath", m_tracePath, sizeof(m_tracePath));
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace"))
+        m_traceStatus = profiler.exportChromeTrace(m_tracePath)
+                ? "saved " + std::to_string(profiler.history().size()) + " frames" : "failed to write";
+    ImGui::SameLine();
+    ImGui::TextUnformatted(m_traceStatus.c_str());
+
+    auto *frame = profiler.lastFrame();
+    if (!frame) {
+        ImGui::Text("Waiting for GPU results");
+        ImGui::End();
+        return;
+    }
+
+    // 时间轴包括晚于 CPU 帧结束的 GPU 区间；每个轨道的高度为最深的嵌套层数
+    // Windows.h 定义了 min/max 宏，调用时加括号
+    auto begin = frame->start, end = frame->end;
+    std::map<int, int> tracks;
+    std::map<std::string, std::pair<double, double>> totals;  // 按名称合计的 CPU 与 GPU 耗时
+    double gpuTime = 0.0;
+    for (auto &event : frame->events) {
+        begin = (std::min)(begin, event.start);
+        end = (std::max)(end, event.end);
+        tracks[event.track] = (std::max)(tracks[event.track], event.depth + 1);
+        auto time = (double)(event.end - event.start) / 1e6;
+        auto &total = totals[event.name];
+        (event.track == Profiler::GPU_TRACK ? total.second : total.first) += time;
+        if (event.track == Profiler::GPU_TRACK && event.depth == 0)
+            gpuTime += time;
+    }
+    ImGui::Text("Frame %llu: CPU %.3f ms, GPU %.3f ms, %zu scopes, %zu dropped, %zu GPU frames dropped",
+                (unsigned long long)frame->index, (double)(frame->end - frame->start) / 1e6, gpuTime,
+                frame->events.size(), profiler.droppedEvents(), profiler.droppedGpuFrames());
+
+    auto *draw = ImGui::GetWindowDrawList();
+    auto origin = ImGui::GetCursorScreenPos();
+    auto width = (std::max)(ImGui::GetContentRegionAvail().x, 200.f);
+    auto row = ImGui::GetTextLineHeightWithSpacing();
+    auto labelWidth = ImGui::CalcTextSize("Worker 00 ").x;
+    auto scale = (width - labelWidth) / (float)(std::max<int64_t>)(end - begin, 1);
+    auto y = origin.y;
+    std::map<int, float> trackY;
+    for (auto &[track, depth] : tracks) {
+        auto label = track == Profiler::GPU_TRACK ? std::string("GPU")
+                : track == 0 ? std::string("Main") : "Worker " + std::to_string(track);
+        draw->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text), label.c_str());
+        trackY[track] = y;
+        y += (float)depth * row + row * 0.5f;
+    }
+    auto mouse = ImGui::GetIO().MousePos;
+    for (auto &event : frame->events) {
+        ImVec2 topLeft(origin.x + labelWidth + (float)(event.start - begin) * scale, trackY[event.track] + (float)event.depth * row);
+        ImVec2 bottomRight((std::max)(topLeft.x + 1.f, origin.x + labelWidth + (float)(event.end - begin) * scale),
+                           topLeft.y + row - 1.f);
+        // 同名区间颜色相同，CPU 与 GPU 的同一阶段容易对应
+        unsigned int hash = 2166136261u;
+        for (auto *c = event.name; *c; c++)
+            hash = (hash ^ (unsigned char)*c) * 16777619u;
+        draw->AddRectFilled(topLeft, bottomRight, ImColor::HSV((float)(hash % 360) / 360.f, 0.5f, 0.8f));
+        draw->PushClipRect(topLeft, bottomRight, true);
+        draw->AddText(ImVec2(topLeft.x + 2.f, topLeft.y), IM_COL32(0, 0, 0, 255), event.name);
+        draw->PopClipRect();
+        if (mouse.x >= topLeft.x && mouse.x < bottomRight.x && mouse.y >= topLeft.y && mouse.y < bottomRight.y)
+            ImGui::SetTooltip("%s: %.3f ms", event.name, (double)(event.end - event.start) / 1e6);
+    }
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+
+    if (ImGui::BeginTable("##scopes", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+        for (auto &[name, total] : totals) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", total.first);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", total.second);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void Controller::showHighlightTab() {
+    ImGui::Text("Points (%zu)", m_render->getHighlightPointCount());
     ImGui::ColorEdit3("Point Color", glm::value_ptr(*m_render->m_highlightPointColor));
-    ImGui::Text("%s", m_render->getHighlightPointString().c_str());
+    m_pointTable->show(m_render->getHighlightPoint());
     ImGui::Separator();
-    ImGui::Text("Triangles");
+    ImGui::Text("Triangles (%zu)", m_render->getHighlightTriangleCount());
     ImGui::ColorEdit3("Face Color", glm::value_ptr(*m_render->m_highlightTriangleColor));
-    ImGui::Text("%s", m_render->getHighlightTriangleString().c_str());
+    m_triangleTable->show(m_render->getHighlightTriangle());
+    ImGui::Separator();
+
+    const auto &topology = m_render->getTopology();
+    size_t components = 0, loops = 0;
+    for (int j = 0; j < topology.meshCount(); j++) {
+        components += topology.componentCount(j);
+        loops += topology.boundaryLoopCount(j);
+    }
+    ImGui::Text("Topology: %zu components, %zu boundary loops (%.2f ms)", components, loops, topology.buildTime);
+    ImGui::SliderInt("Rings", &m_render->highlightRings, 1, 20);
+    if (ImGui::Button("Grow"))
+        m_render->growHighlight();
+    ImGui::SameLine();
+    if (ImGui::Button("Shrink"))
+        m_render->shrinkHighlight();
+    ImGui::SameLine();
+    if (ImGui::Button("Select Connected"))
+        m_render->selectConnectedHighlight();
+    ImGui::Separator();
+
+    showSelectionSets();
+    ImGui::Separator();
+
+    ImGui::Text("Overlay: %.3f ms GPU, %.3f ms CPU", m_render->overlayTimer.elapsed(), m_render->overlayCpuTime);
+    ImGui::Text("List rebuild: %.3f ms points, %.3f ms triangles",
+                m_pointTable->rebuildTime, m_triangleTable->rebuildTime);
+    ImGui::Text("Stress");
+    for (auto count : {1000, 100000, 1000000}) {
+        ImGui::SameLine();
+        if (ImGui::Button(count >= 1000000 ? "1M" : count >= 100000 ? "100k" : "1k"))
+            m_render->stressHighlight(count);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+        m_render->stressHighlight(0);
+}
+
+void Controller::showSelectionSets() {
+    auto store = m_render->selectionStore;
+    const auto &sets = store->sets();
+    if (m_selectionIndex >= (int)sets.size())
+        m_selectionIndex = -1;
+
+    ImGui::Text("Selection Sets");
+    ImGui::InputText("Name", m_selectionName, sizeof(m_selectionName));
+    ImGui::SameLine();
+    if (ImGui::Button("Store") && m_selectionName[0] != '\0')
+        m_render->storeHighlight(m_selectionName);
+
+    if (ImGui::BeginListBox("##selectionSets", ImVec2(0.f, ImGui::GetTextLineHeightWithSpacing() * 5))) {
+        for (int i = 0; i < sets.size(); i++) {
+            auto label = sets[i].name + " (" + std::to_string(sets[i].pointCount()) + " points, " +
+                         std::to_string(sets[i].faceCount()) + " faces)";
+            if (ImGui::Selectable(label.c_str(), i == m_selectionIndex))
+                m_selectionIndex = i;
+        }
+        ImGui::EndListBox();
+    }
+
+    // 高亮集合与选中的命名集合运算
+    ImGui::BeginDisabled(m_selectionIndex < 0);
+    const std::pair<const char *, SelectionSet::Operation> operations[] = {
+            {"Replace", SelectionSet::REPLACE},
+            {"Union", SelectionSet::UNION},
+            {"Intersect", SelectionSet::INTERSECT},
+            {"Subtract", SelectionSet::SUBTRACT},
+    };
+    for (auto &operation : operations) {
+        if (ImGui::Button(operation.first))
+            m_render->combineHighlight(m_selectionIndex, operation.second);
+        ImGui::SameLine();
+    }
+    if (ImGui::Button("Delete"))
+        m_render->selectionStore->remove(m_selectionIndex);
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Invert Highlight"))
+        m_render->invertHighlight();
+
+    if (ImGui::Button("Save")) {
+        if (!store->save(store->defaultPath()))
+            std::cerr << store->lastError << std::endl;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Reload")) {
+        if (!store->load(store->defaultPath()))
+            std::cerr << store->lastError << std::endl;
+    }
+    ImGui::Text("%s: %zu bytes, save %.3f ms, load %.3f ms", store->defaultPath().c_str(), store->fileSize,
+                store->saveTime, store->loadTime);
 }
 
 void Controller::showSelectTab() const {
     ImGui::Checkbox("Select Mode (Ctrl)", &m_render->mode.select);
     ImGui::ColorEdit3("Point Color", glm::value_ptr(*m_render->m_selectPointColor));
     ImGui::ColorEdit3("Face Color", glm::value_ptr(*m_render->m_selectTriangleColor));
+    ImGui::DragFloat("Snap Radius (px)", &m_render->rayPicker->pointPickPixels, 0.1f, 1.f, 50.f);
     ImGui::Separator();
     if(m_render->mode.select) {
         ImGui::Text("Selected");
@@ -134,6 +332,42 @@ void Controller::showSelectTab() const {
         else {
             ImGui::Text("Nothing");
         }
+        ImGui::Text("Snap query: %.3f ms", picker->snapTime);
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Region (Ctrl + Left Drag)");
+    auto shape = (int)m_render->regionShape;
+    ImGui::Combo("Tool", &shape, "None\0Rectangle\0Lasso\0");
+    m_render->regionShape = static_cast<RegionPicker::Shape>(shape);
+    auto &options = m_render->regionOptions;
+    ImGui::Checkbox("Faces", &options.faces);
+    ImGui::SameLine();
+    ImGui::Checkbox("Points", &options.points);
+    ImGui::Checkbox("Partial Faces", &options.partial);
+    ImGui::SameLine();
+    ImGui::Checkbox("Visible Only", &options.visibleOnly);
+    ImGui::Checkbox("Remove From Highlight", &m_render->regionRemove);
+    auto region = m_render->regionPicker;
+    ImGui::Text("Last region: %zu faces, %zu points, %.3f ms", region->faceCount, region->pointCount, region->pickTime);
+}
+
+void Controller::showRegionOutline() const {
+    auto &points = m_render->regionPoints;
+    if (points.size() < 2)
+        return;
+
+    auto drawList = ImGui::GetForegroundDrawList();
+    auto color = IM_COL32(255, 255, 255, 220);
+    if (m_render->regionShape == RegionPicker::RECTANGLE) {
+        drawList->AddRect(ImVec2(points.front().x, points.front().y), ImVec2(points.back().x, points.back().y), color);
+    }
+    else {
+        vector<ImVec2> polyline;
+        polyline.reserve(points.size());
+        for (auto &point : points)
+            polyline.emplace_back(point.x, point.y);
+        drawList->AddPolyline(polyline.data(), (int)polyline.size(), color, ImDrawFlags_Closed, 1.f);
     }
 }
 
@@ -163,6 +397,20 @@ void Controller::showLightTab() {
                 light.reset();
             }
 
+            // 立方体阴影只有第 0 个灯光，阴影图集中每个灯光都可以投射阴影
+            bool shadowed = m_render->atlasShadows ? light.type != NONE && light.type != TORCH_LIGHT
+                                                   : i == 0 && light.type != NONE;
+            if (shadowed) {
+                if (m_render->atlasShadows)
+                    ImGui::Checkbox("Cast Shadow", &light.castShadow);
+                static const unsigned int resolutions[] = {512, 1024, 2048, 4096};
+                int current = 0;
+                while (current < 3 && resolutions[current] != light.shadowResolution)
+                    current++;
+                if (ImGui::Combo("Shadow Size", &current, "512\0" "1024\0" "2048\0" "4096\0"))
+                    light.shadowResolution = resolutions[current];
+            }
+
             switch (light.type) {
                 case DIRECTIONAL_LIGHT:
                     ImGui::ColorEdit3("Color", glm::value_ptr(light.color));
@@ -234,18 +482,39 @@ void Controller::showLightTab() {
 
     if (ImGui::Button("Reset All"))
         m_render->lightFactory->reset();
+
+    ImGui::Separator();
+    ImGui::Checkbox("Clustered Lighting", &m_render->clusteredLighting);
+    ImGui::SliderInt("Sampled Lights", &m_sampledLightCount, 1, 10000, "%d", ImGuiSliderFlags_Logarithmic);
+    if (m_render->modelLoaded && ImGui::Button("Sample On Model"))
+        m_render->sampleLights(m_sampledLightCount);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Sampled"))
+        m_render->sampleLights(0);
+    const auto &clusters = m_render->lightClusters;
+    ImGui::Checkbox("Show Sampled Lamps", &m_render->lightFactory->showSampledLamps);
+    ImGui::Text("Lights: %zu sampled, %zu lamps drawn", m_render->lightFactory->sampledLightCount(),
+                m_render->lightFactory->lampCount());
+    if (m_render->clusteredLighting)
+        ImGui::Text("Clusters: %u x %u x %u, %zu lights visible, %zu indices, max %zu, %.3f ms", clusters.grid.x,
+                    clusters.grid.y, clusters.grid.z, clusters.visibleLights, clusters.indices().size(),
+                    clusters.maxClusterLights, clusters.buildTime);
 }
 
 Controller::~Controller() {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
+    delete m_pointTable;
+    delete m_triangleTable;
 }
 
 Controller::Controller(MainRender *render, Mouse *mouse, Camera *camera) {
     m_render = render;
     m_mouse = mouse;
     m_camera = camera;
+    m_pointTable = new HighlightTable("##highlightPoints");
+    m_triangleTable = new HighlightTable("##highlightTriangles");
 }
 
 void Controller::render() {
@@ -270,6 +539,9 @@ void Controller::showModelTab() const {
         ImGui::Checkbox("Line (L)", &m_render->mode.line);
         ImGui::SameLine();
         ImGui::Checkbox("Point (P)", &m_render->mode.point);
+        ImGui::Checkbox("Single-pass Wireframe", &m_render->singlePassWireframe);
+        ImGui::Checkbox("Hide Occluded Edges", &m_render->occludedOverlay);
+        ImGui::Text("Wireframe: %zu edges, %.3f ms GPU", m_render->getEdgeCount(), m_render->wireTimer.elapsed());
         ImGui::Separator();
         ImGui::DragFloat3("Position", glm::value_ptr(m_render->modelTransform.position), 0.005f, -20.f, 20.f);
         ImGui::DragFloat3("Rotate", glm::value_ptr(m_render->modelTransform.rotation), 0.005f, -3.1415f, 3.1415f);
@@ -342,6 +614,122 @@ void Controller::showModelTab() const {
         ImGui::TreePop();
         ImGui::Separator();
     }
+
+    const auto &stats = ShaderProgram::lastStats;
+    ImGui::Text("Uniforms: %zu uploads, %zu skipped, %zu by name", stats.uploads, stats.skipped, stats.lookups);
+    ImGui::Text("Buffers: %zu updates", GpuBuffer::lastUpdates);
+    auto &cache = ShaderCache::get();
+    ImGui::Text("Startup: %.0f ms to first frame, %zu programs cached, %zu compiled",
+                m_render->startupTime, cache.hits, cache.misses);
+    if (ImGui::Button("Clear Shader Cache"))
+        cache.clear();
+    ImGui::Checkbox("Render On Demand", &m_render->renderOnDemand);
+    ImGui::SameLine();
+    ImGui::Text("Frames: %llu rendered, %llu skipped", m_render->frameStats.framesRendered,
+                m_render->frameStats.framesSkipped);
+#ifdef MODEL_VIEWER_PROFILER
+    bool profiling = Profiler::enabled;
+    if (ImGui::Checkbox("Profiler", &profiling))
+        Profiler::enabled = profiling;
+#endif
+    auto shading = m_render->deferredShading ? 1 : 0;
+    if (ImGui::Combo("Shading", &shading, "Forward\0Deferred\0"))
+        m_render->deferredShading = shading == 1;
+    // 两种方式都显示最近一次测得的耗时，切换后可以直接对比
+    ImGui::Text("Fill GPU: forward %.3f ms, deferred %.3f ms (G-buffer %.3f + lighting %.3f)",
+                m_render->forwardTimer.elapsed(),
+                m_render->gbufferTimer.elapsed() + m_render->lightingTimer.elapsed(),
+                m_render->gbufferTimer.elapsed(), m_render->lightingTimer.elapsed());
+    ImGui::Checkbox("Depth Pre-pass", &m_render->depthPrepass);
+    ImGui::SameLine();
+    ImGui::Checkbox("Front-to-Back", &m_render->sortFrontToBack);
+    ImGui::SameLine();
+    ImGui::Checkbox("Overdraw View", &m_render->overdrawView);
+    if (m_render->depthPrepass)
+        ImGui::Text("Pre-pass: %.3f ms GPU, forward fill %.3f ms in total", m_render->prepassTimer.elapsed(),
+                    m_render->prepassTimer.elapsed() + m_render->forwardTimer.elapsed());
+    if (m_render->overdrawView) {
+        const auto &overdraw = m_render->overdrawStats;
+        ImGui::Text("Overdraw: %zu fragments shaded on %zu pixels, %.2fx", overdraw.shadedFragments,
+                    overdraw.coveredPixels, overdraw.ratio());
+    }
+    if (m_render->deferredShading)
+        ImGui::Text("G-buffer: %d x %d, %.1f MB", m_render->getGBuffer().width(), m_render->getGBuffer().height(),
+                    (float)m_render->getGBuffer().bytes() / (1 << 20));
+    auto transparency = (int)m_render->transparency;
+    if (ImGui::Combo("Transparency", &transparency, "Opaque\0Weighted OIT\0Linked-list OIT\0"))
+        m_render->transparency = (MainRender::Transparency)transparency;
+    ImGui::SliderFloat("Model Opacity", &m_render->modelOpacity, 0.05f, 1.f);
+    const auto &transparent = m_render->transparencyStats;
+    ImGui::Text("Transparent: %zu meshes, %.3f ms GPU, OIT buffers %.1f MB", transparent.meshes,
+                m_render->transparencyTimer.elapsed(), (float)m_render->getOitBuffer().bytes() / (1 << 20));
+    if (m_render->transparency == MainRender::TRANSPARENCY_LINKED_LIST) {
+        ImGui::SliderInt("Nodes Per Pixel", &m_render->oitListLayers, 1, 16);
+        ImGui::Text("Fragments: %zu of %zu nodes, %zu dropped", transparent.fragments, transparent.capacity,
+                    transparent.fragments > transparent.capacity ? transparent.fragments - transparent.capacity : 0);
+    }
+    ImGui::Checkbox("Shader Permutations", &m_render->shaderPermutations);
+    ImGui::Text("Variants: %zu compiled, %zu pending, %zu/%zu meshes specialized",
+                m_render->getModelVariants().size() - m_render->getModelVariants().pending(),
+                m_render->getModelVariants().pending(),
+                m_render->variantDraws, m_render->variantDraws + m_render->fallbackDraws);
+    ImGui::Checkbox("Skip Redundant Uniforms", &ShaderProgram::filterRedundant);
+    if (ImGui::Checkbox("Shadow Atlas (All Lights)", &m_render->atlasShadows))
+        m_render->invalidateShadow();
+    if (m_render->atlasShadows) {
+        auto &atlas = m_render->shadowAtlas;
+        auto tileBudget = (int)atlas.tileBudget;
+        if (ImGui::SliderInt("Tiles Per Frame", &tileBudget, 1, ShadowAtlas::MAX_TILES))
+            atlas.tileBudget = tileBudget;
+        ImGui::DragFloat("Cascade Distance", &atlas.shadowDistance, 0.1f, 1.f, 200.f);
+        const auto &stats = atlas.stats;
+        ImGui::Text("Atlas: %u x %u, %.1f MB, %zu lights, %zu dropped, %zu tiles", atlas.resolution(),
+                    atlas.resolution(), (float)atlas.bytes() / (1 << 20), stats.lights, stats.dropped, stats.tiles);
+        ImGui::Text("Tiles: %zu rendered, %zu deferred, %zu cached, %.3f ms/tile", stats.rendered, stats.deferred,
+                    stats.cached, atlas.timer.elapsedPerSample());
+    }
+    ImGui::Checkbox("Cache Shadow Map", &m_render->shadowCache);
+    ImGui::SameLine();
+    ImGui::Checkbox("Amortize Updates", &m_render->shadowAmortize);
+    const auto &shadow = m_render->shadowStats;
+    ImGui::Text("Shadow: %zu frames updated, %zu skipped, %zu faces, %.3f ms/face, %.1f ms saved",
+                shadow.framesRendered, shadow.framesSkipped, shadow.facesRendered,
+                m_render->shadowTimer.elapsedPerSample(), shadow.savedTime);
+
+    auto path = (int)m_render->shadowPath;
+    if (ImGui::Combo("Shadow Path", &path, "Geometry Shader\0Culled Layered\0Culled Six Passes\0")) {
+        m_render->shadowPath = static_cast<MainRender::ShadowPath>(path);
+        m_render->invalidateShadow();
+    }
+    if (m_render->modelLoaded && m_render->shadowPath != MainRender::SHADOW_GEOMETRY) {
+        const auto &clusters = m_render->getShadowClusters();
+        ImGui::Text("Clusters: %zu, %zu/%zu face draws visible, cull %.3f ms%s", clusters.clusterCount(),
+                    clusters.visibleDraws, clusters.totalDraws, clusters.cullTime,
+                    ShadowClusters::layeredSupported() ? "" : " (no vertex gl_Layer, six passes)");
+    }
+
+    auto budget = (int)(m_render->shadowBudget >> 20);
+    if (ImGui::SliderInt("Shadow Budget (MB)", &budget, 4, 512))
+        m_render->shadowBudget = (size_t)budget << 20;
+    const auto &format = m_render->getShadowMap().format();
+    ImGui::Text("Shadow map: %u x %u x 6, %u-bit depth, %.1f MB", format.resolution, format.resolution,
+                format.depthBits(), (float)ShadowMap::allocatedBytes / (1 << 20));
+    auto available = GpuBuffer::availableMemory();
+    if (available >= 0)
+        ImGui::Text("VRAM available: %.1f MB", (float)available / 1024);
+    else
+        ImGui::Text("VRAM available: not reported by driver");
+
+    if (m_render->modelLoaded && ImGui::Button("Reload Stress (100x)"))
+        m_render->stressReload(100);
+    const auto &stress = m_render->reloadStress;
+    if (stress.loads > 0) {
+        ImGui::Text("%d loads in %.0f ms, shadow maps and atlas reallocated %zu times, %.1f MB", stress.loads, stress.time,
+                    stress.shadowAllocations, (float)stress.shadowBytes / (1 << 20));
+        if (stress.memoryBefore >= 0)
+            ImGui::Text("VRAM available: %.1f MB before, %.1f MB after", (float)stress.memoryBefore / 1024,
+                        (float)stress.memoryAfter / 1024);
+    }
 }
 
 void Controller::showCameraTab() const {
@@ -10,6 +10,7 @@
 class MainRender;
 class Mouse;
 class Camera;
+class HighlightTable;
 struct GLFWwindow;
 
 class Controller {
@@ -25,6 +26,13 @@ private:
     MainRender *m_render;
     Mouse *m_mouse;
     Camera *m_camera;
+    HighlightTable *m_pointTable;
+    HighlightTable *m_triangleTable;
+    char m_selectionName[64] = "Selection";
+    int m_selectionIndex = -1;
+    int m_sampledLightCount = 1000;
+    char m_tracePath[256] = "trace.json";
+    std::string m_traceStatus;
 
     [[nodiscard]] std::string openFile() const&;
 
@@ -32,7 +40,10 @@ private:
     void showCameraTab() const;
     void showLightTab();
     void showSelectTab() const;
-    void showHighlightTab() const;
+    void showHighlightTab();
+    void showSelectionSets();
+    void showRegionOutline() const;
+    void showProfiler();
 };
 
 
@@ -0,0 +1,58 @@
+#include "FaceLookup.h"
+
+#include <cstdint>
+
+FaceLookup::FaceLookup() = default;
+
+FaceLookup::FaceLookup(const vector<Mesh> &meshes) {
+    build(meshes);
+}
+
+void FaceLookup::build(const vector<Mesh> &meshes) {
+    m_tables.assign(meshes.size(), Table());
+    for (size_t j = 0; j < meshes.size(); j++) {
+        const auto &faces = meshes[j].getFaces();
+        auto &table = m_tables[j];
+        table.faceCount = faces.size();
+
+        // 装载因子不超过 0.5
+        size_t capacity = 16;
+        while (capacity < faces.size() * 2)
+            capacity <<= 1;
+        table.entries.assign(capacity, Entry());
+        table.mask = capacity - 1;
+
+        for (unsigned int i = 0; i < faces.size(); i++) {
+            const auto &vertex = faces[i].vertex;
+            auto slot = hash(vertex[0], vertex[1], vertex[2]) & table.mask;
+            while (table.entries[slot].face != INVALID_FACE) {
+                auto &entry = table.entries[slot];
+                if (entry.vertex[0] == vertex[0] && entry.vertex[1] == vertex[1] && entry.vertex[2] == vertex[2])
+                    break;  // 重复的面保留第一个
+                slot = (slot + 1) & table.mask;
+            }
+            if (table.entries[slot].face == INVALID_FACE)
+                table.entries[slot] = {{vertex[0], vertex[1], vertex[2]}, i};
+        }
+    }
+}
+
+unsigned int FaceLookup::find(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) const {
+    const auto &table = m_tables[meshIndex];
+    auto slot = hash(index0, index1, index2) & table.mask;
+    while (true) {
+        const auto &entry = table.entries[slot];
+        if (entry.face == INVALID_FACE)
+            return INVALID_FACE;
+        if (entry.vertex[0] == index0 && entry.vertex[1] == index1 && entry.vertex[2] == index2)
+            return entry.face;
+        slot = (slot + 1) & table.mask;
+    }
+}
+
+size_t FaceLookup::hash(unsigned int index0, unsigned int index1, unsigned int index2) {
+    uint64_t h = index0 * 0x9E3779B97F4A7C15ull;
+    h ^= index1 * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+    h ^= index2 * 0x165667B19E3779F9ull + (h >> 32);
+    return (size_t)(h ^ (h >> 31));
+}
@@ -0,0 +1,41 @@
+#ifndef MODEL_VIEWER_FACELOOKUP_H
+#define MODEL_VIEWER_FACELOOKUP_H
+
+#include <vector>
+#include "opengl/Mesh.h"
+
+/// 由三个顶点序号查找面序号的哈希表，每个网格一张，加载模型时建立
+/// 开放寻址、线性探测，顶点顺序需与网格中的面一致
+class FaceLookup {
+public:
+    static constexpr unsigned int INVALID_FACE = 0xffffffff;
+
+    FaceLookup();
+    explicit FaceLookup(const vector<Mesh> &meshes);
+
+    void build(const vector<Mesh> &meshes);
+
+    /// \return 面序号，不存在时返回 INVALID_FACE
+    [[nodiscard]] unsigned int find(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) const;
+
+    [[nodiscard]] size_t faceCount(int meshIndex) const { return m_tables[meshIndex].faceCount; }
+
+private:
+    struct Entry {
+        unsigned int vertex[3];
+        unsigned int face = INVALID_FACE;
+    };
+
+    struct Table {
+        vector<Entry> entries;  // 长度为 2 的幂
+        size_t mask = 0;
+        size_t faceCount = 0;
+    };
+
+    static size_t hash(unsigned int index0, unsigned int index1, unsigned int index2);
+
+    vector<Table> m_tables;
+};
+
+
+#endif //MODEL_VIEWER_FACELOOKUP_H
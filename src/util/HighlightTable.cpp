@@ -0,0 +1,155 @@
+#include "HighlightTable.h"
+#include "opengl/PolygonPoint.h"
+#include "opengl/PolygonTriangle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <imgui/imgui.h>
+
+HighlightTable::HighlightTable(const char *id) : m_id(id) {
+}
+
+void HighlightTable::show(const PolygonPoint &points) {
+    if (showFilter(points))
+        m_valid = false;
+    static const char *columns[] = {"Mesh", "Point", "X", "Y", "Z"};
+    if (!beginTable(columns, 5))
+        return;
+    update(points);
+
+    ImGuiListClipper clipper;
+    clipper.Begin((int)m_rows.size());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const auto &row = m_rows[i];
+            const auto &position = points.getVertices(row.meshIndex)[row.index].position;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", row.meshIndex);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", row.index);
+            for (int k = 0; k < 3; k++) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", position[k]);
+            }
+        }
+    }
+    ImGui::EndTable();
+}
+
+void HighlightTable::show(const PolygonTriangle &triangles) {
+    if (showFilter(triangles))
+        m_valid = false;
+    static const char *columns[] = {"Mesh", "Face", "V0", "V1", "V2"};
+    if (!beginTable(columns, 5))
+        return;
+    update(triangles);
+
+    ImGuiListClipper clipper;
+    clipper.Begin((int)m_rows.size());
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const auto &row = m_rows[i];
+            const auto &face = triangles.getFace(row.meshIndex, row.index);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", row.meshIndex);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", row.index);
+            for (auto vertex : face.vertex) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", vertex);
+                if (ImGui::IsItemHovered()) {
+                    const auto &position = triangles.getVertices(row.meshIndex)[vertex].position;
+                    ImGui::SetTooltip("%.4f, %.4f, %.4f", position.x, position.y, position.z);
+                }
+            }
+        }
+    }
+    ImGui::EndTable();
+}
+
+bool HighlightTable::showFilter(const Polygon &polygon) {
+    auto meshCount = (int)polygon.meshCount();
+    if (m_meshFilter >= meshCount)
+        m_meshFilter = -1;
+    if (meshCount <= 1)
+        return false;
+
+    ImGui::PushID(m_id);
+    auto changed = false;
+    auto preview = m_meshFilter == -1 ? std::string("All meshes") : "Mesh " + std::to_string(m_meshFilter);
+    if (ImGui::BeginCombo("Mesh", preview.c_str())) {
+        for (int j = -1; j < meshCount; j++) {
+            auto label = j == -1 ? std::string("All meshes") : "Mesh " + std::to_string(j);
+            if (ImGui::Selectable(label.c_str(), j == m_meshFilter) && j != m_meshFilter) {
+                m_meshFilter = j;
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::PopID();
+    return changed;
+}
+
+bool HighlightTable::beginTable(const char *const *columns, int columnCount) {
+    auto flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                 ImGuiTableFlags_BordersV | ImGuiTableFlags_Sortable | ImGuiTableFlags_SizingFixedFit;
+    auto height = ImGui::GetTextLineHeightWithSpacing() * (VISIBLE_ROWS + 1);
+    if (!ImGui::BeginTable(m_id, columnCount, flags, ImVec2(0.f, height)))
+        return false;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    for (int i = 0; i < columnCount; i++) {
+        ImGuiTableColumnFlags columnFlags = ImGuiTableColumnFlags_None;
+        if (i == COLUMN_MESH)
+            columnFlags |= ImGuiTableColumnFlags_DefaultSort;
+        else if (i != COLUMN_ID)
+            columnFlags |= ImGuiTableColumnFlags_NoSort;
+        ImGui::TableSetupColumn(columns[i], columnFlags, 0.f, i);
+    }
+    ImGui::TableHeadersRow();
+
+    // 排序条件变化时只对缓存的行重新排序
+    auto specs = ImGui::TableGetSortSpecs();
+    if (specs && specs->SpecsDirty) {
+        if (specs->SpecsCount > 0) {
+            m_sortColumn = (int)specs->Specs[0].ColumnUserID;
+            m_sortDescending = specs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+        }
+        specs->SpecsDirty = false;
+        if (m_valid)
+            sortRows();
+    }
+    return true;
+}
+
+void HighlightTable::update(const Polygon &polygon) {
+    if (m_valid && m_version == polygon.version())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    m_rows.clear();
+    polygon.getElements(m_rows, m_meshFilter);
+    sortRows();
+    m_version = polygon.version();
+    m_valid = true;
+    rebuildTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HighlightTable::sortRows() {
+    auto byMesh = [](const Polygon::Element &a, const Polygon::Element &b) {
+        return a.meshIndex != b.meshIndex ? a.meshIndex < b.meshIndex : a.index < b.index;
+    };
+    auto byId = [](const Polygon::Element &a, const Polygon::Element &b) {
+        return a.index != b.index ? a.index < b.index : a.meshIndex < b.meshIndex;
+    };
+    if (m_sortColumn == COLUMN_ID)
+        std::sort(m_rows.begin(), m_rows.end(), byId);
+    else
+        std::sort(m_rows.begin(), m_rows.end(), byMesh);
+    if (m_sortDescending)
+        std::reverse(m_rows.begin(), m_rows.end());
+}
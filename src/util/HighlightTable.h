@@ -0,0 +1,50 @@
+#ifndef MODEL_VIEWER_HIGHLIGHTTABLE_H
+#define MODEL_VIEWER_HIGHLIGHTTABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "opengl/Polygon.h"
+
+class PolygonPoint;
+class PolygonTriangle;
+
+/// 高亮元素列表：行缓存只在元素版本、网格过滤或排序变化时重建，
+/// 每帧只格式化可见的行，界面耗时与高亮数量无关
+class HighlightTable {
+public:
+    /// \param id ImGui 表格ID，同一窗口内需唯一
+    explicit HighlightTable(const char *id);
+
+    void show(const PolygonPoint &points);
+    void show(const PolygonTriangle &triangles);
+
+    /// 最近一次重建行缓存的耗时（毫秒）
+    float rebuildTime = 0.f;
+
+private:
+    static constexpr int VISIBLE_ROWS = 12;
+
+    enum Column {
+        COLUMN_MESH,
+        COLUMN_ID,
+    };
+
+    const char *m_id;
+    vector<Polygon::Element> m_rows;
+    uint64_t m_version = 0;
+    int m_meshFilter = -1;  // -1 表示全部网格
+    int m_sortColumn = COLUMN_MESH;
+    bool m_sortDescending = false;
+    bool m_valid = false;
+
+    /// 网格过滤选项，返回 true 时行缓存需要重建
+    bool showFilter(const Polygon &polygon);
+
+    /// 表头与排序，返回 false 时表格不可见
+    bool beginTable(const char *const *columns, int columnCount);
+    void update(const Polygon &polygon);
+    void sortRows();
+};
+
+
+#endif //MODEL_VIEWER_HIGHLIGHTTABLE_H
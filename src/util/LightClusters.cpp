@@ -0,0 +1,331 @@
+#include "LightClusters.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#ifdef SIMD_HAS_AVX2
+namespace {
+    /// 连续 8 个分块的包围盒与圆 (cx, cy, sqrt(limit)) 在 xy 上是否相交，返回 8 位掩码
+    SIMD_AVX2 unsigned int boxMaskAvx2(const float *minX, const float *maxX, const float *minY, const float *maxY,
+                                       float cx, float cy, float limit) {
+        auto x = _mm256_set1_ps(cx), y = _mm256_set1_ps(cy);
+        auto zero = _mm256_setzero_ps();
+        auto dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(minX), x),
+                                              _mm256_sub_ps(x, _mm256_loadu_ps(maxX))), zero);
+        auto dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(minY), y),
+                                              _mm256_sub_ps(y, _mm256_loadu_ps(maxY))), zero);
+        auto d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_set1_ps(limit), _CMP_LE_OQ));
+    }
+}
+#endif
+
+float LightClusters::lightRange(const LightData &light) {
+    auto peak = [](const glm::vec3 &v) { return std::max(v.x, std::max(v.y, v.z)); };
+    // 与着色器一致：环境光不乘灯光颜色
+    auto intensity = std::max(peak(light.ambient),
+                              std::max(peak(light.diffuse), peak(light.specular)) * peak(light.color));
+    // constant + linear * d + quadratic * d^2 = intensity / CUTOFF
+    auto target = intensity / CUTOFF - light.constant;
+    if (target <= 0.f)
+        return 0.f;
+    if (light.quadratic > 0.f)
+        return (-light.linear + std::sqrt(light.linear * light.linear + 4.f * light.quadratic * target)) /
+               (2.f * light.quadratic);
+    if (light.linear > 0.f)
+        return target / light.linear;
+    return std::numeric_limits<float>::infinity();
+}
+
+void LightClusters::build(const LightData *lights, size_t count, const glm::mat4 &view, const glm::mat4 &projection,
+                          float nearPlane, float farPlane) {
+    auto start = std::chrono::steady_clock::now();
+    updateBounds(projection, nearPlane, farPlane);
+
+    // 先并行求出每个灯光的包围球与范围，再去掉不可见的
+    m_candidates.resize(count);
+    auto prepareRange = [&](size_t begin, size_t end, unsigned int) {
+        for (auto i = begin; i < end; i++)
+            if (!prepare(lights[i], (uint32_t)i, view, m_candidates[i]))
+                m_candidates[i].index = INVALID;
+    };
+    if (threads)
+        parallel::forRange(count, prepareRange, 1024);
+    else
+        prepareRange(0, count, 0);
+    m_candidates.erase(std::remove_if(m_candidates.begin(), m_candidates.end(),
+                                      [](const Candidate &candidate) { return candidate.index == INVALID; }),
+                       m_candidates.end());
+    visibleLights = m_candidates.size();
+
+    // 按层分桶，每层只遍历与它相交的灯光
+    m_sliceOffsets.assign(grid.z + 1, 0);
+    for (const auto &candidate : m_candidates)
+        for (auto z = candidate.z0; z <= candidate.z1; z++)
+            m_sliceOffsets[z + 1]++;
+    for (unsigned int z = 0; z < grid.z; z++)
+        m_sliceOffsets[z + 1] += m_sliceOffsets[z];
+    m_sliceCandidates.resize(m_sliceOffsets[grid.z]);
+    std::vector<uint32_t> cursor(m_sliceOffsets.begin(), m_sliceOffsets.end() - 1);
+    for (uint32_t i = 0; i < m_candidates.size(); i++)
+        for (auto z = m_candidates[i].z0; z <= m_candidates[i].z1; z++)
+            m_sliceCandidates[cursor[z]++] = i;
+
+    auto tiles = grid.x * grid.y;
+    m_ranges.assign(clusterCount(), glm::uvec2(0));
+    auto workerCount = parallel::workerCount();
+    m_workerIndices.resize(workerCount);
+    m_workerPairs.resize(workerCount);
+    m_workerSlices.assign(workerCount, glm::uvec2(0));
+
+    auto assign = [this, tiles](size_t begin, size_t end, unsigned int worker) {
+        auto &out = m_workerIndices[worker];
+        out.clear();
+        for (auto z = begin; z < end; z++)
+            assignSlice((unsigned int)z, m_workerPairs[worker], out, &m_ranges[z * tiles]);
+        m_workerSlices[worker] = glm::uvec2(begin, end);
+    };
+    unsigned int workers = 1;
+    if (threads)
+        workers = parallel::forRange(grid.z, assign, 1);
+    else
+        assign(0, grid.z, 0);
+
+    // 各线程的层范围连续且递增，依次拼接并平移起点
+    m_indices.clear();
+    maxClusterLights = 0;
+    for (unsigned int worker = 0; worker < workers; worker++) {
+        auto base = (uint32_t)m_indices.size();
+        auto &out = m_workerIndices[worker];
+        m_indices.insert(m_indices.end(), out.begin(), out.end());
+        auto slices = m_workerSlices[worker];
+        for (auto i = slices.x * tiles; i < slices.y * tiles; i++) {
+            m_ranges[i].x += base;
+            maxClusterLights = std::max<size_t>(maxClusterLights, m_ranges[i].y);
+        }
+    }
+    buildTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned int LightClusters::clusterIndex(const glm::vec2 &ndc, float depth) const {
+    auto tile = [](float v, unsigned int count) {
+        return (unsigned int)std::clamp((int)std::floor((v * 0.5f + 0.5f) * (float)count), 0, (int)count - 1);
+    };
+    return tile(ndc.x, grid.x) + grid.x * (tile(ndc.y, grid.y) + grid.y * slice(depth));
+}
+
+LightClusters::Bounds LightClusters::bounds(unsigned int cluster) const {
+    auto z = cluster / (grid.x * grid.y);
+    return {glm::vec3(m_minX[cluster], m_minY[cluster], -m_sliceFar[z]),
+            glm::vec3(m_maxX[cluster], m_maxY[cluster], -m_sliceNear[z])};
+}
+
+void LightClusters::updateBounds(const glm::mat4 &projection, float nearPlane, float farPlane) {
+    if (grid == m_boundsGrid && projection == m_projection && nearPlane == m_near && farPlane == m_far &&
+        sliceFar == m_boundsSliceFar)
+        return;
+    m_boundsGrid = grid;
+    m_projection = projection;
+    m_near = nearPlane;
+    m_far = farPlane;
+    m_boundsSliceFar = sliceFar;
+
+    auto end = std::clamp(sliceFar, nearPlane * 2.f, farPlane);
+    auto logRatio = std::log(end / nearPlane);
+    m_depthScale = (float)grid.z / logRatio;
+    m_depthBias = (float)grid.z * std::log(nearPlane) / logRatio;
+
+    m_sliceNear.resize(grid.z);
+    m_sliceFar.resize(grid.z);
+    for (unsigned int z = 0; z < grid.z; z++) {
+        m_sliceNear[z] = z == 0 ? nearPlane : m_sliceFar[z - 1];
+        m_sliceFar[z] = z + 1 == grid.z ? farPlane : nearPlane * std::pow(end / nearPlane, float(z + 1) / (float)grid.z);
+    }
+
+    auto count = clusterCount();
+    for (auto *v : {&m_minX, &m_maxX, &m_minY, &m_maxY})
+        v->assign(count + 8, 0.f);
+    m_spheres.resize(count);
+    // 对称投影下 ndc = P[0][0] * x / depth，分块的边界在两个深度处取极值
+    auto extent = [](float ndc0, float ndc1, float d0, float d1, float scale, float &low, float &high) {
+        low = std::min(ndc0 * d0, ndc0 * d1) / scale;
+        high = std::max(ndc1 * d0, ndc1 * d1) / scale;
+    };
+    for (unsigned int z = 0; z < grid.z; z++) {
+        auto d0 = m_sliceNear[z], d1 = m_sliceFar[z];
+        for (unsigned int y = 0; y < grid.y; y++) {
+            for (unsigned int x = 0; x < grid.x; x++) {
+                auto i = x + grid.x * (y + grid.y * z);
+                extent(-1.f + 2.f * (float)x / (float)grid.x, -1.f + 2.f * float(x + 1) / (float)grid.x, d0, d1,
+                       projection[0][0], m_minX[i], m_maxX[i]);
+                extent(-1.f + 2.f * (float)y / (float)grid.y, -1.f + 2.f * float(y + 1) / (float)grid.y, d0, d1,
+                       projection[1][1], m_minY[i], m_maxY[i]);
+                auto low = glm::vec3(m_minX[i], m_minY[i], -d1), high = glm::vec3(m_maxX[i], m_maxY[i], -d0);
+                m_spheres[i] = glm::vec4((low + high) * 0.5f, glm::length(high - low) * 0.5f);
+            }
+        }
+    }
+}
+
+bool LightClusters::prepare(const LightData &light, uint32_t index, const glm::mat4 &view, Candidate &candidate) const {
+    if (light.type != POINT_LIGHT && light.type != SPOT_LIGHT && light.type != TORCH_LIGHT)
+        return false;
+    auto range = lightRange(light);
+    if (range <= 0.f)
+        return false;
+
+    candidate.index = index;
+    candidate.apex = glm::vec3(view * glm::vec4(light.position, 1.f));
+    candidate.center = candidate.apex;
+    candidate.radius = range;
+    candidate.range = range;
+    // 外裁剪角小于 90° 的聚光改用圆锥的包围球
+    candidate.spot = light.type != POINT_LIGHT && light.outerCutOff > 0.f && std::isfinite(range);
+    if (candidate.spot) {
+        candidate.axis = glm::normalize(glm::mat3(view) * light.direction);
+        candidate.cosAngle = light.outerCutOff;
+        candidate.sinAngle = std::sqrt(std::max(0.f, 1.f - light.outerCutOff * light.outerCutOff));
+        if (candidate.cosAngle < 0.70710678f) {  // 大于 45° 时底面圆的外接球更小
+            candidate.center = candidate.apex + candidate.axis * (range * candidate.cosAngle);
+            candidate.radius = range * candidate.sinAngle;
+        } else {
+            candidate.center = candidate.apex + candidate.axis * (range * 0.5f / candidate.cosAngle);
+            candidate.radius = range * 0.5f / candidate.cosAngle;
+        }
+    }
+
+    if (!std::isfinite(candidate.radius)) {
+        candidate.x0 = candidate.y0 = candidate.z0 = 0;
+        candidate.x1 = grid.x - 1;
+        candidate.y1 = grid.y - 1;
+        candidate.z1 = grid.z - 1;
+        return true;
+    }
+
+    auto depth = -candidate.center.z;
+    auto dMin = std::max(depth - candidate.radius, m_near);
+    auto dMax = std::min(depth + candidate.radius, m_far);
+    if (dMin > dMax)
+        return false;
+    candidate.z0 = slice(dMin);
+    candidate.z1 = slice(dMax);
+
+    candidate.depthMin = dMin;
+    candidate.depthMax = dMax;
+    return screenTiles(candidate.center.x, candidate.radius, dMin, dMax, m_projection[0][0], grid.x,
+                       candidate.x0, candidate.x1) &&
+           screenTiles(candidate.center.y, candidate.radius, dMin, dMax, m_projection[1][1], grid.y,
+                       candidate.y0, candidate.y1);
+}
+
+bool LightClusters::screenTiles(float center, float radius, float dMin, float dMax, float scale, unsigned int count,
+                                unsigned int &first, unsigned int &last) {
+    // x / depth 随深度单调，极值在两端
+    auto low = scale * std::min((center - radius) / dMin, (center - radius) / dMax);
+    auto high = scale * std::max((center + radius) / dMin, (center + radius) / dMax);
+    if (high < -1.f || low > 1.f)
+        return false;
+    auto tile = [count](float v) {
+        return (unsigned int)std::clamp((int)std::floor((v * 0.5f + 0.5f) * (float)count), 0, (int)count - 1);
+    };
+    first = tile(std::max(low, -1.f));
+    last = tile(std::min(high, 1.f));
+    return true;
+}
+
+unsigned int LightClusters::slice(float depth) const {
+    auto z = std::floor(std::log(std::max(depth, m_near)) * m_depthScale - m_depthBias);
+    return (unsigned int)std::clamp((int)z, 0, (int)grid.z - 1);
+}
+
+void LightClusters::assignSlice(unsigned int z, std::vector<uint32_t> &pairs, std::vector<uint32_t> &out,
+                                glm::uvec2 *ranges) const {
+    auto tiles = grid.x * grid.y;
+    auto zMin = -m_sliceFar[z], zMax = -m_sliceNear[z];
+#ifdef SIMD_HAS_AVX2
+    auto avx2 = simd && simd::avx2();
+#endif
+    pairs.clear();  // (层内分块, 灯光) 交替存放
+    for (auto c = m_sliceOffsets[z]; c < m_sliceOffsets[z + 1]; c++) {
+        const auto &candidate = m_candidates[m_sliceCandidates[c]];
+        auto dz = std::max(std::max(zMin - candidate.center.z, candidate.center.z - zMax), 0.f);
+        auto limit = candidate.radius * candidate.radius - dz * dz;
+        if (limit < 0.f)
+            continue;
+
+        // 按球在本层内的最大截面与深度范围缩小屏幕范围
+        auto x0 = candidate.x0, x1 = candidate.x1, y0 = candidate.y0, y1 = candidate.y1;
+        if (std::isfinite(limit)) {
+            auto radius = std::sqrt(limit);
+            auto dMin = std::max(candidate.depthMin, m_sliceNear[z]), dMax = std::min(candidate.depthMax, m_sliceFar[z]);
+            if (!screenTiles(candidate.center.x, radius, dMin, dMax, m_projection[0][0], grid.x, x0, x1) ||
+                !screenTiles(candidate.center.y, radius, dMin, dMax, m_projection[1][1], grid.y, y0, y1))
+                continue;
+        }
+
+        auto hit = [&](unsigned int x, unsigned int y) {
+            auto cluster = x + grid.x * (y + grid.y * z);
+            if (candidate.spot && !coneVisible(candidate, cluster))
+                return;
+            pairs.push_back(x + grid.x * y);
+            pairs.push_back(candidate.index);
+        };
+        for (auto y = y0; y <= y1; y++) {
+            auto row = grid.x * (y + grid.y * z);
+#ifdef SIMD_HAS_AVX2
+            if (avx2) {
+                for (auto x = x0; x <= x1; x += 8) {
+                    auto i = row + x;
+                    auto mask = boxMaskAvx2(&m_minX[i], &m_maxX[i], &m_minY[i], &m_maxY[i],
+                                            candidate.center.x, candidate.center.y, limit);
+                    auto lanes = x1 - x + 1;
+                    if (lanes < 8)
+                        mask &= (1u << lanes) - 1;
+                    while (mask) {
+                        hit(x + std::countr_zero(mask), y);
+                        mask &= mask - 1;
+                    }
+                }
+                continue;
+            }
+#endif
+            for (auto x = x0; x <= x1; x++) {
+                auto i = row + x;
+                auto dx = std::max(std::max(m_minX[i] - candidate.center.x, candidate.center.x - m_maxX[i]), 0.f);
+                auto dy = std::max(std::max(m_minY[i] - candidate.center.y, candidate.center.y - m_maxY[i]), 0.f);
+                if (dx * dx + dy * dy <= limit)
+                    hit(x, y);
+            }
+        }
+    }
+
+    // 按分块计数排序，同一分块内保持灯光在缓冲中的顺序
+    for (size_t i = 0; i < pairs.size(); i += 2)
+        ranges[pairs[i]].y++;
+    auto offset = (uint32_t)out.size();
+    for (unsigned int i = 0; i < tiles; i++) {
+        ranges[i].x = offset;
+        offset += ranges[i].y;
+        ranges[i].y = 0;
+    }
+    out.resize(offset);
+    for (size_t i = 0; i < pairs.size(); i += 2) {
+        auto &range = ranges[pairs[i]];
+        out[range.x + range.y++] = pairs[i + 1];
+    }
+}
+
+bool LightClusters::coneVisible(const Candidate &candidate, unsigned int cluster) const {
+    // 分块包围球到圆锥侧面的距离
+    auto sphere = m_spheres[cluster];
+    auto v = glm::vec3(sphere) - candidate.apex;
+    auto lengthSq = glm::dot(v, v);
+    auto along = glm::dot(v, candidate.axis);
+    auto distance = candidate.cosAngle * std::sqrt(std::max(lengthSq - along * along, 0.f)) - along * candidate.sinAngle;
+    return distance <= sphere.w && along <= sphere.w + candidate.range && along >= -sphere.w;
+}
@@ -0,0 +1,113 @@
+#ifndef MODEL_VIEWER_LIGHTCLUSTERS_H
+#define MODEL_VIEWER_LIGHTCLUSTERS_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "opengl/Light.h"
+
+/// 分块前向渲染的灯光分配：观察视锥按屏幕 grid.x * grid.y 块、深度按对数划分为 grid.z 层，
+/// 每帧在 CPU 上求出与每个分块相交的点光与聚光，结果为扁平的索引数组，直接上传为着色器存储缓冲
+///
+/// 灯光的影响范围为光照衰减到 CUTOFF 以下的距离，点光为球，聚光为圆锥（先以包围球粗测）
+/// 按深度层并行，每层内对一行分块的包围盒一次测试 8 个（AVX2）
+/// 不依赖 OpenGL，可以在无窗口时构建与验证
+class LightClusters {
+public:
+    struct Grid {
+        unsigned int x = 16;
+        unsigned int y = 9;
+        unsigned int z = 24;
+
+        bool operator==(const Grid &other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+
+    /// 观察空间中分块的包围盒
+    struct Bounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    static constexpr float CUTOFF = 1.f / 256.f;
+
+    /// 光照（漫反射与镜面光中较大者）衰减到 CUTOFF 的距离，没有衰减时为无穷大
+    static float lightRange(const LightData &light);
+
+    /// 分配 lights[0, count) 中的点光与聚光，平行光与未使用的灯光跳过，索引为在数组中的位置
+    /// 投影须为对称的透视投影
+    void build(const LightData *lights, size_t count, const glm::mat4 &view, const glm::mat4 &projection,
+               float nearPlane, float farPlane);
+
+    /// 与着色器相同的分块编号
+    /// \param ndc 屏幕位置的标准化设备坐标
+    /// \param depth 观察空间深度（到相机平面的距离）
+    [[nodiscard]] unsigned int clusterIndex(const glm::vec2 &ndc, float depth) const;
+    [[nodiscard]] unsigned int clusterCount() const { return grid.x * grid.y * grid.z; }
+    [[nodiscard]] Bounds bounds(unsigned int cluster) const;
+
+    /// 层号 = log(depth) * depthScale - depthBias
+    [[nodiscard]] float depthScale() const { return m_depthScale; }
+    [[nodiscard]] float depthBias() const { return m_depthBias; }
+
+    /// 每个分块在 indices 中的起点与数量
+    [[nodiscard]] const std::vector<glm::uvec2> &ranges() const { return m_ranges; }
+    [[nodiscard]] const std::vector<uint32_t> &indices() const { return m_indices; }
+
+    Grid grid;
+    float sliceFar = 100.f;  // 对数划分的远端，更远的部分都归入最后一层
+    bool simd = true;  // 启用 USE_AVX2 编译且 CPU 支持 AVX2 时才有效
+    bool threads = true;
+
+    float buildTime = 0.f;  // 毫秒
+    size_t visibleLights = 0;  // 与视锥相交的灯光
+    size_t maxClusterLights = 0;  // 单个分块中最多的灯光数
+
+private:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    /// 观察空间中灯光的包围球与覆盖的分块范围
+    struct Candidate {
+        uint32_t index;
+        glm::vec3 center;
+        float radius;
+        bool spot;
+        glm::vec3 apex;  // 聚光的圆锥
+        glm::vec3 axis;
+        float range;
+        float cosAngle, sinAngle;
+        float depthMin, depthMax;  // 与视锥相交的深度范围
+        unsigned int x0, x1, y0, y1, z0, z1;
+    };
+
+    /// 投影或划分变化时重新计算分块包围盒
+    void updateBounds(const glm::mat4 &projection, float nearPlane, float farPlane);
+    [[nodiscard]] bool prepare(const LightData &light, uint32_t index, const glm::mat4 &view, Candidate &candidate) const;
+    [[nodiscard]] unsigned int slice(float depth) const;
+    /// 中心与半径给出的区间在深度 [dMin, dMax] 内投影到屏幕上覆盖的分块，完全在屏幕外时返回 false
+    static bool screenTiles(float center, float radius, float dMin, float dMax, float scale, unsigned int count,
+                            unsigned int &first, unsigned int &last);
+    /// 将与第 z 层相交的灯光写入 out，ranges 的起点相对于 out
+    void assignSlice(unsigned int z, std::vector<uint32_t> &pairs, std::vector<uint32_t> &out, glm::uvec2 *ranges) const;
+    [[nodiscard]] bool coneVisible(const Candidate &candidate, unsigned int cluster) const;
+
+    std::vector<Candidate> m_candidates;
+    std::vector<uint32_t> m_sliceOffsets, m_sliceCandidates;  // 与每层相交的灯光
+    std::vector<glm::uvec2> m_ranges;
+    std::vector<uint32_t> m_indices;
+    // 每个工作线程的结果与处理的层范围，按层的顺序合并
+    std::vector<std::vector<uint32_t>> m_workerIndices, m_workerPairs;
+    std::vector<glm::uvec2> m_workerSlices;
+
+    // 分块包围盒，按 x + grid.x * (y + grid.y * z) 排列，末尾多留 8 个便于整组读取
+    std::vector<float> m_minX, m_maxX, m_minY, m_maxY;
+    std::vector<float> m_sliceNear, m_sliceFar;  // 每层的深度范围
+    std::vector<glm::vec4> m_spheres;  // 包围球，用于圆锥测试
+
+    glm::mat4 m_projection{0.f};
+    float m_near = 0.f, m_far = 0.f, m_boundsSliceFar = 0.f;
+    Grid m_boundsGrid{0, 0, 0};
+    float m_depthScale = 0.f, m_depthBias = 0.f;
+};
+
+
+#endif //MODEL_VIEWER_LIGHTCLUSTERS_H
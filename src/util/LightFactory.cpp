@@ -3,9 +3,13 @@
 //
 
 #include "LightFactory.h"
+#include "LightClusters.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/random.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 Light *LightFactory::getLight(int index) const {
     if (index < 0 || index >= MAX_LIGHT_NUM) {
@@ -31,34 +35,124 @@ int LightFactory::addLight(LightType type, int index) {
 
 void LightFactory::deleteLight(int index) {
     if (index >= 0 && index < MAX_LIGHT_NUM) {
-        if (lights[index]->type != NONE) {
-            delete lights[index];
+        // 灯光对象在工厂的生命周期内一直存在，删除只是停用
+        if (lights[index]->type != NONE)
             lights[index]->type = NONE;
-        }
     }
 }
 
-void LightFactory::importShaderValue(ShaderProgram &shaderProgram) const {
+void LightFactory::setSampledLights(const std::vector<LightData> &sampled) {
+    m_lightData.resize(MAX_LIGHT_NUM);
+    m_lightData.insert(m_lightData.end(), sampled.begin(), sampled.end());
+    m_sampledDirty = true;
+    m_sampledLampsDirty = true;
+}
+
+void LightFactory::updateBuffer() {
+    int first = MAX_LIGHT_NUM, last = -1;
+    auto bytes = m_lightData.size() * sizeof(LightData);
+    if (!m_lightBuffer.valid() || m_lightBuffer.size() != bytes) {
+        m_lightBuffer.allocate(bytes);
+        first = 0;
+        last = (int)m_lightData.size() - 1;
+    } else if (m_sampledDirty) {
+        first = MAX_LIGHT_NUM;
+        last = (int)m_lightData.size() - 1;
+    }
+    m_sampledDirty = false;
+
+    // 按类型排序，特化的着色器变体只需要知道每种类型的数量
+    int order[MAX_LIGHT_NUM];
+    int count = 0;
+    auto collect = [&](LightType type, LightType alias) {
+        int start = count;
+        for (int i = 0; i < MAX_LIGHT_NUM; ++i)
+            if (lights[i]->type == type || lights[i]->type == alias)
+                order[count++] = i;
+        return count - start;
+    };
+    m_dirCount = collect(DIRECTIONAL_LIGHT, DIRECTIONAL_LIGHT);
+    m_pointCount = collect(POINT_LIGHT, POINT_LIGHT);
+    m_spotCount = collect(SPOT_LIGHT, TORCH_LIGHT);
+    collect(NONE, NONE);
+    m_shadowIndex = -1;
+
+    // 灯光参数由界面直接修改，以打包后的内容判断是否变化
     for (int i = 0; i < MAX_LIGHT_NUM; ++i) {
-        lights[i]->importShaderValue(shaderProgram, i);
+        if (order[i] == 0 && lights[0]->type != NONE)
+            m_shadowIndex = i;
+        m_bufferIndex[order[i]] = i;
+        auto data = lights[order[i]]->pack();
+        if (std::memcmp(&data, &m_lightData[i], sizeof(LightData)) != 0) {
+            m_lightData[i] = data;
+            first = std::min(first, i);
+            last = std::max(last, i);
+        }
     }
+    if (first <= last)
+        m_lightBuffer.update(first * sizeof(LightData), &m_lightData[first], (last - first + 1) * sizeof(LightData));
+    m_lightBuffer.bindBase(LIGHT_BINDING);
 }
 
-void LightFactory::modelRender(ShaderProgram &shaderProgram, glm::mat4 &view, glm::mat4 &projection) const {
+void LightFactory::updateLamps() {
+    LampInstance editable[MAX_LIGHT_NUM];
+    size_t count = 0;
     for (auto light : lights) {
-        if (light->type != NONE && light->model != nullptr) {
-            auto pos = light->position;
-            if(light->type == DIRECTIONAL_LIGHT) {
-                pos = -light->direction;
-            }
+        if (light->type == NONE || !light->isShowModel)
+            continue;
+        auto pos = light->position;
+        if (light->type == DIRECTIONAL_LIGHT)
+            pos = -light->direction;
+        editable[count++] = {glm::translate(light->modelMatrix, pos), glm::vec4(light->color, 1.f)};
+    }
 
-            auto model = glm::translate(light->modelMatrix, pos);
-            shaderProgram.use(model, view, projection);
-            light->modelRender(shaderProgram);
+    if (m_sampledLampsDirty || m_lampsShowSampled != showSampledLamps) {
+        m_sampledLamps.clear();
+        if (showSampledLamps) {
+            for (size_t i = MAX_LIGHT_NUM; i < m_lightData.size(); i++) {
+                auto &light = m_lightData[i];
+                auto range = LightClusters::lightRange(light);
+                auto model = glm::translate(glm::mat4(1.f), light.position);
+                if (std::isfinite(range))
+                    model = glm::scale(model, glm::vec3(range * SAMPLED_LAMP_SCALE));
+                m_sampledLamps.push_back({model, glm::vec4(light.color, 1.f)});
+            }
         }
+        m_sampledLampsDirty = false;
+        m_lampsShowSampled = showSampledLamps;
+        m_editableLamps = MAX_LIGHT_NUM + 1;  // 强制整体重建
+    }
+
+    // 可编辑灯光的数量变化时采样灯光的位置随之移动，整体重新上传
+    if (count != m_editableLamps) {
+        m_editableLamps = count;
+        m_lampData.assign(editable, editable + count);
+        m_lampData.insert(m_lampData.end(), m_sampledLamps.begin(), m_sampledLamps.end());
+        auto bytes = std::max<size_t>(m_lampData.size(), 1) * sizeof(LampInstance);
+        if (!m_lampBuffer.valid() || m_lampBuffer.size() < bytes)
+            m_lampBuffer.allocate(bytes);
+        m_lampBuffer.update(0, m_lampData.data(), m_lampData.size() * sizeof(LampInstance));
+        return;
+    }
+    if (count > 0 && std::memcmp(editable, m_lampData.data(), count * sizeof(LampInstance)) != 0) {
+        std::copy(editable, editable + count, m_lampData.begin());
+        m_lampBuffer.update(0, m_lampData.data(), count * sizeof(LampInstance));
     }
 }
 
+void LightFactory::modelRender(ShaderProgram &shaderProgram) {
+    updateLamps();
+    if (m_lampData.empty() || baseModel == nullptr)
+        return;
+    shaderProgram.use();
+    for (auto &mesh : baseModel->meshes) {
+        glBindVertexArray(mesh.getVao());
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.getIndices().size(), GL_UNSIGNED_INT, nullptr,
+                                (GLsizei)m_lampData.size());
+    }
+    glBindVertexArray(0);
+}
+
 LightFactory::LightFactory() {
     for (auto & light : lights) {
         light = new Light();
@@ -73,6 +167,23 @@ LightFactory::~LightFactory() {
 
 void LightFactory::setBaseModel(Model *model) {
     baseModel = model;
+    if (model != nullptr) {
+        // 缓冲重新分配时名称不变，顶点数组的挂载一直有效
+        if (!m_lampBuffer.valid())
+            m_lampBuffer.allocate(sizeof(LampInstance));
+        glBindBuffer(GL_ARRAY_BUFFER, m_lampBuffer.id());
+        for (auto &mesh : model->meshes) {
+            glBindVertexArray(mesh.getVao());
+            for (GLuint i = 0; i < 5; i++) {
+                glEnableVertexAttribArray(LAMP_ATTRIBUTE + i);
+                glVertexAttribPointer(LAMP_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, sizeof(LampInstance),
+                                      (void *)(i * sizeof(glm::vec4)));
+                glVertexAttribDivisor(LAMP_ATTRIBUTE + i, 1);
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
     for (auto & light : lights) {
         light->model = model;
     }
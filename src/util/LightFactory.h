@@ -7,7 +7,9 @@
 
 #define MAX_LIGHT_NUM 10
 
+#include <vector>
 #include "opengl/Light.h"
+#include "opengl/GpuBuffer.h"
 
 class LightFactory {
 public:
@@ -29,9 +31,40 @@ public:
 
     void setBaseModel(Model *model);
 
-    void importShaderValue(ShaderProgram &shaderProgram) const;
-
-    void modelRender(ShaderProgram &shaderProgram, glm::mat4 &view, glm::mat4 &projection) const;
+    /// 打包所有灯光并与上次上传的内容比较，只写入变化的区间，然后绑定到 LIGHT_BINDING
+    /// 每帧调用一次，所有使用灯光的着色器共用
+    /// 缓冲中按平行光、点光、聚光（含手电筒）的顺序排列，未使用的灯光在最后
+    void updateBuffer();
+
+    /// 最近一次 updateBuffer 时各类型灯光的数量，聚光包括手电筒
+    [[nodiscard]] int dirLightCount() const { return m_dirCount; }
+    [[nodiscard]] int pointLightCount() const { return m_pointCount; }
+    [[nodiscard]] int spotLightCount() const { return m_spotCount; }
+    /// 第 0 个灯光（投射阴影）在缓冲中的位置，未使用时为 -1
+    [[nodiscard]] int shadowLightIndex() const { return m_shadowIndex; }
+    /// 第 index 个灯光在缓冲中的位置
+    [[nodiscard]] int bufferIndex(int index) const { return m_bufferIndex[index]; }
+
+    /// 附加在可编辑灯光之后的大量点光与聚光（世界坐标），不能在界面中单独编辑，也不投射阴影
+    /// 缓冲中从 MAX_LIGHT_NUM 开始，下一次 updateBuffer 时上传
+    void setSampledLights(const std::vector<LightData> &sampled);
+    void clearSampledLights() { setSampledLights({}); }
+    [[nodiscard]] size_t sampledLightCount() const { return m_lightData.size() - MAX_LIGHT_NUM; }
+    /// 缓冲中的灯光总数与最近一次 updateBuffer 打包的内容
+    [[nodiscard]] size_t lightCount() const { return m_lightData.size(); }
+    [[nodiscard]] const LightData *lightData() const { return m_lightData.data(); }
+
+    /// 灯光模型的实例属性：模型矩阵占 LAMP_ATTRIBUTE 起的四个位置，颜色在其后
+    static constexpr GLuint LAMP_ATTRIBUTE = 6;
+
+    /// 以一次实例化绘制渲染所有灯光模型，实例数据在灯光变化时才重新上传
+    /// 观察与投影矩阵取自 Frame 块
+    void modelRender(ShaderProgram &shaderProgram);
+    /// 是否同时显示附加的采样灯光，模型按影响范围的 SAMPLED_LAMP_SCALE 缩放
+    bool showSampledLamps = false;
+    static constexpr float SAMPLED_LAMP_SCALE = 0.05f;
+    /// 最近一次 modelRender 绘制的实例数
+    [[nodiscard]] size_t lampCount() const { return m_lampData.size(); }
 
     void reset();
 
@@ -39,9 +72,32 @@ public:
 private:
     LightFactory();
 
-    Model *baseModel;
+    /// 与 lamp_vertex.glsl 的实例属性一致
+    struct LampInstance {
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+
+    /// 可编辑灯光的实例每帧打包并与已上传的内容比较，采样灯光的实例只在其变化时重建
+    void updateLamps();
+
+    Model *baseModel = nullptr;
 
     Light *lights[MAX_LIGHT_NUM];
+
+    std::vector<LightData> m_lightData = std::vector<LightData>(MAX_LIGHT_NUM);  // 已上传的内容
+    bool m_sampledDirty = false;
+    int m_dirCount = 0, m_pointCount = 0, m_spotCount = 0;
+    int m_shadowIndex = -1;
+    int m_bufferIndex[MAX_LIGHT_NUM] = {};
+    GpuBuffer m_lightBuffer{GL_SHADER_STORAGE_BUFFER};
+
+    std::vector<LampInstance> m_lampData;  // 已上传的内容，可编辑灯光在前
+    std::vector<LampInstance> m_sampledLamps;
+    size_t m_editableLamps = 0;
+    bool m_sampledLampsDirty = false;
+    bool m_lampsShowSampled = false;  // 上次重建时 showSampledLamps 的值
+    GpuBuffer m_lampBuffer{GL_ARRAY_BUFFER};
 };
 
 
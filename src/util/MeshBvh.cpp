@@ -0,0 +1,215 @@
+#include "MeshBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+
+MeshBvh::MeshBvh() = default;
+
+MeshBvh::MeshBvh(const Mesh &mesh) {
+    build(mesh);
+}
+
+void MeshBvh::build(const Mesh &mesh) {
+    const auto &faces = mesh.getFaces();
+    const auto &vertices = mesh.getVertices();
+
+    m_nodes.clear();
+    m_faces.resize(faces.size());
+    if (faces.empty())
+        return;
+
+    vector<glm::vec3> centroids(faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        m_faces[i] = i;
+        centroids[i] = (vertices[faces[i].vertex[0]].position +
+                        vertices[faces[i].vertex[1]].position +
+                        vertices[faces[i].vertex[2]].position) / 3.f;
+    }
+
+    m_nodes.reserve(2 * (faces.size() / LEAF_SIZE + 1));
+    buildNode(0, (unsigned int)faces.size(), centroids, mesh);
+}
+
+unsigned int MeshBvh::buildNode(unsigned int begin, unsigned int end,
+                                const vector<glm::vec3> &centroids, const Mesh &mesh) {
+    const auto &faces = mesh.getFaces();
+    const auto &vertices = mesh.getVertices();
+
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    glm::vec3 minCentroid(FLT_MAX), maxCentroid(-FLT_MAX);
+    for (auto i = begin; i < end; i++) {
+        for (auto index : faces[m_faces[i]].vertex) {
+            minPos = glm::min(minPos, vertices[index].position);
+            maxPos = glm::max(maxPos, vertices[index].position);
+        }
+        minCentroid = glm::min(minCentroid, centroids[m_faces[i]]);
+        maxCentroid = glm::max(maxCentroid, centroids[m_faces[i]]);
+    }
+
+    auto nodeIndex = (unsigned int)m_nodes.size();
+    m_nodes.push_back({minPos, begin, maxPos, end - begin});
+    if (end - begin <= LEAF_SIZE)
+        return nodeIndex;
+
+    // 沿重心包围盒最长轴取中位数划分
+    auto extent = maxCentroid - minCentroid;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(m_faces.begin() + begin, m_faces.begin() + mid, m_faces.begin() + end,
+                     [&centroids, axis](unsigned int a, unsigned int b) { return centroids[a][axis] < centroids[b][axis]; });
+
+    buildNode(begin, mid, centroids, mesh);
+    auto right = buildNode(mid, end, centroids, mesh);
+    m_nodes[nodeIndex].first = right;
+    m_nodes[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+/// 射线与包围盒相交测试（slab 方法）
+static inline bool intersectBox(const glm::vec3 &min, const glm::vec3 &max,
+                                const glm::vec3 &orig, const glm::vec3 &invDir, float tMax) {
+    auto t0 = (min - orig) * invDir;
+    auto t1 = (max - orig) * invDir;
+    auto tNear = glm::min(t0, t1);
+    auto tFar = glm::max(t0, t1);
+    auto enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+    auto exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+    return enter <= exit;
+}
+
+/// 射线三角形求交（Möller–Trumbore），不剔除背面
+static inline bool intersectTriangle(const glm::vec3 &orig, const glm::vec3 &dir,
+                                     const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2,
+                                     float &t, float &u, float &v) {
+    constexpr float EPSILON = 1e-9f;
+
+    auto e1 = v1 - v0;
+    auto e2 = v2 - v0;
+    auto p = glm::cross(dir, e2);
+    auto det = glm::dot(e1, p);
+    if (det > -EPSILON && det < EPSILON)
+        return false;
+
+    auto invDet = 1.f / det;
+    auto s = orig - v0;
+    u = glm::dot(s, p) * invDet;
+    if (u < 0.f || u > 1.f)
+        return false;
+
+    auto q = glm::cross(s, e1);
+    v = glm::dot(dir, q) * invDet;
+    if (v < 0.f || u + v > 1.f)
+        return false;
+
+    t = glm::dot(e2, q) * invDet;
+    return t > 1e-6f;
+}
+
+bool MeshBvh::intersect(const Mesh &mesh, const glm::vec3 &orig, const glm::vec3 &dir, float tMax,
+                        RayHit &hit) const {
+    if (m_nodes.empty())
+        return false;
+
+    const auto &faces = mesh.getFaces();
+    const auto &vertices = mesh.getVertices();
+    auto invDir = 1.f / dir;
+    bool found = false;
+
+    unsigned int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const auto &node = m_nodes[stack[--top]];
+        if (!intersectBox(node.min, node.max, orig, invDir, tMax))
+            continue;
+
+        if (node.count > 0) {
+            for (auto i = node.first; i < node.first + node.count; i++) {
+                const auto &face = faces[m_faces[i]];
+                float t, u, v;
+                if (intersectTriangle(orig, dir,
+                                      vertices[face.vertex[0]].position,
+                                      vertices[face.vertex[1]].position,
+                                      vertices[face.vertex[2]].position, t, u, v) && t < tMax) {
+                    tMax = t;
+                    hit = {m_faces[i], t, u, v};
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // 射线方向为正的轴上左子节点（较小坐标）更近，先访问
+        auto left = (unsigned int)(&node - m_nodes.data()) + 1;
+        auto right = node.first;
+        auto axisPositive = m_nodes[left].min + m_nodes[left].max - m_nodes[right].min - m_nodes[right].max;
+        bool leftFirst = glm::dot(axisPositive, dir) < 0.f;
+        stack[top++] = leftFirst ? right : left;
+        stack[top++] = leftFirst ? left : right;
+    }
+
+    return found;
+}
+
+bool MeshBvh::occluded(const Mesh &mesh, const glm::vec3 &orig, const glm::vec3 &dir, float tMax) const {
+    if (m_nodes.empty())
+        return false;
+
+    const auto &faces = mesh.getFaces();
+    const auto &vertices = mesh.getVertices();
+    auto invDir = 1.f / dir;
+
+    unsigned int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const auto &node = m_nodes[stack[--top]];
+        if (!intersectBox(node.min, node.max, orig, invDir, tMax))
+            continue;
+
+        if (node.count > 0) {
+            for (auto i = node.first; i < node.first + node.count; i++) {
+                const auto &face = faces[m_faces[i]];
+                float t, u, v;
+                if (intersectTriangle(orig, dir,
+                                      vertices[face.vertex[0]].position,
+                                      vertices[face.vertex[1]].position,
+                                      vertices[face.vertex[2]].position, t, u, v) && t < tMax)
+                    return true;
+            }
+            continue;
+        }
+        stack[top++] = node.first;
+        stack[top++] = (unsigned int)(&node - m_nodes.data()) + 1;
+    }
+
+    return false;
+}
+
+vector<unsigned int> MeshBvh::subtrees(unsigned int count) const {
+    vector<unsigned int> roots;
+    if (m_nodes.empty())
+        return roots;
+
+    // 广度优先展开内部节点，直到数量足够或只剩叶节点
+    roots.push_back(0);
+    bool expanded = true;
+    while (roots.size() < count && expanded) {
+        expanded = false;
+        vector<unsigned int> next;
+        next.reserve(roots.size() * 2);
+        for (auto root : roots) {
+            if (m_nodes[root].count > 0) {
+                next.push_back(root);
+                continue;
+            }
+            next.push_back(root + 1);
+            next.push_back(m_nodes[root].first);
+            expanded = true;
+        }
+        roots.swap(next);
+    }
+    return roots;
+}
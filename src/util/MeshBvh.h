@@ -0,0 +1,101 @@
+#ifndef MODEL_VIEWER_MESHBVH_H
+#define MODEL_VIEWER_MESHBVH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "opengl/Mesh.h"
+
+/// 网格三角形层次包围盒，建立在模型空间坐标上
+/// 只保存面的重排索引，几何数据在查询时由网格提供
+class MeshBvh {
+public:
+    static constexpr unsigned int LEAF_SIZE = 8;
+    static constexpr unsigned int INVALID_INDEX = 0xffffffff;
+
+    /// 包围盒与查询区域的关系
+    enum Overlap {
+        OUTSIDE,
+        PARTIAL,
+        INSIDE
+    };
+
+    struct RayHit {
+        unsigned int face = INVALID_INDEX;  // 面在网格中的序号
+        float t = 0.f;  // 交点距离起点的距离
+        float u = 0.f;  // 重心坐标 (1 - u - v) * v0 + u * v1 + v * v2
+        float v = 0.f;
+    };
+
+    MeshBvh();
+    explicit MeshBvh(const Mesh &mesh);
+
+    void build(const Mesh &mesh);
+
+    /// 射线求交，返回最近交点
+    /// \param mesh 建树时使用的网格
+    /// \param orig 射线起点（模型空间）
+    /// \param dir 射线方向（模型空间）
+    /// \param tMax 最大距离，只接受更近的交点
+    /// \param hit 交点信息，仅在找到更近的交点时更新
+    /// \return 是否找到交点
+    bool intersect(const Mesh &mesh, const glm::vec3 &orig, const glm::vec3 &dir, float tMax, RayHit &hit) const;
+
+    /// 射线是否在 tMax 之前与任意三角形相交
+    [[nodiscard]] bool occluded(const Mesh &mesh, const glm::vec3 &orig, const glm::vec3 &dir, float tMax) const;
+
+    /// 区域查询
+    /// \param root 起始节点，配合 subtrees 并行遍历
+    /// \param classify 包围盒分类 (min, max) -> Overlap
+    /// \param leaf 叶节点回调 (faces, count, inside)，inside 表示整个叶节点都在区域内
+    template<typename Classify, typename Leaf>
+    void query(unsigned int root, Classify &&classify, Leaf &&leaf) const {
+        if (m_nodes.empty())
+            return;
+
+        struct Entry {
+            unsigned int node;
+            bool inside;
+        };
+        Entry stack[64];
+        int top = 0;
+        stack[top++] = {root, false};
+
+        while (top > 0) {
+            auto entry = stack[--top];
+            const auto &node = m_nodes[entry.node];
+            auto overlap = entry.inside ? INSIDE : classify(node.min, node.max);
+            if (overlap == OUTSIDE)
+                continue;
+
+            if (node.count > 0) {
+                leaf(&m_faces[node.first], node.count, overlap == INSIDE);
+                continue;
+            }
+            stack[top++] = {node.first, overlap == INSIDE};
+            stack[top++] = {entry.node + 1, overlap == INSIDE};
+        }
+    }
+
+    /// 将树切分为至少 count 棵子树（叶节点不再切分），返回子树根节点
+    [[nodiscard]] vector<unsigned int> subtrees(unsigned int count) const;
+
+    [[nodiscard]] bool empty() const { return m_nodes.empty(); }
+    [[nodiscard]] size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        glm::vec3 min;
+        unsigned int first;  // 叶节点：m_faces 中的起始位置；内部节点：右子节点，左子节点紧随当前节点
+        glm::vec3 max;
+        unsigned int count;  // 叶节点三角形数量，内部节点为 0
+    };
+
+    unsigned int buildNode(unsigned int begin, unsigned int end,
+                           const vector<glm::vec3> &centroids, const Mesh &mesh);
+
+    vector<Node> m_nodes;
+    vector<unsigned int> m_faces;  // 按树序重排的面序号
+};
+
+
+#endif //MODEL_VIEWER_MESHBVH_H
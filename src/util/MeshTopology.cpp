@@ -0,0 +1,312 @@
+#include "MeshTopology.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+
+MeshTopology::MeshTopology() = default;
+
+MeshTopology::MeshTopology(const vector<Mesh> &meshes, const VertexWeld &weld) {
+    build(meshes, weld);
+}
+
+void MeshTopology::build(const vector<Mesh> &meshes, const VertexWeld &weld) {
+    auto start = std::chrono::steady_clock::now();
+    m_tables.assign(meshes.size(), Table());
+    for (int j = 0; j < meshes.size(); j++)
+        buildTable(m_tables[j], meshes[j], j, weld);
+    buildTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void MeshTopology::buildTable(Table &table, const Mesh &mesh, int meshIndex, const VertexWeld &weld) {
+    const auto &faces = mesh.getFaces();
+    auto vertexCount = mesh.getVertices().size();
+    table.faces = faces.data();
+    table.faceCount = faces.size();
+
+    // 组内成员按网格与顶点序号排列，本网格的第一个成员即序号最小的顶点
+    table.canonical.resize(vertexCount);
+    parallel::forEach(vertexCount, [&](size_t v) {
+        auto group = weld.group(meshIndex, (unsigned int)v);
+        auto members = weld.members(group);
+        auto first = std::lower_bound(members, members + weld.memberCount(group), meshIndex,
+                                      [](const VertexWeld::Member &member, int mesh) { return member.meshIndex < mesh; });
+        table.canonical[v] = first->vertex;
+    });
+
+    // 拓扑顶点 -> 面，退化面中重复的顶点只记录一次
+    table.vertexFaceOffsets.assign(vertexCount + 1, 0);
+    auto forEachCorner = [&table](unsigned int face, auto &&function) {
+        for (unsigned int k = 0; k < 3; k++) {
+            auto v = table.corner(face * 3 + k);
+            if ((k < 1 || v != table.corner(face * 3)) && (k < 2 || v != table.corner(face * 3 + 1)))
+                function(v);
+        }
+    };
+    for (unsigned int f = 0; f < table.faceCount; f++)
+        forEachCorner(f, [&table](unsigned int v) { table.vertexFaceOffsets[v + 1]++; });
+    for (size_t v = 0; v < vertexCount; v++)
+        table.vertexFaceOffsets[v + 1] += table.vertexFaceOffsets[v];
+    table.vertexFaces.resize(table.vertexFaceOffsets[vertexCount]);
+    vector<unsigned int> cursor(table.vertexFaceOffsets.begin(), table.vertexFaceOffsets.end() - 1);
+    for (unsigned int f = 0; f < table.faceCount; f++)
+        forEachCorner(f, [&table, &cursor, f](unsigned int v) { table.vertexFaces[cursor[v]++] = f; });
+
+    buildOpposites(table);
+    buildBoundaryLoops(table);
+    buildComponents(table);
+}
+
+void MeshTopology::buildOpposites(Table &table) {
+    // 半边 a -> b 的反向半边在包含 b 的面中查找，每个角独立，可以并行
+    table.opposite.assign(table.faceCount * 3, INVALID);
+    parallel::forEach(table.faceCount, [&table](size_t face) {
+        for (unsigned int k = 0; k < 3; k++) {
+            auto c = (unsigned int)face * 3 + k;
+            auto a = table.corner(c);
+            auto b = table.corner((unsigned int)face * 3 + (k + 1) % 3);
+            if (a == b)
+                continue;
+            for (auto i = table.vertexFaceOffsets[b]; i < table.vertexFaceOffsets[b + 1]; i++) {
+                auto other = table.vertexFaces[i];
+                if (other == face)
+                    continue;
+                for (unsigned int m = 0; m < 3; m++) {
+                    if (table.corner(other * 3 + m) == b && table.corner(other * 3 + (m + 1) % 3) == a) {
+                        table.opposite[c] = other * 3 + m;
+                        break;
+                    }
+                }
+                if (table.opposite[c] != INVALID)
+                    break;
+            }
+        }
+    }, 4096);
+}
+
+void MeshTopology::buildBoundaryLoops(Table &table) {
+    auto isBoundary = [&table](unsigned int c) {
+        return table.opposite[c] == INVALID && table.corner(c) != table.corner(c / 3 * 3 + (c % 3 + 1) % 3);
+    };
+
+    // 沿边界半边首尾相接，直到回到起点或无法继续（非流形处断开）
+    Bitset visited(table.opposite.size());
+    for (unsigned int start = 0; start < table.opposite.size(); start++) {
+        if (visited.test(start) || !isBoundary(start))
+            continue;
+        auto c = start;
+        while (c != INVALID) {
+            visited.set(c);
+            table.loopVertices.push_back(table.corner(c));
+            auto b = table.corner(c / 3 * 3 + (c % 3 + 1) % 3);
+            c = INVALID;
+            for (auto i = table.vertexFaceOffsets[b]; i < table.vertexFaceOffsets[b + 1] && c == INVALID; i++) {
+                auto face = table.vertexFaces[i];
+                for (unsigned int k = 0; k < 3; k++) {
+                    auto next = face * 3 + k;
+                    if (table.corner(next) == b && !visited.test(next) && isBoundary(next)) {
+                        c = next;
+                        break;
+                    }
+                }
+            }
+        }
+        table.loopOffsets.push_back((unsigned int)table.loopVertices.size());
+    }
+}
+
+void MeshTopology::buildComponents(Table &table) {
+    // 以共享顶点相连，面的朝向不一致时也不会被分开
+    table.components.assign(table.faceCount, INVALID);
+    vector<unsigned int> stack;
+    for (unsigned int seed = 0; seed < table.faceCount; seed++) {
+        if (table.components[seed] != INVALID)
+            continue;
+        auto id = table.componentCount++;
+        table.components[seed] = id;
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            auto face = stack.back();
+            stack.pop_back();
+            for (unsigned int k = 0; k < 3; k++) {
+                auto v = table.corner(face * 3 + k);
+                for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++) {
+                    auto other = table.vertexFaces[i];
+                    if (table.components[other] == INVALID) {
+                        table.components[other] = id;
+                        stack.push_back(other);
+                    }
+                }
+            }
+        }
+    }
+}
+
+MeshTopology::Range MeshTopology::vertexFaces(int meshIndex, unsigned int vertex) const {
+    const auto &table = m_tables[meshIndex];
+    auto v = table.canonical[vertex];
+    const auto *data = table.vertexFaces.data();
+    return {data + table.vertexFaceOffsets[v], data + table.vertexFaceOffsets[v + 1]};
+}
+
+void MeshTopology::oneRing(int meshIndex, unsigned int vertex, vector<unsigned int> &ring) const {
+    const auto &table = m_tables[meshIndex];
+    auto v = table.canonical[vertex];
+    auto first = ring.size();
+    for (auto face : vertexFaces(meshIndex, vertex)) {
+        for (unsigned int k = 0; k < 3; k++) {
+            auto other = table.corner(face * 3 + k);
+            if (other != v && std::find(ring.begin() + (long long)first, ring.end(), other) == ring.end())
+                ring.push_back(other);
+        }
+    }
+}
+
+void MeshTopology::faceNeighbours(int meshIndex, unsigned int face, unsigned int neighbours[3]) const {
+    const auto &table = m_tables[meshIndex];
+    for (unsigned int k = 0; k < 3; k++) {
+        auto opposite = table.opposite[face * 3 + k];
+        neighbours[k] = opposite == INVALID ? INVALID : opposite / 3;
+    }
+}
+
+MeshTopology::Range MeshTopology::boundaryLoop(int meshIndex, size_t loop) const {
+    const auto &table = m_tables[meshIndex];
+    const auto *data = table.loopVertices.data();
+    return {data + table.loopOffsets[loop], data + table.loopOffsets[loop + 1]};
+}
+
+void MeshTopology::growFaces(int meshIndex, Bitset &faces, int rings) const {
+    const auto &table = m_tables[meshIndex];
+
+    // 从选择的顶点出发逐环向外，只访问选择及其邻域
+    Bitset reached(table.canonical.size());
+    vector<unsigned int> frontier, next;
+    faces.forEach([&](size_t face) {
+        for (unsigned int k = 0; k < 3; k++) {
+            auto v = table.corner((unsigned int)face * 3 + k);
+            if (!reached.test(v)) {
+                reached.set(v);
+                frontier.push_back(v);
+            }
+        }
+    });
+
+    for (int ring = 0; ring < rings && !frontier.empty(); ring++) {
+        next.clear();
+        for (auto v : frontier) {
+            for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++) {
+                auto face = table.vertexFaces[i];
+                if (faces.test(face))
+                    continue;
+                faces.set(face);
+                for (unsigned int k = 0; k < 3; k++) {
+                    auto other = table.corner(face * 3 + k);
+                    if (!reached.test(other)) {
+                        reached.set(other);
+                        next.push_back(other);
+                    }
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+}
+
+void MeshTopology::shrinkFaces(int meshIndex, Bitset &faces, int rings) const {
+    const auto &table = m_tables[meshIndex];
+    Bitset visited(table.canonical.size());
+    vector<unsigned int> boundary;
+    for (int ring = 0; ring < rings; ring++) {
+        // 选择边界上的顶点：同时属于选择内外的面
+        visited.clear();
+        boundary.clear();
+        faces.forEach([&](size_t face) {
+            for (unsigned int k = 0; k < 3; k++) {
+                auto v = table.corner((unsigned int)face * 3 + k);
+                if (visited.test(v))
+                    continue;
+                visited.set(v);
+                for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++) {
+                    if (!faces.test(table.vertexFaces[i])) {
+                        boundary.push_back(v);
+                        break;
+                    }
+                }
+            }
+        });
+        if (boundary.empty())
+            break;
+        for (auto v : boundary)
+            for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++)
+                faces.reset(table.vertexFaces[i]);
+    }
+}
+
+void MeshTopology::growVertices(int meshIndex, Bitset &vertices, int rings) const {
+    const auto &table = m_tables[meshIndex];
+    vector<unsigned int> frontier, next;
+    vertices.forEach([&frontier](size_t v) { frontier.push_back((unsigned int)v); });
+
+    for (int ring = 0; ring < rings && !frontier.empty(); ring++) {
+        next.clear();
+        for (auto v : frontier) {
+            for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++) {
+                auto face = table.vertexFaces[i];
+                for (unsigned int k = 0; k < 3; k++) {
+                    auto other = table.corner(face * 3 + k);
+                    if (!vertices.test(other)) {
+                        vertices.set(other);
+                        next.push_back(other);
+                    }
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+}
+
+void MeshTopology::shrinkVertices(int meshIndex, Bitset &vertices, int rings) const {
+    const auto &table = m_tables[meshIndex];
+    vector<unsigned int> boundary;
+    for (int ring = 0; ring < rings; ring++) {
+        // 有未选择邻点的顶点
+        boundary.clear();
+        vertices.forEach([&](size_t v) {
+            for (auto i = table.vertexFaceOffsets[v]; i < table.vertexFaceOffsets[v + 1]; i++) {
+                auto face = table.vertexFaces[i];
+                if (!vertices.test(table.corner(face * 3)) || !vertices.test(table.corner(face * 3 + 1)) ||
+                    !vertices.test(table.corner(face * 3 + 2))) {
+                    boundary.push_back((unsigned int)v);
+                    return;
+                }
+            }
+        });
+        if (boundary.empty())
+            break;
+        for (auto v : boundary)
+            vertices.reset(v);
+    }
+}
+
+void MeshTopology::connectedFaces(int meshIndex, Bitset &faces) const {
+    const auto &table = m_tables[meshIndex];
+    Bitset selected(table.componentCount);
+    faces.forEach([&](size_t face) { selected.set(table.components[face]); });
+    for (unsigned int face = 0; face < table.faceCount; face++)
+        if (selected.test(table.components[face]))
+            faces.set(face);
+}
+
+void MeshTopology::connectedVertices(int meshIndex, Bitset &vertices) const {
+    const auto &table = m_tables[meshIndex];
+    Bitset selected(table.componentCount);
+    vertices.forEach([&](size_t v) {
+        if (table.vertexFaceOffsets[v] < table.vertexFaceOffsets[v + 1])
+            selected.set(table.components[table.vertexFaces[table.vertexFaceOffsets[v]]]);
+    });
+    for (unsigned int face = 0; face < table.faceCount; face++)
+        if (selected.test(table.components[face]))
+            for (unsigned int k = 0; k < 3; k++)
+                vertices.set(table.corner(face * 3 + k));
+}
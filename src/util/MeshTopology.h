@@ -0,0 +1,100 @@
+#ifndef MODEL_VIEWER_MESHTOPOLOGY_H
+#define MODEL_VIEWER_MESHTOPOLOGY_H
+
+#include <vector>
+#include "opengl/Mesh.h"
+#include "Bitset.h"
+#include "VertexWeld.h"
+
+/// 网格邻接关系（角表），每个网格一张，全部为扁平数组
+/// 同一网格内坐标相同的顶点按焊接表合并为一个拓扑顶点（序号最小者），
+/// 因此纹理接缝两侧的面也是相邻的
+///
+/// 角 c = 3 * face + k 对应半边 vertex[k] -> vertex[(k + 1) % 3]，opposite(c) 为反向的半边
+class MeshTopology {
+public:
+    static constexpr unsigned int INVALID = 0xffffffff;
+
+    /// 连续数组的一段
+    struct Range {
+        const unsigned int *first = nullptr;
+        const unsigned int *last = nullptr;
+
+        [[nodiscard]] const unsigned int *begin() const { return first; }
+        [[nodiscard]] const unsigned int *end() const { return last; }
+        [[nodiscard]] size_t size() const { return last - first; }
+    };
+
+    MeshTopology();
+    MeshTopology(const vector<Mesh> &meshes, const VertexWeld &weld);
+
+    /// 每个网格的拓扑顶点映射与反向半边匹配并行建立
+    void build(const vector<Mesh> &meshes, const VertexWeld &weld);
+
+    /// 顶点对应的拓扑顶点
+    [[nodiscard]] unsigned int canonical(int meshIndex, unsigned int vertex) const {
+        return m_tables[meshIndex].canonical[vertex];
+    }
+
+    /// 包含该顶点的面
+    [[nodiscard]] Range vertexFaces(int meshIndex, unsigned int vertex) const;
+
+    /// 与顶点共边的拓扑顶点（一环邻域），结果追加到 ring
+    void oneRing(int meshIndex, unsigned int vertex, vector<unsigned int> &ring) const;
+
+    /// 与面共边的三个面，依次对应边 v0v1、v1v2、v2v0，边界边为 INVALID
+    void faceNeighbours(int meshIndex, unsigned int face, unsigned int neighbours[3]) const;
+
+    [[nodiscard]] unsigned int opposite(int meshIndex, unsigned int corner) const {
+        return m_tables[meshIndex].opposite[corner];
+    }
+
+    /// 边界环的数量，第 loop 个环依次经过的拓扑顶点
+    [[nodiscard]] size_t boundaryLoopCount(int meshIndex) const { return m_tables[meshIndex].loopOffsets.size() - 1; }
+    [[nodiscard]] Range boundaryLoop(int meshIndex, size_t loop) const;
+
+    /// 以共享顶点相连的面划分的连通分量
+    [[nodiscard]] unsigned int componentCount(int meshIndex) const { return m_tables[meshIndex].componentCount; }
+    [[nodiscard]] unsigned int component(int meshIndex, unsigned int face) const {
+        return m_tables[meshIndex].components[face];
+    }
+
+    /// 选择的扩张、收缩与连通选择，faces 长度为面数，vertices 长度为顶点数且只使用拓扑顶点
+    /// 面按共享顶点扩张一环；收缩时去掉所有接触选择边界的面
+    void growFaces(int meshIndex, Bitset &faces, int rings) const;
+    void shrinkFaces(int meshIndex, Bitset &faces, int rings) const;
+    void growVertices(int meshIndex, Bitset &vertices, int rings) const;
+    void shrinkVertices(int meshIndex, Bitset &vertices, int rings) const;
+    void connectedFaces(int meshIndex, Bitset &faces) const;
+    void connectedVertices(int meshIndex, Bitset &vertices) const;
+
+    [[nodiscard]] size_t meshCount() const { return m_tables.size(); }
+
+    float buildTime = 0.f;  // 毫秒
+
+private:
+    struct Table {
+        const Face *faces = nullptr;
+        size_t faceCount = 0;
+        vector<unsigned int> canonical;  // 顶点 -> 拓扑顶点
+        vector<unsigned int> vertexFaceOffsets;  // 拓扑顶点 -> vertexFaces 起始位置，长度为顶点数 + 1
+        vector<unsigned int> vertexFaces;
+        vector<unsigned int> opposite;  // 角 -> 反向半边的角
+        vector<unsigned int> loopOffsets{0};
+        vector<unsigned int> loopVertices;
+        vector<unsigned int> components;  // 面 -> 连通分量
+        unsigned int componentCount = 0;
+
+        [[nodiscard]] unsigned int corner(unsigned int c) const { return canonical[faces[c / 3].vertex[c % 3]]; }
+    };
+
+    static void buildTable(Table &table, const Mesh &mesh, int meshIndex, const VertexWeld &weld);
+    static void buildOpposites(Table &table);
+    static void buildBoundaryLoops(Table &table);
+    static void buildComponents(Table &table);
+
+    vector<Table> m_tables;
+};
+
+
+#endif //MODEL_VIEWER_MESHTOPOLOGY_H
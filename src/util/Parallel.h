@@ -0,0 +1,54 @@
+#ifndef MODEL_VIEWER_PARALLEL_H
+#define MODEL_VIEWER_PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    /// 可用的工作线程数
+    inline unsigned int workerCount() {
+        static const unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        return count;
+    }
+
+    /// 将 [0, count) 均分给工作线程并行执行
+    /// \param count 元素数量
+    /// \param function 回调 (begin, end, worker)，worker 为线程序号，可用于写入线程私有的结果
+    /// \param grain 每个线程至少处理的元素数量，元素过少时在当前线程直接执行
+    /// \return 实际使用的线程数
+    template<typename Function>
+    unsigned int forRange(size_t count, Function &&function, size_t grain = 1024) {
+        auto workers = (unsigned int)std::min<size_t>(workerCount(), std::max<size_t>(1, count / std::max<size_t>(grain, 1)));
+        if (workers <= 1) {
+            if (count > 0)
+                function(size_t(0), count, 0u);
+            return 1;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        auto chunk = (count + workers - 1) / workers;
+        for (unsigned int worker = 1; worker < workers; worker++) {
+            auto begin = std::min(count, chunk * worker);
+            auto end = std::min(count, begin + chunk);
+            threads.emplace_back([&function, begin, end, worker]() { function(begin, end, worker); });
+        }
+        function(size_t(0), std::min(count, chunk), 0u);  // 当前线程处理第一段
+
+        for (auto &thread : threads)
+            thread.join();
+        return workers;
+    }
+
+    /// 并行执行 [0, count) 中每个元素
+    template<typename Function>
+    void forEach(size_t count, Function &&function, size_t grain = 1024) {
+        forRange(count, [&function](size_t begin, size_t end, unsigned int) {
+            for (auto i = begin; i < end; i++)
+                function(i);
+        }, grain);
+    }
+}
+
+#endif //MODEL_VIEWER_PARALLEL_H
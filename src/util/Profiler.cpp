@@ -0,0 +1,280 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace {
+    int64_t clockNow() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void writeString(std::ofstream &out, const char *text) {
+        out << '"';
+        for (auto *c = text; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+/// 单个线程的区间缓冲，只有所属线程写入、主线程读出
+/// 写满时覆盖最早的区间，主线程读出后检查写入位置，丢弃读的过程中被覆盖的部分
+struct Profiler::ThreadRing {
+    static constexpr size_t CAPACITY = 4096;
+    static constexpr int MAX_DEPTH = 32;
+
+    Event events[CAPACITY];
+    std::atomic<uint64_t> head{0};  // 已写入的区间数
+    uint64_t tail = 0;  // 已读出的区间数，只在主线程访问
+    std::atomic<bool> owned{true};  // 线程退出后可由新线程复用
+    std::atomic<size_t> overflow{0};  // 嵌套超过 MAX_DEPTH 而丢弃的区间
+    int track = 0;
+
+    // 尚未结束的区间，只在所属线程访问
+    int depth = 0;
+    const char *openNames[MAX_DEPTH] = {};
+    int64_t openStarts[MAX_DEPTH] = {};
+};
+
+/// 线程退出时归还环形缓冲
+struct Profiler::ThreadSlot {
+    ThreadRing *ring = nullptr;
+    ~ThreadSlot() {
+        if (ring)
+            ring->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local Profiler::ThreadSlot Profiler::s_threadSlot;
+
+Profiler &Profiler::get() {
+    static Profiler instance;
+    return instance;
+}
+
+// 单例在 OpenGL 上下文销毁之后才析构，查询对象随上下文一起释放
+Profiler::Profiler() : m_epoch(clockNow()) {}
+
+int64_t Profiler::now() const {
+    return clockNow() - m_epoch;
+}
+
+Profiler::ThreadRing *Profiler::threadRing() {
+    if (s_threadSlot.ring)
+        return s_threadSlot.ring;
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    ThreadRing *ring = nullptr;
+    for (auto &candidate : m_rings) {
+        if (!candidate->owned.load(std::memory_order_acquire)) {
+            ring = candidate.get();
+            ring->owned.store(true, std::memory_order_relaxed);
+            ring->depth = 0;
+            break;
+        }
+    }
+    if (!ring) {
+        m_rings.push_back(std::make_unique<ThreadRing>());
+        ring = m_rings.back().get();
+        ring->track = (int)m_rings.size() - 1;
+    }
+    s_threadSlot.ring = ring;
+    return ring;
+}
+
+void Profiler::beginScope(const char *name) {
+    auto *ring = threadRing();
+    if (ring->depth < ThreadRing::MAX_DEPTH) {
+        ring->openNames[ring->depth] = name;
+        ring->openStarts[ring->depth] = now();
+    }
+    ring->depth++;
+}
+
+void Profiler::endScope() {
+    auto *ring = threadRing();
+    if (ring->depth == 0)  // 区间开始时分析器未启用
+        return;
+    auto depth = --ring->depth;
+    if (depth >= ThreadRing::MAX_DEPTH) {
+        ring->overflow.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head % ThreadRing::CAPACITY] = {ring->openNames[depth], ring->openStarts[depth], now(), depth,
+                                                 ring->track};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::drainRings(Frame &frame) {
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    for (auto &ring : m_rings) {
+        auto head = ring->head.load(std::memory_order_acquire);
+        if (head - ring->tail > ThreadRing::CAPACITY) {
+            m_droppedEvents += head - ring->tail - ThreadRing::CAPACITY;
+            ring->tail = head - ThreadRing::CAPACITY;
+        }
+        auto first = frame.events.size();
+        for (auto i = ring->tail; i < head; i++)
+            frame.events.push_back(ring->events[i % ThreadRing::CAPACITY]);
+        // 读的过程中写入线程又绕回来覆盖的区间不可信
+        auto latest = ring->head.load(std::memory_order_acquire);
+        if (latest - ring->tail > ThreadRing::CAPACITY) {
+            auto overwritten = std::min<uint64_t>(latest - ring->tail - ThreadRing::CAPACITY, head - ring->tail);
+            frame.events.erase(frame.events.begin() + (ptrdiff_t)first,
+                               frame.events.begin() + (ptrdiff_t)(first + overwritten));
+            m_droppedEvents += overwritten;
+        }
+        ring->tail = head;
+        m_droppedEvents += ring->overflow.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+GLuint Profiler::nextQuery(GpuFrame &gpu) {
+    if (gpu.used == gpu.queries.size()) {
+        auto count = std::max<size_t>(gpu.queries.size(), 32);
+        gpu.queries.resize(gpu.queries.size() + count);
+        glGenQueries((GLsizei)count, gpu.queries.data() + gpu.used);
+    }
+    return gpu.queries[gpu.used++];
+}
+
+bool Profiler::beginGpuScope(const char *name) {
+    if (!m_frameOpen)
+        return false;
+    auto &gpu = m_gpuFrames[m_frameIndex % GPU_FRAMES];
+    auto query = nextQuery(gpu);
+    glQueryCounter(query, GL_TIMESTAMP);
+    gpu.open.push_back(gpu.scopes.size());
+    gpu.scopes.push_back({name, (int)gpu.open.size() - 1, gpu.used - 1, 0});
+    return true;
+}
+
+void Profiler::endGpuScope() {
+    auto &gpu = m_gpuFrames[m_frameIndex % GPU_FRAMES];
+    if (gpu.open.empty())  // 跨越了帧的分界
+        return;
+    auto query = nextQuery(gpu);
+    glQueryCounter(query, GL_TIMESTAMP);
+    gpu.scopes[gpu.open.back()].end = gpu.used - 1;
+    gpu.open.pop_back();
+}
+
+void Profiler::resolveGpu(GpuFrame &gpu) {
+    if (!gpu.pending)
+        return;
+    gpu.pending = false;
+    auto frame = std::find_if(m_history.begin(), m_history.end(),
+                              [&](const Frame &f) { return f.index == gpu.index; });
+    if (frame == m_history.end())
+        return;
+
+    // 最后一个查询完成时前面的都已完成；仍未完成时放弃这一帧，不等待 GPU
+    GLint available = 1;
+    if (gpu.used > 0)
+        glGetQueryObjectiv(gpu.queries[gpu.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        m_droppedGpuFrames++;
+        return;
+    }
+    frame->gpuResolved = true;
+    std::vector<GLuint64> times(gpu.used);
+    for (size_t i = 0; i < gpu.used; i++)
+        glGetQueryObjectui64v(gpu.queries[i], GL_QUERY_RESULT, &times[i]);
+    for (auto &scope : gpu.scopes) {
+        if (scope.end == 0)  // 帧结束时仍未关闭
+            continue;
+        frame->events.push_back({scope.name, (int64_t)times[scope.begin] + gpu.offset,
+                                 (int64_t)times[scope.end] + gpu.offset, scope.depth, GPU_TRACK});
+    }
+}
+
+void Profiler::newFrame() {
+    bool active = enabled.load(std::memory_order_relaxed);
+    if (!active && !m_frameOpen)
+        return;
+
+    auto time = now();
+    if (m_frameOpen) {
+        m_current.end = time;
+        drainRings(m_current);
+        m_history.push_back(std::move(m_current));
+        while (m_history.size() > HISTORY)
+            m_history.pop_front();
+        m_current = Frame();
+        m_frameOpen = false;
+    }
+    else {
+        Frame discarded;  // 启用之前已开始的区间
+        drainRings(discarded);
+    }
+
+    // 下一帧使用的查询保存着两帧之前的结果
+    m_frameIndex++;
+    auto &gpu = m_gpuFrames[m_frameIndex % GPU_FRAMES];
+    resolveGpu(gpu);
+    if (!active)
+        return;
+
+    m_current.index = m_frameIndex;
+    m_current.start = time;
+    m_frameOpen = true;
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    gpu.index = m_frameIndex;
+    gpu.pending = true;
+    gpu.offset = now() - gpuTime;
+    gpu.used = 0;
+    gpu.scopes.clear();
+    gpu.open.clear();
+}
+
+void Profiler::clear() {
+    m_history.clear();
+    m_droppedEvents = 0;
+    m_droppedGpuFrames = 0;
+}
+
+const Profiler::Frame *Profiler::lastFrame() const {
+    for (auto frame = m_history.rbegin(); frame != m_history.rend(); ++frame)
+        if (frame->gpuResolved)
+            return &*frame;
+    return nullptr;
+}
+
+bool Profiler::exportChromeTrace(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    // 时间以微秒为单位；GPU 单独一个线程轨道
+    constexpr int GPU_TID = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << R"({"ph":"M","pid":1,"tid":0,"name":"thread_name","args":{"name":"GPU"}})";
+    size_t tracks;
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        tracks = m_rings.size();
+    }
+    for (size_t track = 0; track < tracks; track++)
+        out << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << track + 1 << R"(,"name":"thread_name","args":{"name":")"
+            << (track == 0 ? "Main" : "Worker ") << (track == 0 ? "" : std::to_string(track)) << "\"}}";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (auto &frame : m_history) {
+        out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"name\":\"Frame " << frame.index << "\",\"ts\":"
+            << (double)frame.start / 1e3 << ",\"dur\":" << (double)(frame.end - frame.start) / 1e3 << "}";
+        for (auto &event : frame.events) {
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.track == GPU_TRACK ? GPU_TID : event.track + 1)
+                << ",\"cat\":\"" << (event.track == GPU_TRACK ? "gpu" : "cpu") << "\",\"name\":";
+            writeString(out, event.name);
+            out << ",\"ts\":" << (double)event.start / 1e3 << ",\"dur\":" << (double)(event.end - event.start) / 1e3
+                << "}";
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
@@ -0,0 +1,156 @@
+#ifndef MODEL_VIEWER_PROFILER_H
+#define MODEL_VIEWER_PROFILER_H
+
+#include "glad/glad.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// 帧分析器：嵌套的 CPU 区间写入各线程自己的环形缓冲，写入不加锁，主线程在帧的分界处收集
+/// GPU 区间以时间戳查询记录，两帧的查询轮流使用，读取的是两帧之前的结果，不等待 GPU
+/// 编译时未定义 MODEL_VIEWER_PROFILER 时下面的宏展开为空；运行时关闭时每个区间只读一次开关
+class Profiler {
+public:
+    struct Event {
+        const char *name = nullptr;  // 字符串字面量，只保存指针
+        int64_t start = 0;  // 相对分析器创建时刻的纳秒，GPU 区间已换算到 CPU 时钟
+        int64_t end = 0;
+        int depth = 0;  // 嵌套层数，最外层为 0
+        int track = 0;  // CPU 线程的轨道编号，GPU 区间为 GPU_TRACK
+    };
+
+    struct Frame {
+        uint64_t index = 0;
+        int64_t start = 0;  // CPU 的帧区间，GPU 区间可能晚于 end
+        int64_t end = 0;
+        bool gpuResolved = false;  // GPU 结果已读回，查询未按时完成的帧只有 CPU 区间
+        std::vector<Event> events;
+    };
+
+    static constexpr int GPU_TRACK = -1;
+    static constexpr size_t HISTORY = 300;  // 保留的帧数，导出时全部写出
+
+    static Profiler &get();
+    static inline std::atomic<bool> enabled{false};
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    void beginScope(const char *name);
+    void endScope();
+    /// 需要在主线程（持有 OpenGL 上下文）调用，帧尚未开始时返回 false，此时不调用 endGpuScope
+    bool beginGpuScope(const char *name);
+    void endGpuScope();
+
+    /// 帧的分界，在主线程调用：收集各线程上一帧的区间，读回两帧之前的 GPU 时间
+    void newFrame();
+    void clear();
+
+    /// CPU 与 GPU 结果都已收集的最近一帧，没有时返回 nullptr
+    [[nodiscard]] const Frame *lastFrame() const;
+    [[nodiscard]] const std::deque<Frame> &history() const { return m_history; }
+    /// 环形缓冲写满、嵌套过深而丢弃的 CPU 区间，以及查询未完成而放弃的 GPU 帧
+    [[nodiscard]] size_t droppedEvents() const { return m_droppedEvents; }
+    [[nodiscard]] size_t droppedGpuFrames() const { return m_droppedGpuFrames; }
+    [[nodiscard]] int64_t now() const;
+
+    /// 以 Chrome trace 格式写出历史中的全部帧，可在 chrome://tracing 或 Perfetto 中打开
+    bool exportChromeTrace(const std::string &path) const;
+
+private:
+    struct ThreadRing;
+    struct ThreadSlot;
+    static thread_local ThreadSlot s_threadSlot;
+    struct GpuScope {
+        const char *name;
+        int depth;
+        size_t begin;  // 查询在本帧查询列表中的位置
+        size_t end;
+    };
+    /// 一帧的 GPU 查询，两帧轮流使用
+    struct GpuFrame {
+        uint64_t index = 0;
+        bool pending = false;
+        int64_t offset = 0;  // GPU 时间戳换算到 CPU 时钟的偏移
+        std::vector<GLuint> queries;
+        size_t used = 0;
+        std::vector<GpuScope> scopes;
+        std::vector<size_t> open;
+    };
+    static constexpr int GPU_FRAMES = 2;
+
+    Profiler();
+
+    ThreadRing *threadRing();
+    void drainRings(Frame &frame);
+    void resolveGpu(GpuFrame &gpu);
+    GLuint nextQuery(GpuFrame &gpu);
+
+    const int64_t m_epoch;
+    mutable std::mutex m_ringMutex;  // 只在线程第一次记录时注册环形缓冲
+    std::vector<std::unique_ptr<ThreadRing>> m_rings;
+
+    bool m_frameOpen = false;
+    Frame m_current;
+    uint64_t m_frameIndex = 0;
+    GpuFrame m_gpuFrames[GPU_FRAMES];
+    std::deque<Frame> m_history;
+    size_t m_droppedEvents = 0;
+    size_t m_droppedGpuFrames = 0;
+};
+
+/// 作用域内的 CPU 区间
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name) : m_active(Profiler::enabled.load(std::memory_order_relaxed)) {
+        if (m_active)
+            Profiler::get().beginScope(name);
+    }
+    ~ProfileScope() {
+        if (m_active)
+            Profiler::get().endScope();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    bool m_active;
+};
+
+/// 作用域内的 GPU 区间，只能在主线程使用
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char *name)
+            : m_active(Profiler::enabled.load(std::memory_order_relaxed) && Profiler::get().beginGpuScope(name)) {}
+    ~GpuProfileScope() {
+        if (m_active)
+            Profiler::get().endGpuScope();
+    }
+
+    GpuProfileScope(const GpuProfileScope &) = delete;
+    GpuProfileScope &operator=(const GpuProfileScope &) = delete;
+
+private:
+    bool m_active;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#ifdef MODEL_VIEWER_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+/// 渲染阶段同时记录 CPU 与 GPU 区间
+#define PROFILE_PASS(name) PROFILE_SCOPE(name); GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::get().newFrame()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_PASS(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+#endif //MODEL_VIEWER_PROFILER_H
@@ -3,12 +3,15 @@
 //
 
 #include <iostream>
+#include <chrono>
+#include <cfloat>
 #include "RayPicker.h"
+#include "Parallel.h"
 
 void RayPicker::rayPick(const vector<Mesh>& meshes, const glm::vec3 cameraPos,
                         const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
                         float xpos, float ypos, int width, int height) {
-    this->m_meshes = meshes;
+    this->m_meshes = &meshes;
     this->m_model = model;
     this->m_view = view;
     this->m_projection = projection;
@@ -18,134 +21,48 @@ void RayPicker::rayPick(const vector<Mesh>& meshes, const glm::vec3 cameraPos,
     this->m_height = height;
     this->orig = cameraPos;
 
-    rayDirection();
-    checkFaces();
-}
-
-bool RayPicker::intersectTriangleBF(
-                       const glm::vec3& v0,
-                       const glm::vec3& v1,
-                       const glm::vec3& v2,
-                       float& distanceOrig,
-                       float& parameterU,
-                       float& parameterV)
-{
-    auto v0Model = glm::vec3(m_model * glm::vec4(v0, 1.0f));
-    auto v1Model = glm::vec3(m_model * glm::vec4(v1, 1.0f));
-    auto v2Model = glm::vec3(m_model * glm::vec4(v2, 1.0f));
-
-    // Ax+By+Cz+D=0
-    auto A = v0Model.y * (v2Model.z - v1Model.z) + v1Model.y * (v0Model.z - v2Model.z) + v2Model.y * (v1Model.z - v0Model.z);
-    auto B = v0Model.z * (v2Model.x - v1Model.x) + v1Model.z * (v0Model.x - v2Model.x) + v2Model.z * (v1Model.x - v0Model.x);
-    auto C = v0Model.x * (v2Model.y - v1Model.y) + v1Model.x * (v0Model.y - v2Model.y) + v2Model.x * (v1Model.y - v0Model.y);
-    auto D = -(v0Model.x * (v2Model.y * v1Model.z - v1Model.y * v2Model.z) + v1Model.x * (v0Model.y * v2Model.z - v2Model.y * v0Model.z) + v2Model.x * (v1Model.y * v0Model.z - v0Model.y * v1Model.z));
-
-    auto point1 = orig;
-    auto point2 = orig + dir;
-
-    // 线段与平面的交点
-    distanceOrig = -(A * point1.x + B * point1.y + C * point1.z + D) / (A * (point2.x - point1.x) + B * (point2.y - point1.y) + C * (point2.z - point1.z));
-    auto point = point1 + distanceOrig * (point2 - point1);
+    dir = rayDirection(xpos, ypos);
 
-    if (distanceOrig < 0.001f)
-    {
-        return false;
-    }
-
-    // 判断交点是否在三角形内
-    auto s012 = getArea(v0Model, v1Model, v2Model);
-    auto s01p = getArea(v0Model, v1Model, point);
-    auto s02p = getArea(v0Model, v2Model, point);
-    auto s12p = getArea(v1Model, v2Model, point);
-
-    auto s = s01p + s02p + s12p;
-    auto res = (s - s012) < 0.001f;
+    // 吸附半径换算为以射线为轴的圆锥半角
+    auto cosAngle = glm::clamp(glm::dot(dir, rayDirection(xpos + pointPickPixels, ypos)), 1e-6f, 1.f);
+    m_pickTan = std::sqrt(1.f - cosAngle * cosAngle) / cosAngle;
 
-    return res;
+    checkFaces();
 }
 
-float RayPicker::getArea(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
-{
-    auto a = glm::length(v1 - v0);
-    auto b = glm::length(v2 - v1);
-    auto c = glm::length(v0 - v2);
+void RayPicker::buildIndex(const vector<Mesh> &meshes) {
+    m_vertexTrees.clear();
+    m_vertexTrees.reserve(meshes.size());
+    for (auto &mesh : meshes)
+        m_vertexTrees.emplace_back(mesh.getVertices());
 
-    auto p = (a + b + c) / 2.0f;
+    // 各网格的层次包围盒相互独立，并行构建
+    m_bvhs.assign(meshes.size(), MeshBvh());
+    parallel::forEach(meshes.size(), [this, &meshes](size_t i) { m_bvhs[i].build(meshes[i]); }, 1);
+}
 
-    return sqrt(p * (p - a) * (p - b) * (p - c));
+void RayPicker::clearIndex() {
+    m_vertexTrees.clear();
+    m_bvhs.clear();
+    m_meshes = nullptr;
+    selectPointValid = false;
+    selectFaceValid = false;
 }
 
-bool RayPicker::intersectTriangle(
-                        const glm::vec3& v0,
-                        const glm::vec3& v1,
-                        const glm::vec3& v2,
-                        float& distanceOrig,
-                        float& parameterU,
-                        float& parameterV)
+glm::vec3 RayPicker::rayDirection(float xpos, float ypos) const
 {
-    constexpr float EPSILON = 0.0000001f;
-
-    auto v0Model = glm::vec3(m_model * glm::vec4(v0, 1.0f));
-    auto v1Model = glm::vec3(m_model * glm::vec4(v1, 1.0f));
-    auto v2Model = glm::vec3(m_model * glm::vec4(v2, 1.0f));
-
-    // 计算三角形的法线
-    auto E1 = v1Model - v0Model;  // 三角形的边
-    auto E2 = v2Model - v0Model;
-    auto P = glm::cross(dir, E2);
-
-    auto det = glm::dot(E1, P);
-
-    // 如果det=0，说明射线与三角形平行，不相交
-    if (det > -EPSILON && det < EPSILON) {
-        return false;
-    }
-
-
-    auto T = orig - v0Model;
-    // 计算u
-    parameterU = glm::dot(T, P);
-    if (parameterU < EPSILON || parameterU - det > -EPSILON)
-    {
-        return false;
-    }
-
-    auto Q = glm::cross(T, E1);
-
-    // 计算v
-    parameterV = glm::dot(dir, Q);
-    if (parameterV < EPSILON || parameterU + parameterV - det > -EPSILON)
-    {
-        return false;
-    }
-
-    // 计算t
-    distanceOrig = glm::dot(E2, Q);
-
-    auto fInvDet = 1.0f / det;
-    distanceOrig *= fInvDet;
-    parameterU *= fInvDet;
-    parameterV *= fInvDet;
-
-    return true;
+    return unproject(glm::inverse(m_projection * m_view), orig, xpos, ypos, m_width, m_height);
 }
 
-void RayPicker::rayDirection()
+glm::vec3 RayPicker::unproject(const glm::mat4 &inverseViewProjection, const glm::vec3 &orig,
+                               float xpos, float ypos, int width, int height)
 {
-    float x = (2.0f * m_xpos) / m_width - 1.0f;
-    float y = 1.0f - (2.0f * m_ypos) / m_height;
+    float x = (2.0f * xpos) / width - 1.0f;
+    float y = 1.0f - (2.0f * ypos) / height;
     float z = 1.0f;  //  z = 1.0f 代表当前将鼠标的位置投影到远裁剪平面，如果设z的坐标为-1则代表将当前投影到近裁剪平面上
-    auto ray_nds = glm::vec3(x, y, z);
-
-    // 裁剪齐次坐标
-    auto ray_clip = glm::vec4(ray_nds.x, ray_nds.y, ray_nds.z, 1.0f);
 
-    // 视点坐标
-    // 投影矩阵的逆矩阵左乘点的裁剪坐标
-    auto ray_eye = glm::inverse(m_projection) * ray_clip;
-
-    // 世界坐标
-    auto ray_wor = glm::inverse(m_view) * ray_eye;
+    // 裁剪齐次坐标左乘投影与观察矩阵的逆矩阵得到世界坐标
+    auto ray_wor = inverseViewProjection * glm::vec4(x, y, z, 1.0f);
 
     if (ray_wor.w != 0)
     {
@@ -153,90 +70,111 @@ void RayPicker::rayDirection()
     }
 
     // 从摄像机位置发出一条射线
-    dir = glm::normalize(glm::vec3(ray_wor.x, ray_wor.y, ray_wor.z) - orig);
+    return glm::normalize(glm::vec3(ray_wor) - orig);
 }
 
-void RayPicker::checkFaces()
+RayPicker::RayHit RayPicker::intersectRay(const vector<Mesh> &meshes, const glm::mat4 &inverseModel,
+                                          const Ray &ray) const
 {
-    float minT = 1000.f;
-    Face findFace;
-    int meshIndex;
-
-    float u, v, t;
-
-
-#pragma omp parallel
-#pragma omp for
-    for (int j = 0; j < m_meshes.size(); ++j)
+    // 射线变换到模型空间，方向不归一化，模型空间中的参数 t 与世界坐标一致
+    auto origModel = glm::vec3(inverseModel * glm::vec4(ray.orig, 1.0f));
+    auto dirModel = glm::vec3(inverseModel * glm::vec4(ray.dir, 0.0f));
+
+    RayHit hit;
+    MeshBvh::RayHit meshHit;
+    float tMax = FLT_MAX;
+    for (int j = 0; j < m_bvhs.size() && j < meshes.size(); ++j)
     {
-#pragma omp parallel
-#pragma omp for
-        for (auto& face : m_meshes[j].getFaces())
+        if (m_bvhs[j].intersect(meshes[j], origModel, dirModel, tMax, meshHit))
         {
-            VertexData vertex[3];
-            for (int i = 0; i < 3; i++)
-                vertex[i] = m_meshes[j].getVertices()[face.vertex[i]];
-
-            if (intersectTriangle(vertex[0].position, vertex[1].position, vertex[2].position, t, u, v))
-            {
-                if (t > 0 && t < minT)
-                {
-                    minT = t;
-                    findFace = face;
-                    meshIndex = j;
-                }
-            }
+            tMax = meshHit.t;
+            hit = {j, meshHit.face, meshHit.t, meshHit.u, meshHit.v};
         }
     }
+    return hit;
+}
 
-    if (minT < 1000.f)
+void RayPicker::intersectRays(const vector<Mesh> &meshes, const glm::mat4 &model,
+                              const vector<Ray> &rays, vector<RayHit> &hits) const
+{
+    auto inverseModel = glm::inverse(model);
+    hits.resize(rays.size());
+    parallel::forRange(rays.size(), [&](size_t begin, size_t end, unsigned int) {
+        for (auto i = begin; i < end; i++)
+            hits[i] = intersectRay(meshes, inverseModel, rays[i]);
+    }, 256);
+}
+
+vector<RayPicker::Ray> RayPicker::screenRays(glm::vec3 cameraPos, const glm::mat4 &view, const glm::mat4 &projection,
+                                             const vector<glm::vec2> &points, int width, int height)
+{
+    auto inverseViewProjection = glm::inverse(projection * view);
+    vector<Ray> rays(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+        rays[i] = {cameraPos, unproject(inverseViewProjection, cameraPos, points[i].x, points[i].y, width, height)};
+    return rays;
+}
+
+void RayPicker::checkFaces()
+{
+    auto hit = intersectRay(*m_meshes, glm::inverse(m_model), {orig, dir});
+
+    if (hit.meshIndex != -1)
     {
         selectFaceValid = true;
-        selectMeshIndex = meshIndex;
+        selectMeshIndex = hit.meshIndex;
+        const auto &mesh = (*m_meshes)[selectMeshIndex];
+        const auto &face = mesh.getFaces()[hit.face];
         for (int i = 0; i < 3; i++)
         {
-            selectFace[i] = m_meshes[selectMeshIndex].getVertices()[findFace.vertex[i]];
-            selectFaceIndex[i] = findFace.vertex[i];
+            selectFace[i] = mesh.getVertices()[face.vertex[i]];
+            selectFaceIndex[i] = face.vertex[i];
         }
-        crossPoint = orig + dir * minT;
-        m_distance = minT;
-        checkSelectPoint();
+        crossPoint = orig + dir * hit.t;
+        m_distance = hit.t;
+        checkSelectPoint(hit.t * (1.f + POINT_PICK_DEPTH_TOLERANCE + 2.f * m_pickTan));
     }
     else
     {
-        selectPointValid = false;
+        // 未命中任何面时仍可吸附轮廓边缘或点模式下的顶点
         selectFaceValid = false;
+        checkSelectPoint(FLT_MAX);
     }
 }
 
-void RayPicker::checkSelectPoint()
+void RayPicker::checkSelectPoint(float maxDistance)
 {
-    auto pointView = m_projection * m_view * glm::vec4(crossPoint, 1.0f);
-
-    float len[3], minLen = 1000.f;
-    int index = -1;
-
-    for (int i = 0; i < 3; i++)
+    auto start = std::chrono::steady_clock::now();
+
+    // 将射线变换到模型空间，模型矩阵只含均匀缩放，圆锥角保持不变
+    auto inverseModel = glm::inverse(m_model);
+    auto origModel = glm::vec3(inverseModel * glm::vec4(orig, 1.0f));
+    auto dirModel = glm::vec3(inverseModel * glm::vec4(dir, 0.0f));
+    auto scale = glm::length(dirModel);
+    dirModel /= scale;
+
+    VertexKdTree::ConeHit hit;
+    int meshIndex = -1;
+    for (int j = 0; j < m_vertexTrees.size(); ++j)
     {
-        auto pointTriangleView = m_projection * m_view * m_model * glm::vec4(selectFace[i].position, 1.0f);
-        len[i] = glm::length(glm::vec2(pointTriangleView.x, pointTriangleView.y) - glm::vec2(pointView.x, pointView.y));
-        if (len[i] < minLen && len[i] <= POINT_PICK_EPSILON * m_distance)
-        {
-            minLen = len[i];
-            index = i;
-        }
+        if (m_vertexTrees[j].nearestInCone(origModel, dirModel, m_pickTan,
+                                           maxDistance == FLT_MAX ? FLT_MAX : maxDistance * scale, hit))
+            meshIndex = j;
     }
 
-    if (index != -1)
+    if (meshIndex != -1)
     {
         selectPointValid = true;
-        selectPoint = selectFace[index];
-        selectPointIndex = selectFaceIndex[index];
+        selectMeshIndex = meshIndex;
+        selectPoint = (*m_meshes)[meshIndex].getVertices()[hit.index];
+        selectPointIndex = hit.index;
     }
     else
     {
         selectPointValid = false;
     }
+
+    snapTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 RayPicker::RayPicker() {
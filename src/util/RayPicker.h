@@ -6,12 +6,20 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include "opengl/Mesh.h"
+#include "VertexKdTree.h"
+#include "MeshBvh.h"
 
 class RayPicker {
 public:
     RayPicker();
 
-    static constexpr float POINT_PICK_EPSILON = 0.02f;
+    /// 顶点吸附时允许顶点位于命中面之后的相对深度
+    static constexpr float POINT_PICK_DEPTH_TOLERANCE = 0.02f;
+
+    /// 顶点吸附的屏幕像素半径
+    float pointPickPixels = 8.f;
+    /// 最近一次顶点吸附查询耗时（毫秒）
+    float snapTime = 0.f;
 
     glm::vec3 orig, dir;
     glm::vec3 crossPoint;
@@ -37,40 +45,63 @@ public:
     void rayPick(const vector<Mesh>& meshes, glm::vec3 cameraPos, const glm::mat4 &model, const glm::mat4 &view,
                  const glm::mat4 &projection, float xpos, float ypos, int width, int height);
 
+    /// 为模型的每个网格建立顶点索引与三角形层次包围盒，加载模型后调用
+    void buildIndex(const vector<Mesh>& meshes);
+    void clearIndex();
+
+    [[nodiscard]] const vector<MeshBvh> &getBvhs() const { return m_bvhs; }
+
+    struct Ray {
+        glm::vec3 orig;
+        glm::vec3 dir;
+    };
+
+    struct RayHit {
+        int meshIndex = -1;  // 未命中为 -1
+        unsigned int face = MeshBvh::INVALID_INDEX;  // 面在网格中的序号
+        float t = 0.f;  // 交点 orig + dir * t（世界坐标）
+        float u = 0.f;  // 重心坐标 (1 - u - v) * v0 + u * v1 + v * v2
+        float v = 0.f;
+    };
+
+    /// 批量射线求交，不依赖窗口，多线程执行，需先调用 buildIndex
+    /// \param meshes 建立索引时使用的网格
+    /// \param model 模型矩阵
+    /// \param rays 世界坐标中的射线
+    /// \param hits 每条射线的最近交点，与 rays 一一对应
+    void intersectRays(const vector<Mesh>& meshes, const glm::mat4 &model,
+                       const vector<Ray> &rays, vector<RayHit> &hits) const;
+
+    /// 单条射线求交
+    /// \param inverseModel 模型矩阵的逆矩阵
+    [[nodiscard]] RayHit intersectRay(const vector<Mesh>& meshes, const glm::mat4 &inverseModel, const Ray &ray) const;
+
+    /// 由屏幕坐标生成从摄像机出发的射线
+    /// \param points 屏幕像素坐标
+    static vector<Ray> screenRays(glm::vec3 cameraPos, const glm::mat4 &view, const glm::mat4 &projection,
+                                  const vector<glm::vec2> &points, int width, int height);
+
 private:
     float m_xpos, m_ypos;
     int m_width, m_height;
     float m_distance;
+    float m_pickTan;  // 吸附半径对应的圆锥半角正切
 
     glm::mat4 m_model, m_view, m_projection;
 
-    std::vector<Mesh> m_meshes;
-
-    /// 射线三角形检测 直接计算
-    bool intersectTriangleBF(const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2,
-                             float& distanceOrig, float& parameterU, float& parameterV);
-
-    static float getArea(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
-
-    /// 射线三角形检测
-    /// \param orig 射线起点
-    /// \param dir 射线方向
-    /// \param v0 三角形顶点0
-    /// \param v1 三角形顶点1
-    /// \param v2 三角形顶点2
-    /// \param t 交点距离起点的距离
-    /// \param u 交点距离v0的距离
-    /// \param v 交点距离v1的距离
-    /// \return 是否相交
-    /// 根据上面代码求出的t,u,v的值，交点的最终坐标可以用下面两种方法计算
-    /// orig + dir * t
-    /// (1 - u - v) * v0 + u * v1 + v * v2Model
-    bool intersectTriangle(const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2,
-                           float& distanceOrig, float& parameterU, float& parameterV);
-
-    void rayDirection();
-
-    void checkSelectPoint();
+    const vector<Mesh> *m_meshes = nullptr;
+    vector<VertexKdTree> m_vertexTrees;
+    vector<MeshBvh> m_bvhs;
+
+    [[nodiscard]] glm::vec3 rayDirection(float xpos, float ypos) const;
+
+    /// 屏幕坐标投影到远裁剪平面，返回从 orig 出发的单位方向
+    static glm::vec3 unproject(const glm::mat4 &inverseViewProjection, const glm::vec3 &orig,
+                               float xpos, float ypos, int width, int height);
+
+    /// 在射线周围查找最近的可见顶点
+    /// \param maxDistance 最大深度，超过该深度的顶点视为被遮挡
+    void checkSelectPoint(float maxDistance);
 
     void checkFaces();
 };
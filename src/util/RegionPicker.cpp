@@ -0,0 +1,307 @@
+#include "RegionPicker.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+RegionPicker::RegionPicker() = default;
+
+void RegionPicker::regionPick(const vector<Mesh> &meshes, const vector<MeshBvh> &bvhs,
+                              const vector<glm::vec2> &region, Shape shape, const Options &options,
+                              glm::vec3 cameraPos, const glm::mat4 &model, const glm::mat4 &view,
+                              const glm::mat4 &projection, int width, int height) {
+    auto start = std::chrono::steady_clock::now();
+
+    selectFaces.assign(meshes.size(), vector<unsigned int>());
+    selectPoints.assign(meshes.size(), vector<unsigned int>());
+    faceCount = 0;
+    pointCount = 0;
+
+    m_shape = shape;
+    m_options = options;
+    m_meshes = &meshes;
+    m_bvhs = &bvhs;
+    m_mvp = projection * view * model;
+    m_eye = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+    // 屏幕像素坐标转换为标准化设备坐标
+    auto toNdc = [width, height](const glm::vec2 &point) {
+        return glm::vec2(2.0f * point.x / (float)width - 1.0f, 1.0f - 2.0f * point.y / (float)height);
+    };
+    m_polygon.clear();
+    if (shape == RECTANGLE && region.size() >= 2) {
+        auto a = toNdc(region.front());
+        auto b = toNdc(region.back());
+        m_min = glm::min(a, b);
+        m_max = glm::max(a, b);
+        m_polygon = {m_min, glm::vec2(m_max.x, m_min.y), m_max, glm::vec2(m_min.x, m_max.y)};
+    }
+    else if (shape == LASSO && region.size() >= 3) {
+        m_min = glm::vec2(FLT_MAX);
+        m_max = glm::vec2(-FLT_MAX);
+        for (auto &point : region) {
+            m_polygon.push_back(toNdc(point));
+            m_min = glm::min(m_min, m_polygon.back());
+            m_max = glm::max(m_max, m_polygon.back());
+        }
+        buildMask();
+    }
+
+    if (!m_polygon.empty() && m_min.x < m_max.x && m_min.y < m_max.y && bvhs.size() == meshes.size()) {
+        auto workers = parallel::workerCount();
+        for (size_t j = 0; j < meshes.size(); j++) {
+            const auto &mesh = meshes[j];
+            const auto &bvh = bvhs[j];
+            const auto &faces = mesh.getFaces();
+            const auto &vertices = mesh.getVertices();
+
+            // 每个线程遍历若干子树，结果写入子树私有的数组后合并
+            auto roots = bvh.subtrees(workers * 4);
+            vector<vector<unsigned int>> rootFaces(roots.size()), rootPoints(roots.size());
+            vector<std::atomic<bool>> visited(m_options.points ? vertices.size() : 0);
+
+            parallel::forEach(roots.size(), [&](size_t r) {
+                bvh.query(roots[r],
+                          [this](const glm::vec3 &min, const glm::vec3 &max) { return classifyBox(min, max); },
+                          [&](const unsigned int *ids, unsigned int count, bool inside) {
+                              for (unsigned int k = 0; k < count; k++) {
+                                  const auto &face = faces[ids[k]];
+                                  if (m_options.faces && testFace(mesh, face, inside))
+                                      rootFaces[r].push_back(ids[k]);
+                                  if (m_options.points) {
+                                      for (auto index : face.vertex) {
+                                          if (!visited[index].exchange(true) && testPoint(vertices[index]))
+                                              rootPoints[r].push_back(index);
+                                      }
+                                  }
+                              }
+                          });
+            }, 1);
+
+            for (size_t r = 0; r < roots.size(); r++) {
+                selectFaces[j].insert(selectFaces[j].end(), rootFaces[r].begin(), rootFaces[r].end());
+                selectPoints[j].insert(selectPoints[j].end(), rootPoints[r].begin(), rootPoints[r].end());
+            }
+            faceCount += selectFaces[j].size();
+            pointCount += selectPoints[j].size();
+        }
+    }
+
+    pickTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+MeshBvh::Overlap RegionPicker::classifyBox(const glm::vec3 &min, const glm::vec3 &max) const {
+    // 在裁剪空间中对选择视锥的五个平面（四个侧面与近平面）逐一测试包围盒的八个角点
+    int outside[5] = {0, 0, 0, 0, 0};
+    bool allInside = true;
+    for (int i = 0; i < 8; i++) {
+        auto corner = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        auto clip = m_mvp * glm::vec4(corner, 1.0f);
+        bool out[5] = {
+                clip.x < m_min.x * clip.w,
+                clip.x > m_max.x * clip.w,
+                clip.y < m_min.y * clip.w,
+                clip.y > m_max.y * clip.w,
+                clip.z < -clip.w
+        };
+        for (int plane = 0; plane < 5; plane++) {
+            outside[plane] += out[plane];
+            allInside &= !out[plane];
+        }
+    }
+
+    for (auto count : outside)
+        if (count == 8)
+            return MeshBvh::OUTSIDE;
+    // 套索为凹多边形，包围矩形内不代表在区域内
+    return allInside && m_shape == RECTANGLE ? MeshBvh::INSIDE : MeshBvh::PARTIAL;
+}
+
+bool RegionPicker::project(const glm::vec3 &position, glm::vec2 &ndc) const {
+    auto clip = m_mvp * glm::vec4(position, 1.0f);
+    if (clip.w <= 0.f || clip.z < -clip.w)
+        return false;
+    ndc = glm::vec2(clip) / clip.w;
+    return true;
+}
+
+bool RegionPicker::inRegion(const glm::vec2 &point) const {
+    if (point.x < m_min.x || point.x > m_max.x || point.y < m_min.y || point.y > m_max.y)
+        return false;
+    if (m_shape == RECTANGLE)
+        return true;
+
+    auto cell = glm::clamp(glm::ivec2((point - m_min) * m_cellScale), glm::ivec2(0), glm::ivec2(MASK_SIZE - 1));
+    auto state = m_mask[cell.y * MASK_SIZE + cell.x];
+    if (state != CELL_BOUNDARY)
+        return state == CELL_INSIDE;
+    return inPolygon(point);
+}
+
+void RegionPicker::buildMask() {
+    m_mask.assign(MASK_SIZE * MASK_SIZE, CELL_OUTSIDE);
+    if (m_min.x >= m_max.x || m_min.y >= m_max.y)
+        return;
+    m_cellScale = glm::vec2(MASK_SIZE) / (m_max - m_min);
+    auto toCell = [this](const glm::vec2 &point) { return (point - m_min) * m_cellScale; };
+
+    // 标记每条边逐行经过的格子
+    for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++) {
+        auto a = toCell(m_polygon[j]);
+        auto b = toCell(m_polygon[i]);
+        if (a.y > b.y)
+            std::swap(a, b);
+        auto rowBegin = std::clamp((int)std::floor(a.y), 0, MASK_SIZE - 1);
+        auto rowEnd = std::clamp((int)std::floor(b.y), 0, MASK_SIZE - 1);
+        for (auto row = rowBegin; row <= rowEnd; row++) {
+            // 边在当前行 [row, row + 1) 内的横坐标范围
+            auto y0 = std::max(a.y, (float)row);
+            auto y1 = std::min(b.y, (float)row + 1.f);
+            auto x0 = b.y > a.y ? a.x + (b.x - a.x) * (y0 - a.y) / (b.y - a.y) : a.x;
+            auto x1 = b.y > a.y ? a.x + (b.x - a.x) * (y1 - a.y) / (b.y - a.y) : b.x;
+            auto colBegin = std::clamp((int)std::floor(std::min(x0, x1)), 0, MASK_SIZE - 1);
+            auto colEnd = std::clamp((int)std::floor(std::max(x0, x1)), 0, MASK_SIZE - 1);
+            for (auto col = colBegin; col <= colEnd; col++)
+                m_mask[row * MASK_SIZE + col] = CELL_BOUNDARY;
+        }
+    }
+
+    // 其余格子整体在内或在外，按行中心扫描线的交点填充
+    vector<float> crossings;
+    for (int row = 0; row < MASK_SIZE; row++) {
+        auto y = (float)row + 0.5f;
+        crossings.clear();
+        for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++) {
+            auto a = toCell(m_polygon[j]);
+            auto b = toCell(m_polygon[i]);
+            if ((a.y > y) != (b.y > y))
+                crossings.push_back(a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y));
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            auto colBegin = std::max(0, (int)std::ceil(crossings[k] - 0.5f));
+            auto colEnd = std::min(MASK_SIZE - 1, (int)std::floor(crossings[k + 1] - 0.5f));
+            for (auto col = colBegin; col <= colEnd; col++) {
+                auto &cell = m_mask[row * MASK_SIZE + col];
+                if (cell == CELL_OUTSIDE)
+                    cell = CELL_INSIDE;
+            }
+        }
+    }
+}
+
+bool RegionPicker::inPolygon(const glm::vec2 &point) const {
+    // 奇偶规则判断点是否在多边形内
+    bool inside = false;
+    for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++) {
+        const auto &a = m_polygon[i];
+        const auto &b = m_polygon[j];
+        if ((a.y > point.y) != (b.y > point.y) &&
+            point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+            inside = !inside;
+    }
+    return inside;
+}
+
+static inline float cross2(const glm::vec2 &a, const glm::vec2 &b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static inline bool segmentIntersect(const glm::vec2 &a0, const glm::vec2 &a1, const glm::vec2 &b0, const glm::vec2 &b1) {
+    auto d0 = cross2(a1 - a0, b0 - a0);
+    auto d1 = cross2(a1 - a0, b1 - a0);
+    auto d2 = cross2(b1 - b0, a0 - b0);
+    auto d3 = cross2(b1 - b0, a1 - b0);
+    return ((d0 > 0.f) != (d1 > 0.f)) && ((d2 > 0.f) != (d3 > 0.f));
+}
+
+bool RegionPicker::triangleOverlap(const glm::vec2 &v0, const glm::vec2 &v1, const glm::vec2 &v2) const {
+    auto triMin = glm::min(v0, glm::min(v1, v2));
+    auto triMax = glm::max(v0, glm::max(v1, v2));
+    if (triMax.x < m_min.x || triMin.x > m_max.x || triMax.y < m_min.y || triMin.y > m_max.y)
+        return false;
+
+    // 三角形顶点在区域内
+    if (inRegion(v0) || inRegion(v1) || inRegion(v2))
+        return true;
+
+    // 区域顶点在三角形内
+    auto area = cross2(v1 - v0, v2 - v0);
+    for (auto &point : m_polygon) {
+        auto w0 = cross2(v1 - point, v2 - point);
+        auto w1 = cross2(v2 - point, v0 - point);
+        auto w2 = cross2(v0 - point, v1 - point);
+        if (area > 0.f ? (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f) : (w0 <= 0.f && w1 <= 0.f && w2 <= 0.f))
+            return true;
+    }
+
+    // 边相交
+    const glm::vec2 *triangle[3] = {&v0, &v1, &v2};
+    for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++)
+        for (int k = 0; k < 3; k++)
+            if (segmentIntersect(m_polygon[j], m_polygon[i], *triangle[k], *triangle[(k + 1) % 3]))
+                return true;
+    return false;
+}
+
+bool RegionPicker::occluded(const glm::vec3 &position) const {
+    auto dir = position - m_eye;
+    auto distance = glm::length(dir);
+    if (distance <= 0.f)
+        return false;
+    dir /= distance;
+
+    // 略短于目标距离，避免与目标所在的面自相交
+    auto tMax = distance * (1.f - 1e-3f);
+    for (size_t j = 0; j < m_meshes->size(); j++)
+        if ((*m_bvhs)[j].occluded((*m_meshes)[j], m_eye, dir, tMax))
+            return true;
+    return false;
+}
+
+bool RegionPicker::testFace(const Mesh &mesh, const Face &face, bool inside) const {
+    const auto &vertices = mesh.getVertices();
+    glm::vec2 ndc[3];
+    for (int i = 0; i < 3; i++)
+        if (!project(vertices[face.vertex[i]].position, ndc[i]))
+            return false;
+
+    if (!inside) {
+        if (m_options.partial) {
+            if (!triangleOverlap(ndc[0], ndc[1], ndc[2]))
+                return false;
+        }
+        else if (!inRegion(ndc[0]) || !inRegion(ndc[1]) || !inRegion(ndc[2])) {
+            return false;
+        }
+    }
+
+    if (m_options.visibleOnly) {
+        // 逆时针为正面
+        if (cross2(ndc[1] - ndc[0], ndc[2] - ndc[0]) <= 0.f)
+            return false;
+        auto centroid = (vertices[face.vertex[0]].position +
+                         vertices[face.vertex[1]].position +
+                         vertices[face.vertex[2]].position) / 3.f;
+        if (occluded(centroid))
+            return false;
+    }
+    return true;
+}
+
+bool RegionPicker::testPoint(const VertexData &vertex) const {
+    glm::vec2 ndc;
+    if (!project(vertex.position, ndc) || !inRegion(ndc))
+        return false;
+
+    if (m_options.visibleOnly) {
+        if (glm::dot(vertex.normal, m_eye - vertex.position) <= 0.f)
+            return false;
+        if (occluded(vertex.position))
+            return false;
+    }
+    return true;
+}
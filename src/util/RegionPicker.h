@@ -0,0 +1,92 @@
+#ifndef MODEL_VIEWER_REGIONPICKER_H
+#define MODEL_VIEWER_REGIONPICKER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "opengl/Mesh.h"
+#include "MeshBvh.h"
+
+/// 矩形/套索区域选择
+/// 屏幕区域在裁剪空间中构成选择视锥（套索为多边形棱柱），通过层次包围盒并行查询区域内的面与顶点
+class RegionPicker {
+public:
+    enum Shape {
+        NONE,
+        RECTANGLE,
+        LASSO
+    };
+
+    struct Options {
+        bool faces = true;  // 选择面
+        bool points = false;  // 选择顶点
+        bool partial = false;  // 面的一部分位于区域内即选中，否则要求三个顶点都在区域内
+        bool visibleOnly = true;  // 只保留正面朝向且未被遮挡的元素
+    };
+
+    RegionPicker();
+
+    /// 区域选择
+    /// \param meshes 网格
+    /// \param bvhs 网格对应的层次包围盒
+    /// \param region 区域顶点（屏幕像素坐标），矩形为对角两点，套索为依次连接的顶点
+    /// \param shape 区域形状
+    /// \param options 选择选项
+    /// \param cameraPos 摄像机位置
+    /// \param model 模型矩阵
+    /// \param view 视图矩阵
+    /// \param projection 投影矩阵
+    /// \param width 窗口宽度
+    /// \param height 窗口高度
+    void regionPick(const vector<Mesh> &meshes, const vector<MeshBvh> &bvhs,
+                    const vector<glm::vec2> &region, Shape shape, const Options &options,
+                    glm::vec3 cameraPos, const glm::mat4 &model, const glm::mat4 &view,
+                    const glm::mat4 &projection, int width, int height);
+
+    vector<vector<unsigned int>> selectFaces;  // 每个网格中选中的面序号
+    vector<vector<unsigned int>> selectPoints;  // 每个网格中选中的顶点序号
+    size_t faceCount = 0;
+    size_t pointCount = 0;
+    float pickTime = 0.f;  // 最近一次区域选择耗时（毫秒）
+
+private:
+    Shape m_shape = NONE;
+    Options m_options;
+    glm::mat4 m_mvp;
+    glm::vec3 m_eye;  // 模型空间中的摄像机位置
+
+    static constexpr int MASK_SIZE = 256;
+
+    /// 套索掩码格子状态
+    enum Cell : unsigned char {
+        CELL_OUTSIDE,
+        CELL_BOUNDARY,  // 有多边形边经过，需要精确判断
+        CELL_INSIDE
+    };
+
+    glm::vec2 m_min, m_max;  // 区域在标准化设备坐标中的包围矩形
+    vector<glm::vec2> m_polygon;  // 区域在标准化设备坐标中的多边形
+    vector<unsigned char> m_mask;  // 套索包围矩形划分为 MASK_SIZE * MASK_SIZE 的格子，只有边界格子需要逐边判断
+    glm::vec2 m_cellScale;
+
+    const vector<Mesh> *m_meshes = nullptr;
+    const vector<MeshBvh> *m_bvhs = nullptr;
+
+    [[nodiscard]] MeshBvh::Overlap classifyBox(const glm::vec3 &min, const glm::vec3 &max) const;
+
+    /// 投影到标准化设备坐标，位于近平面之后返回 false
+    [[nodiscard]] bool project(const glm::vec3 &position, glm::vec2 &ndc) const;
+
+    void buildMask();
+    [[nodiscard]] bool inRegion(const glm::vec2 &point) const;
+    [[nodiscard]] bool inPolygon(const glm::vec2 &point) const;
+    [[nodiscard]] bool triangleOverlap(const glm::vec2 &v0, const glm::vec2 &v1, const glm::vec2 &v2) const;
+
+    /// 从摄像机到目标点之间是否有遮挡
+    [[nodiscard]] bool occluded(const glm::vec3 &position) const;
+
+    [[nodiscard]] bool testFace(const Mesh &mesh, const Face &face, bool inside) const;
+    [[nodiscard]] bool testPoint(const VertexData &vertex) const;
+};
+
+
+#endif //MODEL_VIEWER_REGIONPICKER_H
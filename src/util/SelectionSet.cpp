@@ -0,0 +1,406 @@
+#include "SelectionSet.h"
+#include "opengl/PolygonPoint.h"
+#include "opengl/PolygonTriangle.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+SelectionSet::SelectionSet() = default;
+
+SelectionSet::SelectionSet(string name, const vector<Mesh> &meshes) : name(std::move(name)) {
+    for (auto &mesh : meshes) {
+        points.emplace_back(mesh.getVertices().size());
+        faces.emplace_back(mesh.getFaces().size());
+    }
+}
+
+SelectionSet SelectionSet::capture(string name, const vector<Mesh> &meshes,
+                                   const PolygonPoint &highlightPoints, const PolygonTriangle &highlightTriangles) {
+    SelectionSet set(std::move(name), meshes);
+    vector<Polygon::Element> elements;
+    for (int j = 0; j < meshes.size(); j++) {
+        for (auto vertex : highlightPoints.getIndices(j))
+            set.points[j].set(vertex);
+        elements.clear();
+        highlightTriangles.getElements(elements, j);
+        for (auto &element : elements)
+            set.faces[j].set(element.index);
+    }
+    return set;
+}
+
+void SelectionSet::applyTo(PolygonPoint &highlightPoints, PolygonTriangle &highlightTriangles) const {
+    vector<Polygon::Element> elements;
+    for (int j = 0; j < faces.size(); j++) {
+        elements.clear();
+        highlightTriangles.getElements(elements, j);
+        Bitset current(faces[j].size());
+        for (auto &element : elements) {
+            current.set(element.index);
+            if (!faces[j].test(element.index))
+                highlightTriangles.removeFace(j, element.index);
+        }
+        faces[j].forEach([&](size_t face) {
+            if (!current.test(face))
+                highlightTriangles.addFace(j, (unsigned int)face);
+        });
+
+        // 删除一个顶点会移除整个焊接组，先复制当前的索引
+        auto indices = highlightPoints.getIndices(j);
+        for (auto vertex : indices)
+            if (!points[j].test(vertex))
+                highlightPoints.removeIndices(j, vertex);
+        points[j].forEach([&](size_t vertex) {
+            highlightPoints.addIndices(j, (unsigned int)vertex);
+        });
+    }
+}
+
+void SelectionSet::combine(const SelectionSet &other, Operation operation) {
+    for (size_t j = 0; j < faces.size(); j++) {
+        switch (operation) {
+            case REPLACE:
+                points[j] = other.points[j];
+                faces[j] = other.faces[j];
+                break;
+            case UNION:
+                points[j].unite(other.points[j]);
+                faces[j].unite(other.faces[j]);
+                break;
+            case INTERSECT:
+                points[j].intersect(other.points[j]);
+                faces[j].intersect(other.faces[j]);
+                break;
+            case SUBTRACT:
+                points[j].subtract(other.points[j]);
+                faces[j].subtract(other.faces[j]);
+                break;
+        }
+    }
+}
+
+void SelectionSet::invert() {
+    // 焊接组内的顶点同时存在或同时不存在，取反后依然成立
+    for (size_t j = 0; j < faces.size(); j++) {
+        points[j].invert();
+        faces[j].invert();
+    }
+}
+
+size_t SelectionSet::pointCount() const {
+    size_t count = 0;
+    for (auto &bits : points)
+        count += bits.count();
+    return count;
+}
+
+size_t SelectionSet::faceCount() const {
+    size_t count = 0;
+    for (auto &bits : faces)
+        count += bits.count();
+    return count;
+}
+
+static constexpr uint32_t FILE_MAGIC = 0x5353564d;  // "MVSS"
+static constexpr uint32_t FILE_VERSION = 1;
+
+enum Encoding : uint8_t {
+    ENCODING_RAW,
+    ENCODING_RUNS,
+};
+
+static uint64_t mix(uint64_t hash, uint64_t value) {
+    value *= 0x9E3779B97F4A7C15ull;
+    value ^= value >> 32;
+    hash ^= value;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    return hash ^ (hash >> 29);
+}
+
+static void writeValue(vector<uint8_t> &out, const void *data, size_t size) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template<typename T>
+static void writeValue(vector<uint8_t> &out, T value) {
+    writeValue(out, &value, sizeof(T));
+}
+
+static void writeVarint(vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+/// 交替写入 0 与 1 的游程长度，以 0 的游程开始，超过 limit 字节时放弃
+static bool encodeRuns(const Bitset &bits, vector<uint8_t> &out, size_t limit) {
+    const auto &words = bits.words();
+    size_t position = 0;
+    bool bit = false;
+    while (position < bits.size()) {
+        auto end = position;
+        while (end < bits.size()) {
+            auto word = words[end >> 6];
+            if (bit)
+                word = ~word;
+            word >>= end & 63;
+            if (word) {
+                end += std::countr_zero(word);
+                break;
+            }
+            end += 64 - (end & 63);
+        }
+        end = std::min(end, bits.size());
+        writeVarint(out, end - position);
+        if (out.size() > limit)
+            return false;
+        position = end;
+        bit = !bit;
+    }
+    return true;
+}
+
+static void writeBitset(vector<uint8_t> &out, const Bitset &bits, vector<uint8_t> &buffer) {
+    auto rawSize = bits.words().size() * sizeof(uint64_t);
+    buffer.clear();
+    if (encodeRuns(bits, buffer, rawSize)) {
+        writeValue<uint8_t>(out, ENCODING_RUNS);
+        writeValue<uint32_t>(out, (uint32_t)buffer.size());
+        writeValue(out, buffer.data(), buffer.size());
+    }
+    else {
+        writeValue<uint8_t>(out, ENCODING_RAW);
+        writeValue<uint32_t>(out, (uint32_t)rawSize);
+        writeValue(out, bits.words().data(), rawSize);
+    }
+}
+
+namespace {
+/// 带越界检查的读取，越界时抛出异常
+class Reader {
+public:
+    Reader(const uint8_t *data, size_t size) : m_data(data), m_end(data + size) { }
+
+    const uint8_t *take(size_t size) {
+        if (size > (size_t)(m_end - m_data))
+            throw std::runtime_error("Selection file is truncated");
+        auto result = m_data;
+        m_data += size;
+        return result;
+    }
+
+    template<typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            auto byte = read<uint8_t>();
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Selection file is corrupted");
+    }
+
+    [[nodiscard]] bool done() const { return m_data == m_end; }
+    [[nodiscard]] size_t remaining() const { return m_end - m_data; }
+
+private:
+    const uint8_t *m_data;
+    const uint8_t *m_end;
+};
+}
+
+static void readBitset(Reader &reader, Bitset &bits) {
+    auto encoding = reader.read<uint8_t>();
+    auto size = reader.read<uint32_t>();
+    auto payload = reader.take(size);
+    if (encoding == ENCODING_RAW) {
+        if (size != bits.words().size() * sizeof(uint64_t))
+            throw std::runtime_error("Selection file is corrupted");
+        std::memcpy(bits.words().data(), payload, size);
+        if (bits.size() & 63)
+            bits.words().back() &= ~uint64_t(0) >> (64 - (bits.size() & 63));
+        return;
+    }
+    if (encoding != ENCODING_RUNS)
+        throw std::runtime_error("Selection file is corrupted");
+
+    Reader runs(payload, size);
+    size_t position = 0;
+    bool bit = false;
+    while (!runs.done()) {
+        auto length = runs.readVarint();
+        if (length > bits.size() - position)
+            throw std::runtime_error("Selection file is corrupted");
+        if (bit)
+            bits.setRange(position, position + length);
+        position += length;
+        bit = !bit;
+    }
+}
+
+SelectionStore::SelectionStore() = default;
+
+SelectionStore::SelectionStore(const vector<Mesh> &meshes) : m_hash(contentHash(meshes)) {
+    for (auto &mesh : meshes) {
+        m_vertexCounts.push_back((unsigned int)mesh.getVertices().size());
+        m_faceCounts.push_back((unsigned int)mesh.getFaces().size());
+    }
+}
+
+uint64_t SelectionStore::contentHash(const vector<Mesh> &meshes) {
+    uint64_t hash = mix(0, meshes.size());
+    for (auto &mesh : meshes) {
+        const auto &vertices = mesh.getVertices();
+        const auto &faces = mesh.getFaces();
+        hash = mix(hash, vertices.size());
+        hash = mix(hash, faces.size());
+        for (auto &vertex : vertices) {
+            uint32_t bits[3];
+            std::memcpy(bits, &vertex.position, sizeof(bits));
+            hash = mix(hash, (uint64_t(bits[0]) << 32) | bits[1]);
+            hash = mix(hash, bits[2]);
+        }
+        for (auto &face : faces) {
+            hash = mix(hash, (uint64_t(face.vertex[0]) << 32) | face.vertex[1]);
+            hash = mix(hash, face.vertex[2]);
+        }
+    }
+    return hash;
+}
+
+string SelectionStore::defaultPath() const {
+    std::stringstream ss;
+    ss << "selections/" << std::hex << std::setw(16) << std::setfill('0') << m_hash << ".sel";
+    return ss.str();
+}
+
+bool SelectionStore::save(const string &path) {
+    auto start = std::chrono::steady_clock::now();
+
+    // 文件头：标识、版本、内容哈希与每个网格的顶点数、面数
+    vector<uint8_t> out, buffer;
+    writeValue(out, FILE_MAGIC);
+    writeValue(out, FILE_VERSION);
+    writeValue(out, m_hash);
+    writeValue<uint32_t>(out, (uint32_t)m_vertexCounts.size());
+    for (size_t j = 0; j < m_vertexCounts.size(); j++) {
+        writeValue<uint32_t>(out, m_vertexCounts[j]);
+        writeValue<uint32_t>(out, m_faceCounts[j]);
+    }
+    writeValue<uint32_t>(out, (uint32_t)m_sets.size());
+    for (auto &set : m_sets) {
+        writeValue<uint32_t>(out, (uint32_t)set.name.size());
+        writeValue(out, set.name.data(), set.name.size());
+        for (size_t j = 0; j < set.faces.size(); j++) {
+            writeBitset(out, set.points[j], buffer);
+            writeBitset(out, set.faces[j], buffer);
+        }
+    }
+
+    auto directory = std::filesystem::path(path).parent_path();
+    std::error_code error;
+    if (!directory.empty())
+        std::filesystem::create_directories(directory, error);
+    std::ofstream fout(path, std::ios_base::binary);
+    if (!fout.is_open()) {
+        lastError = "Selection File " + path + " Open Failed!";
+        return false;
+    }
+    fout.write(reinterpret_cast<const char *>(out.data()), (std::streamsize)out.size());
+    fout.close();
+    if (!fout) {
+        lastError = "Selection File " + path + " Write Failed!";
+        return false;
+    }
+
+    fileSize = out.size();
+    saveTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool SelectionStore::load(const string &path) {
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream fin(path, std::ios_base::binary);
+    if (!fin.is_open()) {
+        lastError = "Selection File " + path + " Open Failed!";
+        return false;
+    }
+    vector<uint8_t> data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    fin.close();
+
+    try {
+        Reader reader(data.data(), data.size());
+        if (reader.read<uint32_t>() != FILE_MAGIC || reader.read<uint32_t>() != FILE_VERSION)
+            throw std::runtime_error("Selection File " + path + " has an unknown format");
+        if (reader.read<uint64_t>() != m_hash)
+            throw std::runtime_error("Selection File " + path + " belongs to another model");
+        if (reader.read<uint32_t>() != m_vertexCounts.size())
+            throw std::runtime_error("Selection File " + path + " belongs to another model");
+        for (size_t j = 0; j < m_vertexCounts.size(); j++) {
+            if (reader.read<uint32_t>() != m_vertexCounts[j] || reader.read<uint32_t>() != m_faceCounts[j])
+                throw std::runtime_error("Selection File " + path + " belongs to another model");
+        }
+
+        // 每个集合至少有名称长度与每个网格两个位集的编码和长度，数量不能超过剩余字节所能容纳的
+        auto count = reader.read<uint32_t>();
+        auto minSetSize = sizeof(uint32_t) + m_vertexCounts.size() * 2 * (sizeof(uint8_t) + sizeof(uint32_t));
+        if (count > reader.remaining() / minSetSize)
+            throw std::runtime_error("Selection File " + path + " is corrupted");
+        vector<SelectionSet> sets;
+        sets.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            auto &set = sets.emplace_back();
+            auto length = reader.read<uint32_t>();
+            auto name = reader.take(length);
+            set.name.assign(reinterpret_cast<const char *>(name), length);
+            for (size_t j = 0; j < m_vertexCounts.size(); j++) {
+                set.points.emplace_back(m_vertexCounts[j]);
+                set.faces.emplace_back(m_faceCounts[j]);
+                readBitset(reader, set.points.back());
+                readBitset(reader, set.faces.back());
+            }
+        }
+        m_sets = std::move(sets);
+    }
+    catch (std::runtime_error &ex) {
+        lastError = ex.what();
+        return false;
+    }
+    catch (std::bad_alloc &) {
+        lastError = "Selection File " + path + " is too large to load";
+        return false;
+    }
+
+    fileSize = data.size();
+    loadTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void SelectionStore::put(SelectionSet set) {
+    for (auto &existing : m_sets) {
+        if (existing.name == set.name) {
+            existing = std::move(set);
+            return;
+        }
+    }
+    m_sets.push_back(std::move(set));
+}
+
+void SelectionStore::remove(size_t index) {
+    m_sets.erase(m_sets.begin() + (long long)index);
+}
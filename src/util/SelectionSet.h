@@ -0,0 +1,83 @@
+#ifndef MODEL_VIEWER_SELECTIONSET_H
+#define MODEL_VIEWER_SELECTIONSET_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "opengl/Mesh.h"
+#include "Bitset.h"
+
+class PolygonPoint;
+class PolygonTriangle;
+
+/// 命名的选择集合：每个网格一个顶点位集和一个面位集
+/// 顶点位集包含焊接组内的所有顶点，与 PolygonPoint 的索引一致
+class SelectionSet {
+public:
+    enum Operation {
+        REPLACE,
+        UNION,
+        INTERSECT,
+        SUBTRACT,
+    };
+
+    SelectionSet();
+    SelectionSet(string name, const vector<Mesh> &meshes);
+
+    /// 从高亮集合复制
+    static SelectionSet capture(string name, const vector<Mesh> &meshes,
+                                const PolygonPoint &highlightPoints, const PolygonTriangle &highlightTriangles);
+
+    /// 高亮集合替换为本集合，只增删有变化的元素
+    void applyTo(PolygonPoint &highlightPoints, PolygonTriangle &highlightTriangles) const;
+
+    void combine(const SelectionSet &other, Operation operation);
+    void invert();
+
+    [[nodiscard]] size_t pointCount() const;
+    [[nodiscard]] size_t faceCount() const;
+
+    string name;
+    vector<Bitset> points;  // 网格 -> 顶点位集
+    vector<Bitset> faces;  // 网格 -> 面位集
+};
+
+/// 一个模型的所有选择集合，以模型内容的哈希值区分，保存为压缩的二进制文件
+/// 位集逐个选择原始字或游程编码中较小的一种
+class SelectionStore {
+public:
+    SelectionStore();
+    explicit SelectionStore(const vector<Mesh> &meshes);
+
+    /// 顶点坐标与面索引的 64 位哈希
+    static uint64_t contentHash(const vector<Mesh> &meshes);
+
+    /// 默认的保存路径，由内容哈希决定，模型移动或改名后仍能找到
+    [[nodiscard]] string defaultPath() const;
+
+    /// \return 是否成功，失败原因保存在 lastError
+    bool save(const string &path);
+    /// 文件的内容哈希或网格结构与当前模型不一致时失败，当前集合保持不变
+    bool load(const string &path);
+
+    /// 同名集合被替换
+    void put(SelectionSet set);
+    void remove(size_t index);
+
+    [[nodiscard]] const vector<SelectionSet> &sets() const { return m_sets; }
+    [[nodiscard]] uint64_t hash() const { return m_hash; }
+
+    string lastError;
+    float saveTime = 0.f;  // 最近一次保存/读取的耗时（毫秒）与文件大小
+    float loadTime = 0.f;
+    size_t fileSize = 0;
+
+private:
+    uint64_t m_hash = 0;
+    vector<unsigned int> m_vertexCounts;
+    vector<unsigned int> m_faceCounts;
+    vector<SelectionSet> m_sets;
+};
+
+
+#endif //MODEL_VIEWER_SELECTIONSET_H
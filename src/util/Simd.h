@@ -0,0 +1,46 @@
+#ifndef MODEL_VIEWER_SIMD_H
+#define MODEL_VIEWER_SIMD_H
+
+/// AVX2 代码路径：USE_AVX2 选项定义 MODEL_VIEWER_AVX2 后才编译
+/// 整个程序仍按基础指令集编译，只有标记 SIMD_AVX2 的函数使用 AVX2 指令，调用前以 simd::avx2() 检查 CPU
+/// SIMD_AVX2 函数内只调用内联函数与其他 SIMD_AVX2 函数，不支持的 CPU 上不会执行到 AVX2 指令
+#if defined(MODEL_VIEWER_AVX2) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define SIMD_HAS_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_AVX2
+#else
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace simd {
+    /// CPU 与操作系统是否支持 AVX2，只检测一次
+    inline bool avx2() {
+#ifdef SIMD_HAS_AVX2
+        static const bool supported = []() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            // 操作系统需要保存 YMM 寄存器
+            __cpuid(info, 1);
+            if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }();
+        return supported;
+#else
+        return false;
+#endif
+    }
+}
+
+#endif //MODEL_VIEWER_SIMD_H
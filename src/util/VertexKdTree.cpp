@@ -0,0 +1,119 @@
+#include "VertexKdTree.h"
+
+#include <algorithm>
+#include <cfloat>
+
+VertexKdTree::VertexKdTree() = default;
+
+VertexKdTree::VertexKdTree(const vector<VertexData> &vertices) {
+    build(vertices);
+}
+
+void VertexKdTree::build(const vector<VertexData> &vertices) {
+    m_nodes.clear();
+    m_points.resize(vertices.size());
+    for (unsigned int i = 0; i < vertices.size(); i++)
+        m_points[i] = {vertices[i].position, i};
+    if (m_points.empty())
+        return;
+
+    m_nodes.reserve(2 * (m_points.size() / LEAF_SIZE + 1));
+    buildNode(0, (unsigned int)m_points.size());
+}
+
+unsigned int VertexKdTree::buildNode(unsigned int begin, unsigned int end) {
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    for (auto i = begin; i < end; i++) {
+        minPos = glm::min(minPos, m_points[i].position);
+        maxPos = glm::max(maxPos, m_points[i].position);
+    }
+
+    auto nodeIndex = (unsigned int)m_nodes.size();
+    m_nodes.push_back({(minPos + maxPos) * 0.5f, glm::length(maxPos - minPos) * 0.5f, begin, end, 0});
+
+    if (end - begin <= LEAF_SIZE)
+        return nodeIndex;
+
+    // 沿包围盒最长轴取中位数划分
+    auto extent = maxPos - minPos;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(m_points.begin() + begin, m_points.begin() + mid, m_points.begin() + end,
+                     [axis](const Point &a, const Point &b) { return a.position[axis] < b.position[axis]; });
+
+    buildNode(begin, mid);
+    auto right = buildNode(mid, end);
+    m_nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+bool VertexKdTree::nearestInCone(const glm::vec3 &orig, const glm::vec3 &dir, float tanAngle, float maxDistance,
+                                 ConeHit &hit) const {
+    if (m_nodes.empty())
+        return false;
+
+    // 已有更优结果时以其角度收紧圆锥
+    bool found = false;
+    float bestTan = hit.index != INVALID_INDEX ? std::min(hit.tan, tanAngle) : tanAngle;
+    float cosAngle = 1.f / std::sqrt(1.f + bestTan * bestTan);
+    float sinAngle = bestTan * cosAngle;
+
+    // 包围球与圆锥相交测试，返回球心到轴线的距离，不相交返回负数
+    auto testNode = [&](const Node &node) {
+        auto v = node.center - orig;
+        auto s = glm::dot(v, dir);
+        if (s + node.radius < 0.f || s - node.radius > maxDistance)
+            return -1.f;
+        auto p = std::sqrt(std::max(glm::dot(v, v) - s * s, 0.f));
+        if (p * cosAngle - s * sinAngle > node.radius)
+            return -1.f;
+        return p;
+    };
+
+    unsigned int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        auto nodeIndex = stack[--top];
+        const auto &node = m_nodes[nodeIndex];
+        if (testNode(node) < 0.f)  // 入栈后圆锥可能已被收紧
+            continue;
+
+        if (node.right == 0) {  // 叶节点
+            for (auto i = node.begin; i < node.end; i++) {
+                auto v = m_points[i].position - orig;
+                auto s = glm::dot(v, dir);
+                if (s <= 0.f || s > maxDistance)
+                    continue;
+                auto t = std::sqrt(std::max(glm::dot(v, v) - s * s, 0.f)) / s;
+                if (t > bestTan || (t == bestTan && hit.index != INVALID_INDEX && s >= hit.distance))
+                    continue;
+
+                bestTan = t;
+                hit = {m_points[i].id, t, s};
+                found = true;
+            }
+            cosAngle = 1.f / std::sqrt(1.f + bestTan * bestTan);
+            sinAngle = bestTan * cosAngle;
+            continue;
+        }
+
+        auto left = nodeIndex + 1;
+        auto right = node.right;
+        auto pLeft = testNode(m_nodes[left]);
+        auto pRight = testNode(m_nodes[right]);
+
+        // 更接近轴线的子节点后入栈、先访问
+        if (pLeft >= 0.f && pRight >= 0.f) {
+            stack[top++] = pLeft < pRight ? right : left;
+            stack[top++] = pLeft < pRight ? left : right;
+        }
+        else if (pLeft >= 0.f)
+            stack[top++] = left;
+        else if (pRight >= 0.f)
+            stack[top++] = right;
+    }
+
+    return found;
+}
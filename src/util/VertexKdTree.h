@@ -0,0 +1,59 @@
+#ifndef MODEL_VIEWER_VERTEXKDTREE_H
+#define MODEL_VIEWER_VERTEXKDTREE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "opengl/Mesh.h"
+
+/// 顶点 k-d 树，用于屏幕空间最近顶点吸附
+/// 树建立在网格的模型空间坐标上，节点与顶点均以扁平数组存储
+class VertexKdTree {
+public:
+    static constexpr unsigned int LEAF_SIZE = 16;
+    static constexpr unsigned int INVALID_INDEX = 0xffffffff;
+
+    struct ConeHit {
+        unsigned int index = INVALID_INDEX;  // 顶点在网格中的索引
+        float tan = 0.f;  // 顶点偏离射线的角度正切，与屏幕距离成正比
+        float distance = 0.f;  // 顶点在射线方向上的深度
+    };
+
+    VertexKdTree();
+    explicit VertexKdTree(const vector<VertexData> &vertices);
+
+    void build(const vector<VertexData> &vertices);
+
+    /// 锥形查询：在以射线为轴的圆锥内查找角度最小的顶点
+    /// \param orig 射线起点（模型空间）
+    /// \param dir 射线方向（模型空间，单位向量）
+    /// \param tanAngle 圆锥半角的正切，由屏幕像素半径换算
+    /// \param maxDistance 最大深度，用于剔除被遮挡的顶点
+    /// \param hit 查询结果，仅在找到更优顶点时更新
+    /// \return 是否找到顶点
+    bool nearestInCone(const glm::vec3 &orig, const glm::vec3 &dir, float tanAngle, float maxDistance,
+                       ConeHit &hit) const;
+
+    [[nodiscard]] size_t size() const { return m_points.size(); }
+    [[nodiscard]] bool empty() const { return m_points.empty(); }
+
+private:
+    struct Point {
+        glm::vec3 position;
+        unsigned int id;  // 顶点在网格中的原始索引
+    };
+
+    struct Node {
+        glm::vec3 center;  // 包围球球心
+        float radius;  // 包围球半径
+        unsigned int begin, end;  // 节点在 m_points 中的范围
+        unsigned int right;  // 右子节点，左子节点紧随当前节点；叶节点为 0
+    };
+
+    unsigned int buildNode(unsigned int begin, unsigned int end);
+
+    vector<Node> m_nodes;
+    vector<Point> m_points;  // 按树序重排的顶点
+};
+
+
+#endif //MODEL_VIEWER_VERTEXKDTREE_H
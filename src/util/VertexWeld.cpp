@@ -0,0 +1,45 @@
+#include "VertexWeld.h"
+
+#include <algorithm>
+#include <tuple>
+
+VertexWeld::VertexWeld() = default;
+
+VertexWeld::VertexWeld(const vector<Mesh> &meshes) {
+    build(meshes);
+}
+
+void VertexWeld::build(const vector<Mesh> &meshes) {
+    m_meshOffsets.clear();
+    size_t total = 0;
+    for (auto &mesh : meshes) {
+        m_meshOffsets.push_back(total);
+        total += mesh.getVertices().size();
+    }
+
+    m_members.clear();
+    m_members.reserve(total);
+    for (int j = 0; j < meshes.size(); j++)
+        for (unsigned int i = 0; i < meshes[j].getVertices().size(); i++)
+            m_members.push_back({j, i});
+
+    // 按坐标排序，坐标相同的顶点相邻；稳定排序保证组内按网格与顶点序号排列
+    auto position = [&meshes](const Member &member) -> const glm::vec3 & {
+        return meshes[member.meshIndex].getVertices()[member.vertex].position;
+    };
+    std::stable_sort(m_members.begin(), m_members.end(), [&position](const Member &a, const Member &b) {
+        const auto &pa = position(a);
+        const auto &pb = position(b);
+        return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+    });
+
+    m_groups.resize(total);
+    m_memberOffsets.clear();
+    m_memberOffsets.reserve(total + 1);
+    for (size_t i = 0; i < m_members.size(); i++) {
+        if (i == 0 || position(m_members[i]) != position(m_members[i - 1]))
+            m_memberOffsets.push_back((unsigned int)i);
+        m_groups[m_meshOffsets[m_members[i].meshIndex] + m_members[i].vertex] = (unsigned int)m_memberOffsets.size() - 1;
+    }
+    m_memberOffsets.push_back((unsigned int)m_members.size());
+}
@@ -0,0 +1,48 @@
+#ifndef MODEL_VIEWER_VERTEXWELD_H
+#define MODEL_VIEWER_VERTEXWELD_H
+
+#include <vector>
+#include "opengl/Mesh.h"
+
+/// 顶点焊接表：将模型所有网格中坐标完全相同的顶点归为一组
+/// 加载模型时建立一次，之后顶点到组、组到成员的查询均为 O(1)
+class VertexWeld {
+public:
+    struct Member {
+        int meshIndex;
+        unsigned int vertex;
+    };
+
+    VertexWeld();
+    explicit VertexWeld(const vector<Mesh> &meshes);
+
+    void build(const vector<Mesh> &meshes);
+
+    /// 顶点所在组的序号
+    [[nodiscard]] unsigned int group(int meshIndex, unsigned int vertex) const {
+        return m_groups[m_meshOffsets[meshIndex] + vertex];
+    }
+
+    /// 顶点在所有网格中的全局序号
+    [[nodiscard]] size_t globalIndex(int meshIndex, unsigned int vertex) const {
+        return m_meshOffsets[meshIndex] + vertex;
+    }
+
+    /// 组内成员为 members(group) 起的 memberCount(group) 个元素，按网格与顶点序号排列
+    [[nodiscard]] const Member *members(unsigned int group) const { return &m_members[m_memberOffsets[group]]; }
+    [[nodiscard]] unsigned int memberCount(unsigned int group) const {
+        return m_memberOffsets[group + 1] - m_memberOffsets[group];
+    }
+
+    [[nodiscard]] size_t groupCount() const { return m_memberOffsets.empty() ? 0 : m_memberOffsets.size() - 1; }
+    [[nodiscard]] size_t vertexCount() const { return m_groups.size(); }
+
+private:
+    vector<size_t> m_meshOffsets;  // 每个网格第一个顶点的全局序号
+    vector<unsigned int> m_groups;  // 全局顶点序号 -> 组序号
+    vector<unsigned int> m_memberOffsets;  // 组 -> 成员起始位置，长度为组数 + 1
+    vector<Member> m_members;
+};
+
+
+#endif //MODEL_VIEWER_VERTEXWELD_H
@@ -5,6 +5,8 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "eventbus/EventBus.hpp"
+#include "eventbus/perk/PerkEventBus.hpp"
+#include "eventbus/perk/WaitPerk.hpp"
 #include "enum.h"
 
 using EventBus = std::shared_ptr<dexode::EventBus>;
@@ -72,6 +74,11 @@ public:
         return m_EventBus;
     }
 
+    /// 上次询问之后是否投递过事件，最多等待 timeout
+    bool waitForEvents(std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        return m_WaitPerk->waitFor(timeout);
+    }
+
     template <class Event, typename _ = void>
     void addListener(std::function<void(const Event&)>&& callback) {
         m_Listener->listen(callback);
@@ -353,9 +360,13 @@ public:
 private:
     EventBus m_EventBus;
     Listener m_Listener;
+    std::shared_ptr<dexode::eventbus::perk::WaitPerk> m_WaitPerk;
 
     EventHandler() {
-        m_EventBus = std::make_shared<dexode::EventBus>();
+        auto bus = std::make_shared<dexode::eventbus::perk::PerkEventBus>();
+        m_WaitPerk = std::make_shared<dexode::eventbus::perk::WaitPerk>();
+        bus->addPerk(m_WaitPerk).registerPostPostpone(&dexode::eventbus::perk::WaitPerk::onPostponeEvent);
+        m_EventBus = bus;
         m_Listener = std::make_shared<dexode::EventBus::Listener>(m_EventBus);
     }
 };
@@ -0,0 +1,93 @@
+#include "GBuffer.h"
+
+namespace {
+    const GLenum internalFormats[GBuffer::TARGET_COUNT] = {GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_RGBA8};
+    const size_t texelBytes[GBuffer::TARGET_COUNT] = {8, 4, 4, 4};
+    constexpr size_t DEPTH_BYTES = 4;
+
+    void createTexture(GLuint &texture) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        // 光照阶段按像素读取，不需要过滤
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+}
+
+GBuffer::~GBuffer() {
+    release();
+}
+
+bool GBuffer::allocate(int width, int height) {
+    if (width <= 0 || height <= 0 || (valid() && width == m_width && height == m_height))
+        return false;
+
+    if (!valid()) {
+        for (auto &texture : m_textures)
+            createTexture(texture);
+        createTexture(m_depth);
+        glGenFramebuffers(1, &m_framebuffer);
+    }
+
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, (GLint)internalFormats[i], width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_width = width;
+    m_height = height;
+
+    GLint previous;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    GLenum drawBuffers[TARGET_COUNT];
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+    glDrawBuffers(TARGET_COUNT, drawBuffers);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previous);
+    return true;
+}
+
+void GBuffer::release() {
+    if (!valid())
+        return;
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(TARGET_COUNT, m_textures);
+    glDeleteTextures(1, &m_depth);
+    m_framebuffer = m_depth = 0;
+    for (auto &texture : m_textures)
+        texture = 0;
+    m_width = m_height = 0;
+}
+
+void GBuffer::clear() const {
+    const GLfloat zero[4] = {0.f, 0.f, 0.f, 0.f};
+    const GLfloat one = 1.f;
+    for (int i = 0; i < TARGET_COUNT; i++)
+        glClearBufferfv(GL_COLOR, i, zero);
+    glClearBufferfv(GL_DEPTH, 0, &one);
+}
+
+void GBuffer::bindTextures(int firstUnit) const {
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0 + firstUnit + TARGET_COUNT);
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+size_t GBuffer::bytes() const {
+    size_t texel = DEPTH_BYTES;
+    for (auto bytes : texelBytes)
+        texel += bytes;
+    return texel * (size_t)m_width * (size_t)m_height;
+}
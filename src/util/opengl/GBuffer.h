@@ -0,0 +1,54 @@
+#ifndef MODEL_VIEWER_GBUFFER_H
+#define MODEL_VIEWER_GBUFFER_H
+
+#include <cstddef>
+#include "glad/glad.h"
+
+/// 延迟渲染的几何缓冲及其帧缓冲，析构时释放
+/// 法线与高光指数为 RGBA16F，漫反射、镜面光与环境光颜色为 RGBA8，深度为 32 位浮点
+/// 不使用多重采样，尺寸变化时在原纹理上重新指定存储
+class GBuffer {
+public:
+    /// 颜色附件的顺序，与 gbuffer_fragment.glsl 的输出位置一致
+    enum Target {
+        NORMAL,
+        DIFFUSE,
+        SPECULAR,
+        AMBIENT,
+        TARGET_COUNT,
+    };
+
+    GBuffer() = default;
+    ~GBuffer();
+
+    GBuffer(const GBuffer &) = delete;
+    GBuffer &operator=(const GBuffer &) = delete;
+
+    /// 首次调用时创建纹理与帧缓冲，尺寸变化时重新分配
+    /// \return 是否重新分配
+    bool allocate(int width, int height);
+    void release();
+
+    /// 颜色清除为 0，深度清除为 1，需先绑定 framebuffer()
+    void clear() const;
+    /// 颜色附件依次绑定到 firstUnit 起的纹理单元，深度绑定到其后一个单元
+    void bindTextures(int firstUnit) const;
+
+    [[nodiscard]] bool valid() const { return m_framebuffer != 0; }
+    [[nodiscard]] GLuint framebuffer() const { return m_framebuffer; }
+    [[nodiscard]] GLuint texture(Target target) const { return m_textures[target]; }
+    [[nodiscard]] GLuint depthTexture() const { return m_depth; }
+    [[nodiscard]] int width() const { return m_width; }
+    [[nodiscard]] int height() const { return m_height; }
+    /// 占用的显存（字节）
+    [[nodiscard]] size_t bytes() const;
+
+private:
+    GLuint m_framebuffer = 0;
+    GLuint m_textures[TARGET_COUNT] = {};
+    GLuint m_depth = 0;
+    int m_width = 0, m_height = 0;
+};
+
+
+#endif //MODEL_VIEWER_GBUFFER_H
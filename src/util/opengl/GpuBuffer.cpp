@@ -0,0 +1,77 @@
+#include "GpuBuffer.h"
+
+size_t GpuBuffer::updates = 0;
+size_t GpuBuffer::lastUpdates = 0;
+
+GpuBuffer::~GpuBuffer() {
+    if (m_id)
+        glDeleteBuffers(1, &m_id);
+}
+
+void GpuBuffer::allocate(size_t size) {
+    if (!m_id)
+        glGenBuffers(1, &m_id);
+    glBindBuffer(m_target, m_id);
+    glBufferData(m_target, (GLsizeiptr)size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(m_target, 0);
+    m_size = size;
+}
+
+void GpuBuffer::update(size_t offset, const void *data, size_t size) {
+    if (!m_id || size == 0 || offset + size > m_size)
+        return;
+    glBindBuffer(m_target, m_id);
+    glBufferSubData(m_target, (GLintptr)offset, (GLsizeiptr)size, data);
+    glBindBuffer(m_target, 0);
+    updates++;
+}
+
+void GpuBuffer::clear() {
+    if (!m_id)
+        return;
+    glBindBuffer(m_target, m_id);
+    glClearBufferData(m_target, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(m_target, 0);
+}
+
+void GpuBuffer::read(size_t offset, void *data, size_t size) const {
+    if (!m_id || size == 0 || offset + size > m_size)
+        return;
+    glBindBuffer(m_target, m_id);
+    glGetBufferSubData(m_target, (GLintptr)offset, (GLsizeiptr)size, data);
+    glBindBuffer(m_target, 0);
+}
+
+void GpuBuffer::bindBase(GLuint binding) const {
+    glBindBufferBase(m_target, binding, m_id);
+}
+
+void GpuBuffer::bindRange(GLuint binding, size_t offset, size_t size) const {
+    glBindBufferRange(m_target, binding, m_id, (GLintptr)offset, (GLsizeiptr)size);
+}
+
+size_t GpuBuffer::uniformAlignment() {
+    static GLint alignment = 0;
+    if (alignment == 0)
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return alignment > 0 ? (size_t)alignment : 256;
+}
+
+void GpuBuffer::resetStats() {
+    lastUpdates = updates;
+    updates = 0;
+}
+
+long long GpuBuffer::availableMemory() {
+    if (GLAD_GL_NVX_gpu_memory_info) {
+        GLint available = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        return available;
+    }
+    if (GLAD_GL_ATI_meminfo) {
+        GLint info[4] = {};  // 第一个值为剩余的总量
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, info);
+        return info[0];
+    }
+    return -1;
+}
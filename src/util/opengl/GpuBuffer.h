@@ -0,0 +1,65 @@
+#ifndef MODEL_VIEWER_GPUBUFFER_H
+#define MODEL_VIEWER_GPUBUFFER_H
+
+#include <cstddef>
+#include "glad/glad.h"
+
+/// 着色器中 UBO/SSBO 的绑定点，与 glsl 中的 layout(binding = N) 一致
+enum BufferBinding {
+    FRAME_BINDING = 0,  // 每帧数据（相机矩阵、观察位置、远平面）
+    LIGHT_BINDING = 1,  // 灯光数组
+    MATERIAL_BINDING = 2,  // 当前网格的材质
+    SHADOW_BINDING = 3,  // 阴影图集的图块
+    CLUSTER_BINDING = 4,  // 分块光照的网格参数与每个分块的灯光区间
+    CLUSTER_LIGHT_BINDING = 5,  // 分块光照的灯光索引
+    OVERDRAW_BINDING = 6,  // 片元着色次数的统计
+    OIT_HEAD_BINDING = 7,  // 链表 OIT 的节点计数与每个像素的链表头
+    OIT_NODE_BINDING = 8,  // 链表 OIT 的节点池
+};
+
+/// OpenGL 缓冲对象，用作 uniform 缓冲、着色器存储缓冲或实例属性的顶点缓冲
+/// 首次分配时创建，保证 OpenGL 上下文已就绪
+class GpuBuffer {
+public:
+    explicit GpuBuffer(GLenum target = GL_UNIFORM_BUFFER) : m_target(target) { }
+    ~GpuBuffer();
+
+    GpuBuffer(const GpuBuffer &) = delete;
+    GpuBuffer &operator=(const GpuBuffer &) = delete;
+
+    /// 分配 size 字节，原有内容丢弃
+    void allocate(size_t size);
+    /// 写入 [offset, offset + size)，超出已分配的范围时忽略
+    void update(size_t offset, const void *data, size_t size);
+    /// 全部内容清零，在 GPU 上执行
+    void clear();
+    /// 读回 [offset, offset + size)，需要等待之前写入该缓冲的绘制完成
+    void read(size_t offset, void *data, size_t size) const;
+
+    void bindBase(GLuint binding) const;
+    void bindRange(GLuint binding, size_t offset, size_t size) const;
+
+    [[nodiscard]] bool valid() const { return m_id != 0; }
+    /// 用于挂载到顶点数组，重新分配不改变
+    [[nodiscard]] GLuint id() const { return m_id; }
+    [[nodiscard]] size_t size() const { return m_size; }
+
+    /// uniform 缓冲绑定区间的偏移对齐（GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT）
+    static size_t uniformAlignment();
+
+    /// 驱动报告的剩余显存（KB），需要 GL_NVX_gpu_memory_info 或 GL_ATI_meminfo，都不支持时返回 -1
+    static long long availableMemory();
+
+    /// 所有缓冲的写入次数，每帧开始时清零
+    static size_t updates;
+    static size_t lastUpdates;  // 上一帧的写入次数
+    static void resetStats();
+
+private:
+    GLenum m_target;
+    GLuint m_id = 0;
+    size_t m_size = 0;
+};
+
+
+#endif //MODEL_VIEWER_GPUBUFFER_H
@@ -0,0 +1,43 @@
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer() {
+    if (m_created)
+        glDeleteQueries(QUERY_COUNT, m_queries);
+}
+
+void GpuTimer::begin(int samples) {
+    if (!m_created) {  // 首次使用时创建，保证 OpenGL 上下文已就绪
+        glGenQueries(QUERY_COUNT, m_queries);
+        m_created = true;
+    }
+
+    // 当前查询对象仍未读取时先取回结果
+    if (m_pending[m_current]) {
+        GLuint64 time = 0;
+        glGetQueryObjectui64v(m_queries[m_current], GL_QUERY_RESULT, &time);
+        m_elapsed = (float)time / 1e6f;
+        m_elapsedSamples = m_samples[m_current];
+        m_pending[m_current] = false;
+    }
+    m_samples[m_current] = samples;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]);
+}
+
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_current] = true;
+    m_current = (m_current + 1) % QUERY_COUNT;
+
+    // 读取已经完成的最早查询
+    if (m_pending[m_current]) {
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[m_current], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 time = 0;
+            glGetQueryObjectui64v(m_queries[m_current], GL_QUERY_RESULT, &time);
+            m_elapsed = (float)time / 1e6f;
+            m_elapsedSamples = m_samples[m_current];
+            m_pending[m_current] = false;
+        }
+    }
+}
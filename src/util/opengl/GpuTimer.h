@@ -0,0 +1,37 @@
+#ifndef MODEL_VIEWER_GPUTIMER_H
+#define MODEL_VIEWER_GPUTIMER_H
+
+#include "glad/glad.h"
+
+/// GPU 计时器，基于 GL_TIME_ELAPSED 查询
+/// 多个查询对象轮流使用，读取的是若干帧之前的结果，避免等待 GPU
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    /// \param samples 本次测量包含的工作量（如渲染的面数），用于计算单位耗时
+    void begin(int samples = 1);
+    void end();
+
+    /// 最近一次可用的测量结果（毫秒）
+    [[nodiscard]] float elapsed() const { return m_elapsed; }
+    [[nodiscard]] float elapsedPerSample() const { return m_elapsedSamples > 0 ? m_elapsed / (float)m_elapsedSamples : 0.f; }
+
+private:
+    static constexpr int QUERY_COUNT = 3;
+
+    GLuint m_queries[QUERY_COUNT] = {};
+    bool m_pending[QUERY_COUNT] = {};
+    int m_samples[QUERY_COUNT] = {};
+    int m_elapsedSamples = 0;
+    int m_current = 0;
+    bool m_created = false;
+    float m_elapsed = 0.f;
+};
+
+
+#endif //MODEL_VIEWER_GPUTIMER_H
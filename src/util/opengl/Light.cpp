@@ -11,44 +11,22 @@ Light::Light(LightType type) {
     this->type = type;
 }
 
-void Light::importShaderValue(ShaderProgram &shaderProgram, int index) const {
-    shaderProgram.use();
-    string lightStr = "lights[" + std::to_string(index) + "].";
-    shaderProgram.setValue(lightStr + "type", static_cast<int>(type));
-    shaderProgram.setValue(lightStr + "color", color);
-    shaderProgram.setValue(lightStr + "ambient", glm::vec3(ambientX));
-    shaderProgram.setValue(lightStr + "diffuse", glm::vec3(diffuseX));
-    shaderProgram.setValue(lightStr + "specular", glm::vec3(specularX));
-    auto cutOff = glm::cos(glm::radians(cutOffDegree));
-    auto outerCutOff = glm::cos(glm::radians(outerCutOffDegree));
-
-    switch (type) {
-        case DIRECTIONAL_LIGHT:
-            shaderProgram.setValue(lightStr + "direction", direction);
-            break;
-        case SPOT_LIGHT:
-        case TORCH_LIGHT:
-            shaderProgram.setValue(lightStr + "direction", direction);
-            shaderProgram.setValue(lightStr + "cutOff", cutOff);
-            shaderProgram.setValue(lightStr + "outerCutOff", outerCutOff);
-            // fall through
-        case POINT_LIGHT:
-            shaderProgram.setValue(lightStr + "position", position);
-            shaderProgram.setValue(lightStr + "constant", constant);
-            shaderProgram.setValue(lightStr + "linear", linear);
-            shaderProgram.setValue(lightStr + "quadratic", quadratic);
-            break;
-        default:
-            break;
-
-    }
-}
-
-void Light::modelRender(ShaderProgram &shaderProgram) const {
-    if (isShowModel && model != nullptr) {
-        shaderProgram.setValue("lightColor", color);
-        model->render(&shaderProgram);
-    }
+LightData Light::pack() const {
+    // 所有成员都写入，着色器按类型只读取用到的部分
+    LightData data{};
+    data.type = static_cast<int>(type);
+    data.position = position;
+    data.direction = direction;
+    data.color = color;
+    data.ambient = glm::vec3(ambientX);
+    data.diffuse = glm::vec3(diffuseX);
+    data.specular = glm::vec3(specularX);
+    data.constant = constant;
+    data.linear = linear;
+    data.quadratic = quadratic;
+    data.cutOff = glm::cos(glm::radians(cutOffDegree));
+    data.outerCutOff = glm::cos(glm::radians(outerCutOffDegree));
+    return data;
 }
 
 Light::Light() {
@@ -16,15 +16,31 @@ enum LightType {
     TORCH_LIGHT
 };
 
+/// 与着色器中 std430 布局的 Light 结构一致，vec3 之后紧跟一个标量填满 16 字节
+struct LightData {
+    glm::vec3 position;
+    int type;
+    glm::vec3 direction;
+    float cutOff;  // 聚光裁剪角的余弦
+    glm::vec3 color;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+static_assert(sizeof(LightData) == 96, "LightData must match the std430 Light struct");
+
 class Light {
 public:
     Light();
     explicit Light(LightType type);
     ~Light() = default;
 
-    void importShaderValue(ShaderProgram &shaderProgram, int index) const;
-
-    void modelRender(ShaderProgram &shaderProgram) const;
+    /// 转换为着色器使用的布局
+    [[nodiscard]] LightData pack() const;
 
     void reset();
 
@@ -47,6 +63,9 @@ public:
     Model *model = nullptr;
     glm::mat4 modelMatrix = glm::mat4(1.0f);
     bool isShowModel = true;
+
+    unsigned int shadowResolution = 4096;  // 阴影立方体贴图每个面的边长，阴影图集中为图块边长的上限
+    bool castShadow = true;  // 使用阴影图集时是否投射阴影
 };
 
 
@@ -1,6 +1,9 @@
 ﻿#include "Mesh.h"
 #include "ShaderProgram.h"
+#include "../Parallel.h"
 #include "glad/glad.h"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <utility>
 
@@ -8,27 +11,86 @@ Mesh::Mesh(const vector<VertexData> &vertices,
            const vector<unsigned int> &indices,
            const vector<Face> &faces,
            const vector<Texture> &textures,
-           const MeshInfo &meshInfo) :
+           const MeshInfo &meshInfo,
+           bool headless) :
         m_vertices(vertices),
         m_indices(indices),
         m_faces(faces),
         m_textures(textures),
         m_meshInfo(meshInfo)
 {
-    setupMesh();
+    // 纹理序号（diffuse_textureN 中的 N）按类型分别计数，名称只在加载时拼接一次
+    size_t diffuseNum = 1;
+    size_t specularNum = 1;
+    size_t normalNum = 1;
+    size_t heightNum = 1;
+    for (auto &texture : m_textures)
+    {
+        string name = texture.name;
+        if (name == "diffuse")  // 漫反射贴图
+            name += std::to_string(diffuseNum++);
+        else if (name == "specular")  // 镜面贴图
+            name += std::to_string(specularNum++);
+        else if (name == "normal")  // 法线贴图
+            name += std::to_string(normalNum++);
+        else if (name == "height")  // 高度贴图
+            name += std::to_string(heightNum++);
+        m_textureUniforms.push_back("textures." + name);
+    }
+
+    if (!headless)  // 无窗口模式下不创建OpenGL对象
+        setupMesh();
 }
 
 
 Mesh::~Mesh()
 {
+    if (m_vao) {  // 无窗口模式下没有OpenGL对象
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_ebo);
+        glDeleteVertexArrays(1, &m_edgeVao);
+        glDeleteBuffers(1, &m_edgeEbo);
+    }
+}
+
+Mesh::Mesh(Mesh &&other) noexcept :
+        m_vao(std::exchange(other.m_vao, 0)),
+        m_vbo(std::exchange(other.m_vbo, 0)),
+        m_ebo(std::exchange(other.m_ebo, 0)),
+        m_edgeVao(std::exchange(other.m_edgeVao, 0)),
+        m_edgeEbo(std::exchange(other.m_edgeEbo, 0)),
+        m_edgeIndexCount(std::exchange(other.m_edgeIndexCount, 0)),
+        m_textureUniforms(std::move(other.m_textureUniforms)),
+        m_vertices(std::move(other.m_vertices)),
+        m_indices(std::move(other.m_indices)),
+        m_textures(std::move(other.m_textures)),
+        m_faces(std::move(other.m_faces)),
+        m_meshInfo(other.m_meshInfo)
+{
+}
+
+Mesh &Mesh::operator=(Mesh &&other) noexcept
+{
+    if (this != &other) {
+        std::swap(m_vao, other.m_vao);
+        std::swap(m_vbo, other.m_vbo);
+        std::swap(m_ebo, other.m_ebo);
+        std::swap(m_edgeVao, other.m_edgeVao);
+        std::swap(m_edgeEbo, other.m_edgeEbo);
+        std::swap(m_edgeIndexCount, other.m_edgeIndexCount);
+        m_textureUniforms = std::move(other.m_textureUniforms);
+        m_vertices = std::move(other.m_vertices);
+        m_indices = std::move(other.m_indices);
+        m_textures = std::move(other.m_textures);
+        m_faces = std::move(other.m_faces);
+        m_meshInfo = other.m_meshInfo;
+    }
+    return *this;
 }
 
 void Mesh::render(ShaderProgram *program, bool forceColor, bool useMeshInfo, unsigned int depthMap)
 {
-    size_t diffuseNum = 1;
-    size_t specularNum = 1;
-    size_t normalNum = 1;
-    size_t heightNum = 1;
     size_t size = m_textures.size();
 
     if (size == 0 && !forceColor)
@@ -46,17 +108,7 @@ void Mesh::render(ShaderProgram *program, bool forceColor, bool useMeshInfo, uns
         glActiveTexture(GL_TEXTURE0 + i);  // 在绑定之前激活相应的纹理单元
         // 获取纹理序号（diffuse_textureN 中的 N）
         glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
-        string name = m_textures[i].name;
-        if (name == "diffuse")  // 漫反射贴图
-            name += std::to_string(diffuseNum++);
-        else if (name == "specular")  // 镜面贴图
-            name += std::to_string(specularNum++);
-        else if (name == "normal")  // 法线贴图
-            name += std::to_string(normalNum++);
-        else if (name == "height")  // 高度贴图
-            name += std::to_string(heightNum++);
-
-        program->setValue(("material." + name).c_str(), (int)i);
+        program->setValue(m_textureUniforms[i], (int)i);
     }
 
     if (depthMap != 0xffffffff) {
@@ -74,6 +126,67 @@ void Mesh::render(ShaderProgram *program, bool forceColor, bool useMeshInfo, uns
     glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::renderEdges() const
+{
+    glBindVertexArray(m_edgeVao);
+    glDrawElements(GL_LINES, (GLsizei)m_edgeIndexCount, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+}
+
+void Mesh::renderPoints() const
+{
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)m_vertices.size());
+    glBindVertexArray(0);
+}
+
+vector<unsigned int> Mesh::uniqueEdges(const vector<unsigned int> &indices, size_t vertexCount)
+{
+    // 边编码为 (较小序号 << 32 | 较大序号)，排序后相同的边相邻
+    auto buckets = (size_t)parallel::workerCount();
+    auto bucketSize = std::max<size_t>(1, (vertexCount + buckets - 1) / buckets);
+    auto triangles = indices.size() / 3;
+    vector<vector<uint64_t>> scattered(buckets * buckets);  // [线程][区间]
+    parallel::forRange(triangles, [&](size_t begin, size_t end, unsigned int worker) {
+        auto *local = &scattered[worker * buckets];
+        for (auto t = begin; t < end; t++) {
+            for (int k = 0; k < 3; k++) {
+                auto a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+                if (a == b)
+                    continue;
+                auto low = std::min(a, b), high = std::max(a, b);
+                local[std::min<size_t>(low / bucketSize, buckets - 1)].push_back((uint64_t)low << 32 | high);
+            }
+        }
+    }, 4096);
+
+    // 区间按顶点序号递增，各区间去重后依次拼接即整体有序
+    vector<vector<uint64_t>> sorted(buckets);
+    parallel::forEach(buckets, [&](size_t bucket) {
+        auto &keys = sorted[bucket];
+        for (size_t worker = 0; worker < buckets; worker++) {
+            auto &part = scattered[worker * buckets + bucket];
+            keys.insert(keys.end(), part.begin(), part.end());
+            vector<uint64_t>().swap(part);
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }, 1);
+
+    vector<size_t> offsets(buckets + 1, 0);
+    for (size_t bucket = 0; bucket < buckets; bucket++)
+        offsets[bucket + 1] = offsets[bucket] + sorted[bucket].size() * 2;
+    vector<unsigned int> edges(offsets[buckets]);
+    parallel::forEach(buckets, [&](size_t bucket) {
+        auto *out = edges.data() + offsets[bucket];
+        for (auto key : sorted[bucket]) {
+            *out++ = (unsigned int)(key >> 32);
+            *out++ = (unsigned int)key;
+        }
+    }, 1);
+    return edges;
+}
+
 void Mesh::setupMesh()
 {
     glGenVertexArrays(1, &m_vao);
@@ -87,6 +200,25 @@ void Mesh::setupMesh()
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW);
 
+    setupVertexAttributes();
+
+    // 线框只绘制一次每条边
+    auto edges = uniqueEdges(m_indices, m_vertices.size());
+    m_edgeIndexCount = edges.size();
+    glGenVertexArrays(1, &m_edgeVao);
+    glGenBuffers(1, &m_edgeEbo);
+    glBindVertexArray(m_edgeVao);
+    setupVertexAttributes();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, edges.size() * sizeof(unsigned int), edges.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void Mesh::setupVertexAttributes()
+{
     // 顶点位置
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void *)0);
@@ -102,10 +234,6 @@ void Mesh::setupMesh()
     // 顶点副切线
     glEnableVertexAttribArray(4);
     glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, bitangent));
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 const vector<VertexData> &Mesh::getVertices() const {
@@ -135,3 +263,7 @@ Mesh::Mesh() {
 unsigned int Mesh::getVao() const {
     return m_vao;
 }
+
+unsigned int Mesh::getVbo() const {
+    return m_vbo;
+}
@@ -58,16 +58,36 @@ public:
          const vector<unsigned int> &indices,
          const vector<Face> &faces,
          const vector<Texture> &textures,
-         const MeshInfo &meshInfo);
+         const MeshInfo &meshInfo,
+         bool headless = false);
 
     Mesh();
 
+    /// 释放顶点数组与缓冲对象，只能移动，避免副本重复释放
     ~Mesh();
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+    Mesh(Mesh &&other) noexcept;
+    Mesh &operator=(Mesh &&other) noexcept;
 
 
     void render(ShaderProgram *program,bool forceColor=false, bool useMeshInfo = true, unsigned int depthMap = 0xffffffff);
+    /// 以 GL_LINES 绘制每条边一次，相邻三角形共享的边不重复绘制
+    void renderEdges() const;
+    /// 以 GL_POINTS 绘制每个顶点一次
+    void renderPoints() const;
+
+    /// 三角形索引中的无向边去重，返回 GL_LINES 使用的顶点序号对
+    /// 边按较小的顶点序号划分为与线程数相同的区间，各线程分发自己那段三角形的边后各自排序、去重一个区间
+    static vector<unsigned int> uniqueEdges(const vector<unsigned int> &indices, size_t vertexCount);
+    /// 去重后的边数，无窗口模式下为 0
+    [[nodiscard]] size_t edgeCount() const { return m_edgeIndexCount / 2; }
 
     [[nodiscard]] unsigned int getVao() const;
+    [[nodiscard]] unsigned int getVbo() const;
+
+    /// 按 VertexData 布局设置顶点属性，需先绑定 VAO 与顶点缓冲
+    static void setupVertexAttributes();
 
     [[nodiscard]] const vector<VertexData> &getVertices() const;
     [[nodiscard]] const vector<unsigned int> &getIndices() const;
@@ -78,7 +98,10 @@ public:
 private:
     void setupMesh();
 
-    unsigned int m_vao, m_vbo, m_ebo;
+    unsigned int m_vao = 0, m_vbo = 0, m_ebo = 0;
+    unsigned int m_edgeVao = 0, m_edgeEbo = 0;  // 共享顶点缓冲，使用去重后的边索引
+    size_t m_edgeIndexCount = 0;
+    vector<string> m_textureUniforms;  // 每个纹理对应的采样器名称，如 textures.diffuse1
     vector<VertexData> m_vertices;
     vector<unsigned int> m_indices;
     vector<Texture> m_textures;
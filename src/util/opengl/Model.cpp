@@ -1,32 +1,144 @@
 ﻿#include "Model.h"
 #include "Image.h"
 #include <iostream>
+#include <algorithm>
 #include <cfloat>
+#include <cstring>
 #include "glad/glad.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/random.hpp>
 #include <filesystem>
 
+namespace {
+/// 与着色器中 std140 布局的 Material 块一致
+struct MaterialData {
+    glm::vec3 ambient;
+    float shininess;
+    glm::vec3 diffuse;
+    float dissolve;
+    glm::vec3 specular;
+    float refractiveIndex;
+    glm::vec3 emission;
+    int illum;
+
+    MaterialData() : MaterialData(MeshInfo()) { }
+    explicit MaterialData(const MeshInfo &info) :
+            ambient(info.ambient), shininess(info.shininess),
+            diffuse(info.diffuse), dissolve(info.dissolve),
+            specular(info.specular), refractiveIndex(info.refractiveIndex),
+            emission(info.emission), illum(info.illum) { }
+};
+static_assert(sizeof(MaterialData) == 64, "MaterialData must match the std140 Material block");
+}
 
 /// 从文件中加载模型
 /// \param path 路径
-Model::Model(const string &path)
+/// \param headless 无窗口模式，仅加载几何数据
+Model::Model(const string &path, bool headless) : m_headless(headless)
 {
     loadModel(path);
 }
 
 Model::~Model()
 {
-
+    // 网格的缓冲对象由 Mesh 释放，纹理由模型统一加载，在这里释放
+    for (auto &texture : m_loadedTextures)
+        glDeleteTextures(1, &texture.id);
 }
 
 /// 渲染模型
 /// \param program 着色器对象
 void Model::render(ShaderProgram *program, bool forceColor, bool useMeshInfo, unsigned int depthMap)
 {
-    for (auto it : meshes)
-        it.render(program, forceColor, useMeshInfo, depthMap);
+    for (size_t i = 0; i < meshes.size(); i++)
+        renderMesh(i, program, forceColor, useMeshInfo, depthMap);
+}
+
+void Model::renderMesh(size_t index, ShaderProgram *program, bool forceColor, bool useMeshInfo, unsigned int depthMap)
+{
+    if (m_materialBuffer.valid())
+    {
+        auto slot = useMeshInfo && meshes[index].getMeshInfo().valid ? index : meshes.size();
+        m_materialBuffer.bindRange(MATERIAL_BINDING, slot * m_materialStride, sizeof(MaterialData));
+    }
+    meshes[index].render(program, forceColor, useMeshInfo, depthMap);
+}
+
+void Model::renderEdges() const
+{
+    for (auto &mesh : meshes)
+        mesh.renderEdges();
+}
+
+void Model::renderPoints() const
+{
+    for (auto &mesh : meshes)
+        mesh.renderPoints();
+}
+
+void Model::partitionTransparency()
+{
+    m_transparent.assign(meshes.size(), false);
+    m_transparentMeshes.clear();
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        auto &info = meshes[i].getMeshInfo();
+        if (info.valid && info.dissolve < 1.0f)
+        {
+            m_transparent[i] = true;
+            m_transparentMeshes.push_back(i);
+        }
+    }
+}
+
+void Model::setDefaultShininess(float shininess)
+{
+    if (shininess == m_defaultShininess || !m_materialBuffer.valid())
+        return;
+    m_defaultShininess = shininess;
+    MaterialData material;
+    material.shininess = shininess;
+    m_materialBuffer.update(meshes.size() * m_materialStride, &material, sizeof(material));
+}
+
+void Model::sortFrontToBack(const glm::mat4 &model, const glm::vec3 &eye, vector<size_t> &order) const
+{
+    // 观察位置变换到模型空间，与包围盒最近点的距离按模型空间比较，均匀缩放下顺序不变
+    auto local = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.f));
+    vector<std::pair<float, float>> keys(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        auto &info = meshes[i].getMeshInfo();
+        auto nearest = glm::clamp(local, info.minVertex, info.maxVertex);
+        auto center = (info.minVertex + info.maxVertex) * 0.5f;
+        // 包含观察位置的网格距离都为 0，再按中心的距离区分
+        keys[i] = {glm::dot(local - nearest, local - nearest), glm::dot(local - center, local - center)};
+    }
+    order.resize(meshes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+}
+
+void Model::setupMaterials()
+{
+    auto alignment = GpuBuffer::uniformAlignment();
+    m_materialStride = (sizeof(MaterialData) + alignment - 1) / alignment * alignment;
+
+    // 一次写入所有槽，槽之间的填充部分不使用
+    vector<char> data((meshes.size() + 1) * m_materialStride);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        MaterialData material(meshes[i].getMeshInfo());
+        std::memcpy(data.data() + i * m_materialStride, &material, sizeof(material));
+    }
+    MaterialData material;
+    material.shininess = m_defaultShininess;
+    std::memcpy(data.data() + meshes.size() * m_materialStride, &material, sizeof(material));
+
+    m_materialBuffer.allocate(data.size());
+    m_materialBuffer.update(0, data.data(), data.size());
 }
 
 /// 从文件中加载模型
@@ -64,7 +176,7 @@ void Model::loadModel(const string &modelPath)
     glm::vec3 maxVertex = glm::vec3(FLT_MIN, FLT_MIN, FLT_MIN);
     glm::vec3 minVertex = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
 
-    for (auto it : meshes)
+    for (const auto &it : meshes)
     {
         maxVertex.x = std::max(maxVertex.x, it.getMeshInfo().maxVertex.x);
         maxVertex.y = std::max(maxVertex.y, it.getMeshInfo().maxVertex.y);
@@ -86,6 +198,10 @@ void Model::loadModel(const string &modelPath)
 
     basisTransform = glm::translate(glm::mat4(1.0f), glm::vec3(-move.x * scale / 2.0f, -move.y * scale / 2.0f, 0.f));
     basisTransform = glm::scale(basisTransform, glm::vec3(scale));
+
+    partitionTransparency();
+    if (!m_headless)
+        setupMaterials();
 }
 
 /// 处理节点
@@ -199,13 +315,16 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
     if (mesh->mMaterialIndex > 0)
     {
         aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];  // 获取材质
-        vector<Texture> diffuseMaps = loadMaterialTextures(material,
-                                                           aiTextureType_DIFFUSE, "diffuse");  // 获取漫反射贴图
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());  // 将漫反射贴图添加到纹理数组中
+        if (!m_headless)  // 无窗口模式不加载纹理
+        {
+            vector<Texture> diffuseMaps = loadMaterialTextures(material,
+                                                               aiTextureType_DIFFUSE, "diffuse");  // 获取漫反射贴图
+            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());  // 将漫反射贴图添加到纹理数组中
 
-        vector<Texture> specularMaps = loadMaterialTextures(material,
-                                                            aiTextureType_SPECULAR, "specular");  // 获取镜面贴图
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());  // 将镜面贴图添加到纹理数组中
+            vector<Texture> specularMaps = loadMaterialTextures(material,
+                                                                aiTextureType_SPECULAR, "specular");  // 获取镜面贴图
+            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());  // 将镜面贴图添加到纹理数组中
+        }
 
         float infoFloat;
         if (material->Get(AI_MATKEY_SHININESS, infoFloat) == AI_SUCCESS)
@@ -213,7 +332,7 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
         if (material->Get(AI_MATKEY_OPACITY, infoFloat) == AI_SUCCESS)
             meshInfo.dissolve = infoFloat;  // 获取材质的透明度
         if (material->Get(AI_MATKEY_REFRACTI, infoFloat) == AI_SUCCESS)
-            meshInfo.dissolve = infoFloat;  // 获取材质的折射率
+            meshInfo.refractiveIndex = infoFloat;  // 获取材质的折射率
 
         int infoInt;
         if (material->Get(AI_MATKEY_SHADING_MODEL, infoInt) == AI_SUCCESS)
@@ -235,7 +354,7 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
     meshInfo.maxVertex = maxVertex;
     meshInfo.minVertex = minVertex;
 
-    return Mesh(vertices, indices, faces, textures, meshInfo);  // 返回标准化网格对象
+    return Mesh(vertices, indices, faces, textures, meshInfo, m_headless);  // 返回标准化网格对象
 }
 
 /// 加载材质纹理
@@ -1,6 +1,7 @@
 ﻿#ifndef MODEL_H
 #define MODEL_H
 #include "Mesh.h"
+#include "GpuBuffer.h"
 #include <string>
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
@@ -11,10 +12,34 @@ class Model
 {
 public:
     Model();
-    explicit Model(const string &path);
+    explicit Model(const string &path, bool headless = false);
     ~Model();
 
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    /// 渲染前按网格绑定材质缓冲的区间，useMeshInfo 为 false 时所有网格使用默认材质
     void render(ShaderProgram *program, bool forceColor=false, bool useMeshInfo = true, unsigned int depthMap = 0xffffffff);
+    /// 只渲染第 index 个网格，用于逐网格选择着色器
+    void renderMesh(size_t index, ShaderProgram *program, bool forceColor=false, bool useMeshInfo = true, unsigned int depthMap = 0xffffffff);
+
+    /// 所有网格的去重边（GL_LINES）与顶点（GL_POINTS），不绑定材质与纹理，用于线框与顶点叠加层
+    void renderEdges() const;
+    void renderPoints() const;
+
+    /// 默认材质的高光指数，只在值变化时写入材质缓冲
+    void setDefaultShininess(float shininess);
+
+    /// 网格按包围盒到观察位置的距离由近到远排列，先绘制的近处网格让提前深度测试剔除远处被遮挡的片元
+    /// \param model 模型矩阵
+    /// \param eye 世界坐标中的观察位置
+    /// \param order 输出的网格序号
+    void sortFrontToBack(const glm::mat4 &model, const glm::vec3 &eye, vector<size_t> &order) const;
+
+    /// 按材质透明度（dissolve 小于 1）划分透明与不透明网格，加载时调用，直接修改 meshes 后需要重新划分
+    void partitionTransparency();
+    [[nodiscard]] bool isTransparent(size_t index) const { return index < m_transparent.size() && m_transparent[index]; }
+    [[nodiscard]] const vector<size_t> &transparentMeshes() const { return m_transparentMeshes; }
 
     /// 基础变换矩阵
     glm::mat4 basisTransform = glm::mat4(1.0f);
@@ -28,11 +53,22 @@ private:
     Mesh processMesh(aiMesh *mesh, const aiScene *scene);
     vector<Texture> loadMaterialTextures(aiMaterial *material, aiTextureType type, const string &name);
     unsigned int loadTexture(const string &filename);
+    /// 每个网格的材质常量写入材质缓冲，最后一个槽为默认材质
+    void setupMaterials();
 
     /// 模型目录
     string m_directory;
+    /// 仅加载几何数据，不创建OpenGL对象及纹理
+    bool m_headless = false;
     /// 已加载的纹理，避免重复加载
     vector<Texture> m_loadedTextures;
+    /// 材质缓冲，槽按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐
+    GpuBuffer m_materialBuffer;
+    size_t m_materialStride = 0;
+    float m_defaultShininess = 32.0f;
+    /// 按网格序号标记的透明网格及其序号列表
+    vector<bool> m_transparent;
+    vector<size_t> m_transparentMeshes;
 
 };
 
@@ -0,0 +1,213 @@
+#include "OitBuffer.h"
+
+namespace {
+    const GLenum internalFormats[OitBuffer::TARGET_COUNT] = {GL_RGBA16F, GL_R16F};
+    const size_t texelBytes[OitBuffer::TARGET_COUNT] = {8, 2};
+
+    size_t depthBytes(GLenum format) {
+        switch (format) {
+            case GL_DEPTH_COMPONENT16:
+                return 2;
+            case GL_DEPTH32F_STENCIL8:
+                return 8;
+            default:
+                return 4;
+        }
+    }
+}
+
+OitBuffer::~OitBuffer() {
+    release();
+    for (auto fence : m_fences)
+        if (fence)
+            glDeleteSync(fence);
+}
+
+bool OitBuffer::allocate(int width, int height, GLenum depthFormat) {
+    if (width <= 0 || height <= 0 ||
+        (valid() && width == m_width && height == m_height && depthFormat == m_depthFormat))
+        return false;
+
+    if (!valid()) {
+        glGenTextures(TARGET_COUNT, m_textures);
+        for (auto texture : m_textures) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            // 合成时按像素读取，不需要过滤
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glGenRenderbuffers(1, &m_depth);
+        glGenFramebuffers(1, &m_framebuffer);
+    }
+
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, (GLint)internalFormats[i], width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    m_width = width;
+    m_height = height;
+    m_depthFormat = depthFormat;
+
+    GLint previous;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    GLenum drawBuffers[TARGET_COUNT];
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    auto stencil = depthFormat == GL_DEPTH24_STENCIL8 || depthFormat == GL_DEPTH32F_STENCIL8;
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, m_depth);
+    glDrawBuffers(TARGET_COUNT, drawBuffers);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previous);
+    return true;
+}
+
+bool OitBuffer::allocateLists(int width, int height, int layers) {
+    auto capacity = (size_t)width * (size_t)height * (size_t)(layers > 0 ? layers : 1);
+    if (width <= 0 || height <= 0 ||
+        (m_heads.valid() && width == m_listWidth && height == m_listHeight && capacity == m_nodeCapacity))
+        return false;
+    m_heads.allocate(HEADER_BYTES + (size_t)width * (size_t)height * sizeof(GLuint));
+    m_nodes.allocate(capacity * NODE_BYTES);
+    m_listWidth = width;
+    m_listHeight = height;
+    m_nodeCapacity = capacity;
+    return true;
+}
+
+void OitBuffer::release() {
+    if (valid()) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        glDeleteTextures(TARGET_COUNT, m_textures);
+        glDeleteRenderbuffers(1, &m_depth);
+        m_framebuffer = m_depth = 0;
+        for (auto &texture : m_textures)
+            texture = 0;
+        m_width = m_height = 0;
+        m_depthFormat = 0;
+    }
+    if (m_heads.valid()) {
+        // 缓冲对象随 GpuBuffer 析构释放，这里只丢弃内容
+        m_heads.allocate(0);
+        m_nodes.allocate(0);
+        m_listWidth = m_listHeight = 0;
+        m_nodeCapacity = 0;
+    }
+}
+
+void OitBuffer::begin(GLuint source) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    const GLfloat zero[4] = {0.f, 0.f, 0.f, 0.f};
+    const GLfloat one[4] = {1.f, 1.f, 1.f, 1.f};
+    glClearBufferfv(GL_COLOR, ACCUM, zero);
+    glClearBufferfv(GL_COLOR, REVEALAGE, one);
+}
+
+void OitBuffer::bindTextures(int firstUnit) const {
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void OitBuffer::clearLists() {
+    m_heads.clear();
+    m_heads.bindBase(OIT_HEAD_BINDING);
+    m_nodes.bindBase(OIT_NODE_BINDING);
+}
+
+size_t OitBuffer::readFragmentCount() const {
+    GLuint count = 0;
+    if (m_heads.valid())
+        m_heads.read(0, &count, sizeof(count));
+    return count;
+}
+
+void OitBuffer::queryFragmentCount() {
+    if (!m_heads.valid())
+        return;
+    // 当前读回缓冲仍未读取时先取回结果
+    collect(m_currentReadback, true);
+    auto &readback = m_readback[m_currentReadback];
+    if (!readback.valid())
+        readback.allocate(sizeof(GLuint));
+    glBindBuffer(GL_COPY_READ_BUFFER, m_heads.id());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readback.id());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GLuint));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_fences[m_currentReadback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_currentReadback = (m_currentReadback + 1) % READBACK_COUNT;
+
+    // 读取已经完成的最早复制
+    collect(m_currentReadback, false);
+}
+
+void OitBuffer::collect(int index, bool wait) {
+    auto &fence = m_fences[index];
+    if (!fence)
+        return;
+    auto status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return;
+    glDeleteSync(fence);
+    fence = nullptr;
+    GLuint count = 0;
+    m_readback[index].read(0, &count, sizeof(count));
+    m_fragmentCount = count;
+}
+
+size_t OitBuffer::bytes() const {
+    size_t texel = valid() ? depthBytes(m_depthFormat) : 0;
+    if (valid())
+        for (auto bytes : texelBytes)
+            texel += bytes;
+    return texel * (size_t)m_width * (size_t)m_height + m_heads.size() + m_nodes.size();
+}
+
+GLenum OitBuffer::depthFormat(GLuint framebuffer) {
+    GLint previous;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    auto depthAttachment = framebuffer == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+    auto stencilAttachment = framebuffer == 0 ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+    GLint depthType = GL_NONE, stencilType = GL_NONE, depthBits = 0, stencilBits = 0, component = GL_UNSIGNED_NORMALIZED;
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &depthType);
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &stencilType);
+    if (depthType != GL_NONE) {
+        glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment,
+                                              GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+        glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, depthAttachment,
+                                              GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &component);
+    }
+    if (stencilType != GL_NONE)
+        glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, stencilAttachment,
+                                              GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous);
+
+    if (component == GL_FLOAT)
+        return stencilBits > 0 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+    if (depthBits == 16)
+        return GL_DEPTH_COMPONENT16;
+    if (depthBits == 32)
+        return GL_DEPTH_COMPONENT32;
+    if (depthBits == 24 && stencilBits == 0)
+        return GL_DEPTH_COMPONENT24;
+    return GL_DEPTH24_STENCIL8;  // 窗口最常见的格式
+}
@@ -0,0 +1,87 @@
+#ifndef MODEL_VIEWER_OITBUFFER_H
+#define MODEL_VIEWER_OITBUFFER_H
+
+#include <cstddef>
+#include "glad/glad.h"
+#include "GpuBuffer.h"
+
+/// 顺序无关透明（OIT）的缓冲，析构时释放
+/// 加权混合：累加颜色 RGBA16F 与透射率 R16F 两个附件，深度从画面复制，透明片元按不透明几何的深度测试
+/// 逐像素链表：每个像素的链表头与节点池两个着色器存储缓冲，节点池按平均层数分配，超出容量的片元被丢弃
+/// 两种方式按需分配，尺寸变化时重新分配
+class OitBuffer {
+public:
+    /// 颜色附件的顺序，与 model_fragment.glsl 中 OIT_WEIGHTED 的输出位置一致
+    enum Target {
+        ACCUM,
+        REVEALAGE,
+        TARGET_COUNT,
+    };
+    static constexpr size_t NODE_BYTES = 16;  // 与 model_fragment.glsl 的 oitNodes 一致
+    static constexpr size_t HEADER_BYTES = sizeof(GLuint);  // 链表头之前的节点计数
+
+    OitBuffer() = default;
+    ~OitBuffer();
+
+    OitBuffer(const OitBuffer &) = delete;
+    OitBuffer &operator=(const OitBuffer &) = delete;
+
+    /// 加权混合的目标，depthFormat 须与复制深度的来源一致（见 depthFormat）
+    /// \return 是否重新分配
+    bool allocate(int width, int height, GLenum depthFormat);
+    /// 链表头与平均每个像素 layers 个节点的节点池
+    /// \return 是否重新分配
+    bool allocateLists(int width, int height, int layers);
+    void release();
+
+    /// 从 source 帧缓冲复制深度（多重采样时取其中一个样本），之后绑定 framebuffer() 并清除颜色：
+    /// 累加颜色为 0，透射率为 1
+    void begin(GLuint source) const;
+    /// 累加颜色与透射率依次绑定到 firstUnit 起的纹理单元
+    void bindTextures(int firstUnit) const;
+
+    /// 链表头与节点计数清零并绑定到着色器存储缓冲的绑定点
+    void clearLists();
+    /// 上一次绘制申请的节点数，需要等待绘制完成
+    [[nodiscard]] size_t readFragmentCount() const;
+    /// 节点计数复制到轮流使用的读回缓冲，不等待绘制完成，结果由 fragmentCount 在之后的帧取得
+    void queryFragmentCount();
+    /// 最近一次已完成的 queryFragmentCount 的结果，是若干帧之前的计数
+    [[nodiscard]] size_t fragmentCount() const { return m_fragmentCount; }
+
+    [[nodiscard]] bool valid() const { return m_framebuffer != 0; }
+    [[nodiscard]] GLuint framebuffer() const { return m_framebuffer; }
+    [[nodiscard]] int width() const { return m_width; }
+    [[nodiscard]] int height() const { return m_height; }
+    [[nodiscard]] size_t nodeCapacity() const { return m_nodeCapacity; }
+    /// 占用的显存（字节），两种方式之和
+    [[nodiscard]] size_t bytes() const;
+
+    /// 帧缓冲（0 为窗口）深度附件的内部格式，位数与之相同的格式才能用 glBlitFramebuffer 复制深度
+    static GLenum depthFormat(GLuint framebuffer);
+
+private:
+    GLuint m_framebuffer = 0;
+    GLuint m_textures[TARGET_COUNT] = {};
+    GLuint m_depth = 0;  // 渲染缓冲
+    GLenum m_depthFormat = 0;
+    int m_width = 0, m_height = 0;
+
+    GpuBuffer m_heads{GL_SHADER_STORAGE_BUFFER};
+    GpuBuffer m_nodes{GL_SHADER_STORAGE_BUFFER};
+    int m_listWidth = 0, m_listHeight = 0;
+    size_t m_nodeCapacity = 0;
+
+    /// 取回第 index 个读回缓冲的计数，wait 为 false 时复制尚未完成则不读取
+    void collect(int index, bool wait);
+
+    static constexpr int READBACK_COUNT = 3;
+    GpuBuffer m_readback[READBACK_COUNT] = {GpuBuffer{GL_COPY_WRITE_BUFFER}, GpuBuffer{GL_COPY_WRITE_BUFFER},
+                                            GpuBuffer{GL_COPY_WRITE_BUFFER}};
+    GLsync m_fences[READBACK_COUNT] = {};
+    int m_currentReadback = 0;
+    size_t m_fragmentCount = 0;
+};
+
+
+#endif //MODEL_VIEWER_OITBUFFER_H
@@ -1,7 +1,7 @@
 ﻿#include "OpenGLWindow.h"
+#include "../Profiler.h"
 #include <iostream>
 #include <sstream>
-#include <sysinfoapi.h>
 
 int OpenGLWindow::m_major = 3;
 int OpenGLWindow::m_minor = 3;
@@ -17,69 +17,77 @@ OpenGLWindow::OpenGLWindow(int width, int height)
 
 OpenGLWindow::~OpenGLWindow() = default;
 
-void OpenGLWindow::closeCallback(GLFWwindow *window)
+OpenGLWindow *OpenGLWindow::fromWindow(GLFWwindow *window)
 {
+    // 窗口回调都来自输入或窗口状态的变化，之后的几帧需要重绘
     auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    _this->m_redrawFrames = REDRAW_FRAMES;
+    return _this;
+}
+
+void OpenGLWindow::closeCallback(GLFWwindow *window)
+{
+    auto *_this = fromWindow(window);
     _this->closeEvent();
 }
 
 void OpenGLWindow::focusCallback(GLFWwindow *window, int focused)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->focusEvent(focused);
 }
 
 void OpenGLWindow::minimizeCallback(GLFWwindow *window, int minimized)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->minimizeEvent(minimized);
 }
 
 void OpenGLWindow::posCallback(GLFWwindow* window, int xpos, int ypos)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->posEvent(xpos, ypos);
 }
 
 void OpenGLWindow::updateCallback(GLFWwindow* window)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->updateEvent();
 }
 
 void OpenGLWindow::resizeCallback(GLFWwindow *window, int width, int height)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->resizeEvent(width, height);
 }
 
 void OpenGLWindow::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->keyEvent(key, scancode, action, mods);
 }
 
 void OpenGLWindow::mouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->mouseScrollEvent(xoffset, yoffset);
 }
 
 void OpenGLWindow::mouseMoveCallBack(GLFWwindow *window, double xpos, double ypos)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->mouseMoveEvent(xpos, ypos);
 }
 
 void OpenGLWindow::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->mouseButtonEvent(button, action, mods);
 }
 
 void OpenGLWindow::charCallback(GLFWwindow* window, unsigned int codepoint)
 {
-    auto *_this = static_cast<OpenGLWindow *>(glfwGetWindowUserPointer(window));
+    auto *_this = fromWindow(window);
     _this->charEvent(codepoint);
 }
 
@@ -178,25 +186,36 @@ void OpenGLWindow::setCursorMode(CursorMode mode)
 
 void OpenGLWindow::exec()
 {
-#ifdef _WIN32
-    m_lastTime = ::GetTickCount64();
-#else
-    m_lastTime = glfwGetTime();
-#endif
+    m_lastTime = std::chrono::steady_clock::now();
+    m_lastFPSTime = m_lastTime;
     while (!glfwWindowShouldClose(m_window))
     {
+        bool idle = false;
+        if (m_renderOnDemand && !redrawPending())
+        {
+            // 窗口回调会唤醒等待，超时后再询问一次子类（异步编译的着色器等）
+            glfwWaitEventsTimeout(IDLE_TIMEOUT);
+            if (!redrawPending())
+            {
+                m_skippedFrames++;
+                continue;
+            }
+            idle = true;
+        }
+
+        PROFILE_FRAME();
         static unsigned int frame = 0;
         frame++;
 
-#ifdef _WIN32
-        auto now = ::GetTickCount64();
-#else
-        auto now = glfwGetTime();
-#endif
-        auto deltaTime = now - m_lastTime;
+        // GetTickCount64 的分辨率约为 16 ms，帧间隔改用 steady_clock
+        auto now = std::chrono::steady_clock::now();
+        // 空闲等待的时间不计入帧间隔，否则按住按键后的第一帧相机会跳一大步
+        if (idle)
+            m_lastTime = now;
+        auto deltaTime = std::chrono::duration<float>(now - m_lastTime).count();
         m_lastTime = now;
 
-        if (now - m_lastFPSTime >= 1000)
+        if (now - m_lastFPSTime >= std::chrono::seconds(1))
         {
             m_fps = frame;
             frame = 0;
@@ -204,9 +223,16 @@ void OpenGLWindow::exec()
         }
         setWindowTitle(m_title);
 
-        render((float)deltaTime / 1000.0f);
-        glfwSwapBuffers(m_window);
+        render(deltaTime);
+        {
+            PROFILE_SCOPE("Swap Buffers");
+            glfwSwapBuffers(m_window);
+        }
+        m_renderedFrames++;
+        if (m_redrawFrames > 0)
+            m_redrawFrames--;
 
+        PROFILE_SCOPE("Poll Events");
         glfwPollEvents();
     }
 
@@ -218,6 +244,14 @@ void OpenGLWindow::close()
     glfwSetWindowShouldClose(m_window, true);
 }
 
+bool OpenGLWindow::redrawPending()
+{
+    // 最小化时没有可见的画面
+    if (glfwGetWindowAttrib(m_window, GLFW_ICONIFIED))
+        return false;
+    return m_redrawFrames > 0 || needsRedraw();
+}
+
 void APIENTRY OpenGLWindow::glDebugOutput(GLenum source,
                                           GLenum type,
                                           GLuint id,
@@ -1,5 +1,6 @@
 #ifndef OPENGLWINDOW_H
 #define OPENGLWINDOW_H
+#include <chrono>
 #include <string>
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -37,12 +38,20 @@ public:
     void exec();
     void close();
 
+    /// 按需渲染：没有输入与重绘请求时阻塞等待事件，不重复绘制相同的画面
+    void setRenderOnDemand(bool onDemand) { m_renderOnDemand = onDemand; }
+    bool renderOnDemand() const { return m_renderOnDemand; }
+    unsigned long long getRenderedFrames() const { return m_renderedFrames; }
+    unsigned long long getSkippedFrames() const { return m_skippedFrames; }
+
     static void setOpenGLContextVersion(int major, int minor);
     static void setOpenGLProfile(OpenGLProfile profile);
     static void setSamples(int samples);
 
 protected:
     virtual void render(float deltaTime) { }
+    /// 按需渲染时每次被唤醒后询问，子类在有动画或未完成的异步工作时返回 true
+    virtual bool needsRedraw() { return false; }
 
     virtual void closeEvent() { }
     virtual void focusEvent(int focused) { }
@@ -57,6 +66,7 @@ protected:
     virtual void charEvent(unsigned int codepoint) { }
 
 private:
+    static OpenGLWindow *fromWindow(GLFWwindow *window);
     static void closeCallback(GLFWwindow *window);
     static void focusCallback(GLFWwindow *window, int focused);
     static void minimizeCallback(GLFWwindow *window, int minimized);
@@ -75,15 +85,19 @@ private:
     static OpenGLProfile m_profile;
     static int m_samples;
 
+    static constexpr int REDRAW_FRAMES = 3;  // 输入之后继续绘制的帧数，ImGui 的状态与 GPU 计时要晚一两帧才更新
+    static constexpr double IDLE_TIMEOUT = 0.5;  // 按需渲染时最长的等待时间（秒）
+
+    bool redrawPending();
+
 protected:
-#ifdef _WIN32
-    unsigned long long m_lastTime = 0;
-    unsigned long long m_lastFPSTime = 0;
-#else
-    double m_lastTime = 0.0;
-    double m_lastFPSTime = 0.0;
-#endif
+    std::chrono::steady_clock::time_point m_lastTime;
+    std::chrono::steady_clock::time_point m_lastFPSTime;
     unsigned int m_fps = 0;
+    bool m_renderOnDemand = true;
+    int m_redrawFrames = REDRAW_FRAMES;
+    unsigned long long m_renderedFrames = 0;
+    unsigned long long m_skippedFrames = 0;  // 按需渲染时被唤醒但画面没有变化的次数
     string m_title = "OpenGL Window";
     GLFWwindow *m_window = nullptr;
 
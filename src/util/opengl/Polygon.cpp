@@ -3,18 +3,42 @@
 //
 
 #include "Polygon.h"
+#include <algorithm>
 
-Polygon::Polygon(const vector<Mesh>& meshes) {
+Polygon::Polygon(const vector<Mesh>& meshes, bool headless) : m_headless(headless) {
     for (auto &mesh : meshes) {
         PolygonMesh polygonMesh;
-        polygonMesh.vao = mesh.getVao();
         polygonMesh.indices = vector<unsigned int>();
         polygonMesh.vertices = mesh.getVertices();
+        if (headless) {
+            m_meshes.push_back(polygonMesh);
+            continue;
+        }
+
+        // 复用网格的顶点缓冲，绑定独立的索引缓冲
+        glGenVertexArrays(1, &polygonMesh.vao);
+        glGenBuffers(1, &polygonMesh.ebo);
+        glBindVertexArray(polygonMesh.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.getVbo());
+        Mesh::setupVertexAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, polygonMesh.ebo);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         m_meshes.push_back(polygonMesh);
     }
 }
 
+Polygon::~Polygon() {
+    if (m_headless)
+        return;
+    for (auto &mesh : m_meshes) {
+        glDeleteVertexArrays(1, &mesh.vao);
+        glDeleteBuffers(1, &mesh.ebo);
+    }
+}
+
 void Polygon::render(float offset, float size) {
     glPolygonOffset(offset, offset);
     if (size > 0.f)
@@ -23,8 +47,27 @@ void Polygon::render(float offset, float size) {
     }
 
     for (auto &mesh : m_meshes) {
+        if (mesh.indices.empty() && !mesh.dirty)
+            continue;
+
         glBindVertexArray(mesh.vao);
-        draw(mesh);
+        if (mesh.dirty) {
+            // 容量不足时按倍数扩容并整体上传，否则只上传变化的部分
+            if (mesh.indices.size() > mesh.capacity) {
+                mesh.capacity = std::max({mesh.indices.size(), mesh.capacity * 2, MIN_CAPACITY});
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.capacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+                mesh.dirtyBegin = 0;
+                mesh.dirtyEnd = SIZE_MAX;
+            }
+            auto dirtyEnd = std::min(mesh.dirtyEnd, mesh.indices.size());
+            if (mesh.dirtyBegin < dirtyEnd)
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, mesh.dirtyBegin * sizeof(unsigned int),
+                                (dirtyEnd - mesh.dirtyBegin) * sizeof(unsigned int),
+                                mesh.indices.data() + mesh.dirtyBegin);
+            mesh.dirty = false;
+        }
+        if (!mesh.indices.empty())
+            draw(mesh);
     }
 
     glBindVertexArray(0);
@@ -43,6 +86,30 @@ bool Polygon::modifyIndices(int meshIndex, unsigned int index0, unsigned int ind
     }
 }
 
+void Polygon::clearIndices() {
+    for (int i = 0; i < m_meshes.size(); i++) {
+        m_meshes[i].indices.clear();
+        markDirty(i, 0);
+    }
+}
+
+size_t Polygon::indexCount() const {
+    size_t count = 0;
+    for (auto &mesh : m_meshes)
+        count += mesh.indices.size();
+    return count;
+}
+
+void Polygon::markDirty(int meshIndex, size_t begin, size_t end) {
+    static uint64_t versionCounter = 0;
+    m_version = ++versionCounter;
+
+    auto &mesh = m_meshes[meshIndex];
+    mesh.dirtyBegin = mesh.dirty ? std::min(mesh.dirtyBegin, begin) : begin;
+    mesh.dirtyEnd = mesh.dirty ? std::max(mesh.dirtyEnd, end) : end;
+    mesh.dirty = true;
+}
+
 Polygon::Polygon() {
 
 }
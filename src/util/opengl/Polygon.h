@@ -1,6 +1,7 @@
 #ifndef POLYGON_H
 #define POLYGON_H
 
+#include <cstdint>
 #include <vector>
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -12,25 +13,65 @@ using std::vector;
 class Polygon {
 public:
     struct PolygonMesh {
-        unsigned int vao;
+        unsigned int vao = 0;  // 共享网格的顶点缓冲，使用独立的索引缓冲
+        unsigned int ebo = 0;
+        size_t capacity = 0;  // 索引缓冲容量（索引个数）
+        bool dirty = false;
+        size_t dirtyBegin = 0;  // indices 中 [dirtyBegin, dirtyEnd) 的内容需要重新上传
+        size_t dirtyEnd = 0;
         vector<unsigned int> indices;
         vector<VertexData> vertices;
         MeshInfo meshInfo;
     };
 
+    /// 高亮元素：点为焊接组中第一个顶点的序号，三角形为面序号
+    struct Element {
+        int meshIndex;
+        unsigned int index;
+    };
+
     Polygon();
-    Polygon(const vector<Mesh>& meshes);
+    /// \param headless 无窗口模式，不创建OpenGL对象，只维护索引
+    explicit Polygon(const vector<Mesh>& meshes, bool headless = false);
+    virtual ~Polygon();
 
+    /// 每个网格上传变化的索引后使用一次 glDrawElements 绘制
     void render(float offset, float size = 0.f);
     virtual void addIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) = 0;
     virtual void removeIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) = 0;
     bool modifyIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0);
 
+    /// 批量添加/移除，已存在（不存在）的元素跳过
+    /// \param meshIndex 网格序号
+    /// \param indices 点为顶点序号，三角形为依次排列的三个顶点序号
+    virtual void addIndices(int meshIndex, const vector<unsigned int> &indices) = 0;
+    virtual void removeIndices(int meshIndex, const vector<unsigned int> &indices) = 0;
+
     virtual void resetIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) = 0;
-    virtual std::string getIndicesString() const& = 0;
+    virtual void clearIndices();
+
+    /// 按网格依次输出当前的元素
+    /// \param meshIndex 只输出该网格的元素，-1 表示全部网格
+    virtual void getElements(vector<Element> &elements, int meshIndex = -1) const = 0;
+
+    /// 元素每次变化后递增，所有实例共用一个计数器，重新加载模型后也不会与旧值重复
+    [[nodiscard]] uint64_t version() const { return m_version; }
+    [[nodiscard]] size_t meshCount() const { return m_meshes.size(); }
+    [[nodiscard]] const vector<VertexData> &getVertices(int meshIndex) const { return m_meshes[meshIndex].vertices; }
+    [[nodiscard]] const vector<unsigned int> &getIndices(int meshIndex) const { return m_meshes[meshIndex].indices; }
+
+    /// 所有网格的索引总数
+    [[nodiscard]] size_t indexCount() const;
 
 protected:
+    static constexpr size_t MIN_CAPACITY = 1024;
+
     vector<PolygonMesh> m_meshes;
+    bool m_headless = false;
+    uint64_t m_version = 0;
+
+    /// 标记网格索引 [begin, end) 发生变化，下次绘制时上传，end 缺省表示直到末尾
+    void markDirty(int meshIndex, size_t begin, size_t end = SIZE_MAX);
 
     virtual void draw(const PolygonMesh &mesh) = 0;
     virtual bool in(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) = 0;
@@ -3,47 +3,77 @@
 //
 
 #include "PolygonPoint.h"
-#include <sstream>
 
-PolygonPoint::PolygonPoint(const vector<Mesh>& meshes) : Polygon(meshes) {
+PolygonPoint::PolygonPoint(const vector<Mesh>& meshes, const VertexWeld &weld, bool headless) :
+        Polygon(meshes, headless), m_weld(&weld) {
+    m_groups.resize(weld.groupCount());
+    m_positions.assign(weld.vertexCount(), INVALID_POSITION);
 }
 
 void PolygonPoint::addIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    m_meshes[meshIndex].indices.push_back(index0);
-    auto pos = std::make_tuple(m_meshes[meshIndex].vertices[index0].position.x,
-                               m_meshes[meshIndex].vertices[index0].position.y,
-                               m_meshes[meshIndex].vertices[index0].position.z);
-    m_points.insert({pos, {index0, meshIndex}});
+    auto group = m_weld->group(meshIndex, index0);
+    if (!m_groups.test(group))
+        addGroup(group);
 }
 
 void PolygonPoint::removeIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    // 需要处理相同坐标、不同ID的点
-
-    auto info = getInfo(m_meshes[meshIndex].vertices[index0].position);  // 根据坐标在记录表中查找已绘制的点信息
-    if (info.index != 0xffffffff) {  // 如果找到了
-        // 从indices中删除查找到的点
-        m_meshes[info.meshIndex].indices.erase(
-                std::find(m_meshes[info.meshIndex].indices.begin(), m_meshes[info.meshIndex].indices.end(), info.index));
-        // 从记录表中删除点坐标对应的信息
-        m_points.erase({
-            m_meshes[meshIndex].vertices[index0].position.x,
-            m_meshes[meshIndex].vertices[index0].position.y,
-            m_meshes[meshIndex].vertices[index0].position.z});
+    // 相同坐标、不同ID的点属于同一焊接组，一并删除
+    auto group = m_weld->group(meshIndex, index0);
+    if (m_groups.test(group))
+        removeGroup(group);
+}
+
+void PolygonPoint::addIndices(int meshIndex, const vector<unsigned int> &indices) {
+    for (auto index : indices)
+        addIndices(meshIndex, index);
+}
+
+void PolygonPoint::removeIndices(int meshIndex, const vector<unsigned int> &indices) {
+    for (auto index : indices)
+        removeIndices(meshIndex, index);
+}
+
+void PolygonPoint::addGroup(unsigned int group) {
+    m_groups.set(group);
+    m_pointCount++;
+
+    // 组内所有顶点追加到各自网格的索引末尾
+    auto members = m_weld->members(group);
+    for (unsigned int i = 0; i < m_weld->memberCount(group); i++) {
+        auto &indices = m_meshes[members[i].meshIndex].indices;
+        m_positions[m_weld->globalIndex(members[i].meshIndex, members[i].vertex)] = (unsigned int)indices.size();
+        markDirty(members[i].meshIndex, indices.size());
+        indices.push_back(members[i].vertex);
+    }
+}
+
+void PolygonPoint::removeGroup(unsigned int group) {
+    m_groups.reset(group);
+    m_pointCount--;
+
+    // 用末尾元素填补被删除的位置，只有该位置需要重新上传
+    auto members = m_weld->members(group);
+    for (unsigned int i = 0; i < m_weld->memberCount(group); i++) {
+        auto meshIndex = members[i].meshIndex;
+        auto &indices = m_meshes[meshIndex].indices;
+        auto &position = m_positions[m_weld->globalIndex(meshIndex, members[i].vertex)];
+        auto last = indices.back();
+        indices[position] = last;
+        m_positions[m_weld->globalIndex(meshIndex, last)] = position;
+        markDirty(meshIndex, position, position + 1);
+        indices.pop_back();
+        position = INVALID_POSITION;
     }
 }
 
 void PolygonPoint::draw(const PolygonMesh &mesh) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
-    for(auto& it : mesh.indices)
-        glDrawArrays(GL_POINTS, it, 1);
+    glDrawElements(GL_POINTS, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
 bool PolygonPoint::in(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    auto pointPos = m_meshes[meshIndex].vertices[index0].position;
-    if (getInfo(pointPos).index != 0xffffffff)
-        return true;
-    return false;
+    return m_groups.test(m_weld->group(meshIndex, index0));
 }
 
 PolygonPoint::PolygonPoint() {
@@ -51,48 +81,41 @@ PolygonPoint::PolygonPoint() {
 }
 
 void PolygonPoint::resetIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    for (auto &mesh: m_meshes) {
-        mesh.indices.clear();
-    }
-    m_points.clear();
-
+    clearIndices();
     addIndices(meshIndex, index0, index1, index2);
 }
 
-PolygonPoint::PointInfo PolygonPoint::getInfo(const glm::vec3& pos) const {
-    auto key = std::make_tuple(pos.x, pos.y, pos.z);
-    auto index = m_points.find(key);
-    if (index != m_points.end())
-        return index->second;
-    return {0xffffffff, -1};  // max unsigned int
+void PolygonPoint::clearIndices() {
+    // 只复位已添加的顶点，选择预览每帧都会调用
+    for (int j = 0; j < m_meshes.size(); j++) {
+        for (auto index : m_meshes[j].indices) {
+            m_positions[m_weld->globalIndex(j, index)] = INVALID_POSITION;
+            m_groups.reset(m_weld->group(j, index));
+        }
+    }
+    m_pointCount = 0;
+    Polygon::clearIndices();
 }
 
 bool PolygonPoint::modifyIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    auto pointPos = m_meshes[meshIndex].vertices[index0].position;
-    auto info = getInfo(pointPos);
-    if (info.index != 0xffffffff)  // if the point is in the vector of points
-    {
-        m_meshes[meshIndex].indices.erase(std::find(m_meshes[meshIndex].indices.begin(), m_meshes[meshIndex].indices.end(), info.index));
-        m_points.erase({m_meshes[meshIndex].vertices[index0].position.x, m_meshes[meshIndex].vertices[index0].position.y, m_meshes[meshIndex].vertices[index0].position.z});
+    auto group = m_weld->group(meshIndex, index0);
+    if (m_groups.test(group)) {
+        removeGroup(group);
         return false;
     }
-    else
-    {
-        addIndices(meshIndex, index0, index1, index2);
-        return true;
-    }
+    addGroup(group);
+    return true;
 }
 
-std::string PolygonPoint::getIndicesString() const& {
-    std::stringstream ss;
-    for (auto &mesh: m_meshes) {
-        for (auto &index: mesh.indices) {
-            ss << "Point " << index << ": " <<
-            mesh.vertices[index].position.x << ", " <<
-            mesh.vertices[index].position.y << ", " <<
-            mesh.vertices[index].position.z << std::endl;
+void PolygonPoint::getElements(vector<Element> &elements, int meshIndex) const {
+    for (int j = 0; j < m_meshes.size(); j++) {
+        if (meshIndex != -1 && meshIndex != j)
+            continue;
+        for (auto index : m_meshes[j].indices) {
+            // 每个焊接组只输出第一个顶点
+            auto &first = m_weld->members(m_weld->group(j, index))[0];
+            if (first.meshIndex == j && first.vertex == index)
+                elements.push_back({j, index});
         }
     }
-    return ss.str();
 }
-
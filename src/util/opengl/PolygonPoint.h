@@ -4,38 +4,46 @@
 
 #ifndef POLYGONPOINT_H
 #define POLYGONPOINT_H
-#include <map>
 
 #include "ShaderProgram.h"
 #include "Polygon.h"
+#include "../Bitset.h"
+#include "../VertexWeld.h"
 
 class PolygonPoint : public Polygon {
 public:
     PolygonPoint();
-    PolygonPoint(const vector<Mesh>& meshes);
+    /// \param weld 模型的顶点焊接表，坐标相同的顶点作为同一个点整体添加、删除与绘制
+    PolygonPoint(const vector<Mesh>& meshes, const VertexWeld &weld, bool headless = false);
 
     void addIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) override;
     void removeIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0);
+    void addIndices(int meshIndex, const vector<unsigned int> &indices) override;
+    void removeIndices(int meshIndex, const vector<unsigned int> &indices) override;
 
     bool modifyIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0);
 
     void resetIndices(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) override;
+    void clearIndices() override;
+
+    void getElements(vector<Element> &elements, int meshIndex = -1) const override;
+
+    /// 点（焊接组）的数量
+    [[nodiscard]] size_t pointCount() const { return m_pointCount; }
 
-    [[nodiscard]] std::string getIndicesString() const& override;
 private:
-    struct PointInfo {
-        unsigned int index;
-        int meshIndex;
-    };
+    static constexpr unsigned int INVALID_POSITION = 0xffffffff;
 
     void draw(const PolygonMesh &mesh) override;
     bool in(int meshIndex, unsigned int index0, unsigned int index1 = 0, unsigned int index2 = 0) override;
 
-    [[nodiscard]] PointInfo getInfo(const glm::vec3& pos) const;
+    void addGroup(unsigned int group);
+    void removeGroup(unsigned int group);
 
-    /// key: point position <x, y, z>
-    /// value: point info
-    std::map<std::tuple<float, float, float>, PointInfo> m_points;
+    const VertexWeld *m_weld = nullptr;
+    Bitset m_groups;  // 已添加的焊接组
+    vector<unsigned int> m_positions;  // 全局顶点序号 -> 在所属网格 indices 中的位置
+    size_t m_pointCount = 0;
 };
 
 
@@ -3,39 +3,100 @@
 //
 
 #include "PolygonTriangle.h"
-#include <sstream>
-
-PolygonTriangle::PolygonTriangle(const vector<Mesh>& meshes) : Polygon(meshes) {
+#include <algorithm>
 
+PolygonTriangle::PolygonTriangle(const vector<Mesh>& meshes, const FaceLookup &lookup, bool headless) :
+        Polygon(meshes, headless), m_lookup(&lookup), m_sets(meshes.size()) {
+    for (auto &mesh : meshes)
+        m_faces.push_back(mesh.getFaces().data());
 }
 
 void PolygonTriangle::addIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    m_meshes[meshIndex].indices.push_back(index0);
-    m_meshes[meshIndex].indices.push_back(index1);
-    m_meshes[meshIndex].indices.push_back(index2);
+    auto face = m_lookup->find(meshIndex, index0, index1, index2);
+    if (face != FaceLookup::INVALID_FACE)
+        addFace(meshIndex, face);
 }
 
 void PolygonTriangle::removeIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    for (int i = 0; i < m_meshes[meshIndex].indices.size(); i += 3) {
-        if (m_meshes[meshIndex].indices[i] == index0 && m_meshes[meshIndex].indices[i + 1] == index1 && m_meshes[meshIndex].indices[i + 2] == index2) {
-            m_meshes[meshIndex].indices.erase(m_meshes[meshIndex].indices.begin() + i, m_meshes[meshIndex].indices.begin() + i + 3);
-            break;
-        }
+    auto face = m_lookup->find(meshIndex, index0, index1, index2);
+    if (face != FaceLookup::INVALID_FACE)
+        removeFace(meshIndex, face);
+}
+
+void PolygonTriangle::addIndices(int meshIndex, const vector<unsigned int> &indices) {
+    m_meshes[meshIndex].indices.reserve(m_meshes[meshIndex].indices.size() + indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        addIndices(meshIndex, indices[i], indices[i + 1], indices[i + 2]);
+}
+
+void PolygonTriangle::removeIndices(int meshIndex, const vector<unsigned int> &indices) {
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        removeIndices(meshIndex, indices[i], indices[i + 1], indices[i + 2]);
+}
+
+void PolygonTriangle::addFace(int meshIndex, unsigned int face) {
+    auto &set = m_sets[meshIndex];
+    if (set.slots.empty()) {  // 选择预览只用到一个面，首次添加时才分配
+        auto faceCount = m_lookup->faceCount(meshIndex);
+        set.contains.resize(faceCount);
+        set.slots.assign(faceCount, INVALID_SLOT);
+    }
+    if (set.contains.test(face))
+        return;
+
+    set.contains.set(face);
+    set.slots[face] = (unsigned int)set.faces.size();
+    set.faces.push_back(face);
+
+    auto &indices = m_meshes[meshIndex].indices;
+    markDirty(meshIndex, indices.size());
+    indices.insert(indices.end(), m_faces[meshIndex][face].vertex, m_faces[meshIndex][face].vertex + 3);
+    m_triangleCount++;
+}
+
+void PolygonTriangle::removeFace(int meshIndex, unsigned int face) {
+    if (!containsFace(meshIndex, face))
+        return;
+
+    // 末尾的面移动到被删除的槽位，只需更新该槽位的三个索引
+    auto &set = m_sets[meshIndex];
+    auto &indices = m_meshes[meshIndex].indices;
+    auto slot = set.slots[face];
+    auto last = set.faces.back();
+    set.faces[slot] = last;
+    set.slots[last] = slot;
+    std::copy(indices.end() - 3, indices.end(), indices.begin() + slot * 3);
+    markDirty(meshIndex, slot * 3, slot * 3 + 3);
+
+    set.faces.pop_back();
+    indices.resize(indices.size() - 3);
+    set.slots[face] = INVALID_SLOT;
+    set.contains.reset(face);
+    m_triangleCount--;
+}
+
+bool PolygonTriangle::modifyFace(int meshIndex, unsigned int face) {
+    if (containsFace(meshIndex, face)) {
+        removeFace(meshIndex, face);
+        return false;
     }
+    addFace(meshIndex, face);
+    return true;
+}
+
+bool PolygonTriangle::containsFace(int meshIndex, unsigned int face) const {
+    const auto &set = m_sets[meshIndex];
+    return !set.slots.empty() && set.contains.test(face);
 }
 
 void PolygonTriangle::draw(const PolygonMesh &mesh) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    for (int i = 0; i != mesh.indices.size(); i += 3)
-        glDrawArrays(GL_TRIANGLES, mesh.indices[i], 3);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
 }
 
 bool PolygonTriangle::in(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    for (int i = 0; i < m_meshes[meshIndex].indices.size(); i += 3) {
-        if (m_meshes[meshIndex].indices[i] == index0 && m_meshes[meshIndex].indices[i + 1] == index1 && m_meshes[meshIndex].indices[i + 2] == index2)
-            return true;
-    }
-    return false;
+    auto face = m_lookup->find(meshIndex, index0, index1, index2);
+    return face != FaceLookup::INVALID_FACE && containsFace(meshIndex, face);
 }
 
 PolygonTriangle::PolygonTriangle() {
@@ -43,18 +104,28 @@ PolygonTriangle::PolygonTriangle() {
 }
 
 void PolygonTriangle::resetIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) {
-    for (auto &mesh : m_meshes) {
-        mesh.indices.clear();
-    }
+    clearIndices();
     addIndices(meshIndex, index0, index1, index2);
 }
 
-std::string PolygonTriangle::getIndicesString() const &{
-    std::stringstream ss;
-    for (const auto & mesh : m_meshes) {
-        for (int j = 0; j < mesh.indices.size(); j += 3) {
-            ss << "Triangle (" << mesh.indices[j] << ", " << mesh.indices[j + 1] << ", " << mesh.indices[j + 2] << ") " << std::endl;
+void PolygonTriangle::clearIndices() {
+    // 只复位已添加的面
+    for (auto &set : m_sets) {
+        for (auto face : set.faces) {
+            set.contains.reset(face);
+            set.slots[face] = INVALID_SLOT;
         }
+        set.faces.clear();
+    }
+    m_triangleCount = 0;
+    Polygon::clearIndices();
+}
+
+void PolygonTriangle::getElements(vector<Element> &elements, int meshIndex) const {
+    for (int j = 0; j < m_sets.size(); j++) {
+        if (meshIndex != -1 && meshIndex != j)
+            continue;
+        for (auto face : m_sets[j].faces)
+            elements.push_back({j, face});
     }
-    return ss.str();
 }
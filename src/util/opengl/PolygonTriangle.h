@@ -8,20 +8,52 @@
 
 #include "ShaderProgram.h"
 #include "Polygon.h"
+#include "../Bitset.h"
+#include "../FaceLookup.h"
 
 class PolygonTriangle : public Polygon {
 public:
     PolygonTriangle();
 
-    explicit PolygonTriangle(const vector<Mesh>& meshes);
+    /// \param lookup 模型的面查找表，三角形以面序号记录
+    PolygonTriangle(const vector<Mesh>& meshes, const FaceLookup &lookup, bool headless = false);
     void addIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) override;
     void removeIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) override;
+    void addIndices(int meshIndex, const vector<unsigned int> &indices) override;
+    void removeIndices(int meshIndex, const vector<unsigned int> &indices) override;
     void resetIndices(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) override;
+    void clearIndices() override;
+
+    /// 切换面的状态
+    /// \return 切换后是否包含该面
+    bool modifyFace(int meshIndex, unsigned int face);
+    void addFace(int meshIndex, unsigned int face);
+    void removeFace(int meshIndex, unsigned int face);
+    [[nodiscard]] bool containsFace(int meshIndex, unsigned int face) const;
+
+    void getElements(vector<Element> &elements, int meshIndex = -1) const override;
+
+    [[nodiscard]] const Face &getFace(int meshIndex, unsigned int face) const { return m_faces[meshIndex][face]; }
+
+    [[nodiscard]] size_t triangleCount() const { return m_triangleCount; }
 
-    [[nodiscard]] std::string getIndicesString() const& override;
 private:
+    static constexpr unsigned int INVALID_SLOT = 0xffffffff;
+
+    /// 网格中已添加的面：位集判断是否存在，faces 与 indices 按槽位一一对应，删除时用末尾元素填补
+    struct FaceSet {
+        Bitset contains;
+        vector<unsigned int> slots;  // 面序号 -> 槽位，首次添加时分配
+        vector<unsigned int> faces;  // 槽位 -> 面序号
+    };
+
     void draw(const PolygonMesh &mesh) override;
     bool in(int meshIndex, unsigned int index0, unsigned int index1, unsigned int index2) override;
+
+    const FaceLookup *m_lookup = nullptr;
+    vector<FaceSet> m_sets;
+    vector<const Face *> m_faces;  // 每个网格的面数组
+    size_t m_triangleCount = 0;
 };
 
 
@@ -0,0 +1,136 @@
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace {
+constexpr uint32_t FILE_MAGIC = 0x4353564d;  // "MVSC"
+constexpr uint32_t FILE_VERSION = 1;
+
+/// FNV-1a
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t hashString(uint64_t hash, const string &text) {
+    // 长度一并计入，避免相邻字符串拼接后相同
+    auto size = (uint64_t)text.size();
+    hash = hashBytes(hash, &size, sizeof(size));
+    return hashBytes(hash, text.data(), text.size());
+}
+
+string glString(GLenum name) {
+    auto value = reinterpret_cast<const char *>(glGetString(name));
+    return value ? value : "";
+}
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+}
+
+uint64_t ShaderCache::key(const string *sources, size_t count, const string &defines) {
+    if (m_driverHash == 0) {
+        m_driverHash = 0xcbf29ce484222325ull;
+        m_driverHash = hashString(m_driverHash, glString(GL_VENDOR));
+        m_driverHash = hashString(m_driverHash, glString(GL_RENDERER));
+        m_driverHash = hashString(m_driverHash, glString(GL_VERSION));
+    }
+
+    auto hash = hashString(m_driverHash, defines);
+    for (size_t i = 0; i < count; i++)
+        hash = hashString(hash, sources[i]);
+    return hash;
+}
+
+string ShaderCache::path(uint64_t key) const {
+    std::stringstream ss;
+    ss << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return ss.str();
+}
+
+bool ShaderCache::supported() {
+    if (m_supported < 0) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        m_supported = formats > 0;
+    }
+    return m_supported;
+}
+
+bool ShaderCache::load(GLuint program, uint64_t key) {
+    if (!enabled || !supported())
+        return false;
+    auto file = path(key);
+    std::ifstream fin(file, std::ios_base::binary);
+    if (!fin.is_open())
+        return false;
+
+    Header header{};
+    fin.read(reinterpret_cast<char *>(&header), sizeof(header));
+    std::vector<char> binary;
+    if (fin && header.magic == FILE_MAGIC && header.version == FILE_VERSION && header.key == key) {
+        binary.resize(header.length);
+        fin.read(binary.data(), header.length);
+    }
+    bool complete = fin && !binary.empty();
+    fin.close();
+
+    if (complete) {
+        glProgramBinary(program, header.format, binary.data(), header.length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked) {
+            hits++;
+            return true;
+        }
+    }
+
+    // 文件损坏或驱动不再接受该二进制
+    std::error_code error;
+    std::filesystem::remove(file, error);
+    return false;
+}
+
+void ShaderCache::store(GLuint program, uint64_t key) {
+    if (!enabled || !supported())
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    Header header{FILE_MAGIC, FILE_VERSION, key, 0, 0};
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &header.format, binary.data());
+    if (written <= 0)
+        return;
+    header.length = (uint32_t)written;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::ofstream fout(path(key), std::ios_base::binary);
+    if (!fout.is_open())
+        return;
+    fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fout.write(binary.data(), written);
+}
+
+void ShaderCache::clear() {
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+}
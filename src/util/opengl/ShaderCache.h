@@ -0,0 +1,54 @@
+#ifndef MODEL_VIEWER_SHADERCACHE_H
+#define MODEL_VIEWER_SHADERCACHE_H
+
+#include <cstdint>
+#include <string>
+#include "glad/glad.h"
+
+using std::string;
+
+/// 程序二进制（glGetProgramBinary）的磁盘缓存
+/// 键由各阶段源码、宏定义与驱动信息（厂商、渲染器、版本）的哈希组成，
+/// 源码修改或驱动更新后键随之改变，程序回退到从源码编译
+class ShaderCache {
+public:
+    static ShaderCache &get() {
+        static ShaderCache instance;
+        return instance;
+    }
+
+    ShaderCache(ShaderCache const &) = delete;
+    void operator=(ShaderCache const &) = delete;
+
+    /// \param sources 各阶段源码（已插入宏定义），空字符串表示没有该阶段
+    [[nodiscard]] uint64_t key(const string *sources, size_t count, const string &defines);
+
+    /// 读取缓存的二进制并载入 program
+    /// \return 是否成功，驱动拒绝二进制时删除该文件
+    bool load(GLuint program, uint64_t key);
+    /// 保存已链接程序的二进制，需在链接前设置 GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    void store(GLuint program, uint64_t key);
+
+    /// 删除所有缓存文件，下次启动为冷启动
+    void clear();
+
+    [[nodiscard]] string path(uint64_t key) const;
+
+    bool enabled = true;
+    string directory = "shader_cache";
+
+    size_t hits = 0;  // 从缓存载入的程序数
+    size_t misses = 0;  // 从源码编译的程序数
+
+private:
+    ShaderCache() = default;
+
+    /// 驱动不支持任何二进制格式时缓存不可用
+    [[nodiscard]] bool supported();
+
+    uint64_t m_driverHash = 0;
+    int m_supported = -1;  // -1 表示尚未查询
+};
+
+
+#endif //MODEL_VIEWER_SHADERCACHE_H
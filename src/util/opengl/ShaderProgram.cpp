@@ -1,4 +1,6 @@
 #include "ShaderProgram.h"
+#include "ShaderCache.h"
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -44,12 +46,15 @@ void ShaderProgram::use() const
     glUseProgram(m_programId);
 }
 
-void ShaderProgram::use(const glm::mat4 model, const glm::mat4 view, const glm::mat4 projection)
+void ShaderProgram::use(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection)
 {
     glUseProgram(m_programId);
-    setValue("model", model);
-    setValue("view", view);
-    setValue("projection", projection);
+    if (m_modelIndex >= 0)
+        upload(m_modelIndex, &model[0][0], 1);
+    if (m_viewIndex >= 0)
+        upload(m_viewIndex, &view[0][0], 1);
+    if (m_projectionIndex >= 0)
+        upload(m_projectionIndex, &projection[0][0], 1);
 }
 
 bool ShaderProgram::link()
@@ -59,53 +64,335 @@ bool ShaderProgram::link()
     GLint linked;
     GLchar infoLog[512];
     glGetProgramiv(m_programId, GL_LINK_STATUS, &linked);
+    m_linked = linked;
     if (!linked)
     {
         glGetProgramInfoLog(m_programId, sizeof(infoLog), nullptr, infoLog);
         m_lastError = "Shader Program Linking Error :" + string(infoLog);
         return false;
     }
-    else return true;
+    reflect();
+    return true;
 }
 
-void ShaderProgram::setValue(const string &name, int value) const
+void ShaderProgram::enableParallelCompile()
 {
-    glUniform1i(glGetUniformLocation(m_programId, name.c_str()), value);
+    if (GLAD_GL_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xffffffff);
+    else if (GLAD_GL_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xffffffff);
 }
 
-void ShaderProgram::setValue(const string &name, float value) const
+void ShaderProgram::loadAsync(const string &vertex_path, const string &fragment_path, const string &geometry_path,
+                              const string &defines)
 {
-    glUniform1f(glGetUniformLocation(m_programId, name.c_str()), value);
+    if (m_programId)
+        glDeleteProgram(m_programId);
+    m_programId = glCreateProgram();
+    m_pending = false;
+    m_linked = false;
+    m_fromCache = false;
+
+    string sources[3];
+    const ShaderType types[3] = {Vertex, Fragment, Geometry};
+    const string *paths[3] = {&vertex_path, &fragment_path, &geometry_path};
+    for (int i = 0; i < 3; i++)
+    {
+        if (!paths[i]->empty() && readShaderFile(*paths[i], sources[i]))
+            sources[i] = insertDefines(sources[i], defines);
+    }
+
+    auto &cache = ShaderCache::get();
+    m_cacheKey = cache.key(sources, 3, defines);
+    if (cache.load(m_programId, m_cacheKey))
+    {
+        m_linked = true;
+        m_fromCache = true;
+        reflect();
+        return;
+    }
+    cache.misses++;
+
+    // 编译与链接的结果在 finish 中查询，查询之前驱动可以在后台线程完成编译
+    glProgramParameteri(m_programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    for (int i = 0; i < 3; i++)
+    {
+        if (sources[i].empty())
+            continue;
+        GLuint shader = glCreateShader((GLenum)types[i]);
+        const GLchar *shaderSource = sources[i].c_str();
+        glShaderSource(shader, 1, &shaderSource, nullptr);
+        glCompileShader(shader);
+        glAttachShader(m_programId, shader);
+        glDeleteShader(shader);  // 附加在程序上，链接失败时仍可读取日志
+    }
+    glLinkProgram(m_programId);
+    m_pending = true;
 }
 
-void ShaderProgram::setValue(const string &name, const glm::vec2 &value) const
+bool ShaderProgram::ready() const
 {
-    glUniform2fv(glGetUniformLocation(m_programId, name.c_str()), 1, &value[0]);
+    if (!m_pending || !(GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile))
+        return true;
+    GLint completed = GL_FALSE;
+    glGetProgramiv(m_programId, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed;
 }
 
-void ShaderProgram::setValue(const string &name, const glm::vec3 &value) const
+bool ShaderProgram::finish()
 {
-    glUniform3fv(glGetUniformLocation(m_programId, name.c_str()), 1, &value[0]);
+    if (!m_pending)
+        return m_linked;
+    m_pending = false;
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_programId, GL_LINK_STATUS, &linked);
+    m_linked = linked;
+    if (!linked)
+    {
+        collectShaderLogs();
+        std::cerr << m_lastError << std::endl;
+        return false;
+    }
+
+    reflect();
+    ShaderCache::get().store(m_programId, m_cacheKey);
+    return true;
 }
 
-void ShaderProgram::setValue(const string &name, const glm::vec4 &value) const
+void ShaderProgram::collectShaderLogs()
 {
-    glUniform4fv(glGetUniformLocation(m_programId, name.c_str()), 1, &value[0]);
+    GLchar infoLog[512];
+    GLuint shaders[3];
+    GLsizei count = 0;
+    glGetAttachedShaders(m_programId, 3, &count, shaders);
+    m_lastError.clear();
+    for (GLsizei i = 0; i < count; i++)
+    {
+        GLint success = GL_TRUE, type = 0;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+        if (success)
+            continue;
+        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+        glGetShaderInfoLog(shaders[i], sizeof(infoLog), nullptr, infoLog);
+        if (type == Vertex)
+            m_lastError += "Compile Vertex Shader Error :" + string(infoLog);
+        else if (type == Fragment)
+            m_lastError += "Compile Fragment Shader Error :" + string(infoLog);
+        else if (type == Geometry)
+            m_lastError += "Compile Geometry Shader Error :" + string(infoLog);
+    }
+    if (m_lastError.empty())
+    {
+        glGetProgramInfoLog(m_programId, sizeof(infoLog), nullptr, infoLog);
+        m_lastError = "Shader Program Linking Error :" + string(infoLog);
+    }
 }
 
-void ShaderProgram::setValue(const string &name, const glm::mat2 &value) const
+string ShaderProgram::insertDefines(const string &source, const string &defines)
 {
-    glUniformMatrix2fv(glGetUniformLocation(m_programId, name.c_str()), 1, GL_FALSE, &value[0][0]);
+    if (defines.empty())
+        return source;
+    size_t position = 0;
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        position = source.find('\n');
+        position = position == string::npos ? source.size() : position + 1;
+    }
+    auto result = source.substr(0, position);
+    if (!result.empty() && result.back() != '\n')
+        result += '\n';
+    result += defines;
+    if (defines.back() != '\n')
+        result += '\n';
+    result += source.substr(position);
+    return result;
+}
+
+ShaderProgram::UniformStats ShaderProgram::stats;
+ShaderProgram::UniformStats ShaderProgram::lastStats;
+bool ShaderProgram::filterRedundant = true;
+
+void ShaderProgram::resetStats()
+{
+    lastStats = stats;
+    stats = UniformStats();
+}
+
+/// uniform 类型的分量数，返回 0 表示不支持
+static unsigned int componentCount(GLenum type, bool &isFloat)
+{
+    isFloat = true;
+    switch (type)
+    {
+        case GL_FLOAT: return 1;
+        case GL_FLOAT_VEC2: return 2;
+        case GL_FLOAT_VEC3: return 3;
+        case GL_FLOAT_VEC4: return 4;
+        case GL_FLOAT_MAT2: return 4;
+        case GL_FLOAT_MAT3: return 9;
+        case GL_FLOAT_MAT4: return 16;
+        default: break;
+    }
+    isFloat = false;
+    switch (type)
+    {
+        case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: return 4;
+        case GL_DOUBLE: case GL_UNSIGNED_INT: return 0;
+        default: return 1;  // int、bool 与各种采样器
+    }
 }
 
-void ShaderProgram::setValue(const string &name, const glm::mat3 &value) const
+void ShaderProgram::reflect()
 {
-    glUniformMatrix3fv(glGetUniformLocation(m_programId, name.c_str()), 1, GL_FALSE, &value[0][0]);
+    static unsigned int generationCounter = 0;
+    m_generation = ++generationCounter;
+    m_uniforms.clear();
+    m_uniformIndices.clear();
+    m_values.clear();
+
+    GLint count = 0, maxNameLength = 0;
+    glGetProgramInterfaceiv(m_programId, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(m_programId, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+    std::vector<GLchar> buffer(std::max(maxNameLength, 1));
+    const GLenum properties[] = {GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+    for (GLint i = 0; i < count; i++)
+    {
+        GLint values[4];
+        glGetProgramResourceiv(m_programId, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+        if (values[0] != -1 || values[1] < 0)  // uniform 块中的成员没有位置
+            continue;
+        glGetProgramResourceName(m_programId, GL_UNIFORM, i, maxNameLength, nullptr, buffer.data());
+        string name(buffer.data());
+        bool isFloat;
+        auto words = componentCount(values[2], isFloat);
+        if (words == 0)
+            continue;
+
+        // 数组 a[0] 展开为 a[0]...a[n-1]，a 指向第一个元素
+        auto arraySize = std::max(values[3], 1);
+        auto arrayName = name;
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            arrayName = name.substr(0, name.size() - 3);
+            m_uniformIndices.emplace(arrayName, (int)m_uniforms.size());
+        }
+        for (GLint k = 0; k < arraySize; k++)
+        {
+            auto elementName = arraySize > 1 ? arrayName + "[" + std::to_string(k) + "]" : name;
+            m_uniformIndices.emplace(elementName, (int)m_uniforms.size());
+            m_uniforms.push_back({values[1] + k, (GLenum)values[2], (unsigned int)m_values.size(), words,
+                                  (unsigned int)(arraySize - k), false});
+            m_values.resize(m_values.size() + words);
+        }
+    }
+
+    m_modelIndex = find("model");
+    m_viewIndex = find("view");
+    m_projectionIndex = find("projection");
 }
 
-void ShaderProgram::setValue(const string &name, const glm::mat4 &value) const
+int ShaderProgram::find(std::string_view name) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_programId, name.c_str()), 1, GL_FALSE, &value[0][0]);
+    auto it = m_uniformIndices.find(name);
+    return it == m_uniformIndices.end() ? -1 : it->second;
+}
+
+bool ShaderProgram::compatible(GLenum type, GLenum valueType, unsigned int words)
+{
+    bool isFloat;
+    auto count = componentCount(type, isFloat);
+    return count == words && isFloat == (valueType == GL_FLOAT);
+}
+
+void ShaderProgram::upload(int index, const void *data, int count)
+{
+    const auto &uniform = m_uniforms[index];
+    count = std::min(count, (int)uniform.remaining);
+    auto size = uniform.words * count * sizeof(uint32_t);
+    auto cache = &m_values[uniform.offset];
+
+    // 程序对象保存 uniform 的值，与上次上传的值相同时不需要再调用
+    auto cached = true;
+    for (int i = 0; i < count; i++)
+        cached = cached && m_uniforms[index + i].cached;
+    if (filterRedundant && cached && std::memcmp(cache, data, size) == 0)
+    {
+        stats.skipped++;
+        return;
+    }
+    std::memcpy(cache, data, size);
+    for (int i = 0; i < count; i++)
+        m_uniforms[index + i].cached = true;
+    stats.uploads++;
+
+    auto floats = static_cast<const GLfloat *>(data);
+    auto ints = static_cast<const GLint *>(data);
+    switch (uniform.type)
+    {
+        case GL_FLOAT: glUniform1fv(uniform.location, count, floats); break;
+        case GL_FLOAT_VEC2: glUniform2fv(uniform.location, count, floats); break;
+        case GL_FLOAT_VEC3: glUniform3fv(uniform.location, count, floats); break;
+        case GL_FLOAT_VEC4: glUniform4fv(uniform.location, count, floats); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(uniform.location, count, GL_FALSE, floats); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(uniform.location, count, GL_FALSE, floats); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(uniform.location, count, GL_FALSE, floats); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(uniform.location, count, ints); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(uniform.location, count, ints); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(uniform.location, count, ints); break;
+        default: glUniform1iv(uniform.location, count, ints); break;
+    }
+}
+
+void ShaderProgram::setByName(std::string_view name, GLenum valueType, const void *data, unsigned int words)
+{
+    stats.lookups++;
+    auto index = find(name);
+    if (index < 0 || !compatible(m_uniforms[index].type, valueType, words))
+        return;
+    upload(index, data, 1);
+}
+
+void ShaderProgram::setValue(std::string_view name, int value)
+{
+    setByName(name, GL_INT, &value, 1);
+}
+
+void ShaderProgram::setValue(std::string_view name, float value)
+{
+    setByName(name, GL_FLOAT, &value, 1);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::vec2 &value)
+{
+    setByName(name, GL_FLOAT, &value[0], 2);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::vec3 &value)
+{
+    setByName(name, GL_FLOAT, &value[0], 3);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::vec4 &value)
+{
+    setByName(name, GL_FLOAT, &value[0], 4);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::mat2 &value)
+{
+    setByName(name, GL_FLOAT, &value[0][0], 4);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::mat3 &value)
+{
+    setByName(name, GL_FLOAT, &value[0][0], 9);
+}
+
+void ShaderProgram::setValue(std::string_view name, const glm::mat4 &value)
+{
+    setByName(name, GL_FLOAT, &value[0][0], 16);
 }
 
 GLuint ShaderProgram::compileShader(ShaderType type, const string &source)
@@ -138,42 +425,51 @@ GLuint ShaderProgram::compileShader(ShaderType type, const string &source)
 }
 
 GLuint ShaderProgram::compileShaderFile(ShaderType type, const string &filename)
+{
+    string source;
+    readShaderFile(filename, source);
+    return compileShader(type, source);
+}
+
+bool ShaderProgram::readShaderFile(const string &filename, string &source)
 {
     std::ifstream fin;
     fin.open(filename, std::ios_base::in);
     if (!fin.is_open())
+    {
         m_lastError = "Shader File " + filename + " Open Failed!";
+        return false;
+    }
     std::stringstream buffer;
     buffer << fin.rdbuf();
-    string source(buffer.str());
+    source = buffer.str();
+    fin.close();
     if (source.empty())
+    {
         m_lastError = "Shader File " + filename + " is Empty!";
-    fin.close();
-
-    return compileShader(type, source);
+        return false;
+    }
+    return true;
 }
 
 ShaderProgram::ShaderProgram(const string& vertex_path, const string& fragment_path, const string& geometry_path) {
     load(vertex_path, fragment_path, geometry_path);
 }
 
-void ShaderProgram::setValue(const string &name, float x, float y) {
-    glUniform2f(glGetUniformLocation(m_programId, name.c_str()), x, y);
+void ShaderProgram::setValue(std::string_view name, float x, float y) {
+    setValue(name, glm::vec2(x, y));
 }
 
-void ShaderProgram::setValue(const string &name, float x, float y, float z) {
-    glUniform3f(glGetUniformLocation(m_programId, name.c_str()), x, y, z);
+void ShaderProgram::setValue(std::string_view name, float x, float y, float z) {
+    setValue(name, glm::vec3(x, y, z));
 }
 
-void ShaderProgram::setValue(const string &name, float x, float y, float z, float w) {
-    glUniform4f(glGetUniformLocation(m_programId, name.c_str()), x, y, z, w);
+void ShaderProgram::setValue(std::string_view name, float x, float y, float z, float w) {
+    setValue(name, glm::vec4(x, y, z, w));
 }
 
-void ShaderProgram::load(const string &vertex_path, const string &fragment_path, const string &geometry_path) {
-    m_programId = glCreateProgram();
-    addShaderFile(Vertex, vertex_path);
-    addShaderFile(Fragment, fragment_path);
-    if (!geometry_path.empty())
-        addShaderFile(Geometry, geometry_path);
-    link();
+void ShaderProgram::load(const string &vertex_path, const string &fragment_path, const string &geometry_path,
+                         const string &defines) {
+    loadAsync(vertex_path, fragment_path, geometry_path, defines);
+    finish();
 }
@@ -1,10 +1,40 @@
 #ifndef SHADERPROGRAM_H
 #define SHADERPROGRAM_H
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include "glad/glad.h"
 #include "glm/matrix.hpp"
 
 using std::string;
+
+class ShaderProgram;
+
+/// 链接后解析一次的 uniform，设置时不再按名称查找
+/// 程序重新链接后需要重新获取
+template<typename T>
+class UniformHandle
+{
+public:
+    UniformHandle() = default;
+
+    [[nodiscard]] bool valid() const { return m_program != nullptr; }
+
+    void set(const T &value) const;
+    /// 从该元素开始连续设置 count 个数组元素
+    void set(const T *values, int count) const;
+
+private:
+    friend class ShaderProgram;
+    UniformHandle(ShaderProgram *program, int index) : m_program(program), m_index(index) { }
+
+    ShaderProgram *m_program = nullptr;
+    int m_index = -1;
+};
+
 class ShaderProgram
 {
 public:
@@ -20,35 +50,158 @@ public:
     ShaderProgram(const string& vertex_path, const string& fragment_path, const string& geometry_path = "");
     ~ShaderProgram();
 
+    /// 所有程序的 uniform 设置次数，每帧开始时清零
+    struct UniformStats {
+        size_t uploads = 0;  // 实际调用 glUniform* 的次数
+        size_t skipped = 0;  // 与上次的值相同而跳过的次数
+        size_t lookups = 0;  // 按名称设置的次数
+    };
+    static UniformStats stats;
+    static UniformStats lastStats;  // 上一帧的统计
+    static void resetStats();
+
+    /// 跳过与上次相同的值，关闭后每次都上传，用于对比
+    static bool filterRedundant;
+
     GLuint programId() const { return m_programId; }
     string lastError() const { return m_lastError; }
 
     bool addShader(ShaderType type, const string &source);
     bool addShaderFile(ShaderType type, const string &filename);
 
-    void load(const string& vertex_path, const string& fragment_path, const string& geometry_path = "");
+    /// 加载并等待链接完成，相当于 loadAsync 之后 finish
+    /// \param defines 插入到 #version 之后的宏定义，如 "#define SHADOW\n"
+    void load(const string& vertex_path, const string& fragment_path, const string& geometry_path = "",
+              const string &defines = "");
+    /// 只提交编译与链接，不查询结果，多个程序可以由驱动并行编译
+    /// 程序二进制缓存命中时直接载入
+    void loadAsync(const string& vertex_path, const string& fragment_path, const string& geometry_path = "",
+                   const string &defines = "");
+    /// 编译与链接是否已完成，不阻塞，驱动不支持 GL_KHR_parallel_shader_compile 时总是返回 true
+    [[nodiscard]] bool ready() const;
+    /// 等待链接完成并检查结果，成功后建立 uniform 表，从源码编译的程序写入缓存
+    bool finish();
+
+    [[nodiscard]] bool linked() const { return m_linked; }
+    [[nodiscard]] bool fromCache() const { return m_fromCache; }
+
+    /// 允许驱动使用尽可能多的线程编译着色器，在提交编译前调用
+    static void enableParallelCompile();
 
     void use() const;
-    void use(const glm::mat4 model, const glm::mat4 view, const glm::mat4 projection);
+    void use(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection);
     bool link();
-    void setValue(const string &name, int value) const;
-    void setValue(const string &name, float value) const;
-    void setValue(const string &name, float x, float y);
-    void setValue(const string &name, float x, float y, float z);
-    void setValue(const string &name, float x, float y, float z, float w);
-    void setValue(const string &name, const glm::vec2 &value) const;
-    void setValue(const string &name, const glm::vec3 &value) const;
-    void setValue(const string &name, const glm::vec4 &value) const;
-    void setValue(const string &name, const glm::mat2 &value) const;
-    void setValue(const string &name, const glm::mat3 &value) const;
-    void setValue(const string &name, const glm::mat4 &value) const;
+
+    /// 获取 uniform 句柄，不存在或类型不匹配时返回无效句柄
+    template<typename T>
+    UniformHandle<T> uniform(std::string_view name);
+
+    /// 按名称设置，在链接后建立的表中查找，不调用 glGetUniformLocation
+    /// 与 glUniform* 相同，调用前需要 use()
+    void setValue(std::string_view name, int value);
+    void setValue(std::string_view name, float value);
+    void setValue(std::string_view name, float x, float y);
+    void setValue(std::string_view name, float x, float y, float z);
+    void setValue(std::string_view name, float x, float y, float z, float w);
+    void setValue(std::string_view name, const glm::vec2 &value);
+    void setValue(std::string_view name, const glm::vec3 &value);
+    void setValue(std::string_view name, const glm::vec4 &value);
+    void setValue(std::string_view name, const glm::mat2 &value);
+    void setValue(std::string_view name, const glm::mat3 &value);
+    void setValue(std::string_view name, const glm::mat4 &value);
+
+    /// 每次链接成功后递增，所有程序共用，句柄的持有者据此判断是否需要重新获取
+    [[nodiscard]] unsigned int generation() const { return m_generation; }
 
 private:
+    template<typename T> friend class UniformHandle;
+
+    struct Uniform {
+        GLint location;
+        GLenum type;
+        unsigned int offset;  // 在 m_values 中的位置，数组的每个元素单独占用
+        unsigned int words;  // 每个元素的分量数
+        unsigned int remaining;  // 数组中从该元素到末尾的元素个数
+        bool cached;
+    };
+
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
     GLuint compileShader(ShaderType type, const string &source);
     GLuint compileShaderFile(ShaderType type, const string &filename);
+    bool readShaderFile(const string &filename, string &source);
+    /// 宏定义插入到 #version 行之后
+    static string insertDefines(const string &source, const string &defines);
+    /// 链接失败时取回各阶段的编译日志
+    void collectShaderLogs();
+
+    /// 通过 glGetProgramInterfaceiv 枚举所有 uniform，建立名称到位置、类型的表
+    void reflect();
+    [[nodiscard]] int find(std::string_view name) const;
+    static bool compatible(GLenum type, GLenum valueType, unsigned int words);
+    /// data 为 count 个元素的分量（int 或 float），与缓存相同时跳过
+    void upload(int index, const void *data, int count);
+    void setByName(std::string_view name, GLenum valueType, const void *data, unsigned int words);
 
     string m_lastError;
-    GLuint m_programId;
+    GLuint m_programId = 0;
+    bool m_pending = false;  // 已提交链接，尚未检查结果
+    bool m_linked = false;
+    bool m_fromCache = false;
+    uint64_t m_cacheKey = 0;
+    unsigned int m_generation = 0;
+    std::vector<Uniform> m_uniforms;
+    std::unordered_map<string, int, NameHash, std::equal_to<>> m_uniformIndices;
+    std::vector<uint32_t> m_values;
+    int m_modelIndex = -1, m_viewIndex = -1, m_projectionIndex = -1;
 };
 
+/// C++ 类型对应的分量类型与分量数
+template<typename T> struct UniformTraits;
+template<> struct UniformTraits<int> { static constexpr GLenum type = GL_INT; static constexpr unsigned int words = 1; };
+template<> struct UniformTraits<bool> { static constexpr GLenum type = GL_BOOL; static constexpr unsigned int words = 1; };
+template<> struct UniformTraits<float> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 1; };
+template<> struct UniformTraits<glm::vec2> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 2; };
+template<> struct UniformTraits<glm::vec3> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 3; };
+template<> struct UniformTraits<glm::vec4> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 4; };
+template<> struct UniformTraits<glm::mat2> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 4; };
+template<> struct UniformTraits<glm::mat3> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 9; };
+template<> struct UniformTraits<glm::mat4> { static constexpr GLenum type = GL_FLOAT; static constexpr unsigned int words = 16; };
+
+template<typename T>
+UniformHandle<T> ShaderProgram::uniform(std::string_view name)
+{
+    auto index = find(name);
+    if (index < 0 || !compatible(m_uniforms[index].type, UniformTraits<T>::type, UniformTraits<T>::words))
+        return {};
+    return {this, index};
+}
+
+template<typename T>
+void UniformHandle<T>::set(const T &value) const
+{
+    set(&value, 1);
+}
+
+template<typename T>
+void UniformHandle<T>::set(const T *values, int count) const
+{
+    if (!m_program)
+        return;
+    if constexpr (std::is_same_v<T, bool>) {
+        // GLSL 的 bool 以 int 上传
+        int converted[32];
+        count = std::min(count, 32);
+        for (int i = 0; i < count; i++)
+            converted[i] = values[i];
+        m_program->upload(m_index, converted, count);
+    }
+    else {
+        m_program->upload(m_index, values, count);
+    }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "ShaderVariants.h"
+
+#include <iostream>
+#include <sstream>
+
+uint64_t ShaderPermutation::key() const {
+    return (uint64_t)(dirLights & 0xff) |
+           (uint64_t)(pointLights & 0xff) << 8 |
+           (uint64_t)(spotLights & 0xff) << 16 |
+           (uint64_t)texture << 24 |
+           (uint64_t)((shadowLight + 1) & 0xff) << 32 |
+           (uint64_t)atlas << 40 |
+           (uint64_t)clustered << 41 |
+           (uint64_t)deferred << 42 |
+           (uint64_t)wireframe << 43 |
+           (uint64_t)(oit & 0x3) << 44;
+}
+
+string ShaderPermutation::defines() const {
+    std::stringstream ss;
+    ss << "#define PERMUTATION\n"
+       << "#define DIR_LIGHT_COUNT " << dirLights << "\n"
+       << "#define POINT_LIGHT_COUNT " << pointLights << "\n"
+       << "#define SPOT_LIGHT_COUNT " << spotLights << "\n"
+       << "#define HAS_TEXTURE " << (texture ? 1 : 0) << "\n"
+       << "#define SHADOW_LIGHT " << shadowLight << "\n"
+       << "#define ATLAS_SHADOWS " << (atlas ? 1 : 0) << "\n"
+       << "#define CLUSTERED " << (clustered ? 1 : 0) << "\n";
+    if (deferred)
+        ss << "#define DEFERRED\n";
+    if (wireframe)
+        ss << "#define WIREFRAME\n";
+    if (oit == OIT_WEIGHTED_MODE)
+        ss << "#define OIT_WEIGHTED\n";
+    else if (oit == OIT_LINKED_MODE)
+        ss << "#define OIT_LINKED\n";
+    return ss.str();
+}
+
+ShaderVariants::ShaderVariants(string vertexPath, string fragmentPath, string wireframePath) :
+        m_vertexPath(std::move(vertexPath)), m_fragmentPath(std::move(fragmentPath)),
+        m_wireframePath(std::move(wireframePath)) {
+}
+
+ShaderVariants::Variant &ShaderVariants::submit(const ShaderPermutation &permutation) {
+    auto &variant = m_variants[permutation.key()];
+    if (!variant.program) {
+        variant.program = std::make_unique<ShaderProgram>();
+        variant.program->loadAsync(m_vertexPath, m_fragmentPath, permutation.wireframe ? m_wireframePath : "",
+                                   permutation.defines());
+    }
+    return variant;
+}
+
+ShaderProgram *ShaderVariants::find(const ShaderPermutation &permutation) {
+    auto &variant = submit(permutation);
+    if (!variant.finished) {
+        if (!variant.program->ready())
+            return nullptr;
+        variant.linked = variant.program->finish();
+        variant.finished = true;
+        if (!variant.linked)
+            std::cerr << "shader variant " << std::hex << permutation.key() << std::dec << ": "
+                      << variant.program->lastError() << std::endl;
+    }
+    return variant.linked ? variant.program.get() : nullptr;
+}
+
+ShaderProgram *ShaderVariants::get(const ShaderPermutation &permutation) {
+    auto &variant = submit(permutation);
+    if (!variant.finished) {
+        variant.linked = variant.program->finish();
+        variant.finished = true;
+    }
+    return variant.linked ? variant.program.get() : nullptr;
+}
+
+void ShaderVariants::clear() {
+    m_variants.clear();
+}
+
+size_t ShaderVariants::pending() const {
+    size_t count = 0;
+    for (auto &it : m_variants)
+        count += !it.second.finished;
+    return count;
+}
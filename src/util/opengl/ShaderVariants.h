@@ -0,0 +1,63 @@
+#ifndef MODEL_VIEWER_SHADERVARIANTS_H
+#define MODEL_VIEWER_SHADERVARIANTS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "ShaderProgram.h"
+
+/// model_fragment.glsl 的特化参数，对应着色器中 PERMUTATION 分支使用的宏
+struct ShaderPermutation {
+    int dirLights = 0;
+    int pointLights = 0;
+    int spotLights = 0;
+    bool texture = false;
+    int shadowLight = -1;  // 投射阴影的灯光在灯光缓冲中的位置，-1 表示没有阴影
+    bool atlas = false;  // 所有灯光从阴影图集取阴影，此时 shadowLight 为 -1
+    bool clustered = false;  // 点光与聚光从分块的灯光列表读取，此时 pointLights 与 spotLights 不使用
+    bool deferred = false;  // 延迟渲染的光照阶段，材质从 G-buffer 读取，此时 texture 不使用
+    bool wireframe = false;  // 填充时同时画出三角形的边，需要 ShaderVariants 提供几何着色器
+    int oit = 0;  // 透明网格的输出方式：0 为不透明，OIT_WEIGHTED_MODE 为加权混合，OIT_LINKED_MODE 为逐像素链表
+
+    static constexpr int OIT_WEIGHTED_MODE = 1;
+    static constexpr int OIT_LINKED_MODE = 2;
+
+    [[nodiscard]] uint64_t key() const;
+    [[nodiscard]] string defines() const;
+};
+
+/// 同一组源码按宏定义特化的程序，以特化参数为键缓存
+/// 首次使用某个组合时提交编译（优先从程序二进制缓存载入），完成之前 find 返回空，调用者使用通用版本
+class ShaderVariants {
+public:
+    /// \param wireframePath wireframe 为 true 的变体附加的几何着色器
+    ShaderVariants(string vertexPath, string fragmentPath, string wireframePath = "");
+
+    /// 已完成链接的变体，尚未编译时提交编译并返回 nullptr，编译失败时同样返回 nullptr
+    ShaderProgram *find(const ShaderPermutation &permutation);
+    /// 等待编译完成，用于基准测试
+    ShaderProgram *get(const ShaderPermutation &permutation);
+
+    void clear();
+
+    [[nodiscard]] size_t size() const { return m_variants.size(); }
+    [[nodiscard]] size_t pending() const;
+
+private:
+    struct Variant {
+        std::unique_ptr<ShaderProgram> program;
+        bool finished = false;
+        bool linked = false;
+    };
+
+    Variant &submit(const ShaderPermutation &permutation);
+
+    string m_vertexPath;
+    string m_fragmentPath;
+    string m_wireframePath;
+    std::unordered_map<uint64_t, Variant> m_variants;
+};
+
+
+#endif //MODEL_VIEWER_SHADERVARIANTS_H
@@ -0,0 +1,353 @@
+#include "ShadowAtlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    constexpr float NEAR_PLANE = 0.05f;
+    constexpr float DIRECTIONAL_WEIGHT = 4.f;  // 平行光的级联覆盖整个画面，优先于其它灯光
+    constexpr float CASCADE_LAMBDA = 0.7f;  // 级联划分中对数划分的比重
+
+    glm::vec3 safeNormalize(const glm::vec3 &v, const glm::vec3 &fallback) {
+        auto length = glm::length(v);
+        return length > 1e-6f ? v / length : fallback;
+    }
+
+    glm::vec3 upVector(const glm::vec3 &direction) {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+    }
+
+    /// Z 序编号 -> 二维坐标
+    unsigned int compact(unsigned int v) {
+        v &= 0x55555555;
+        v = (v | (v >> 1)) & 0x33333333;
+        v = (v | (v >> 2)) & 0x0f0f0f0f;
+        v = (v | (v >> 4)) & 0x00ff00ff;
+        v = (v | (v >> 8)) & 0x0000ffff;
+        return v;
+    }
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    release();
+}
+
+unsigned int ShadowAtlas::fit(size_t budget) {
+    auto resolution = MAX_RESOLUTION;
+    while (resolution > MIN_RESOLUTION && (size_t)resolution * resolution * 4 > budget)
+        resolution /= 2;
+    return resolution;
+}
+
+bool ShadowAtlas::allocate(unsigned int resolution) {
+    if (valid() && m_resolution == resolution)
+        return false;
+
+    if (!valid()) {
+        glGenTextures(1, &m_texture);
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        // 硬件比较并双线性过滤，着色器中每次采样即为 2x2 的百分比渐近过滤
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glGenFramebuffers(1, &m_framebuffer);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, (GLsizei)resolution, (GLsizei)resolution, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_resolution = resolution;
+    m_tiles.clear();
+    allocations++;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
+
+void ShadowAtlas::release() {
+    if (!valid())
+        return;
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_texture);
+    m_framebuffer = m_texture = 0;
+    m_resolution = 0;
+    m_tiles.clear();
+}
+
+float ShadowAtlas::importance(const Light &light, const glm::vec3 &viewPos) {
+    auto luminance = glm::dot(light.color, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * light.diffuseX;
+    if (light.type == DIRECTIONAL_LIGHT)
+        return luminance * DIRECTIONAL_WEIGHT;
+    auto d = glm::distance(light.position, viewPos);
+    return luminance / (light.constant + light.linear * d + light.quadratic * d * d);
+}
+
+int ShadowAtlas::tileCount(LightType type) {
+    switch (type) {
+        case DIRECTIONAL_LIGHT:
+            return CASCADES;
+        case POINT_LIGHT:
+            return 6;
+        case SPOT_LIGHT:
+        case TORCH_LIGHT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+void ShadowAtlas::lightMatrices(const Light &light, const View &view, unsigned int size, glm::mat4 *matrices) const {
+    if (light.type == DIRECTIONAL_LIGHT) {
+        auto direction = safeNormalize(light.direction, glm::vec3(0.f, -1.f, 0.f));
+        auto up = upVector(direction);
+
+        // 视锥的棱上观察深度线性变化，按深度在近远平面的角点之间插值得到每一级的角点
+        auto inverse = glm::inverse(view.projection * view.view);
+        glm::vec3 nearCorners[4], farCorners[4];
+        for (int i = 0; i < 4; i++) {
+            glm::vec2 ndc((i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f);
+            auto nearCorner = inverse * glm::vec4(ndc, -1.f, 1.f);
+            auto farCorner = inverse * glm::vec4(ndc, 1.f, 1.f);
+            nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+            farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+        }
+        auto n = view.nearPlane;
+        auto f = std::min(shadowDistance, view.farPlane);
+        auto split = [&](int i) {
+            auto t = (float)i / CASCADES;
+            return CASCADE_LAMBDA * n * std::pow(f / n, t) + (1.f - CASCADE_LAMBDA) * (n + (f - n) * t);
+        };
+
+        for (int c = 0; c < CASCADES; c++) {
+            glm::vec3 corners[8];
+            auto from = (split(c) - n) / (view.farPlane - n);
+            auto to = (split(c + 1) - n) / (view.farPlane - n);
+            glm::vec3 center(0.f);
+            for (int i = 0; i < 4; i++) {
+                corners[i] = nearCorners[i] + (farCorners[i] - nearCorners[i]) * from;
+                corners[i + 4] = nearCorners[i] + (farCorners[i] - nearCorners[i]) * to;
+                center += corners[i] + corners[i + 4];
+            }
+            center /= 8.f;
+            // 包围球的半径不随相机旋转变化，按 1/16 取整避免微小抖动
+            float radius = 0.f;
+            for (auto &corner : corners)
+                radius = std::max(radius, glm::distance(corner, center));
+            radius = std::ceil(radius * 16.f) / 16.f;
+
+            auto lightView = glm::lookAt(center - direction * (radius + casterRange), center, up);
+            auto projection = glm::ortho(-radius, radius, -radius, radius, 0.f, 2.f * radius + casterRange);
+            // 原点对齐到纹素，相机平移时阴影边缘不闪烁
+            auto origin = glm::vec2(projection * lightView * glm::vec4(0.f, 0.f, 0.f, 1.f)) * ((float)size / 2.f);
+            auto offset = (glm::round(origin) - origin) * (2.f / (float)size);
+            projection[3][0] += offset.x;
+            projection[3][1] += offset.y;
+            matrices[c] = projection * lightView;
+        }
+    }
+    else if (light.type == POINT_LIGHT) {
+        auto projection = glm::perspective(glm::radians(90.f), 1.f, NEAR_PLANE, view.farPlane);
+        const glm::vec3 directions[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+        const glm::vec3 ups[6] = {{0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+        for (int i = 0; i < 6; i++)
+            matrices[i] = projection * glm::lookAt(light.position, light.position + directions[i], ups[i]);
+    }
+    else {
+        auto direction = safeNormalize(light.direction, glm::vec3(0.f, -1.f, 0.f));
+        auto fov = std::min(2.f * light.outerCutOffDegree + 5.f, 170.f);
+        auto projection = glm::perspective(glm::radians(fov), 1.f, NEAR_PLANE, view.farPlane);
+        matrices[0] = projection * glm::lookAt(light.position, light.position + direction, upVector(direction));
+    }
+}
+
+void ShadowAtlas::layout(const std::vector<Caster> &casters, const View &view, const glm::mat4 &model) {
+    stats = Stats();
+    if (!valid()) {
+        m_tiles.clear();
+        return;
+    }
+    auto viewPos = glm::vec3(glm::inverse(view.view)[3]);
+
+    struct Request {
+        const Caster *caster;
+        float importance;
+        unsigned int size;
+        int count;
+    };
+    std::vector<Request> requests;
+    for (auto &caster : casters) {
+        auto count = tileCount(caster.light->type);
+        if (count > 0 && caster.index >= 0 && caster.index < MAX_LIGHTS)
+            requests.push_back({&caster, importance(*caster.light, viewPos), 0, count});
+    }
+    std::stable_sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+        return a.importance > b.importance;
+    });
+
+    // 最重要的灯光的图块边长为图集的 1/4，重要性每低 4 倍边长减半，且不超过灯光设置的分辨率
+    for (auto &request : requests) {
+        auto size = m_resolution / 4;
+        while (size > request.caster->light->shadowResolution && size > MIN_TILE)
+            size /= 2;
+        auto ratio = requests.front().importance / std::max(request.importance, 1e-6f);
+        for (auto level = std::log2(std::max(ratio, 1.f)) / 2.f; level >= 1.f && size > MIN_TILE; level -= 1.f)
+            size /= 2;
+        request.size = size;
+    }
+
+    // 超出图集面积或图块数量时缩小最不重要的灯光，都已是最小边长时放弃最不重要的灯光
+    auto overflow = [&]() {
+        size_t area = 0;
+        int count = 0;
+        for (auto &request : requests) {
+            area += (size_t)request.count * request.size * request.size;
+            count += request.count;
+        }
+        return area > (size_t)m_resolution * m_resolution || count > MAX_TILES;
+    };
+    while (!requests.empty() && overflow()) {
+        auto shrink = std::find_if(requests.rbegin(), requests.rend(), [](const Request &request) {
+            return request.size > MIN_TILE;
+        });
+        if (shrink != requests.rend())
+            shrink->size /= 2;
+        else {
+            requests.pop_back();
+            stats.dropped++;
+        }
+    }
+
+    std::vector<Tile> tiles;
+    for (auto &request : requests) {
+        glm::mat4 matrices[6];
+        lightMatrices(*request.caster->light, view, request.size, matrices);
+        for (int sub = 0; sub < request.count; sub++) {
+            Tile tile;
+            tile.slot = request.caster->slot;
+            tile.index = request.caster->index;
+            tile.sub = sub;
+            tile.size = request.size;
+            tile.importance = request.importance;
+            tile.matrix = matrices[sub];
+            tiles.push_back(tile);
+        }
+    }
+
+    // 按边长从大到小以 Z 序排列，边长都是 2 的幂，每个图块的起点都与其边长对齐，不会重叠
+    // 同一灯光的图块边长相同，稳定排序后仍然相邻
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile &a, const Tile &b) { return a.size > b.size; });
+    unsigned int cell = 0;
+    for (auto &tile : tiles) {
+        tile.x = compact(cell) * MIN_TILE;
+        tile.y = compact(cell >> 1) * MIN_TILE;
+        cell += (tile.size / MIN_TILE) * (tile.size / MIN_TILE);
+
+        // 同一灯光的同一图块位置不变时保留内容
+        for (auto &old : m_tiles) {
+            if (old.slot == tile.slot && old.sub == tile.sub && old.valid &&
+                old.x == tile.x && old.y == tile.y && old.size == tile.size) {
+                tile.rendered = old.rendered;
+                tile.model = old.model;
+                tile.valid = true;
+                tile.dirty = old.dirty || old.rendered != tile.matrix || old.model != model;
+                break;
+            }
+        }
+    }
+    m_tiles = std::move(tiles);
+    m_model = model;
+    stats.lights = requests.size();
+    stats.tiles = m_tiles.size();
+}
+
+void ShadowAtlas::render(const std::function<void(const std::vector<glm::mat4> &)> &prepare,
+                         const std::function<void(size_t, const glm::mat4 &)> &draw) {
+    if (!valid())
+        return;
+
+    std::vector<Tile *> dirty;
+    for (auto &tile : m_tiles)
+        if (tile.dirty)
+            dirty.push_back(&tile);
+    std::stable_sort(dirty.begin(), dirty.end(), [](const Tile *a, const Tile *b) {
+        if (a->valid != b->valid)
+            return !a->valid;
+        return a->importance > b->importance;
+    });
+    auto count = std::min(dirty.size(), tileBudget);
+    stats.rendered = count;
+    stats.deferred = dirty.size() - count;
+    stats.cached = m_tiles.size() - dirty.size();
+
+    if (count > 0) {
+        std::vector<glm::mat4> matrices(count);
+        for (size_t i = 0; i < count; i++)
+            matrices[i] = dirty[i]->matrix;
+        prepare(matrices);
+
+        timer.begin((int)count);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+        glEnable(GL_SCISSOR_TEST);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.5f, 4.f);
+        glCullFace(GL_FRONT);
+        for (size_t i = 0; i < count; i++) {
+            auto &tile = *dirty[i];
+            glViewport((GLint)tile.x, (GLint)tile.y, (GLsizei)tile.size, (GLsizei)tile.size);
+            glScissor((GLint)tile.x, (GLint)tile.y, (GLsizei)tile.size, (GLsizei)tile.size);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            draw(i, tile.matrix);
+            tile.rendered = tile.matrix;
+            tile.model = m_model;
+            tile.valid = true;
+            tile.dirty = false;
+        }
+        glCullFace(GL_BACK);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        timer.end();
+    }
+    upload();
+}
+
+void ShadowAtlas::invalidate() {
+    for (auto &tile : m_tiles)
+        tile.dirty = true;
+}
+
+void ShadowAtlas::upload() {
+    GpuData data{};
+    auto scale = 1.f / (float)m_resolution;
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        auto &tile = m_tiles[i];
+        auto &light = data.lights[tile.index];
+        if (light.y == 0)
+            light.x = (int)i;
+        light.y++;
+        data.tiles[i].matrix = tile.rendered;
+        if (tile.valid)
+            data.tiles[i].rect = glm::vec4((float)tile.x * scale, (float)tile.y * scale, (float)tile.size * scale, 0.f);
+    }
+
+    if (!m_buffer.valid()) {
+        m_buffer.allocate(sizeof(GpuData));
+        m_buffer.update(0, &data, sizeof(GpuData));
+        m_data = data;
+    }
+    else if (std::memcmp(&data, &m_data, sizeof(GpuData)) != 0) {
+        m_buffer.update(0, &data, sizeof(GpuData));
+        m_data = data;
+    }
+    m_buffer.bindBase(SHADOW_BINDING);
+}
@@ -0,0 +1,137 @@
+#ifndef MODEL_VIEWER_SHADOWATLAS_H
+#define MODEL_VIEWER_SHADOWATLAS_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/glad.h"
+#include "GpuBuffer.h"
+#include "GpuTimer.h"
+#include "Light.h"
+
+/// 所有投射阴影的灯光共用的阴影图集：一张二维深度纹理划分为边长为 2 的幂的图块
+/// 平行光按相机视锥分为 CASCADES 级，聚光一个透视图块，点光源六个 90° 透视图块（与立方体贴图的面顺序相同）
+///
+/// 图块边长按灯光的重要性（亮度与到相机距离的衰减）决定，总面积超过图集时先缩小最不重要的灯光，
+/// 都已是最小边长时放弃它的阴影，因此图集大小固定，灯光再多开销也有上限
+/// 图块的内容与渲染时的矩阵一起保存，矩阵变化或位置变化时才需要重新渲染，每帧最多渲染 tileBudget 个，
+/// 尚未更新的图块继续以旧矩阵采样旧内容
+///
+/// 图块信息写入 SHADOW_BINDING 的存储缓冲，着色器按灯光在灯光缓冲中的位置查找
+class ShadowAtlas {
+public:
+    static constexpr unsigned int MIN_TILE = 128;
+    static constexpr unsigned int MIN_RESOLUTION = 1024;
+    static constexpr unsigned int MAX_RESOLUTION = 8192;
+    static constexpr int CASCADES = 3;
+    static constexpr int MAX_LIGHTS = 16;  // 与着色器中 shadowLights 的长度一致
+    static constexpr int MAX_TILES = 64;
+
+    /// 投射阴影的灯光
+    struct Caster {
+        int slot;  // 在 LightFactory 中的位置，用于匹配上一帧的图块
+        int index;  // 在灯光缓冲中的位置
+        const Light *light;
+    };
+
+    /// 级联阴影划分的相机视锥
+    struct View {
+        glm::mat4 view;
+        glm::mat4 projection;
+        float nearPlane;
+        float farPlane;
+    };
+
+    struct Stats {
+        size_t lights = 0;  // 分配到图块的灯光
+        size_t dropped = 0;  // 图集已满而没有阴影的灯光
+        size_t tiles = 0;
+        size_t rendered = 0;  // 本帧渲染的图块
+        size_t deferred = 0;  // 需要更新但超出本帧预算的图块
+        size_t cached = 0;  // 内容仍然有效的图块
+    };
+
+    ShadowAtlas() = default;
+    ~ShadowAtlas();
+
+    ShadowAtlas(const ShadowAtlas &) = delete;
+    ShadowAtlas &operator=(const ShadowAtlas &) = delete;
+
+    /// 显存预算内最大的图集边长，24 位深度按 4 字节计算
+    static unsigned int fit(size_t budget);
+
+    /// 边长变化时重新分配，所有图块失效
+    /// \return 是否重新分配
+    bool allocate(unsigned int resolution);
+    void release();
+
+    /// 按重要性分配图块并计算每个图块的光源矩阵，位置不变的图块保留内容
+    /// \param model 模型矩阵，变化时所有图块需要重新渲染
+    void layout(const std::vector<Caster> &casters, const View &view, const glm::mat4 &model);
+
+    /// 渲染需要更新的图块（优先没有内容的与重要的灯光），然后上传图块信息并绑定
+    /// prepare 在渲染之前以本帧要渲染的各图块的 投影 * 观察 矩阵调用一次，可在此一次剔除所有图块
+    /// draw 在图块的视口已设置、深度已清除后调用，参数为图块在 prepare 矩阵中的序号与矩阵
+    /// 结束后帧缓冲恢复为 0，视口由调用者恢复
+    void render(const std::function<void(const std::vector<glm::mat4> &)> &prepare,
+                const std::function<void(size_t, const glm::mat4 &)> &draw);
+
+    /// 几何变化后下一次 render 重新渲染所有图块，更新之前仍使用旧内容
+    void invalidate();
+
+    [[nodiscard]] bool valid() const { return m_texture != 0; }
+    [[nodiscard]] GLuint texture() const { return m_texture; }
+    [[nodiscard]] unsigned int resolution() const { return m_resolution; }
+    [[nodiscard]] size_t bytes() const { return (size_t)m_resolution * m_resolution * 4; }
+
+    size_t tileBudget = 8;  // 每帧最多渲染的图块数
+    float shadowDistance = 20.f;  // 平行光阴影覆盖的观察距离
+    float casterRange = 50.f;  // 级联之外朝向光源方向仍然投射阴影的距离
+    Stats stats;
+    size_t allocations = 0;  // 纹理累计分配次数
+    GpuTimer timer;  // 按图块数平均的渲染耗时
+
+private:
+    struct Tile {
+        int slot = -1;
+        int index = -1;
+        int sub = 0;  // 级联或立方体面的序号
+        unsigned int x = 0, y = 0, size = 0;
+        float importance = 0.f;
+        glm::mat4 matrix{1.f};  // 当前需要的矩阵
+        glm::mat4 rendered{1.f};  // 内容对应的矩阵
+        glm::mat4 model{1.f};
+        bool valid = false;  // 内容属于此位置，可以采样
+        bool dirty = true;
+    };
+
+    /// 与着色器中 std430 布局的 ShadowTile 一致
+    struct GpuTile {
+        glm::mat4 matrix;
+        glm::vec4 rect;  // 纹理坐标的偏移与缩放，z 为 0 表示没有内容
+    };
+
+    /// 与着色器中的 Shadows 缓冲一致
+    struct GpuData {
+        glm::ivec4 lights[MAX_LIGHTS];  // x 第一个图块, y 图块数（0 表示没有阴影）
+        GpuTile tiles[MAX_TILES];
+    };
+
+    static float importance(const Light &light, const glm::vec3 &viewPos);
+    static int tileCount(LightType type);
+    /// 按级联、聚光或点光源的面计算光源矩阵
+    void lightMatrices(const Light &light, const View &view, unsigned int size, glm::mat4 *matrices) const;
+    void upload();
+
+    GLuint m_texture = 0;
+    GLuint m_framebuffer = 0;
+    unsigned int m_resolution = 0;
+    std::vector<Tile> m_tiles;
+    glm::mat4 m_model{1.f};  // 最近一次 layout 的模型矩阵
+    GpuData m_data{};  // 已上传的内容
+    GpuBuffer m_buffer{GL_SHADER_STORAGE_BUFFER};
+};
+
+
+#endif //MODEL_VIEWER_SHADOWATLAS_H
@@ -0,0 +1,208 @@
+#include "ShadowClusters.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    /// 视锥平面（Gribb-Hartmann），法线朝内
+    void extractPlanes(const glm::mat4 &m, glm::vec4 planes[6]) {
+        for (int i = 0; i < 3; i++) {
+            planes[i * 2] = glm::vec4(m[0][3] + m[0][i], m[1][3] + m[1][i], m[2][3] + m[2][i], m[3][3] + m[3][i]);
+            planes[i * 2 + 1] = glm::vec4(m[0][3] - m[0][i], m[1][3] - m[1][i], m[2][3] - m[2][i], m[3][3] - m[3][i]);
+        }
+    }
+
+    bool outside(const glm::vec4 planes[6], const glm::vec3 &center, const glm::vec3 &extent) {
+        for (int i = 0; i < 6; i++) {
+            glm::vec3 normal(planes[i]);
+            if (glm::dot(normal, center) + planes[i].w + glm::dot(glm::abs(normal), extent) < 0.f)
+                return true;
+        }
+        return false;
+    }
+}
+
+ShadowClusters::ShadowClusters(const vector<Mesh> &meshes) : m_meshes(&meshes) {
+    for (unsigned int j = 0; j < meshes.size(); j++) {
+        const auto &vertices = meshes[j].getVertices();
+        const auto &indices = meshes[j].getIndices();
+        for (size_t first = 0; first < indices.size(); first += CLUSTER_TRIANGLES * 3) {
+            auto last = std::min(indices.size(), first + CLUSTER_TRIANGLES * 3);
+            Cluster cluster{j, (unsigned int)first, (unsigned int)(last - first), glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+            for (auto i = first; i < last; i++) {
+                cluster.min = glm::min(cluster.min, vertices[indices[i]].position);
+                cluster.max = glm::max(cluster.max, vertices[indices[i]].position);
+            }
+            m_clusters.push_back(cluster);
+        }
+    }
+
+    m_instanceFaces = {0, 1, 2, 3, 4, 5};
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_faceBuffer);
+    glGenBuffers(1, &m_viewBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_faceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m_instanceFaces.size() * sizeof(GLint)), m_instanceFaces.data(), GL_STREAM_DRAW);
+
+    // 其它着色器不读取该属性，普通绘制时取第 0 个实例的值也没有影响
+    for (auto &mesh : meshes) {
+        glBindVertexArray(mesh.getVao());
+        glEnableVertexAttribArray(FACE_ATTRIBUTE);
+        glVertexAttribIPointer(FACE_ATTRIBUTE, 1, GL_INT, sizeof(GLint), nullptr);
+        glVertexAttribDivisor(FACE_ATTRIBUTE, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ShadowClusters::~ShadowClusters() {
+    glDeleteBuffers(1, &m_commandBuffer);
+    glDeleteBuffers(1, &m_faceBuffer);
+    glDeleteBuffers(1, &m_viewBuffer);
+}
+
+void ShadowClusters::cull(const glm::mat4 &model, const glm::mat4 *faceMatrices, unsigned int faces) {
+    auto start = std::chrono::steady_clock::now();
+    auto meshCount = m_meshes->size();
+
+    // 在模型空间剔除，平面随 投影观察 * 模型 矩阵一起变换，不需要变换包围盒
+    glm::vec4 planes[6][6];
+    for (int face = 0; face < 6; face++)
+        if (faces & (1u << face))
+            extractPlanes(faceMatrices[face] * model, planes[face]);
+
+    vector<unsigned char> masks(m_clusters.size(), 0);
+    visibleDraws = totalDraws = 0;
+    for (size_t i = 0; i < m_clusters.size(); i++) {
+        auto &cluster = m_clusters[i];
+        auto center = (cluster.min + cluster.max) * 0.5f;
+        auto extent = (cluster.max - cluster.min) * 0.5f;
+        for (int face = 0; face < 6; face++) {
+            if (!(faces & (1u << face)))
+                continue;
+            totalDraws++;
+            if (!outside(planes[face], center, extent)) {
+                masks[i] |= 1u << face;
+                visibleDraws++;
+            }
+        }
+    }
+
+    m_commands.clear();
+    m_ranges.assign(7 * meshCount, Range());
+    m_instanceFaces.resize(6);
+    for (size_t group = 0; group < 7; group++) {
+        for (size_t i = 0; i < m_clusters.size(); i++) {
+            auto &cluster = m_clusters[i];
+            GLuint instanceCount = 1, baseInstance;
+            if (group == 0) {  // 分层绘制：每个可见的面一个实例
+                if (masks[i] == 0)
+                    continue;
+                baseInstance = (GLuint)m_instanceFaces.size();
+                for (int face = 0; face < 6; face++)
+                    if (masks[i] & (1u << face))
+                        m_instanceFaces.push_back(face);
+                instanceCount = (GLuint)m_instanceFaces.size() - baseInstance;
+            }
+            else {
+                if (!(masks[i] & (1u << (group - 1))))
+                    continue;
+                baseInstance = (GLuint)(group - 1);
+            }
+            auto &range = m_ranges[group * meshCount + cluster.mesh];
+            if (range.count == 0)
+                range.first = m_commands.size();
+            range.count++;
+            m_commands.push_back({cluster.count, instanceCount, cluster.firstIndex, 0, baseInstance});
+        }
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)(m_commands.size() * sizeof(DrawCommand)), m_commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, m_faceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(m_instanceFaces.size() * sizeof(GLint)), m_instanceFaces.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cullTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShadowClusters::cullViews(const glm::mat4 &model, const vector<glm::mat4> &matrices) {
+    auto start = std::chrono::steady_clock::now();
+    auto meshCount = m_meshes->size();
+
+    // 块按网格顺序排列，同一视图中每个网格的命令连续
+    m_viewCommands.clear();
+    m_viewRanges.assign(matrices.size() * meshCount, Range());
+    visibleDraws = 0;
+    totalDraws = matrices.size() * m_clusters.size();
+    glm::vec4 planes[6];
+    for (size_t view = 0; view < matrices.size(); view++) {
+        extractPlanes(matrices[view] * model, planes);
+        for (auto &cluster : m_clusters) {
+            if (outside(planes, (cluster.min + cluster.max) * 0.5f, (cluster.max - cluster.min) * 0.5f))
+                continue;
+            auto &range = m_viewRanges[view * meshCount + cluster.mesh];
+            if (range.count == 0)
+                range.first = m_viewCommands.size();
+            range.count++;
+            m_viewCommands.push_back({cluster.count, 1, cluster.firstIndex, 0, 0});
+            visibleDraws++;
+        }
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_viewBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)(m_viewCommands.size() * sizeof(DrawCommand)),
+                 m_viewCommands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    cullTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShadowClusters::drawView(size_t view) const {
+    auto meshCount = m_meshes->size();
+    if ((view + 1) * meshCount > m_viewRanges.size())
+        return;
+    drawRanges(m_viewBuffer, m_viewRanges.data() + view * meshCount);
+}
+
+void ShadowClusters::drawLayered() const {
+    drawGroup(0);
+}
+
+void ShadowClusters::drawFace(int face) const {
+    drawGroup(1 + face);
+}
+
+void ShadowClusters::drawGroup(size_t group) const {
+    auto meshCount = m_meshes->size();
+    if (m_ranges.size() != 7 * meshCount)  // 尚未剔除
+        return;
+    drawRanges(m_commandBuffer, m_ranges.data() + group * meshCount);
+}
+
+void ShadowClusters::drawRanges(GLuint buffer, const Range *ranges) const {
+    auto meshCount = m_meshes->size();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    for (size_t j = 0; j < meshCount; j++) {
+        auto &range = ranges[j];
+        if (range.count == 0)
+            continue;
+        glBindVertexArray((*m_meshes)[j].getVao());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void *)(range.first * sizeof(DrawCommand)),
+                                    range.count, 0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+bool ShadowClusters::layeredSupported() {
+    return GLAD_GL_ARB_shader_viewport_layer_array || GLAD_GL_AMD_vertex_shader_layer;
+}
+
+std::string ShadowClusters::layerDefines() {
+    if (GLAD_GL_ARB_shader_viewport_layer_array)
+        return "#define LAYER_ARB\n";
+    if (GLAD_GL_AMD_vertex_shader_layer)
+        return "#define LAYER_AMD\n";
+    return "";
+}
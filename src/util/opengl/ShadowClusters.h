@@ -0,0 +1,95 @@
+#ifndef MODEL_VIEWER_SHADOWCLUSTERS_H
+#define MODEL_VIEWER_SHADOWCLUSTERS_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "glad/glad.h"
+#include "Mesh.h"
+
+/// 立方体阴影贴图的分块剔除：每个网格的索引按顺序切成固定三角形数的块并保存模型空间包围盒，
+/// 更新阴影前在 CPU 上对六个面的视锥逐块剔除，生成间接绘制命令，只绘制各个面可见的块
+///
+/// 分层绘制时每个块按可见的面数实例化，顶点着色器以实例属性（location 5）写入 gl_Layer，
+/// 不支持在顶点着色器中写 gl_Layer 时逐面挂载并各绘制一遍
+/// 阴影图集的图块作为单独的视图，一帧内所有图块一起剔除并上传一次命令
+class ShadowClusters {
+public:
+    static constexpr unsigned int CLUSTER_TRIANGLES = 256;
+    static constexpr GLuint FACE_ATTRIBUTE = 5;
+
+    /// 为每个网格的顶点数组添加实例属性，网格需已创建OpenGL对象
+    explicit ShadowClusters(const vector<Mesh> &meshes);
+    ~ShadowClusters();
+
+    ShadowClusters(const ShadowClusters &) = delete;
+    ShadowClusters &operator=(const ShadowClusters &) = delete;
+
+    /// 对 faces 位掩码中的面剔除并上传绘制命令
+    /// \param faceMatrices 六个面的投影观察矩阵
+    void cull(const glm::mat4 &model, const glm::mat4 *faceMatrices, unsigned int faces);
+
+    /// 一次绘制所有面，需要 layeredSupported()
+    void drawLayered() const;
+    /// 只绘制第 face 个面可见的块，目标面由调用者挂载
+    void drawFace(int face) const;
+
+    /// 对多个单独的视图（阴影图集的图块）一次剔除，所有视图的绘制命令一起上传到独立的命令缓冲
+    /// \param matrices 每个视图的投影观察矩阵
+    void cullViews(const glm::mat4 &model, const vector<glm::mat4> &matrices);
+    /// 绘制第 view 个视图可见的块，命令按偏移从 cullViews 上传的缓冲中读取
+    void drawView(size_t view) const;
+
+    [[nodiscard]] size_t clusterCount() const { return m_clusters.size(); }
+
+    /// 驱动是否支持在顶点着色器中写入 gl_Layer
+    static bool layeredSupported();
+    /// 着色器使用的扩展宏，不支持时为空
+    static std::string layerDefines();
+
+    size_t visibleDraws = 0;  // 最近一次剔除后（块, 面）的可见数量
+    size_t totalDraws = 0;  // 最近一次剔除的（块, 面）总数
+    float cullTime = 0.f;  // 毫秒
+
+private:
+    struct Cluster {
+        unsigned int mesh;
+        unsigned int firstIndex;
+        unsigned int count;
+        glm::vec3 min, max;
+    };
+
+    /// 与 glMultiDrawElementsIndirect 的命令布局一致
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    /// 命令缓冲的一段，第 0 组为分层绘制，第 1 + face 组为逐面绘制，每组按网格划分
+    struct Range {
+        size_t first = 0;
+        GLsizei count = 0;
+    };
+
+    void drawGroup(size_t group) const;
+    /// 按网格依次绘制 ranges 中的 网格数 段命令
+    void drawRanges(GLuint buffer, const Range *ranges) const;
+
+    const vector<Mesh> *m_meshes;
+    vector<Cluster> m_clusters;
+    vector<DrawCommand> m_commands;
+    vector<Range> m_ranges;  // (1 + 6) * 网格数
+    vector<GLint> m_instanceFaces;  // 前 6 个为 0..5，供逐面命令使用
+    GLuint m_commandBuffer = 0;
+    GLuint m_faceBuffer = 0;
+
+    vector<DrawCommand> m_viewCommands;
+    vector<Range> m_viewRanges;  // 视图数 * 网格数
+    GLuint m_viewBuffer = 0;
+};
+
+
+#endif //MODEL_VIEWER_SHADOWCLUSTERS_H
@@ -0,0 +1,82 @@
+#include "ShadowMap.h"
+
+size_t ShadowMap::allocatedBytes = 0;
+size_t ShadowMap::allocations = 0;
+
+size_t ShadowMap::Format::bytes() const {
+    size_t texel = internalFormat == GL_DEPTH_COMPONENT16 ? 2 : 4;
+    return 6 * (size_t)resolution * resolution * texel;
+}
+
+ShadowMap::Format ShadowMap::fit(unsigned int requested, size_t budget) {
+    const GLenum internalFormats[] = {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT16};
+    Format format;
+    for (auto resolution = requested; ; resolution /= 2) {
+        for (auto internalFormat : internalFormats) {
+            format.resolution = resolution;
+            format.internalFormat = internalFormat;
+            if (format.bytes() <= budget)
+                return format;
+        }
+        if (resolution / 2 < MIN_RESOLUTION)  // 预算过小时使用最低规格
+            return format;
+    }
+}
+
+ShadowMap::~ShadowMap() {
+    release();
+}
+
+bool ShadowMap::allocate(const Format &format) {
+    if (valid() && m_format == format)
+        return false;
+
+    if (!valid()) {
+        glGenTextures(1, &m_texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glGenFramebuffers(1, &m_framebuffer);
+    }
+    else {
+        allocatedBytes -= m_format.bytes();
+    }
+
+    // 重新指定存储时旧的存储由驱动释放，纹理与帧缓冲对象保持不变
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+    for (unsigned int i = 0; i < 6; ++i)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, (GLint)format.internalFormat,
+                     (GLsizei)format.resolution, (GLsizei)format.resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    m_format = format;
+    allocatedBytes += format.bytes();
+    allocations++;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    attachLayered();
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
+
+void ShadowMap::release() {
+    if (!valid())
+        return;
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_texture);
+    m_framebuffer = m_texture = 0;
+    allocatedBytes -= m_format.bytes();
+    m_format = Format();
+}
+
+void ShadowMap::attachLayered() const {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0);
+}
+
+void ShadowMap::attachFace(int face) const {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_texture, 0);
+}
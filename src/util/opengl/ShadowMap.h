@@ -0,0 +1,63 @@
+#ifndef MODEL_VIEWER_SHADOWMAP_H
+#define MODEL_VIEWER_SHADOWMAP_H
+
+#include <cstddef>
+#include "glad/glad.h"
+
+/// 全向阴影使用的深度立方体贴图及其帧缓冲，析构时释放
+/// 规格不变时重复分配直接复用，切换模型时不需要重新创建
+class ShadowMap {
+public:
+    /// 深度格式与每个面的边长
+    struct Format {
+        unsigned int resolution = 0;
+        GLenum internalFormat = GL_DEPTH_COMPONENT16;
+
+        [[nodiscard]] unsigned int depthBits() const { return internalFormat == GL_DEPTH_COMPONENT16 ? 16 : 24; }
+        /// 六个面占用的字节数，24 位深度按驱动实际使用的 4 字节计算
+        [[nodiscard]] size_t bytes() const;
+
+        bool operator==(const Format &other) const {
+            return resolution == other.resolution && internalFormat == other.internalFormat;
+        }
+    };
+
+    /// 在显存预算内选择规格：从 requested 开始逐级减半（不低于 MIN_RESOLUTION），
+    /// 同一分辨率优先 24 位深度，放不下时改用 16 位
+    static Format fit(unsigned int requested, size_t budget);
+
+    static constexpr unsigned int MIN_RESOLUTION = 512;
+
+    ShadowMap() = default;
+    ~ShadowMap();
+
+    ShadowMap(const ShadowMap &) = delete;
+    ShadowMap &operator=(const ShadowMap &) = delete;
+
+    /// 首次调用时创建纹理与帧缓冲，规格变化时在原纹理上重新指定存储
+    /// \return 是否重新分配（原有内容失效）
+    bool allocate(const Format &format);
+    void release();
+
+    /// 挂载整个立方体贴图，几何着色器按 gl_Layer 输出到各个面
+    void attachLayered() const;
+    /// 只挂载第 face 个面，需先绑定 framebuffer()
+    void attachFace(int face) const;
+
+    [[nodiscard]] bool valid() const { return m_texture != 0; }
+    [[nodiscard]] GLuint texture() const { return m_texture; }
+    [[nodiscard]] GLuint framebuffer() const { return m_framebuffer; }
+    [[nodiscard]] const Format &format() const { return m_format; }
+
+    /// 所有阴影贴图当前占用的显存（字节）与累计分配次数
+    static size_t allocatedBytes;
+    static size_t allocations;
+
+private:
+    GLuint m_texture = 0;
+    GLuint m_framebuffer = 0;
+    Format m_format;
+};
+
+
+#endif //MODEL_VIEWER_SHADOWMAP_H